@@ -237,6 +237,15 @@ int xine_stream_master_slave(xine_stream_t *master, xine_stream_t *slave,
  */
 int xine_open (xine_stream_t *stream, const char *mrl) XINE_PROTECTED;
 
+/*
+ * gapless playlists: while the current mrl plays, find and open the input
+ * plugin for the next one in the background (connect, read first data).
+ * a following xine_open () with the same mrl takes it over instead of
+ * opening again, another mrl or NULL drops it.
+ * returns 1 if pre-opening was started, 0 on error.
+ */
+int xine_open_next (xine_stream_t *stream, const char *mrl) XINE_PROTECTED;
+
 /** The keyframe seek index feature. */
 
 #define XINE_KEYFRAMES 1 /**<< Check this for feature available. */
@@ -247,8 +256,8 @@ typedef struct {
 } xine_keyframes_entry_t;
 
 /** @brief Query stream keyframe seek index.
-    @note  We dont do an expensive file scan. We will only find keyframes listed in
-           container or already seen while playing.
+    @note  We dont do an expensive file scan by default. We will only find keyframes listed in
+           container, already seen while playing, or found by xine_keyframes_scan ().
     @param stream The stream that index is for.
     @param pos    On call, the start time or normpos.
                   On return, the found time and normpos.
@@ -266,6 +275,15 @@ int xine_keyframes_find (xine_stream_t *stream, xine_keyframes_entry_t *pos, int
 */
 xine_keyframes_entry_t *xine_keyframes_get (xine_stream_t *stream, int *size) XINE_PROTECTED;
 
+/** @brief Build the stream keyframe seek index in the background.
+    @note  A hidden stream without decoders runs the demuxer over the same mrl at full speed.
+           Progress is reported with XINE_EVENT_PROGRESS. The scan ends with xine_close ().
+    @param stream The opened stream to index.
+    @return  1: Scan started, running already, or the container has an index.
+             0: Failure, or the input is live, not seekable or of unknown length.
+*/
+int xine_keyframes_scan (xine_stream_t *stream) XINE_PROTECTED;
+
 /*
  * play a stream from a given position
  *
@@ -353,6 +371,7 @@ int  xine_get_param (xine_stream_t *stream, int param) XINE_PROTECTED;
 #define XINE_PARAM_EARLY_FINISHED_EVENT   31 /* send event when demux finish*/
 #define XINE_PARAM_GAPLESS_SWITCH         32 /* next stream only gapless swi*/
 #define XINE_PARAM_DELAY_FINISHED_EVENT   33 /* 1/10sec,0=>disable,-1=>forev*/
+#define XINE_PARAM_KEYFRAMES_ONLY         34 /* decode video keyframes only */
 
 /*
  * speed values for XINE_PARAM_SPEED parameter.
@@ -625,6 +644,69 @@ int xine_get_next_video_frame (xine_video_port_t *port,
 
 void xine_free_video_frame (xine_video_port_t *port, xine_video_frame_t *frame) XINE_PROTECTED;
 
+/*
+ * batch access to the frames of a framegrab port.
+ *
+ * xine_get_video_frames () waits for up to num frames and returns how many
+ * it got, 0 at end of stream. It stops early when the decoder ran out of
+ * free frames, so asking for more than the port has does not dead lock.
+ * The planes are references into the engine's own frame buffers; hand
+ * every returned frame back with xine_free_video_frames ().
+ */
+
+/* return what is already queued, do not wait for more. */
+#define XINE_VIDEO_FRAMES_NOWAIT  0x0001
+/* also deliver a packed RGB24 picture, scaled to rgb_width x rgb_height
+ * (0 means source size). conversion runs in parallel on all cpus.
+ * calls from several threads on the same port convert one after another. */
+#define XINE_VIDEO_FRAMES_RGB     0x0002
+
+typedef struct {
+
+  int64_t  vpts;       /* timestamp 1/90000 sec for a/v sync */
+  int64_t  duration;
+  double   aspect_ratio;
+  int      width, height;
+  int      colorspace; /* XINE_IMGFMT_* */
+
+  int      pos_stream; /* bytes from stream start */
+  int      pos_time;   /* milliseconds */
+
+  int      frame_number; /* frame number (may be unknown) */
+
+  /* YV12: Y, U, V. YUY2: packed data in base[0]. not to be modified. */
+  const uint8_t *base[3];
+  int      pitches[3];
+
+  /* XINE_VIDEO_FRAMES_RGB only, NULL if the frame could not be converted. */
+  uint8_t *rgb;
+  int      rgb_width, rgb_height;
+
+  void    *xine_frame; /* used internally by xine engine */
+} xine_video_frame_ref_t;
+
+int xine_get_video_frames (xine_video_port_t *port, xine_video_frame_ref_t *frames, int num,
+                           int flags, int rgb_width, int rgb_height) XINE_PROTECTED;
+
+void xine_free_video_frames (xine_video_port_t *port, xine_video_frame_ref_t *frames, int num) XINE_PROTECTED;
+
+/*
+ * ring mode for slow consumers: when more than max_queued frames wait
+ * to be fetched, the oldest one is dropped instead of blocking the decoder.
+ * 0 (default) turns it off again.
+ */
+void xine_set_video_frames_ring (xine_video_port_t *port, int max_queued) XINE_PROTECTED;
+
+/*
+ * fast thumbnails: for a stream opened on a framegrab port, seek to num
+ * evenly spaced positions and decode one keyframe each, skipping all
+ * other video frames, audio and subtitles. the frames come as RGB24 only
+ * (XINE_VIDEO_FRAMES_RGB, base[] is NULL). returns the number of frames
+ * got; release them with xine_free_video_frames ().
+ */
+int xine_get_thumbnails (xine_stream_t *stream, xine_video_frame_ref_t *frames, int num,
+                         int rgb_width, int rgb_height) XINE_PROTECTED;
+
 xine_audio_port_t *xine_new_framegrab_audio_port (xine_t *self) XINE_PROTECTED;
 
 typedef struct {
@@ -1038,6 +1120,9 @@ const char *xine_get_meta_info   (xine_stream_t *stream, int info) XINE_PROTECTE
 #define XINE_STREAM_INFO_DVD_CHAPTER_COUNT  33
 #define XINE_STREAM_INFO_DVD_ANGLE_NUMBER   34
 #define XINE_STREAM_INFO_DVD_ANGLE_COUNT    35
+#define XINE_STREAM_INFO_KEYFRAMES_ONLY     36
+#define XINE_STREAM_INFO_LIVE_LATENCY      37 /* ms buffered, net_buf_ctrl live mode */
+#define XINE_STREAM_INFO_VIDEO_DROP_LEVEL  38 /* 0 none, 1 disposable, 2 all but keyframes */
 
 /* possible values for XINE_STREAM_INFO_VIDEO_AFD */
 #define XINE_VIDEO_AFD_NOT_PRESENT         -1
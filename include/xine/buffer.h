@@ -426,6 +426,11 @@ struct buf_element_s {
   * (mpeg-ts). Decoders will never see this. */
 #define BUF_FLAG_MERGE 0x8000
 
+/** No other frame refers to this one (eg mpeg B frames). When decoding
+  * falls behind, the engine may drop it before it reaches the decoder.
+  * Like BUF_FLAG_KEYFRAME, set this on all bufs of the frame. */
+#define BUF_FLAG_DISPOSABLE 0x10000
+
 /**
  * \defgroup buffer_special Special buffer types:
  * Sometimes there is a need to relay special information from a demuxer
@@ -678,6 +683,14 @@ struct fifo_buffer_s
    * Any result may still be smaller, do check buf->max_size.
    */
   buf_element_t *(*buffer_pool_realloc) (buf_element_t *buf, size_t new_size);
+
+  /* Same as get but return NULL instead of waiting for a buf. */
+  buf_element_t *(*try_get) (fifo_buffer_t *fifo);
+
+  /* private: decoder pool wakeup. Called with fifo->mutex held
+   * after each put or insert. */
+  void           (*notify) (void *data);
+  void            *notify_data;
 } ;
 
 /**
@@ -189,6 +189,10 @@ struct metronom_s {
 /* Nasty input_vdr helper. Inserts an immediate absolute discontinuity,
  * old style without pts reorder fix. */
 #define METRONOM_VDR_TRICK_PTS    11
+/* 1 makes handle_{audio,video}_discontinuity () return at once instead of waiting
+ * for the other side. METRONOM_WAITING then tells whether that still needs to
+ * happen, and decoding should be held until it did. */
+#define METRONOM_DISC_NONBLOCK    12
 #define METRONOM_NO_LOCK          0x8000
 
 typedef void xine_speed_change_cb_t (void *user_data, int new_speed);
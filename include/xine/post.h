@@ -334,6 +334,11 @@ struct post_audio_port_s {
 post_audio_port_t *_x_post_intercept_audio_port(post_plugin_t *post, xine_audio_port_t *port,
 						post_in_t **input, post_out_t **output) XINE_PROTECTED;
 
+/* The default get_capabilities () hides AO_CAP_FLOAT32, so decoders send
+ * integer samples only. Plugins that handle format.bits == 32 float
+ * samples may use this one instead, to pass AO_CAP_FLOAT32 on. */
+uint32_t _x_post_audio_get_capabilities_float (xine_audio_port_t *port_gen) XINE_PROTECTED;
+
 
 /* If you do intercept these decoder-called functions
  * (that is, you do not use post defaults), please
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2000-2018 the xine project
+ * Copyright (C) 2000-2020 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -62,4 +62,29 @@ void _x_audio_out_resample_monotostereo(int16_t* input_samples,
 void _x_audio_out_resample_stereotomono(int16_t* input_samples,
 					int16_t* output_samples, uint32_t frames) XINE_PROTECTED;
 
+/*
+ * float32 samples, nominal range -1.0 .. 1.0.
+ */
+
+/* linear interpolation of channels interleaved frames */
+void _x_audio_out_resample_float(float *last_sample, const float *input_samples, uint32_t in_frames,
+                                 float *output_samples, uint32_t out_frames, int channels) XINE_PROTECTED;
+
+void _x_audio_out_resample_16tofloat(const int16_t *input_samples,
+                                     float *output_samples, uint32_t samples) XINE_PROTECTED;
+
+/* saturates values outside the nominal range. */
+void _x_audio_out_resample_floatto16(const float *input_samples,
+                                     int16_t *output_samples, uint32_t samples) XINE_PROTECTED;
+
+/* MSB aligned 32 bit integer, eg. 24 bit samples shifted left by 8. */
+void _x_audio_out_resample_s32tofloat(const int32_t *input_samples,
+                                      float *output_samples, uint32_t samples) XINE_PROTECTED;
+
+void _x_audio_out_resample_monotostereo_float(const float *input_samples,
+                                              float *output_samples, uint32_t frames) XINE_PROTECTED;
+
+void _x_audio_out_resample_stereotomono_float(const float *input_samples,
+                                              float *output_samples, uint32_t frames) XINE_PROTECTED;
+
 #endif
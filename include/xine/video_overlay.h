@@ -32,7 +32,7 @@
 #endif
 
 #define MAX_OBJECTS   50
-#define MAX_EVENTS    50
+#define MAX_EVENTS    50     /* initial event queue size, grows on demand */
 #define MAX_SHOWING   (5 + 16)
 
 #define OVERLAY_EVENT_NULL             0
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Worker Pool
+ *
+ * A small set of helper threads for splitting one piece of work
+ * (eg. the scanlines of a picture) into independent jobs.
+ */
+
+#ifndef XINE_WORKER_POOL_H
+#define XINE_WORKER_POOL_H
+
+#include <xine/attributes.h>
+
+typedef struct xine_worker_pool_s xine_worker_pool_t;
+
+/* Job callback. job is in the range 0 .. num_jobs - 1. */
+typedef void (*xine_worker_func_t)(void *data, int job);
+
+/* Creates a new pool
+ *   num_threads: total number of threads working on a job set, including
+ *                the calling thread. <= 0 means one per cpu.
+ */
+xine_worker_pool_t *xine_worker_pool_new(int num_threads) XINE_MALLOC XINE_PROTECTED;
+
+/* Stops all helper threads and deletes the pool. NULL is allowed. */
+void xine_worker_pool_delete(xine_worker_pool_t *pool) XINE_PROTECTED;
+
+/* Returns the number of threads working on a job set, including the caller.
+ * NULL pool returns 1. */
+int xine_worker_pool_size(xine_worker_pool_t *pool) XINE_PROTECTED;
+
+/* Runs func (data, job) for all jobs in parallel and returns when all of them
+ * are done. The calling thread takes part in the work. With a NULL pool,
+ * all jobs run sequentially in the caller.
+ * Different callers may share a pool; their job sets are serialized.
+ */
+void xine_worker_pool_run(xine_worker_pool_t *pool, xine_worker_func_t func, void *data, int num_jobs) XINE_PROTECTED;
+
+#endif
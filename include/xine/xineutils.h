@@ -233,13 +233,53 @@ static inline void *xine_small_memcpy (void *to, const void *from, size_t len) {
  * Debug stuff
  */
 /*
- * profiling (unworkable in non DEBUG isn't defined)
+ * profiling.
+ * nothing is recorded until xine_profiler_init () (or $XINE_PROFILE, see
+ * xine_init ()). zones are timed per thread without locking, and may nest.
  */
+extern int xine_profiler_enabled XINE_PROTECTED;
+/* start recording, or forget what was recorded so far. */
 void xine_profiler_init (void) XINE_PROTECTED;
 int xine_profiler_allocate_slot (const char *label) XINE_PROTECTED;
 void xine_profiler_start_count (int id) XINE_PROTECTED;
 void xine_profiler_stop_count (int id) XINE_PROTECTED;
 void xine_profiler_print_results (void) XINE_PROTECTED;
+/* name the calling thread in traces. name must stay valid. */
+void xine_profiler_thread_name (const char *name) XINE_PROTECTED;
+/* name must stay valid (a string literal). */
+void xine_profiler_zone_begin (const char *name) XINE_PROTECTED;
+void xine_profiler_zone_end (void) XINE_PROTECTED;
+/* format 0 means: guess from filename extension. */
+#define XINE_PROFILER_SUMMARY      1 /* text table */
+#define XINE_PROFILER_CHROME_TRACE 2 /* .json for chrome://tracing, perfetto */
+#define XINE_PROFILER_FOLDED       3 /* .folded stacks like perf script | stackcollapse-perf.pl, for flamegraph.pl */
+/* filename NULL means stdout. return 1 on success. */
+int xine_profiler_write (const char *filename, int format) XINE_PROTECTED;
+
+#define XINE_PROFILER_THREAD(name) do { \
+  if (xine_profiler_enabled) \
+    xine_profiler_thread_name (name); \
+} while (0)
+#define XINE_PROFILER_BEGIN(name) do { \
+  if (xine_profiler_enabled) \
+    xine_profiler_zone_begin (name); \
+} while (0)
+#define XINE_PROFILER_END() do { \
+  if (xine_profiler_enabled) \
+    xine_profiler_zone_end (); \
+} while (0)
+/* a zone that ends with the enclosing block, including break, continue and return. */
+#if defined(__GNUC__)
+static inline void _xine_profiler_scope_end (int *on) {
+  if (*on)
+    xine_profiler_zone_end ();
+}
+#  define XINE_PROFILER_SCOPE(name) \
+  int _xine_profiler_scope __attribute__ ((__cleanup__ (_xine_profiler_scope_end))) = \
+    xine_profiler_enabled ? (xine_profiler_zone_begin (name), 1) : 0
+#else
+#  define XINE_PROFILER_SCOPE(name) int _xine_profiler_scope = 0
+#endif
 
 /*
  * xine_container_of()
@@ -302,6 +342,28 @@ void  xine_free_aligned    (void *ptr)              XINE_PROTECTED;
 void *xine_realloc_aligned (void *ptr, size_t size) XINE_PROTECTED;
 #define xine_freep_aligned(xinefreepptr) do {xine_free_aligned (*(xinefreepptr)); *(xinefreepptr) = NULL; } while (0)
 
+/**
+ * Video frame plane memory.
+ * XINE_FRAME_MEM_ALIGN byte aligned, large blocks use huge pages where
+ * available. Freed blocks are cached and reused for requests of about the
+ * same size. Contents of new blocks are undefined, and may be left over
+ * from another stream. xine_frame_mem_allocz () clears them.
+ * xine_frame_mem_flush () returns all cached blocks to the system.
+ * The cache is process wide. Users like video out ports register with
+ * xine_frame_mem_ref (), and xine_frame_mem_unref () of the last one
+ * flushes it.
+ */
+
+#define XINE_FRAME_MEM_ALIGN 64
+
+void *xine_frame_mem_alloc (size_t size)            XINE_PROTECTED XINE_MALLOC;
+void *xine_frame_mem_allocz (size_t size)           XINE_PROTECTED XINE_MALLOC;
+void  xine_frame_mem_free  (void *ptr)              XINE_PROTECTED;
+void  xine_frame_mem_flush (void)                   XINE_PROTECTED;
+void  xine_frame_mem_ref   (void)                   XINE_PROTECTED;
+void  xine_frame_mem_unref (void)                   XINE_PROTECTED;
+#define xine_frame_mem_freep(xinefreepptr) do {xine_frame_mem_free (*(xinefreepptr)); *(xinefreepptr) = NULL; } while (0)
+
 /**
  * Base64 encoder.
  * from: pointer to binary input.
@@ -46,6 +46,7 @@
 
 #include <xine/xine_internal.h>
 #include <xine/audio_out.h>
+#include <xine/resample.h>
 #include <xine/buffer.h>
 
 #ifdef WIN32
@@ -64,6 +65,7 @@ typedef struct lpcm_decoder_s {
   uint32_t         ao_cap_mode;
 
   int              output_open;
+  int              output_float; /* 24 bits as float32 */
   int		   cpu_be;	/* TRUE, if we're a Big endian CPU */
 
   int64_t          pts;
@@ -72,6 +74,9 @@ typedef struct lpcm_decoder_s {
   size_t           buffered_bytes;
   size_t           buf_size;
 
+  int32_t         *ibuf;
+  size_t           ibuf_size;
+
 } lpcm_decoder_t;
 
 static void lpcm_reset (audio_decoder_t *this_gen) {
@@ -86,6 +91,69 @@ static void lpcm_discontinuity (audio_decoder_t *this_gen) {
   lpcm_reset(this_gen);
 }
 
+/* 24 bit samples to float32, split into as many audio buffers as needed. */
+static void lpcm_put_24_float (lpcm_decoder_t *this, const uint8_t *s, int n, int stream_be, int special_dvd_audio) {
+  size_t samples = special_dvd_audio ? (size_t)(n / 12) * 4 : (size_t)(n / 3);
+  const float *p;
+  int32_t *d;
+  int frames;
+
+  if (this->ibuf_size < samples) {
+    free (this->ibuf);
+    this->ibuf_size = 0;
+    this->ibuf = malloc (samples * sizeof (*this->ibuf));
+    if (!this->ibuf)
+      return;
+    this->ibuf_size = samples;
+  }
+
+  /* MSB aligned int32 first */
+  d = this->ibuf;
+  if (special_dvd_audio) {
+    /* 4 samples high words, then their 4 low bytes. */
+    while (n >= 12) {
+      *d++ = ((uint32_t)s[0] << 24) | ((uint32_t)s[1] << 16) | ((uint32_t)s[ 8] << 8);
+      *d++ = ((uint32_t)s[2] << 24) | ((uint32_t)s[3] << 16) | ((uint32_t)s[ 9] << 8);
+      *d++ = ((uint32_t)s[4] << 24) | ((uint32_t)s[5] << 16) | ((uint32_t)s[10] << 8);
+      *d++ = ((uint32_t)s[6] << 24) | ((uint32_t)s[7] << 16) | ((uint32_t)s[11] << 8);
+      s += 12;
+      n -= 12;
+    }
+  } else if (stream_be) {
+    while (n >= 3) {
+      *d++ = ((uint32_t)s[0] << 24) | ((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 8);
+      s += 3;
+      n -= 3;
+    }
+  } else {
+    while (n >= 3) {
+      *d++ = ((uint32_t)s[2] << 24) | ((uint32_t)s[1] << 16) | ((uint32_t)s[0] << 8);
+      s += 3;
+      n -= 3;
+    }
+  }
+  /* then in place to float. */
+  _x_audio_out_resample_s32tofloat (this->ibuf, (float *)this->ibuf, samples);
+
+  p = (const float *)this->ibuf;
+  frames = samples / this->number_of_channels;
+  while (frames > 0) {
+    audio_buffer_t *audio_buffer = this->stream->audio_out->get_buffer (this->stream->audio_out);
+    int todo = audio_buffer->mem_size / (sizeof (float) * this->number_of_channels);
+
+    if (todo > frames)
+      todo = frames;
+    memcpy (audio_buffer->mem, p, todo * sizeof (float) * this->number_of_channels);
+    p += todo * this->number_of_channels;
+    frames -= todo;
+
+    audio_buffer->vpts       = this->pts;
+    audio_buffer->num_frames = todo;
+    this->pts = 0;
+    this->stream->audio_out->put_buffer (this->stream->audio_out, audio_buffer, this->stream);
+  }
+}
+
 static void lpcm_decode_data (audio_decoder_t *this_gen, buf_element_t *buf) {
 
   lpcm_decoder_t *this = xine_container_of(this_gen, lpcm_decoder_t, audio_decoder);
@@ -200,13 +268,15 @@ static void lpcm_decode_data (audio_decoder_t *this_gen, buf_element_t *buf) {
 
     this->ao_cap_mode=_x_ao_channels2mode(this->number_of_channels);
 
-    /* force 24-bit samples into 16 bits for now */
-    if (this->bits_per_sample == 24)
+    /* 24-bit samples go as float when possible, 16 bits otherwise */
+    this->output_float = 0;
+    if (this->bits_per_sample == 24) {
+      this->output_float = !!(this->stream->audio_out->get_capabilities (this->stream->audio_out) & AO_CAP_FLOAT32);
       this->output_open = (this->stream->audio_out->open) (this->stream->audio_out, this->stream,
-                                               16,
+                                               this->output_float ? 32 : 16,
                                                this->rate,
                                                this->ao_cap_mode) ;
-    else
+    } else
       this->output_open = (this->stream->audio_out->open) (this->stream->audio_out, this->stream,
                                                this->bits_per_sample,
                                                this->rate,
@@ -246,12 +316,18 @@ static void lpcm_decode_data (audio_decoder_t *this_gen, buf_element_t *buf) {
     }
   }
 
-  audio_buffer = this->stream->audio_out->get_buffer (this->stream->audio_out);
-
   /* Swap LPCM samples into native byte order, if necessary */
   buf->type &= 0xffff0000;
   stream_be = ( buf->type == BUF_AUDIO_LPCM_BE );
 
+  if (this->output_float) {
+    lpcm_put_24_float (this, sample_buffer, buf_size, stream_be, special_dvd_audio);
+    this->pts = 0;
+    return;
+  }
+
+  audio_buffer = this->stream->audio_out->get_buffer (this->stream->audio_out);
+
   if( this->bits_per_sample == 16 ){
     if (stream_be != this->cpu_be)
       swab (sample_buffer, audio_buffer->mem, buf_size);
@@ -357,6 +433,7 @@ static void lpcm_dispose (audio_decoder_t *this_gen) {
   this->output_open = 0;
 
   _x_freep (&this->buf);
+  _x_freep (&this->ibuf);
 
   free (this_gen);
 }
@@ -126,6 +126,7 @@ struct ff_video_decoder_s {
   uint8_t           cs_convert_init:1;
   uint8_t           assume_bad_field_picture:1;
   uint8_t           use_bad_frames:1;
+  uint8_t           keyframes_only:1;  /* XINE_PARAM_KEYFRAMES_ONLY */
 
   xine_bmiheader    bih;
   unsigned char    *buf;
@@ -926,6 +927,7 @@ static void init_video_codec (ff_video_decoder_t *this, unsigned int codec_type)
     this->context->flags2 |= AV_CODEC_FLAG2_FAST;
 
   this->context->skip_loop_filter = skip_loop_filter_enum_values[this->class->skip_loop_filter_enum];
+  this->keyframes_only = !!_x_stream_info_get (this->stream, XINE_STREAM_INFO_KEYFRAMES_ONLY);
 
   /* disable threads for SVQ3 */
   if (this->codec->id == CODEC_ID_SVQ3) {
@@ -1929,6 +1931,19 @@ static int decode_video_wrapper (ff_video_decoder_t *this,
   return len;
 }
 
+#if XFF_VIDEO > 1
+/* XINE_STREAM_INFO_VIDEO_DROP_LEVEL: engine says we are too slow. */
+static int ff_skip_frame (ff_video_decoder_t *this) {
+  int level = _x_stream_info_get (this->stream, XINE_STREAM_INFO_VIDEO_DROP_LEVEL);
+
+  if (this->keyframes_only || (level >= 2))
+    return AVDISCARD_NONKEY;
+  if ((this->skipframes > 0) || (level == 1))
+    return AVDISCARD_NONREF;
+  return AVDISCARD_DEFAULT;
+}
+#endif
+
 static void ff_handle_mpeg12_buffer (ff_video_decoder_t *this, buf_element_t *buf) {
 
   vo_frame_t *img;
@@ -1992,7 +2007,7 @@ static void ff_handle_mpeg12_buffer (ff_video_decoder_t *this, buf_element_t *bu
 
     /* skip decoding b frames if too late */
 #if XFF_VIDEO > 1
-    this->context->skip_frame = (this->skipframes > 0) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    this->context->skip_frame = ff_skip_frame (this);
 #else
     this->context->hurry_up = (this->skipframes > 0);
 #endif
@@ -2238,7 +2253,7 @@ static void ff_handle_buffer (ff_video_decoder_t *this, buf_element_t *buf) {
       } else {
         /* skip decoding b frames if too late */
 #if XFF_VIDEO > 1
-	this->context->skip_frame = (this->skipframes > 0) ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        this->context->skip_frame = ff_skip_frame (this);
 #else
         this->context->hurry_up = (this->skipframes > 0);
 #endif
@@ -2712,6 +2727,8 @@ static void ff_reset (video_decoder_t *this_gen) {
 
   this->size = 0;
   this->state = STATE_RESET;
+  /* seek or stream start. time to look again. */
+  this->keyframes_only = !!_x_stream_info_get (this->stream, XINE_STREAM_INFO_KEYFRAMES_ONLY);
 
   if(this->context && this->decoder_ok)
   {
@@ -65,6 +65,7 @@ typedef struct flac_decoder_s {
   size_t         min_size;
 
   int            output_open;
+  int            output_float;
 
 } flac_decoder_t;
 
@@ -122,7 +123,8 @@ flac_write_callback (const FLAC__StreamDecoder *decoder,
     flac_decoder_t *this = (flac_decoder_t *)client_data;
     audio_buffer_t *audio_buffer = NULL;
     unsigned int samples_left = frame->header.blocksize;
-    unsigned int bytes_per_sample = (frame->header.bits_per_sample <= 8) ? 1 : 2;
+    unsigned int bytes_per_sample = (frame->header.bits_per_sample <= 8) ? 1 :
+                                    this->output_float ? 4 : 2;
     unsigned int buf_samples;
     int8_t *data8;
     int16_t *data16;
@@ -159,6 +161,15 @@ flac_write_callback (const FLAC__StreamDecoder *decoder,
         break;
 
       case 24:
+        if (this->output_float) {
+          /* keep all 24 bits. */
+          float *dataf = (float *)audio_buffer->mem;
+
+          for( j=0; j < buf_samples; j++ )
+            for( i=0; i < frame->header.channels; i++ )
+              *dataf++ = (float)buffer[i][j] * (1.0f / 8388608.0f);
+          break;
+        }
         data16 = (int16_t *)audio_buffer->mem;
 
         for( j=0; j < buf_samples; j++ )
@@ -279,10 +290,12 @@ flac_decode_data (audio_decoder_t *this_gen, buf_element_t *buf)
         if (!this->output_open)
         {
             const int bits = bits_per_sample;
+            this->output_float = (bits > 16)
+              && (this->stream->audio_out->get_capabilities (this->stream->audio_out) & AO_CAP_FLOAT32);
             this->output_open = (this->stream->audio_out->open) (
                                             this->stream->audio_out,
                                             this->stream,
-                                            bits > 16 ? 16 : bits,
+                                            this->output_float ? 32 : bits > 16 ? 16 : bits,
                                             sample_rate,
                                             mode);
         }
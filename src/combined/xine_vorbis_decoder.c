@@ -57,6 +57,7 @@ typedef struct vorbis_decoder_s {
   int               output_sampling_rate;
   int               output_open;
   int               output_mode;
+  int               output_float;
 
   ogg_packet        op; /* we must use this struct to sent data to libvorbis */
 
@@ -232,9 +233,11 @@ static void vorbis_decode_data (audio_decoder_t *this_gen, buf_element_t *buf) {
           this->convsize=MAX_NUM_SAMPLES/this->vi.channels;
 
           if (!this->output_open) {
+            /* libvorbis decodes to float, pass that on when possible. */
+            this->output_float = !!(this->stream->audio_out->get_capabilities (this->stream->audio_out) & AO_CAP_FLOAT32);
             this->output_open = (this->stream->audio_out->open) (this->stream->audio_out,
                                                       this->stream,
-                                                      16,
+                                                      this->output_float ? 32 : 16,
                                                       this->vi.rate,
                                                       mode) ;
 
@@ -281,6 +284,17 @@ static void vorbis_decode_data (audio_decoder_t *this_gen, buf_element_t *buf) {
 
         audio_buffer = this->stream->audio_out->get_buffer (this->stream->audio_out);
 
+        if (this->output_float) {
+          /* just interleave */
+          for (i = 0; i < this->vi.channels; i++) {
+            float *ptr = (float *)audio_buffer->mem + i;
+            float *mono = pcm[i];
+            for (j = 0; j < bout; j++) {
+              *ptr = mono[j];
+              ptr += this->vi.channels;
+            }
+          }
+        } else
         /* convert floats to 16 bit signed ints (host order) and
           interleave */
         for(i=0;i<this->vi.channels;i++){
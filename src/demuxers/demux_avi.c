@@ -1631,6 +1631,15 @@ static int demux_avi_next (demux_avi_t *this, int decoder_flags) {
 
   if (do_read_video) {
 
+    /* XINE_PARAM_KEYFRAMES_ONLY: jump over the others using the index. */
+    if (this->has_index && !this->avi->video_posb
+      && _x_stream_info_get (this->stream, XINE_STREAM_INFO_KEYFRAMES_ONLY)) {
+      while ((this->avi->video_posf + 1 < this->avi->video_idx.video_frames)
+        && !(this->avi->video_idx.vindex[this->avi->video_posf].flags & AVIIF_KEYFRAME))
+        this->avi->video_posf++;
+      video_pts = get_video_pts (this, this->avi->video_posf);
+    }
+
     buf = this->video_fifo->buffer_pool_alloc (this->video_fifo);
 
     /* read video */
@@ -2134,7 +2134,7 @@ static int parse_ebml_uint(demux_matroska_t *this, uint8_t *data, uint64_t *num)
     mask >>= 1;
   }
   if (size > 8) {
-    off_t pos = this->input->get_current_pos(this->input);
+    off_t pos = ebml_get_pos(this->ebml);
     xprintf(this->stream->xine, XINE_VERBOSITY_LOG,
             "demux_matroska: Invalid Track Number at position %" PRIdMAX "\n",
             (intmax_t)pos);
@@ -2192,8 +2192,8 @@ static int read_block_data (demux_matroska_t *this, size_t len, size_t offset) {
             "demux_matroska: memory allocation error\n");
     return 0;
   }
-  if (this->input->read (this->input, this->block_data + offset, len) != (int)len) {
-    off_t pos = this->input->get_current_pos(this->input);
+  if (!ebml_read (this->ebml, this->block_data + offset, len)) {
+    off_t pos = ebml_get_pos(this->ebml);
     xprintf(this->stream->xine, XINE_VERBOSITY_LOG,
             "demux_matroska: read error at position %" PRIdMAX "\n",
             (intmax_t)pos);
@@ -2211,7 +2211,9 @@ static int parse_int16(uint8_t *data) {
   return value;
 }
 
-static int parse_block (demux_matroska_t *this, size_t block_size,
+/* block points to the block data. If any track uses header stripping,
+ * it must be preceded by compress_maxlen bytes of writable space. */
+static int parse_block (demux_matroska_t *this, uint8_t *block, size_t block_size,
                         uint64_t cluster_timecode, uint64_t block_duration,
                         int normpos, int is_key) {
   matroska_track_t *track;
@@ -2225,7 +2227,7 @@ static int parse_block (demux_matroska_t *this, size_t block_size,
   int               decoder_flags = 0;
   size_t            headers_len = 0;
 
-  data = this->block_data + this->compress_maxlen;
+  data = block;
   if (!(num_len = parse_ebml_uint(this, data, &track_num)))
     return 0;
   data += num_len;
@@ -2261,6 +2263,11 @@ static int parse_block (demux_matroska_t *this, size_t block_size,
     this->skip_to_timecode = 0;
   }
 
+  /* XINE_PARAM_KEYFRAMES_ONLY: no need to bother the engine with the others. */
+  if (!is_key && (track->track_type == MATROSKA_TRACK_VIDEO)
+    && _x_stream_info_get (this->stream, XINE_STREAM_INFO_KEYFRAMES_ONLY))
+    return 1;
+
   if (block_duration) {
     xduration = (int64_t)block_duration *
                 (int64_t)this->timecode_scale * (int64_t)90 /
@@ -2288,7 +2295,7 @@ static int parse_block (demux_matroska_t *this, size_t block_size,
     if (is_key)
       decoder_flags |= BUF_FLAG_KEYFRAME;
 
-    block_size_left = (this->block_data + block_size + this->compress_maxlen) - data;
+    block_size_left = (block + block_size) - data;
     lprintf("size: %zu, block_size: %zu, block_offset: %zu\n", block_size_left, block_size, this->compress_maxlen);
 
     if (headers_len) {
@@ -2321,7 +2328,7 @@ static int parse_block (demux_matroska_t *this, size_t block_size,
               "demux_matroska: too many frames: %d\n", lace_num);
       return 0;
     }
-    block_size_left = this->block_data + block_size + this->compress_maxlen - data;
+    block_size_left = block + block_size - data;
 
     switch (lacing) {
       case MATROSKA_XIPH_LACING: {
@@ -2453,18 +2460,25 @@ static int parse_simpleblock(demux_matroska_t *this, size_t block_len, uint64_t
   off_t file_len          = 0;
   int normpos             = 0;
   int is_key              = 1;
+  uint8_t *block          = NULL;
 
   lprintf("simpleblock\n");
-  block_pos = this->input->get_current_pos(this->input);
+  block_pos = ebml_get_pos(this->ebml);
   file_len = this->input->get_length(this->input);
   if( file_len )
     normpos = (int) ( (double) block_pos * 65535 / file_len );
 
-  if (!read_block_data(this, block_len, this->compress_maxlen))
-    return 0;
+  /* parse in place when there is no header stripping to prepend */
+  if (!this->compress_maxlen)
+    block = ebml_map(this->ebml, block_len);
+  if (!block) {
+    if (!read_block_data(this, block_len, this->compress_maxlen))
+      return 0;
+    block = this->block_data + this->compress_maxlen;
+  }
 
     /* we have the duration, we can parse the block now */
-  if (!parse_block(this, block_len, cluster_timecode, block_duration,
+  if (!parse_block(this, block, block_len, cluster_timecode, block_duration,
                    normpos, is_key))
     return 0;
   return 1;
@@ -2494,7 +2508,7 @@ static int parse_block_group(demux_matroska_t *this,
     switch (elem.id) {
       case MATROSKA_ID_CL_BLOCK:
         lprintf("block\n");
-        block_pos = this->input->get_current_pos(this->input);
+        block_pos = ebml_get_pos(ebml);
         block_len = elem.len;
         file_len = this->input->get_length(this->input);
         if( file_len )
@@ -2528,8 +2542,8 @@ static int parse_block_group(demux_matroska_t *this,
     return 0;
 
   /* we have the duration, we can parse the block now */
-  if (!parse_block(this, block_len, cluster_timecode, block_duration,
-                   normpos, is_key))
+  if (!parse_block(this, this->block_data + this->compress_maxlen, block_len,
+                   cluster_timecode, block_duration, normpos, is_key))
     return 0;
   return 1;
 }
@@ -2735,15 +2749,17 @@ static int parse_seek_entry(demux_matroska_t *this) {
     seek_pos = this->segment.start + pos;
 
     if ((seek_pos > 0) && (seek_pos < this->input->get_length(this->input))) {
-      ebml_parser_t ebml_bak;
+      ebml_elem_t stack_bak[EBML_STACK_SIZE];
+      int level_bak;
 
       /* backup current state */
-      current_pos = this->input->get_current_pos(this->input);
-      memcpy(&ebml_bak, this->ebml, sizeof(ebml_parser_t));   /* FIXME */
+      current_pos = ebml_get_pos(this->ebml);
+      memcpy(stack_bak, this->ebml->elem_stack, sizeof(stack_bak));
+      level_bak = this->ebml->level;
 
       /* seek and parse the top_level element */
       this->ebml->level = 1;
-      if (this->input->seek(this->input, seek_pos, SEEK_SET) < 0) {
+      if (ebml_seek(this->ebml, seek_pos, SEEK_SET) < 0) {
         xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
                 "demux_matroska: failed to seek to pos: %" PRIdMAX "\n",
                 (intmax_t)seek_pos);
@@ -2753,8 +2769,9 @@ static int parse_seek_entry(demux_matroska_t *this) {
         return 0;
 
       /* restore old state */
-      memcpy(this->ebml, &ebml_bak, sizeof(ebml_parser_t));   /* FIXME */
-      if (this->input->seek(this->input, current_pos, SEEK_SET) < 0) {
+      memcpy(this->ebml->elem_stack, stack_bak, sizeof(stack_bak));
+      this->ebml->level = level_bak;
+      if (ebml_seek(this->ebml, current_pos, SEEK_SET) < 0) {
         xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
                 "demux_matroska: failed to seek to pos: %" PRIdMAX "\n",
                 (intmax_t)current_pos);
@@ -2818,7 +2835,7 @@ static int parse_top_level_head(demux_matroska_t *this, int *next_level) {
   off_t current_pos;
 
 
-  current_pos = this->input->get_current_pos(this->input);
+  current_pos = ebml_get_pos(ebml);
   lprintf("current_pos: %" PRIdMAX "\n", (intmax_t)current_pos);
 
   if (!ebml_read_elem_head(ebml, &elem))
@@ -2939,16 +2956,16 @@ static int parse_top_level(demux_matroska_t *this, int *next_level) {
       break;
     case MATROSKA_ID_CLUSTER:
       lprintf("Cluster\n");
-      cluster_pos = this->input->get_current_pos(this->input);
+      cluster_pos = ebml_get_pos(ebml);
       cluster_len = elem.len;
       if (!ebml_read_master (ebml, &elem))
         return 0;
       if (!parse_cluster(this)) {
-        off_t fail_pos = this->input->get_current_pos(this->input);
+        off_t fail_pos = ebml_get_pos(ebml);
         off_t skip = cluster_pos + cluster_len - fail_pos;
         xprintf(ebml->xine, XINE_VERBOSITY_LOG, LOG_MODULE
                 "parse_cluster failed ! Skipping %" PRId64 " bytes\n", (int64_t)skip);
-        if (this->input->seek(ebml->input, skip, SEEK_CUR) < 0) {
+        if (ebml_seek(ebml, skip, SEEK_CUR) < 0) {
           xprintf(ebml->xine, XINE_VERBOSITY_LOG,
                   "seek error (skipping %" PRId64 " bytes)\n", (int64_t)skip);
         }
@@ -3067,7 +3084,7 @@ static void demux_matroska_send_headers (demux_plugin_t *this_gen) {
 
   /* seek back to the beginning of the segment */
   next_level = 1;
-  if (this->input->seek(this->input, this->segment.start, SEEK_SET) < 0) {
+  if (ebml_seek(this->ebml, this->segment.start, SEEK_SET) < 0) {
     xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
             "demux_matroska: failed to seek to pos: %" PRIdMAX "\n",
             (intmax_t)this->segment.start);
@@ -3087,7 +3104,7 @@ static void demux_matroska_send_headers (demux_plugin_t *this_gen) {
 
   /* seek back to the beginning of the segment */
   next_level = 1;
-  if (this->input->seek(this->input, this->segment.start, SEEK_SET) < 0) {
+  if (ebml_seek(this->ebml, this->segment.start, SEEK_SET) < 0) {
     xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
             "demux_matroska: failed to seek to pos: %" PRIdMAX "\n",
             (intmax_t)this->segment.start);
@@ -3220,7 +3237,7 @@ static int demux_matroska_seek (demux_plugin_t *this_gen,
             start_pos ? (intmax_t)start_pos : (intmax_t)start_time,
             index->track_num, index->timecode[entry], (intmax_t)index->pos[entry]);
 
-    if (this->input->seek(this->input, index->pos[entry], SEEK_SET) < 0)
+    if (ebml_seek(this->ebml, index->pos[entry], SEEK_SET) < 0)
       this->status = DEMUX_FINISHED;
 
     /* we always seek to the ebml level 1 */
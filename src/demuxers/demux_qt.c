@@ -3495,6 +3495,13 @@ static int demux_qt_send_chunk(demux_plugin_t *this_gen) {
       return this->status;
     }
 
+    /* XINE_PARAM_KEYFRAMES_ONLY: do not even read the others. */
+    if (!QTF_KEYFRAME(trak->frames[i])
+      && _x_stream_info_get (this->stream, XINE_STREAM_INFO_KEYFRAMES_ONLY)) {
+      this->status = DEMUX_OK;
+      return this->status;
+    }
+
     remaining_sample_bytes = trak->frames[i].size;
     if ((off_t)QTF_OFFSET(trak->frames[i]) != current_pos) {
       if (this->input->seek (this->input, QTF_OFFSET(trak->frames[i]), SEEK_SET) < 0) {
@@ -478,6 +478,7 @@ typedef struct {
   uint8_t          resume;
   int              corrupted_pes;
   int              pes_bytes_left; /* butes left if PES packet size is known */
+  uint32_t         frame_flags;    /* BUF_FLAG_KEYFRAME, BUF_FLAG_DISPOSABLE */
 
   int              input_normpos;
   int              input_time;
@@ -689,6 +690,7 @@ static int demux_ts_dynamic_pmt_find (demux_ts_t *this,
     m->pts            = 0;
     m->keep           = 1;
     m->resume         = 0;
+    m->frame_flags    = 0;
     if (type == BUF_AUDIO_BASE) {
       xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "demux_ts: new audio pid %d\n", pid);
       /* allocate new audio track as well */
@@ -1023,7 +1025,7 @@ static void demux_ts_send_buffer (demux_ts_t *this, demux_ts_media *m, int flags
     }
     m->buf->content = m->buf->mem;
     m->buf->type = m->type;
-    m->buf->decoder_flags |= flags;
+    m->buf->decoder_flags |= flags | m->frame_flags;
     m->buf->pts = m->pts;
     m->buf->decoder_info[0] = 1;
     m->buf->extra_info->input_normpos = m->input_normpos;
@@ -1367,6 +1369,7 @@ static int demux_ts_parse_pes_header (demux_ts_t *this, demux_ts_media *m,
   uint32_t       header_len;
   int64_t        pts;
   uint32_t       stream_id;
+  uint32_t       frame_flags = 0;
 
   if (this->stream->xine->verbosity == 4)
     demux_ts_hexdump (this, "demux_ts: PES header", buf, buf[8] + 9);
@@ -1462,7 +1465,12 @@ static int demux_ts_parse_pes_header (demux_ts_t *this, demux_ts_media *m,
 
   if ((m->pid == this->videoPid) && this->get_frametype) {
     frametype_t t = this->get_frametype (p + header_len, packet_len - header_len);
+    /* mpeg and vc1 B frames are never used as a reference.
+     * h.264 and hevc ones may be, leave these to the decoder. */
+    if ((t == FRAMETYPE_B) && ((this->get_frametype == frametype_mpeg) || (this->get_frametype == frametype_vc1)))
+      frame_flags = BUF_FLAG_DISPOSABLE;
     if (t == FRAMETYPE_I) {
+      frame_flags = BUF_FLAG_KEYFRAME;
       if (!this->last_keyframe_time) {
         this->last_keyframe_time = pts;
       } else if (pts) {
@@ -1498,8 +1506,11 @@ static int demux_ts_parse_pes_header (demux_ts_t *this, demux_ts_media *m,
       m->resume &= ~PES_RESUME;
     }
   }
-  /* now that finished previous buf is sent, set new pts. */
+  /* now that finished previous buf is sent, set new pts.
+   * a resumed PES continues the same frame. */
   m->pts = pts;
+  if (m->resume & PES_FLUSHED)
+    m->frame_flags = frame_flags;
   /* allocate the buffer here, as pes_header needs a valid buf for dvbsubs */
   if (!m->buf)
     m->buf = m->fifo->buffer_pool_alloc (m->fifo);
@@ -3149,6 +3160,7 @@ static int demux_ts_seek (demux_plugin_t *this_gen,
     m->corrupted_pes  = 1;
     m->pts            = 0;
     m->resume         = 0;
+    m->frame_flags    = 0;
   }
 
   if( !playing ) {
@@ -38,13 +38,29 @@
 #include "ebml.h"
 
 
+/* read window size for inputs that can deliver data ahead of time.
+ * start small so that content detection does not read too much. */
+#define EBML_READ_AHEAD       (128 << 10)
+#define EBML_READ_AHEAD_START (4 << 10)
+
 ebml_parser_t *new_ebml_parser (xine_t *xine, input_plugin_t *input) {
   ebml_parser_t *ebml;
 
   ebml = calloc(1, sizeof(ebml_parser_t));
   if (ebml) {
+    uint32_t caps = input->get_capabilities (input);
+
     ebml->xine                 = xine;
     ebml->input                = input;
+    ebml->buf_start            = input->get_current_pos (input);
+    /* a live stream would block until the window is full */
+    if ((caps & INPUT_CAP_SEEKABLE) && !(caps & INPUT_CAP_LIVE)) {
+      ebml->buf = malloc (EBML_READ_AHEAD);
+      if (ebml->buf) {
+        ebml->buf_size = EBML_READ_AHEAD;
+        ebml->read_ahead = EBML_READ_AHEAD_START;
+      }
+    }
   }
   return ebml;
 }
@@ -52,12 +68,149 @@ ebml_parser_t *new_ebml_parser (xine_t *xine, input_plugin_t *input) {
 
 void dispose_ebml_parser(ebml_parser_t *ebml) {
   if (ebml) {
+    xprintf (ebml->xine, XINE_VERBOSITY_DEBUG,
+             "ebml: %" PRIu64 " input reads for %" PRIu64 " bytes.\n",
+             ebml->num_reads, ebml->num_bytes);
     _x_freep(&ebml->doctype);
+    free(ebml->buf);
     free(ebml);
   }
 }
 
 
+/*
+ * buffered input access.
+ * buf holds input data from buf_start to buf_start + buf_len,
+ * buf_pos is the current read position within.
+ */
+
+static int ebml_input_read (ebml_parser_t *ebml, void *buf, size_t len) {
+  off_t got = ebml->input->read (ebml->input, buf, len);
+  ebml->num_reads++;
+  if (got > 0)
+    ebml->num_bytes += got;
+  return got < 0 ? 0 : got;
+}
+
+/* make at least need bytes available in the window. */
+static int ebml_fill (ebml_parser_t *ebml, size_t need) {
+  size_t avail = ebml->buf_len - ebml->buf_pos;
+  size_t want;
+  int got;
+
+  if (avail >= need)
+    return 1;
+  if (need > ebml->buf_size)
+    return 0;
+
+  /* move the remaining bytes to the start of the window */
+  if (ebml->buf_pos) {
+    if (avail)
+      memmove (ebml->buf, ebml->buf + ebml->buf_pos, avail);
+    ebml->buf_start += ebml->buf_pos;
+    ebml->buf_pos = 0;
+    ebml->buf_len = avail;
+  }
+
+  want = ebml->read_ahead;
+  if (want < need)
+    want = need;
+  want -= avail;
+  if (ebml->read_ahead < ebml->buf_size)
+    ebml->read_ahead <<= 1;
+  got = ebml_input_read (ebml, ebml->buf + avail, want);
+  ebml->buf_len = avail + got;
+
+  return ebml->buf_len >= need;
+}
+
+int ebml_read (ebml_parser_t *ebml, void *buf, size_t len) {
+  size_t avail;
+
+  if (!ebml->buf)
+    return ebml_input_read (ebml, buf, len) == (int)len;
+
+  if (len < ebml->buf_size && ebml_fill (ebml, len)) {
+    memcpy (buf, ebml->buf + ebml->buf_pos, len);
+    ebml->buf_pos += len;
+    return 1;
+  }
+
+  /* large or final read: drain the window, then read directly */
+  avail = ebml->buf_len - ebml->buf_pos;
+  if (avail > len)
+    avail = len;
+  memcpy (buf, ebml->buf + ebml->buf_pos, avail);
+  ebml->buf_start += ebml->buf_len;
+  ebml->buf_pos = ebml->buf_len = 0;
+  if (avail == len)
+    return 1;
+  len -= avail;
+  if ((size_t)ebml_input_read (ebml, (uint8_t *)buf + avail, len) != len) {
+    ebml->buf_start = ebml->input->get_current_pos (ebml->input);
+    return 0;
+  }
+  ebml->buf_start += len;
+  return 1;
+}
+
+uint8_t *ebml_map (ebml_parser_t *ebml, size_t len) {
+  uint8_t *p;
+
+  if (!ebml->buf || (len >= ebml->buf_size) || !ebml_fill (ebml, len))
+    return NULL;
+  p = ebml->buf + ebml->buf_pos;
+  ebml->buf_pos += len;
+  return p;
+}
+
+off_t ebml_get_pos (ebml_parser_t *ebml) {
+  if (!ebml->buf)
+    return ebml->input->get_current_pos (ebml->input);
+  return ebml->buf_start + ebml->buf_pos;
+}
+
+off_t ebml_seek (ebml_parser_t *ebml, off_t offset, int origin) {
+  off_t target, input_pos, res;
+
+  if (!ebml->buf)
+    return ebml->input->seek (ebml->input, offset, origin);
+
+  if (origin == SEEK_CUR)
+    target = ebml->buf_start + ebml->buf_pos + offset;
+  else if (origin == SEEK_SET)
+    target = offset;
+  else {
+    /* SEEK_END: let the input resolve it */
+    res = ebml->input->seek (ebml->input, offset, origin);
+    if (res >= 0) {
+      ebml->buf_start = res;
+      ebml->buf_pos = ebml->buf_len = 0;
+    }
+    return res;
+  }
+
+  /* inside the window */
+  if ((target >= ebml->buf_start) && (target <= ebml->buf_start + (off_t)ebml->buf_len)) {
+    ebml->buf_pos = target - ebml->buf_start;
+    return target;
+  }
+
+  /* relative forward seeks work on slow seekable inputs too */
+  input_pos = ebml->buf_start + ebml->buf_len;
+  if (target >= input_pos)
+    res = ebml->input->seek (ebml->input, target - input_pos, SEEK_CUR);
+  else
+    res = ebml->input->seek (ebml->input, target, SEEK_SET);
+  if (res < 0)
+    return res;
+
+  ebml->buf_start = res;
+  ebml->buf_pos = ebml->buf_len = 0;
+  return res;
+}
+
+
 uint32_t ebml_get_next_level(ebml_parser_t *ebml, ebml_elem_t *elem) {
   ebml_elem_t *parent_elem;
 
@@ -85,7 +238,7 @@ static int ebml_read_elem_id(ebml_parser_t *ebml, uint32_t *id) {
   int       size = 1;
   int       i;
 
-  if (ebml->input->read(ebml->input, data, 1) != 1) {
+  if (!ebml_read (ebml, data, 1)) {
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: read error\n");
     return 0;
@@ -98,7 +251,7 @@ static int ebml_read_elem_id(ebml_parser_t *ebml, uint32_t *id) {
     mask >>= 1;
   }
   if (size > 4) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: invalid EBML ID size (0x%x) at position %" PRIdMAX "\n",
             data[0], (intmax_t)pos);
@@ -106,8 +259,8 @@ static int ebml_read_elem_id(ebml_parser_t *ebml, uint32_t *id) {
   }
 
   /* read the rest of the id */
-  if (ebml->input->read(ebml->input, data + 1, size - 1) != (size - 1)) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+  if (!ebml_read (ebml, data + 1, size - 1)) {
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: read error at position %" PRIdMAX "\n", (intmax_t)pos);
     return 0;
@@ -129,8 +282,8 @@ static int ebml_read_elem_len(ebml_parser_t *ebml, uint64_t *len) {
   uint64_t value;
   int i;
 
-  if (ebml->input->read(ebml->input, data, 1) != 1) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+  if (!ebml_read (ebml, data, 1)) {
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: read error at position %" PRIdMAX "\n", (intmax_t)pos);
     return 0;
@@ -143,7 +296,7 @@ static int ebml_read_elem_len(ebml_parser_t *ebml, uint64_t *len) {
     mask >>= 1;
   }
   if (size > 8) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: Invalid EBML length size (0x%x) at position %" PRIdMAX "\n",
              data[0], (intmax_t)pos);
@@ -160,8 +313,8 @@ static int ebml_read_elem_len(ebml_parser_t *ebml, uint64_t *len) {
     ff_bytes = 0;
 
   /* read the rest of the len */
-  if (ebml->input->read(ebml->input, data + 1, size - 1) != (size - 1)) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+  if (!ebml_read (ebml, data + 1, size - 1)) {
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: read error at position %" PRIdMAX "\n", (intmax_t)pos);
     return 0;
@@ -183,8 +336,8 @@ static int ebml_read_elem_len(ebml_parser_t *ebml, uint64_t *len) {
 
 static int ebml_read_elem_data(ebml_parser_t *ebml, void *buf, int64_t len) {
 
-  if (ebml->input->read(ebml->input, buf, len) != len) {
-    off_t pos = ebml->input->get_current_pos(ebml->input);
+  if (!ebml_read (ebml, buf, len)) {
+    off_t pos = ebml_get_pos (ebml);
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: read error at position %" PRIdMAX "\n", (intmax_t)pos);
     return 0;
@@ -195,7 +348,7 @@ static int ebml_read_elem_data(ebml_parser_t *ebml, void *buf, int64_t len) {
 
 
 int ebml_skip(ebml_parser_t *ebml, ebml_elem_t *elem) {
-  if (ebml->input->seek(ebml->input, elem->len, SEEK_CUR) < 0) {
+  if (ebml_seek (ebml, elem->len, SEEK_CUR) < 0) {
     xprintf(ebml->xine, XINE_VERBOSITY_LOG,
             "ebml: seek error (failed skipping %" PRId64 " bytes)\n", (int64_t)elem->len);
     return 0;
@@ -211,7 +364,7 @@ int ebml_read_elem_head(ebml_parser_t *ebml, ebml_elem_t *elem) {
 
   int ret_len = ebml_read_elem_len(ebml, &elem->len);
 
-  elem->start = ebml->input->get_current_pos(ebml->input);
+  elem->start = ebml_get_pos (ebml);
 
   return (ret_id && ret_len);
 }
@@ -62,6 +62,18 @@ typedef struct ebml_parser_s {
   uint64_t               doctype_version;
   uint64_t               doctype_read_version;
 
+  /* read window, see ebml_read () */
+  uint8_t               *buf;
+  size_t                 buf_size;
+  size_t                 buf_len;
+  size_t                 buf_pos;
+  off_t                  buf_start;
+  size_t                 read_ahead;
+
+  /* statistics */
+  uint64_t               num_reads;
+  uint64_t               num_bytes;
+
 } ebml_parser_t;
 
 
@@ -69,6 +81,19 @@ ebml_parser_t *new_ebml_parser (xine_t *xine, input_plugin_t *input) XINE_MALLOC
 
 void dispose_ebml_parser (ebml_parser_t *ebml);
 
+/* Buffered input access. Seekable inputs are read in large windows,
+ * all demuxer reads and seeks shall go through these functions. */
+int ebml_read(ebml_parser_t *ebml, void *buf, size_t len);
+
+/* Returns a pointer to the next len bytes inside the read window and
+ * advances past them, or NULL if they do not fit. The data stays valid
+ * until the next read, map or seek. */
+uint8_t *ebml_map(ebml_parser_t *ebml, size_t len);
+
+off_t ebml_get_pos(ebml_parser_t *ebml);
+
+off_t ebml_seek(ebml_parser_t *ebml, off_t offset, int origin);
+
 /* check EBML header */
 int ebml_check_header(ebml_parser_t *read);
 
@@ -59,6 +59,22 @@ static inline int _private_gettimeofday( struct timeval *tv, void *tz )
 #include <io.h> /* read() */
 #define lseek64 _lseeki64
 #endif
+
+/* The read ahead cache of libdvdnav reads from its own thread, while
+ * ifo and udf reads happen in the main thread. Both share one device
+ * with a seek position and a css title, so make seek + read atomic. */
+#ifndef WIN32
+#include <pthread.h>
+#define DVD_LOCK_INIT(dvd)    pthread_mutex_init( &(dvd)->lock, NULL )
+#define DVD_LOCK_DESTROY(dvd) pthread_mutex_destroy( &(dvd)->lock )
+#define DVD_LOCK(dvd)         pthread_mutex_lock( &(dvd)->lock )
+#define DVD_UNLOCK(dvd)       pthread_mutex_unlock( &(dvd)->lock )
+#else
+#define DVD_LOCK_INIT(dvd)
+#define DVD_LOCK_DESTROY(dvd)
+#define DVD_LOCK(dvd)
+#define DVD_UNLOCK(dvd)
+#endif
  
 #if defined(__FreeBSD_kernel__) || defined(__OpenBSD__) || defined(__NetBSD__) || defined(__bsdi__)|| defined(__DARWIN__)
 #define SYS_BSD 1
@@ -98,6 +114,10 @@ struct dvd_reader_s {
     /* Filesystem cache */
     int udfcache_level; /* 0 - turned off, 1 - on */
     void *udfcache;
+
+#ifndef WIN32
+    pthread_mutex_t lock;
+#endif
 };
 
 struct dvd_file_s {
@@ -250,6 +270,7 @@ static dvd_reader_t *DVDOpenImageFile( const char *location, int have_css )
     
     dvd->udfcache_level = DEFAULT_UDF_CACHE_LEVEL;
     dvd->udfcache = NULL;
+    DVD_LOCK_INIT( dvd );
 
     if( have_css ) {
       /* Only if DVDCSS_METHOD = title, a bit if it's disc or if
@@ -275,6 +296,7 @@ static dvd_reader_t *DVDOpenPath( const char *path_root )
 
     dvd->udfcache_level = DEFAULT_UDF_CACHE_LEVEL;
     dvd->udfcache = NULL;
+    DVD_LOCK_INIT( dvd );
     
     dvd->css_state = 0; /* Only used in the UDF path */
     dvd->css_title = 0; /* Only matters in the UDF path */
@@ -553,6 +575,7 @@ void DVDClose( dvd_reader_t *dvd )
         if( dvd->dev ) dvdinput_close( dvd->dev );
         if( dvd->path_root ) free( dvd->path_root );
 	if( dvd->udfcache ) FreeUDFCache( dvd->udfcache );
+        DVD_LOCK_DESTROY( dvd );
         free( dvd );
     }
 }
@@ -885,10 +908,9 @@ void DVDCloseFile( dvd_file_t *dvd_file )
     }
 }
 
-/* Internal, but used from dvd_udf.c */
-int UDFReadBlocksRaw( dvd_reader_t *device, uint32_t lb_number,
-			 size_t block_count, unsigned char *data, 
-			 int encrypted )
+static int UDFReadBlocksRawUnlocked( dvd_reader_t *device, uint32_t lb_number,
+				     size_t block_count, unsigned char *data,
+				     int encrypted )
 {
    int ret;
    if( !device->dev ) {
@@ -907,6 +929,18 @@ int UDFReadBlocksRaw( dvd_reader_t *device, uint32_t lb_number,
    return ret;
 }
 
+/* Internal, but used from dvd_udf.c */
+int UDFReadBlocksRaw( dvd_reader_t *device, uint32_t lb_number,
+			 size_t block_count, unsigned char *data, 
+			 int encrypted )
+{
+   int ret;
+   DVD_LOCK( device );
+   ret = UDFReadBlocksRawUnlocked( device, lb_number, block_count, data, encrypted );
+   DVD_UNLOCK( device );
+   return ret;
+}
+
 /* This is using a single input and starting from 'dvd_file->lb_start' offset.
  *
  * Reads 'block_count' blocks from 'dvd_file' at block offset 'offset'
@@ -917,8 +951,8 @@ static int DVDReadBlocksUDF( dvd_file_t *dvd_file, uint32_t offset,
 			     size_t block_count, unsigned char *data,
 			     int encrypted )
 {
-    return UDFReadBlocksRaw( dvd_file->dvd, dvd_file->lb_start + offset,
-			     block_count, data, encrypted );
+    return UDFReadBlocksRawUnlocked( dvd_file->dvd, dvd_file->lb_start + offset,
+				     block_count, data, encrypted );
 }
 
 /* This is using possibly several inputs and starting from an offset of '0'.
@@ -1003,6 +1037,7 @@ ssize_t DVDReadBlocks( dvd_file_t *dvd_file, int offset,
     if( dvd_file == NULL || offset < 0 || data == NULL )
       return -1;
     
+    DVD_LOCK( dvd_file->dvd );
     /* Hack, and it will still fail for multiple opens in a threaded app ! */
     if( dvd_file->dvd->css_title != dvd_file->css_title ) {
       dvd_file->dvd->css_title = dvd_file->css_title;
@@ -1022,6 +1057,7 @@ ssize_t DVDReadBlocks( dvd_file_t *dvd_file, int offset,
 	ret = DVDReadBlocksPath( dvd_file, (unsigned int)offset, 
 				 block_count, data, DVDINPUT_READ_DECRYPT );
     }
+    DVD_UNLOCK( dvd_file->dvd );
     
     return (ssize_t)ret;
 }
@@ -1085,6 +1121,7 @@ ssize_t DVDReadBytes( dvd_file_t *dvd_file, void *data, size_t byte_size )
         return 0;
     }
     
+    DVD_LOCK( dvd_file->dvd );
     if( dvd_file->dvd->isImageFile ) {
 	ret = DVDReadBlocksUDF( dvd_file, (uint32_t) seek_sector, 
 				(size_t) numsec, secbuf, DVDINPUT_NOFLAGS );
@@ -1092,6 +1129,7 @@ ssize_t DVDReadBytes( dvd_file_t *dvd_file, void *data, size_t byte_size )
 	ret = DVDReadBlocksPath( dvd_file, seek_sector, 
 				 (size_t) numsec, secbuf, DVDINPUT_NOFLAGS );
     }
+    DVD_UNLOCK( dvd_file->dvd );
 
     if( ret != (int) numsec ) {
         free( secbuf_base );
@@ -39,6 +39,9 @@
 static dvdnav_status_t dvdnav_clear(dvdnav_t * this) {
   /* clear everything except file, vm, mutex, readahead */
 
+  /* stop reading ahead from the file first. */
+  dvdnav_read_cache_clear(this->cache);
+
   if (this->file) DVDCloseFile(this->file);
   this->file = NULL;
 
@@ -54,8 +57,6 @@ static dvdnav_status_t dvdnav_clear(dvdnav_t * this) {
   this->spu_clut_changed = 0;
   this->started = 0;
 
-  dvdnav_read_cache_clear(this->cache);
-  
   return DVDNAV_STATUS_OK;
 }
 
@@ -124,6 +125,7 @@ dvdnav_status_t dvdnav_close(dvdnav_t *this) {
   }
 
   if (this->file) {
+    dvdnav_read_cache_clear(this->cache);
     DVDCloseFile(this->file);
 #ifdef LOG_DEBUG
     fprintf(MSG_OUT, "libdvdnav: close:file closing\n");
@@ -515,6 +517,7 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
     int32_t vtsN;
     dvdnav_vts_change_event_t *vts_event = (dvdnav_vts_change_event_t *)*buf;
     
+    dvdnav_read_cache_clear(this->cache);
     if(this->file) {
       DVDCloseFile(this->file);
       this->file = NULL;
@@ -546,7 +549,6 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
     
     this->position_current.vts = this->position_next.vts; 
     this->position_current.domain = this->position_next.domain;
-    dvdnav_read_cache_clear(this->cache);
     this->file = DVDOpenFile(vm_get_dvd_reader(this->vm), vtsN, domain);
     vts_event->new_vtsN = this->position_next.vts; 
     vts_event->new_domain = this->position_next.domain; 
@@ -771,6 +773,11 @@ dvdnav_status_t dvdnav_get_next_cache_block(dvdnav_t *this, uint8_t **buf,
      * This improves pre-caching, because the VOBU will almost certainly be read entirely.
      */
     dvdnav_pre_cache_blocks(this->cache, this->vobu.vobu_start+1, this->vobu.vobu_length+1);
+    /* The NAV packet also tells where the next VOBU starts. Assume it has
+     * a similar size, and have that read in the background too. */
+    if (this->vobu.vobu_next != SRI_END_OF_CELL)
+      dvdnav_prefetch_blocks(this->cache, this->vobu.vobu_start + this->vobu.vobu_next,
+                             this->vobu.vobu_length + 2);
     
     /* release NAV menu filter, when we reach the same NAV packet again */
     if (this->last_cmd_nav_lbn == this->pci.pci_gi.nv_pck_lbn)
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * read a dvd title through libdvdnav like input_dvd does, and report
+ * how long dvdnav_get_next_cache_block () blocks the caller, together
+ * with the read cache statistics.
+ *
+ * usage: dvdnav_bench [-n] [-r mbit/s] [-m MB] <image or device> [title]
+ *   -n  no read ahead
+ *   -r  consume at this rate like playback does, 0 = as fast as possible
+ *   -m  stop after this many MB
+ *
+ * drop the page cache before comparing runs on a local image, eg
+ * "echo 1 > /proc/sys/vm/drop_caches".
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "dvdnav_internal.h"
+#include "read_cache.h"
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main (int argc, char **argv) {
+  dvdnav_t *nav;
+  dvdnav_read_cache_stats_t stats;
+  uint8_t *mem, *buf;
+  double rate = 0, max_mb = 0, start, worst = 0, total_wait = 0;
+  int read_ahead = 1, title = 1, opt, stop = 0;
+  unsigned int blocks = 0, slow = 0;
+
+  while ((opt = getopt (argc, argv, "nr:m:")) != -1) {
+    switch (opt) {
+      case 'n': read_ahead = 0; break;
+      case 'r': rate = atof (optarg) * 1000000.0 / 8.0; break;
+      case 'm': max_mb = atof (optarg); break;
+      default:
+        fprintf (stderr, "usage: %s [-n] [-r mbit/s] [-m MB] <image or device> [title]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf (stderr, "usage: %s [-n] [-r mbit/s] [-m MB] <image or device> [title]\n", argv[0]);
+    return 1;
+  }
+  if (optind + 1 < argc)
+    title = atoi (argv[optind + 1]);
+
+  if (dvdnav_open (&nav, argv[optind]) != DVDNAV_STATUS_OK) {
+    fprintf (stderr, "cannot open %s.\n", argv[optind]);
+    return 1;
+  }
+  dvdnav_set_readahead_flag (nav, read_ahead);
+  dvdnav_set_PGC_positioning_flag (nav, 1);
+  if (dvdnav_title_play (nav, title) != DVDNAV_STATUS_OK) {
+    fprintf (stderr, "cannot play title %d: %s\n", title, dvdnav_err_to_string (nav));
+    dvdnav_close (nav);
+    return 1;
+  }
+
+  mem = malloc (DVD_VIDEO_LB_LEN);
+  start = _now ();
+  while (mem && !stop) {
+    int32_t event, len;
+    double t = _now (), d;
+
+    buf = mem;
+    if (dvdnav_get_next_cache_block (nav, &buf, &event, &len) != DVDNAV_STATUS_OK) {
+      fprintf (stderr, "read error: %s\n", dvdnav_err_to_string (nav));
+      break;
+    }
+    d = _now () - t;
+    switch (event) {
+      case DVDNAV_BLOCK_OK:
+        blocks++;
+        total_wait += d;
+        if (worst < d)
+          worst = d;
+        if (d > 0.01)
+          slow++;
+        if (max_mb > 0 && blocks * (double)DVD_VIDEO_LB_LEN >= max_mb * 1048576.0)
+          stop = 1;
+        if (rate > 0) {
+          /* sleep until this block is due. */
+          double due = start + blocks * (double)DVD_VIDEO_LB_LEN / rate - _now ();
+          if (due > 0)
+            usleep (due * 1e6);
+        }
+        break;
+      case DVDNAV_STILL_FRAME:
+        dvdnav_still_skip (nav);
+        break;
+      case DVDNAV_WAIT:
+        dvdnav_wait_skip (nav);
+        break;
+      case DVDNAV_STOP:
+        stop = 1;
+        break;
+      default: ;
+    }
+    if (buf != mem)
+      dvdnav_free_cache_block (nav, buf);
+  }
+
+  dvdnav_read_cache_stats (nav->cache, &stats);
+  printf ("read ahead %s: %.1f MB in %.2f s, blocked %.3f s, worst %.1f ms, %u blocks over 10 ms.\n",
+    read_ahead ? "on" : "off", blocks * (double)DVD_VIDEO_LB_LEN / 1048576.0, _now () - start,
+    total_wait, worst * 1e3, slow);
+  printf ("cache: %u hits, %u waits, %u misses, %u sectors read ahead, %u unused.\n",
+    stats.hits, stats.waits, stats.misses, stats.prefetched, stats.unused);
+
+  dvdnav_close (nav);
+  free (mem);
+  return 0;
+}
@@ -19,9 +19,11 @@
  * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA
  */
 /*
- * There was a multithreaded read ahead cache in here for some time, but
- * it had only been used for a short time. If you want to have a look at it,
- * search the CVS attic.
+ * A prefetch thread fills the cache chunks in the background: the VOBU
+ * announced by the last NAV packet, and the VOBU following it (see
+ * dvdnav_prefetch_blocks()). A reader only waits when it overtakes the
+ * thread, and reads by itself when nothing was planned for a sector.
+ * Without threads, the reader fills the planned chunks on demand.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -34,33 +36,53 @@
 #include <sys/time.h>
 #include <time.h>
 
-#define READ_CACHE_CHUNKS 10
+#define READ_CACHE_CHUNKS 16
 
 /* all cache chunks must be memory aligned to allow use of raw devices */
 #define ALIGNMENT 2048
 
-#define READ_AHEAD_SIZE_MIN 4
-#define READ_AHEAD_SIZE_MAX 512
+/* chunks get at least this many sectors. VOBUs rarely exceed 500. */
+#define READ_CACHE_CHUNK_MIN 1024
+
+/* read this many sectors at once, so the device is never blocked for long. */
+#define READ_CACHE_STEP 64
+
+#ifndef WIN32
+#  define READ_CACHE_THREAD 1
+#else
+#  define READ_CACHE_THREAD 0
+#endif
 
 typedef struct read_cache_chunk_s {
   uint8_t     *cache_buffer;
   uint8_t     *cache_buffer_base;  /* used in malloc and free for alignment */
+  dvd_file_t  *file;               /* read from here */
   int32_t      cache_start_sector; /* -1 means cache invalid */
   int32_t      cache_read_count;   /* this many sectors are already read */
+  int32_t      cache_used_count;   /* this many sectors have been handed out */
   size_t       cache_block_count;  /* this many sectors will go in this chunk */
   size_t       cache_malloc_size;
   int          cache_valid;
+  int          busy;         /* a read into this chunk is in progress */
+  uint32_t     seq;          /* planning order */
   int          usage_count;  /* counts how many buffers where issued from this chunk */
 } read_cache_chunk_t;
 
 struct read_cache_s {
   read_cache_chunk_t  chunk[READ_CACHE_CHUNKS];
   int                 current;
+  int                 wanted;   /* a reader waits for this chunk */
   int                 freeing;  /* is set to one when we are about to dispose the cache */
-  uint32_t            read_ahead_size;
-  int                 read_ahead_incr;
-  int                 last_sector;
+  uint32_t            seq;
   pthread_mutex_t     lock;
+#if READ_CACHE_THREAD
+  pthread_cond_t      wake;     /* there is new work for the prefetch thread */
+  pthread_cond_t      filled;   /* a read has finished */
+  pthread_t           thread;
+  int                 thread_running;
+#endif
+
+  dvdnav_read_cache_stats_t stats;
 
   /* Bit of strange cross-linking going on here :) -- Gotta love C :) */
   dvdnav_t           *dvd_self;
@@ -88,6 +110,186 @@ struct read_cache_s {
 # endif
 #endif
 
+/* The following helpers need self->lock held. */
+
+static void read_cache_drop_chunk(read_cache_t *self, read_cache_chunk_t *chunk) {
+  if (chunk->cache_valid && chunk->cache_read_count > chunk->cache_used_count)
+    self->stats.unused += chunk->cache_read_count - chunk->cache_used_count;
+  chunk->cache_valid = 0;
+}
+
+/* read the next sectors of a planned chunk. drops the lock while reading. */
+static void read_cache_fill(read_cache_t *self, read_cache_chunk_t *chunk, int32_t count) {
+  dvd_file_t *file = chunk->file;
+  int32_t start = chunk->cache_start_sector + chunk->cache_read_count;
+  uint8_t *buf = chunk->cache_buffer + chunk->cache_read_count * DVD_VIDEO_LB_LEN;
+  int32_t left = chunk->cache_block_count - chunk->cache_read_count;
+  ssize_t got;
+
+  if (count > left)
+    count = left;
+  if (count <= 0)
+    return;
+  chunk->busy = 1;
+  pthread_mutex_unlock(&self->lock);
+  got = DVDReadBlocks(file, start, count, buf);
+  pthread_mutex_lock(&self->lock);
+  chunk->busy = 0;
+  if (chunk->cache_valid) {
+    if (got > 0) {
+      chunk->cache_read_count += got;
+      self->stats.prefetched += got;
+    }
+    /* read error or end of file: stop here, readers will read directly. */
+    if (got < count)
+      chunk->cache_block_count = chunk->cache_read_count;
+  }
+  dprintf("read %d sectors at %d, got %d\n", (int)count, (int)start, (int)got);
+#if READ_CACHE_THREAD
+  pthread_cond_broadcast(&self->filled);
+#endif
+}
+
+/* find the chunk planned to hold sector, prefer the current one. */
+static int read_cache_find(read_cache_t *self, int sector) {
+  int i;
+
+  for (i = -1; i < READ_CACHE_CHUNKS; i++) {
+    read_cache_chunk_t *chunk = &self->chunk[i < 0 ? self->current : i];
+    if (chunk->cache_valid && sector >= chunk->cache_start_sector &&
+        sector < chunk->cache_start_sector + (int32_t)chunk->cache_block_count)
+      return i < 0 ? self->current : i;
+  }
+  return -1;
+}
+
+/* get a chunk for block_count new sectors: an invalid one, one older than
+ * the current VOBU, a new one, or the oldest of the rest, in that order. */
+static int read_cache_get(read_cache_t *self, size_t block_count) {
+  read_cache_chunk_t *chunk;
+  uint32_t cur_seq = self->chunk[self->current].seq;
+  int i, use = -1, best = 4;
+
+  for (i = 0; i < READ_CACHE_CHUNKS; i++) {
+    int rank;
+    chunk = &self->chunk[i];
+    if (chunk->busy || chunk->usage_count || i == self->current)
+      continue;
+    if (!chunk->cache_buffer)
+      rank = 2;
+    else if (!chunk->cache_valid)
+      rank = 0;
+    else if ((int32_t)(chunk->seq - cur_seq) < 0)
+      rank = 1;
+    else
+      rank = 3;
+    if (rank < best || (rank == best && (rank & 1) && (int32_t)(chunk->seq - self->chunk[use].seq) < 0)) {
+      best = rank;
+      use = i;
+    }
+  }
+  if (use < 0)
+    return -1;
+
+  chunk = &self->chunk[use];
+  read_cache_drop_chunk(self, chunk);
+  if (chunk->cache_malloc_size < block_count) {
+    size_t size = block_count > READ_CACHE_CHUNK_MIN ? block_count : READ_CACHE_CHUNK_MIN;
+    uint8_t *base;
+    /* old contents are not needed. */
+    free(chunk->cache_buffer_base);
+    base = malloc(size * DVD_VIDEO_LB_LEN + ALIGNMENT);
+    chunk->cache_buffer_base = base;
+    if (!base) {
+      chunk->cache_buffer = NULL;
+      chunk->cache_malloc_size = 0;
+      return -1;
+    }
+    chunk->cache_buffer =
+      (uint8_t *)(((uintptr_t)base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
+    chunk->cache_malloc_size = size;
+    dprintf("chunk %d: %d sectors\n", use, (int)size);
+  }
+  return use;
+}
+
+/* make sure [sector, sector + block_count) will be read. */
+static void read_cache_plan(read_cache_t *self, int sector, size_t block_count, int make_current) {
+  read_cache_chunk_t *chunk;
+  int use;
+
+  use = read_cache_find(self, sector);
+  if (use >= 0) {
+    /* typically, a prefetch of the next VOBU. */
+    chunk = &self->chunk[use];
+    if (sector + block_count > chunk->cache_start_sector + chunk->cache_block_count) {
+      if (sector + block_count - chunk->cache_start_sector <= chunk->cache_malloc_size)
+        chunk->cache_block_count = sector + block_count - chunk->cache_start_sector;
+      else
+        use = -1;
+    }
+  }
+  if (use < 0) {
+    use = read_cache_get(self, block_count);
+    if (use < 0) {
+      dprintf("pre_caching was impossible, no cache chunk available\n");
+      return;
+    }
+    chunk = &self->chunk[use];
+    chunk->file = self->dvd_self->file;
+    chunk->cache_start_sector = sector;
+    chunk->cache_block_count = block_count;
+    chunk->cache_read_count = 0;
+    chunk->cache_used_count = 0;
+    chunk->cache_valid = 1;
+    chunk->seq = ++self->seq;
+  }
+  if (make_current)
+    self->current = use;
+#if READ_CACHE_THREAD
+  pthread_cond_signal(&self->wake);
+#endif
+}
+
+#if READ_CACHE_THREAD
+/* the chunk a reader waits for, the current one, or the oldest planned. */
+static int read_cache_next_work(read_cache_t *self) {
+  int i, use = -1;
+
+  if (self->wanted >= 0) {
+    read_cache_chunk_t *chunk = &self->chunk[self->wanted];
+    if (chunk->cache_valid && chunk->cache_read_count < (int32_t)chunk->cache_block_count)
+      return self->wanted;
+  }
+  for (i = -1; i < READ_CACHE_CHUNKS; i++) {
+    int n = i < 0 ? self->current : i;
+    read_cache_chunk_t *chunk = &self->chunk[n];
+    if (!chunk->cache_valid || chunk->busy || chunk->cache_read_count >= (int32_t)chunk->cache_block_count)
+      continue;
+    if (i < 0)
+      return n;
+    if (use < 0 || (int32_t)(chunk->seq - self->chunk[use].seq) < 0)
+      use = n;
+  }
+  return use;
+}
+
+static void *read_cache_loop(void *data) {
+  read_cache_t *self = (read_cache_t *)data;
+
+  pthread_mutex_lock(&self->lock);
+  while (!self->freeing) {
+    int use = read_cache_next_work(self);
+    if (use < 0) {
+      pthread_cond_wait(&self->wake, &self->lock);
+      continue;
+    }
+    read_cache_fill(self, &self->chunk[use], READ_CACHE_STEP);
+  }
+  pthread_mutex_unlock(&self->lock);
+  return NULL;
+}
+#endif
 
 read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self) {
   read_cache_t *self;
@@ -97,17 +299,28 @@ read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self) {
 
   if(self) {
     self->current = 0;
+    self->wanted = -1;
     self->freeing = 0;
+    self->seq = 0;
     self->dvd_self = dvd_self;
-    self->last_sector = 0;
-    self->read_ahead_size = READ_AHEAD_SIZE_MIN;
-    self->read_ahead_incr = 0;
-    pthread_mutex_init(&self->lock, NULL);
-    dvdnav_read_cache_clear(self);
+    memset(&self->stats, 0, sizeof(self->stats));
     for (i = 0; i < READ_CACHE_CHUNKS; i++) {
       self->chunk[i].cache_buffer = NULL;
+      self->chunk[i].cache_buffer_base = NULL;
+      self->chunk[i].cache_malloc_size = 0;
+      self->chunk[i].cache_valid = 0;
+      self->chunk[i].busy = 0;
+      self->chunk[i].seq = 0;
       self->chunk[i].usage_count = 0;
     }
+    pthread_mutex_init(&self->lock, NULL);
+#if READ_CACHE_THREAD
+    pthread_cond_init(&self->wake, NULL);
+    pthread_cond_init(&self->filled, NULL);
+    self->thread_running = !pthread_create(&self->thread, NULL, read_cache_loop, self);
+    if (!self->thread_running)
+      fprintf(MSG_OUT, "libdvdnav: cannot start read ahead thread, reading on demand\n");
+#endif
   }
 
   return self;
@@ -118,7 +331,30 @@ void dvdnav_read_cache_free(read_cache_t* self) {
   int i;
 
   pthread_mutex_lock(&self->lock);
-  self->freeing = 1;
+  if (!self->freeing) {
+    dvdnav_read_cache_stats_t *s = &self->stats;
+    self->freeing = 1;
+#if READ_CACHE_THREAD
+    if (self->thread_running) {
+      self->thread_running = 0;
+      pthread_cond_signal(&self->wake);
+      pthread_mutex_unlock(&self->lock);
+      pthread_join(self->thread, NULL);
+      pthread_mutex_lock(&self->lock);
+    }
+#endif
+    for (i = 0; i < READ_CACHE_CHUNKS; i++)
+      read_cache_drop_chunk(self, &self->chunk[i]);
+#if READ_CACHE_TRACE
+    /* callers get these quietly via dvdnav_read_cache_stats (). */
+    if (s->hits + s->waits + s->misses)
+      fprintf(MSG_OUT, "libdvdnav: read cache: %u hits, %u waits, %u misses, "
+        "%u sectors read ahead, %u of them unused\n",
+        s->hits, s->waits, s->misses, s->prefetched, s->unused);
+#else
+    (void)s;
+#endif
+  }
   for (i = 0; i < READ_CACHE_CHUNKS; i++)
     if (self->chunk[i].cache_buffer && self->chunk[i].usage_count == 0) {
       free(self->chunk[i].cache_buffer_base);
@@ -131,6 +367,10 @@ void dvdnav_read_cache_free(read_cache_t* self) {
 
   /* all buffers returned, free everything */
   tmp = self->dvd_self;
+#if READ_CACHE_THREAD
+  pthread_cond_destroy(&self->wake);
+  pthread_cond_destroy(&self->filled);
+#endif
   pthread_mutex_destroy(&self->lock);
   free(self);
   free(tmp);
@@ -145,14 +385,18 @@ void dvdnav_read_cache_clear(read_cache_t *self) {
 
   pthread_mutex_lock(&self->lock);
   for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    self->chunk[i].cache_valid = 0;
+    read_cache_drop_chunk(self, &self->chunk[i]);
+#if READ_CACHE_THREAD
+  /* the file may be closed after this, let reads in progress finish. */
+  for (i = 0; i < READ_CACHE_CHUNKS; i++)
+    while (self->chunk[i].busy)
+      pthread_cond_wait(&self->filled, &self->lock);
+#endif
   pthread_mutex_unlock(&self->lock);
 }
 
 /* This function is called just after reading the NAV packet. */
 void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count) {
-  int i, use;
-
   if(!self)
     return;
 
@@ -160,161 +404,95 @@ void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count)
     return;
 
   pthread_mutex_lock(&self->lock);
+  read_cache_plan(self, sector, block_count, 1);
+  pthread_mutex_unlock(&self->lock);
+}
 
-  /* find a free cache chunk that best fits the required size */
-  use = -1;
-  for (i = 0; i < READ_CACHE_CHUNKS; i++)
-    if (self->chunk[i].usage_count == 0 && self->chunk[i].cache_buffer &&
-        self->chunk[i].cache_malloc_size >= block_count &&
-        (use == -1 || self->chunk[use].cache_malloc_size > self->chunk[i].cache_malloc_size))
-      use = i;
+/* Like dvdnav_pre_cache_blocks(), for a VOBU expected later. */
+void dvdnav_prefetch_blocks(read_cache_t *self, int sector, size_t block_count) {
+  if(!self)
+    return;
 
-  if (use == -1) {
-    /* we haven't found a cache chunk, so we try to reallocate an existing one */
-    for (i = 0; i < READ_CACHE_CHUNKS; i++)
-      if (self->chunk[i].usage_count == 0 && self->chunk[i].cache_buffer &&
-          (use == -1 || self->chunk[use].cache_malloc_size < self->chunk[i].cache_malloc_size))
-        use = i;
-    if (use >= 0) {
-      self->chunk[use].cache_buffer_base = realloc(self->chunk[use].cache_buffer_base,
-        block_count * DVD_VIDEO_LB_LEN + ALIGNMENT);
-      self->chunk[use].cache_buffer =
-        (uint8_t *)(((uintptr_t)self->chunk[use].cache_buffer_base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
-      dprintf("pre_cache DVD read realloc happened\n");
-      self->chunk[use].cache_malloc_size = block_count;
-    } else {
-      /* we still haven't found a cache chunk, let's allocate a new one */
-      for (i = 0; i < READ_CACHE_CHUNKS; i++)
-        if (!self->chunk[i].cache_buffer) {
-	  use = i;
-	  break;
-	}
-      if (use >= 0) {
-        /* We start with a sensible figure for the first malloc of 500 blocks.
-         * Some DVDs I have seen venture to 450 blocks.
-         * This is so that fewer realloc's happen if at all.
-         */
-	self->chunk[i].cache_buffer_base =
-	  malloc((block_count > 500 ? block_count : 500) * DVD_VIDEO_LB_LEN + ALIGNMENT);
-	self->chunk[i].cache_buffer =
-	  (uint8_t *)(((uintptr_t)self->chunk[i].cache_buffer_base & ~((uintptr_t)(ALIGNMENT - 1))) + ALIGNMENT);
-	self->chunk[i].cache_malloc_size = block_count > 500 ? block_count : 500;
-	dprintf("pre_cache DVD read malloc %d blocks\n",
-	  (block_count > 500 ? block_count : 500 ));
-      }
-    }
-  }
+  if(!self->dvd_self->use_read_ahead)
+    return;
 
-  if (use >= 0) {
-    self->chunk[use].cache_start_sector = sector;
-    self->chunk[use].cache_block_count = block_count;
-    self->chunk[use].cache_read_count = 0;
-    self->chunk[use].cache_valid = 1;
-    self->current = use;
-  } else {
-    dprintf("pre_caching was impossible, no cache chunk available\n");
-  }
+  pthread_mutex_lock(&self->lock);
+  read_cache_plan(self, sector, block_count, 0);
   pthread_mutex_unlock(&self->lock);
 }
 
 int dvdnav_read_cache_block(read_cache_t *self, int sector, size_t block_count, uint8_t **buf) {
-  int i, use;
-  int start;
-  int size;
-  int incr;
-  uint8_t *read_ahead_buf;
   int32_t res;
 
   if(!self)
     return 0;
 
-  use = -1;
-
   if(self->dvd_self->use_read_ahead) {
-    /* first check, if sector is in current chunk */
-    read_cache_chunk_t cur = self->chunk[self->current];
-    if (cur.cache_valid && sector >= cur.cache_start_sector &&
-        sector <= (cur.cache_start_sector + cur.cache_read_count) &&
-        sector + block_count <= cur.cache_start_sector + cur.cache_block_count)
-      use = self->current;
-    else
-      for (i = 0; i < READ_CACHE_CHUNKS; i++)
-        if (self->chunk[i].cache_valid &&
-            sector >= self->chunk[i].cache_start_sector &&
-            sector <= (self->chunk[i].cache_start_sector + self->chunk[i].cache_read_count) &&
-            sector + block_count <= self->chunk[i].cache_start_sector + self->chunk[i].cache_block_count)
-            use = i;
-  }
-
-  if (use >= 0) {
-    read_cache_chunk_t *chunk;
-    
-    /* Increment read-ahead size if sector follows the last sector */
-    if (sector == (self->last_sector + 1)) {
-      if (self->read_ahead_incr < READ_AHEAD_SIZE_MAX)
-        self->read_ahead_incr++;
-    } else {
-      self->read_ahead_size = READ_AHEAD_SIZE_MIN;
-      self->read_ahead_incr = 0;
-    }
-    self->last_sector = sector;
+    read_cache_chunk_t *chunk = NULL;
+    int use, waited = 0;
 
-    /* The following resources need to be protected by a mutex :
-     *   self->chunk[*].cache_buffer
-     *   self->chunk[*].cache_malloc_size
-     *   self->chunk[*].usage_count
-     */
     pthread_mutex_lock(&self->lock);
-    chunk = &self->chunk[use];
-    read_ahead_buf = chunk->cache_buffer + chunk->cache_read_count * DVD_VIDEO_LB_LEN;
-    *buf = chunk->cache_buffer + (sector - chunk->cache_start_sector) * DVD_VIDEO_LB_LEN;
-    chunk->usage_count++;
-    pthread_mutex_unlock(&self->lock);
-
-    dprintf("libdvdnav: sector=%d, start_sector=%d, last_sector=%d\n", sector, chunk->cache_start_sector, chunk->cache_start_sector + chunk->cache_block_count);
-
-    /* read_ahead_size */
-    incr = self->read_ahead_incr >> 1;
-    if ((self->read_ahead_size + incr) > READ_AHEAD_SIZE_MAX) {
-      self->read_ahead_size = READ_AHEAD_SIZE_MAX;
-    } else {
-      self->read_ahead_size += incr;
-    }
-
-    /* real read size */
-    start = chunk->cache_start_sector + chunk->cache_read_count;
-    if (chunk->cache_read_count + self->read_ahead_size > chunk->cache_block_count) {
-      size = chunk->cache_block_count - chunk->cache_read_count;
-    } else {
-      size = self->read_ahead_size;
-      /* ensure that the sector we want will be read */
-      if (sector >= chunk->cache_start_sector + chunk->cache_read_count + size)
-        size = sector - chunk->cache_start_sector - chunk->cache_read_count;
+    use = read_cache_find(self, sector);
+    while (use >= 0) {
+      int32_t end;
+      chunk = &self->chunk[use];
+      end = sector + block_count - chunk->cache_start_sector;
+      /* cleared, or read error */
+      if (!chunk->cache_valid || end > (int32_t)chunk->cache_block_count) {
+        use = -1;
+        break;
+      }
+      if (end <= chunk->cache_read_count)
+        break;
+      waited = 1;
+#if READ_CACHE_THREAD
+      if (self->thread_running) {
+        self->wanted = use;
+        pthread_cond_signal(&self->wake);
+        pthread_cond_wait(&self->filled, &self->lock);
+        continue;
+      }
+#endif
+      read_cache_fill(self, chunk, end - chunk->cache_read_count > READ_CACHE_STEP ?
+        end - chunk->cache_read_count : READ_CACHE_STEP);
     }
-    dprintf("libdvdnav: read_ahead_size=%d, size=%d\n", self->read_ahead_size, size);
-
-    if (size)
-      chunk->cache_read_count += DVDReadBlocks(self->dvd_self->file,
-                                               start,
-                                               size,
-                                               read_ahead_buf);
+    self->wanted = -1;
 
-    res = DVD_VIDEO_LB_LEN * block_count;
-
-  } else {
-
-    if (self->dvd_self->use_read_ahead) {
-      dprintf("cache miss on sector %d\n", sector);
+    if (use >= 0) {
+      int32_t end = sector + block_count - chunk->cache_start_sector;
+      *buf = chunk->cache_buffer + (sector - chunk->cache_start_sector) * DVD_VIDEO_LB_LEN;
+      chunk->usage_count++;
+      if (chunk->cache_used_count < end)
+        chunk->cache_used_count = end;
+      if (waited)
+        self->stats.waits++;
+      else
+        self->stats.hits++;
+      pthread_mutex_unlock(&self->lock);
+      return DVD_VIDEO_LB_LEN * block_count;
     }
 
-    res = DVDReadBlocks(self->dvd_self->file,
-                        sector,
-                        block_count,
-                        *buf) * DVD_VIDEO_LB_LEN;
+    self->stats.misses++;
+    pthread_mutex_unlock(&self->lock);
+    dprintf("cache miss on sector %d\n", sector);
   }
 
+  res = DVDReadBlocks(self->dvd_self->file,
+                      sector,
+                      block_count,
+                      *buf) * DVD_VIDEO_LB_LEN;
+
   return res;
+}
 
+void dvdnav_read_cache_stats(read_cache_t *self, dvdnav_read_cache_stats_t *stats) {
+  if (!self) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  pthread_mutex_lock(&self->lock);
+  *stats = self->stats;
+  pthread_mutex_unlock(&self->lock);
 }
 
 dvdnav_status_t dvdnav_free_cache_block(dvdnav_t *self, unsigned char *buf) {
@@ -26,10 +26,13 @@
 /* Opaque cache type -- defined in dvdnav_internal.h */
 /* typedef struct read_cache_s read_cache_t; */
 
-/* EXPERIMENTAL: Setting the following to 1 will use an experimental multi-threaded
- *               read-ahead cache. 
- */
-#define _MULTITHREAD_ 0
+typedef struct {
+  uint32_t hits;       /* sector was already read */
+  uint32_t waits;      /* sector was planned, but had to be waited for */
+  uint32_t misses;     /* sector was not planned, read directly */
+  uint32_t prefetched; /* sectors read ahead */
+  uint32_t unused;     /* sectors read ahead and dropped unread */
+} dvdnav_read_cache_stats_t;
 
 /* Constructor/destructors */
 read_cache_t *dvdnav_read_cache_new(dvdnav_t* dvd_self);
@@ -39,10 +42,15 @@ void dvdnav_read_cache_free(read_cache_t* self);
 void dvdnav_read_cache_clear(read_cache_t *self);
 /* This function is called just after reading the NAV packet. */
 void dvdnav_pre_cache_blocks(read_cache_t *self, int sector, size_t block_count);
+/* Hint about a VOBU that will probably be read after the current one.
+ * Both functions only plan, the reading happens in the background. */
+void dvdnav_prefetch_blocks(read_cache_t *self, int sector, size_t block_count);
 /* This function will do the cache read.
  * The buffer handed in must be malloced to take one dvd block.
  * On a cache hit, a different buffer will be returned though.
  * Those buffers must _never_ be freed. */
 int dvdnav_read_cache_block(read_cache_t *self, int sector, size_t block_count, uint8_t **buf);
+/* Hit/miss counters since dvdnav_read_cache_new(). */
+void dvdnav_read_cache_stats(read_cache_t *self, dvdnav_read_cache_stats_t *stats);
 
 #endif /* __DVDNAV_READ_CACHE_H */
@@ -400,6 +400,7 @@ static post_plugin_t *upmix_open_plugin(post_class_t *class_gen, int inputs,
 
   port = _x_post_intercept_audio_port(&this->post, audio_target[0], &input, &output);
   port->new_port.open       = upmix_port_open;
+  port->new_port.get_capabilities = _x_post_audio_get_capabilities_float;
 #if 0
   port->new_port.close      = upmix_port_close;
 #endif
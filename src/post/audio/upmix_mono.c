@@ -319,6 +319,7 @@ static post_plugin_t *upmix_mono_open_plugin(post_class_t *class_gen, int inputs
 
   port = _x_post_intercept_audio_port(&this->post, audio_target[0], &input, &output);
   port->new_port.open       = upmix_mono_port_open;
+  port->new_port.get_capabilities = _x_post_audio_get_capabilities_float;
   port->new_port.put_buffer = upmix_mono_port_put_buffer;
 
   xine_list_push_back(this->post.input, (void *)&params_input);
@@ -432,6 +432,7 @@ static post_plugin_t *volnorm_open_plugin(post_class_t *class_gen, int inputs,
 
     port = _x_post_intercept_audio_port(&this->post, audio_target[0], &input, &output);
     port->new_port.open       = volnorm_port_open;
+    port->new_port.get_capabilities = _x_post_audio_get_capabilities_float;
     port->new_port.close      = volnorm_port_close;
     port->new_port.put_buffer = volnorm_port_put_buffer;
 
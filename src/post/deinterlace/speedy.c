@@ -179,6 +179,31 @@ static inline __attribute__ ((always_inline,const)) uint8_t clip255( int x )
     }
 }
 
+static unsigned int comb_factor_packed422_scanline_c( uint8_t *top, uint8_t *mid,
+                                                      uint8_t *bot, int width )
+{
+    const int CombJaggieThreshold = 73;
+    unsigned int ret = 0;
+
+    /* Same as the mmx version: whole groups of 4 pixels, 7 bit luma. */
+    width &= ~3;
+
+    while( width-- ) {
+        int t = top[ 0 ] >> 1;
+        int m = mid[ 0 ] >> 1;
+        int b = bot[ 0 ] >> 1;
+
+        if( (t - m) * (b - m) - (((t - b) * (t - b)) >> 7) > CombJaggieThreshold ) {
+            ret++;
+        }
+        top += 2;
+        mid += 2;
+        bot += 2;
+    }
+
+    return ret;
+}
+
 #if defined(ARCH_X86)
 static unsigned int comb_factor_packed422_scanline_mmx( uint8_t *top, uint8_t *mid,
                                                         uint8_t *bot, int width )
@@ -349,10 +374,13 @@ static unsigned int diff_factor_packed422_scanline_mmx( uint8_t *cur, uint8_t *o
 
 static const sse_t dqwYMask = { .uq = { 0x00ff00ff00ff00ffULL, 0x00ff00ff00ff00ffULL }};
 static const sse_t dqwCMask = { .uq = { 0xff00ff00ff00ff00ULL, 0xff00ff00ff00ff00ULL }};
+static const sse_t dqwOnes = { .uq = { 0x0001000100010001ULL, 0x0001000100010001ULL }};
+static const sse_t dqwByteOnes = { .uq = { 0x0101010101010101ULL, 0x0101010101010101ULL }};
 
 static unsigned int diff_factor_packed422_scanline_sse2_aligned( uint8_t *cur, uint8_t *old, int width )
 {
     register unsigned int temp;
+    int tail = width & 4;
 
     width /= 8;
 
@@ -376,6 +404,18 @@ static unsigned int diff_factor_packed422_scanline_sse2_aligned( uint8_t *cur, u
         old += 16;
     }
 
+    /* last group of 4 pixels, like the mmx version */
+    if( tail ) {
+        movq_m2r( *cur, xmm4 );
+        movq_m2r( *old, xmm5 );
+        pand_r2r( xmm1, xmm4 );
+        pand_r2r( xmm1, xmm5 );
+        psubw_r2r( xmm5, xmm4 );
+        pmaddwd_r2r( xmm4, xmm4 );
+        psrld_r2r( xmm7, xmm4 );
+        paddd_r2r( xmm4, xmm0 );
+    }
+
     pshufd_r2r(xmm0, xmm1, 0x0e);
     paddd_r2r(xmm1, xmm0);
     pshufd_r2r(xmm0, xmm1, 0x01);
@@ -394,6 +434,7 @@ static unsigned int diff_factor_packed422_scanline_sse2( uint8_t *cur, uint8_t *
     }
 
     register unsigned int temp;
+    int tail = width & 4;
 
     width /= 8;
 
@@ -417,6 +458,18 @@ static unsigned int diff_factor_packed422_scanline_sse2( uint8_t *cur, uint8_t *
         old += 16;
     }
 
+    /* last group of 4 pixels, like the mmx version */
+    if( tail ) {
+        movq_m2r( *cur, xmm4 );
+        movq_m2r( *old, xmm5 );
+        pand_r2r( xmm1, xmm4 );
+        pand_r2r( xmm1, xmm5 );
+        psubw_r2r( xmm5, xmm4 );
+        pmaddwd_r2r( xmm4, xmm4 );
+        psrld_r2r( xmm7, xmm4 );
+        paddd_r2r( xmm4, xmm0 );
+    }
+
     pshufd_r2r(xmm0, xmm1, 0x0e);
     paddd_r2r(xmm1, xmm0);
     pshufd_r2r(xmm0, xmm1, 0x01);
@@ -428,6 +481,71 @@ static unsigned int diff_factor_packed422_scanline_sse2( uint8_t *cur, uint8_t *
 }
 #endif
 
+#if defined(ARCH_X86)
+static unsigned int comb_factor_packed422_scanline_sse2( uint8_t *top, uint8_t *mid,
+                                                         uint8_t *bot, int width )
+{
+    const sse_t dqwThreshold = { .uq = { 0x0049004900490049ULL, 0x0049004900490049ULL }};
+    register unsigned int temp;
+
+    /* Groups of 4 pixels, 2 per pass. A last single group leaves the
+     * upper half zero, which never counts. */
+    width /= 4;
+
+    movdqa_m2r( dqwThreshold, xmm0 );
+    movdqa_m2r( dqwYMask, xmm1 );
+    pxor_r2r( xmm7, xmm7 );
+
+    while( width > 0 ) {
+        if( width > 1 ) {
+            movdqu_m2r( *top, xmm3 );
+            movdqu_m2r( *mid, xmm4 );
+            movdqu_m2r( *bot, xmm5 );
+        } else {
+            movq_m2r( *top, xmm3 );
+            movq_m2r( *mid, xmm4 );
+            movq_m2r( *bot, xmm5 );
+        }
+
+        pand_r2r( xmm1, xmm3 );
+        pand_r2r( xmm1, xmm4 );
+        pand_r2r( xmm1, xmm5 );
+
+        psrlw_i2r( 1, xmm3 );
+        psrlw_i2r( 1, xmm4 );
+        psrlw_i2r( 1, xmm5 );
+
+        /* xmm6 = (top - mid) * (bot - mid) - ((top - bot)^2 >> 7) */
+        movdqa_r2r( xmm3, xmm6 );
+        psubw_r2r( xmm4, xmm6 );
+        psubw_r2r( xmm5, xmm3 );
+        psubw_r2r( xmm4, xmm5 );
+        pmullw_r2r( xmm5, xmm6 );
+        pmullw_r2r( xmm3, xmm3 );
+        psrlw_i2r( 7, xmm3 );
+        psubw_r2r( xmm3, xmm6 );
+
+        /* -1 where above the threshold */
+        pcmpgtw_r2r( xmm0, xmm6 );
+        psubw_r2r( xmm6, xmm7 );
+
+        top += 16;
+        mid += 16;
+        bot += 16;
+        width -= 2;
+    }
+
+    pmaddwd_m2r( dqwOnes, xmm7 );
+    pshufd_r2r( xmm7, xmm1, 0x0e );
+    paddd_r2r( xmm1, xmm7 );
+    pshufd_r2r( xmm7, xmm1, 0x01 );
+    paddd_r2r( xmm1, xmm7 );
+
+    movd_r2a( xmm7, temp );
+    return temp;
+}
+#endif
+
 #define ABS(a) (((a) < 0)?-(a):(a))
 
 #if defined(ARCH_X86)
@@ -575,6 +693,105 @@ static void diff_packed422_block8x8_mmx( pulldown_metrics_t *m, uint8_t *old,
 }
 #endif
 
+#if defined(ARCH_X86)
+static void diff_packed422_block8x8_sse2( pulldown_metrics_t *m, uint8_t *old,
+                                          uint8_t *new, int os, int ns )
+{
+    uint8_t *oldp, *newp;
+    int i, e, o, s, p, t;
+
+    /* A block row of 8 pixels is one register. */
+    movdqa_m2r( dqwYMask, xmm7 );
+    pxor_r2r( xmm4, xmm4 );  /* even difference */
+    pxor_r2r( xmm5, xmm5 );  /* odd difference */
+
+    oldp = old; newp = new;
+    for( i = 4; i; --i ) {
+        movdqu_m2r( oldp[0], xmm0 );
+        movdqu_m2r( newp[0], xmm1 );
+        movdqu_m2r( oldp[os], xmm2 );
+        movdqu_m2r( newp[ns], xmm3 );
+        pand_r2r( xmm7, xmm0 );
+        pand_r2r( xmm7, xmm1 );
+        pand_r2r( xmm7, xmm2 );
+        pand_r2r( xmm7, xmm3 );
+        psadbw_r2r( xmm1, xmm0 );
+        psadbw_r2r( xmm3, xmm2 );
+        paddd_r2r( xmm0, xmm4 );
+        paddd_r2r( xmm2, xmm5 );
+        oldp += os << 1;
+        newp += ns << 1;
+    }
+    pshufd_r2r( xmm4, xmm0, 0x0e );
+    pshufd_r2r( xmm5, xmm2, 0x0e );
+    paddd_r2r( xmm0, xmm4 );
+    paddd_r2r( xmm2, xmm5 );
+    movd_r2a( xmm4, e );
+    movd_r2a( xmm5, o );
+
+    pxor_r2r( xmm4, xmm4 );  /* past spacial noise */
+    pxor_r2r( xmm5, xmm5 );  /* temporal noise */
+    pxor_r2r( xmm6, xmm6 );  /* current spacial noise */
+
+    oldp = old; newp = new;
+    for( i = 4; i; --i ) {
+        movdqu_m2r( oldp[0], xmm0 );
+        movdqu_m2r( oldp[os], xmm1 );
+        movdqu_m2r( newp[0], xmm2 );
+        movdqu_m2r( newp[ns], xmm3 );
+        pand_r2r( xmm7, xmm0 );
+        pand_r2r( xmm7, xmm1 );
+        pand_r2r( xmm7, xmm2 );
+        pand_r2r( xmm7, xmm3 );
+        paddw_r2r( xmm1, xmm4 );
+        paddw_r2r( xmm1, xmm5 );
+        paddw_r2r( xmm3, xmm6 );
+        psubw_r2r( xmm0, xmm4 );
+        psubw_r2r( xmm2, xmm5 );
+        psubw_r2r( xmm2, xmm6 );
+        oldp += os << 1;
+        newp += ns << 1;
+    }
+
+    /* per column absolute values, then the sum of the 8 columns */
+    pxor_r2r( xmm0, xmm0 );
+    pxor_r2r( xmm1, xmm1 );
+    pxor_r2r( xmm2, xmm2 );
+    psubw_r2r( xmm4, xmm0 );
+    psubw_r2r( xmm5, xmm1 );
+    psubw_r2r( xmm6, xmm2 );
+    pmaxsw_r2r( xmm0, xmm4 );
+    pmaxsw_r2r( xmm1, xmm5 );
+    pmaxsw_r2r( xmm2, xmm6 );
+    movdqa_m2r( dqwOnes, xmm7 );
+    pmaddwd_r2r( xmm7, xmm4 );
+    pmaddwd_r2r( xmm7, xmm5 );
+    pmaddwd_r2r( xmm7, xmm6 );
+    pshufd_r2r( xmm4, xmm0, 0x0e );
+    pshufd_r2r( xmm5, xmm1, 0x0e );
+    pshufd_r2r( xmm6, xmm2, 0x0e );
+    paddd_r2r( xmm0, xmm4 );
+    paddd_r2r( xmm1, xmm5 );
+    paddd_r2r( xmm2, xmm6 );
+    pshufd_r2r( xmm4, xmm0, 0x01 );
+    pshufd_r2r( xmm5, xmm1, 0x01 );
+    pshufd_r2r( xmm6, xmm2, 0x01 );
+    paddd_r2r( xmm0, xmm4 );
+    paddd_r2r( xmm1, xmm5 );
+    paddd_r2r( xmm2, xmm6 );
+    movd_r2a( xmm4, p );
+    movd_r2a( xmm5, t );
+    movd_r2a( xmm6, s );
+
+    m->e = e;
+    m->o = o;
+    m->d = e + o;
+    m->p = p;
+    m->t = t;
+    m->s = s;
+}
+#endif
+
 static void diff_packed422_block8x8_c( pulldown_metrics_t *m, uint8_t *old,
                                        uint8_t *new, int os, int ns )
 {
@@ -682,7 +899,7 @@ static void vfilter_chroma_121_packed422_scanline_mmx( uint8_t *output, int widt
     // Get width in bytes.
     width *= 2;
     i = width / 8;
-    width -= i * 8;
+    width = (width - i * 8) / 2;
 
     movq_m2r( ymask, mm7 );
     movq_m2r( cmask, mm6 );
@@ -737,6 +954,53 @@ static void vfilter_chroma_121_packed422_scanline_c( uint8_t *output, int width,
     }
 }
 
+#if defined(ARCH_X86)
+static void vfilter_chroma_121_packed422_scanline_sse2( uint8_t *output, int width,
+                                                        uint8_t *m, uint8_t *t, uint8_t *b )
+{
+    int i;
+
+    movdqa_m2r( dqwYMask, xmm7 );
+    movdqa_m2r( dqwCMask, xmm6 );
+
+    for( i = width / 8; i; --i ) {
+        movdqu_m2r ( *t, xmm0 );
+        movdqu_m2r ( *b, xmm1 );
+        movdqu_m2r ( *m, xmm2 );
+
+        movdqa_r2r ( xmm2, xmm3 );
+        pand_r2r   ( xmm7, xmm3 );
+
+        pand_r2r   ( xmm6, xmm0 );
+        pand_r2r   ( xmm6, xmm1 );
+        pand_r2r   ( xmm6, xmm2 );
+
+        psrlw_i2r  ( 8, xmm0 );
+        psrlw_i2r  ( 8, xmm1 );
+        psrlw_i2r  ( 7, xmm2 );
+
+        paddw_r2r  ( xmm0, xmm2 );
+        paddw_r2r  ( xmm1, xmm2 );
+
+        psllw_i2r  ( 6, xmm2 );
+        pand_r2r   ( xmm6, xmm2 );
+
+        por_r2r    ( xmm3, xmm2 );
+
+        movdqu_r2m( xmm2, *output );
+        output += 16;
+        t += 16;
+        b += 16;
+        m += 16;
+    }
+    output++; t++; b++; m++;
+    for( i = width & 7; i; --i ) {
+        *output = (*t + *b + (*m << 1)) >> 2;
+        output +=2; t+=2; b+=2; m+=2;
+    }
+}
+#endif
+
 #if defined(ARCH_X86)
 static void vfilter_chroma_332_packed422_scanline_mmx( uint8_t *output, int width,
                                                        uint8_t *m, uint8_t *t, uint8_t *b )
@@ -748,7 +1012,7 @@ static void vfilter_chroma_332_packed422_scanline_mmx( uint8_t *output, int widt
     // Get width in bytes.
     width *= 2;
     i = width / 8;
-    width -= i * 8;
+    width = (width - i * 8) / 2;
 
     movq_m2r( ymask, mm7 );
     movq_m2r( cmask, mm6 );
@@ -810,7 +1074,7 @@ static void vfilter_chroma_332_packed422_scanline_sse2_aligned( uint8_t *output,
     // Get width in bytes.
     width *= 2;
     i = width / 16;
-    width -= i * 16;
+    width = (width - i * 16) / 2;
 
     movdqa_m2r( dqwYMask, xmm7 );
     movdqa_m2r( dqwCMask, xmm6 );
@@ -874,7 +1138,7 @@ static void vfilter_chroma_332_packed422_scanline_sse2( uint8_t *output, int wid
     // Get width in bytes.
     width *= 2;
     i = width / 16;
-    width -= i * 16;
+    width = (width - i * 16) / 2;
 
     movdqa_m2r( dqwYMask, xmm7 );
     movdqa_m2r( dqwCMask, xmm6 );
@@ -967,6 +1231,28 @@ static void kill_chroma_packed422_inplace_scanline_c( uint8_t *data, int width )
     }
 }
 
+#if defined(ARCH_X86)
+static void kill_chroma_packed422_inplace_scanline_sse2( uint8_t *data, int width )
+{
+    const sse_t nullchroma = { .uq = { 0x8000800080008000ULL, 0x8000800080008000ULL }};
+
+    movdqa_m2r( dqwYMask, xmm7 );
+    movdqa_m2r( nullchroma, xmm6 );
+    for(; width >= 8; width -= 8 ) {
+        movdqu_m2r( *data, xmm0 );
+        pand_r2r( xmm7, xmm0 );
+        por_r2r( xmm6, xmm0 );
+        movdqu_r2m( xmm0, *data );
+        data += 16;
+    }
+
+    while( width-- ) {
+        data[ 1 ] = 128;
+        data += 2;
+    }
+}
+#endif
+
 #if defined(ARCH_X86)
 static void invert_colour_packed422_inplace_scanline_mmx( uint8_t *data, int width )
 {
@@ -999,6 +1285,25 @@ static void invert_colour_packed422_inplace_scanline_c( uint8_t *data, int width
     }
 }
 
+#if defined(ARCH_X86)
+static void invert_colour_packed422_inplace_scanline_sse2( uint8_t *data, int width )
+{
+    pcmpeqb_r2r( xmm7, xmm7 );
+    for(; width >= 8; width -= 8 ) {
+        movdqu_m2r( *data, xmm0 );
+        pxor_r2r( xmm7, xmm0 );
+        movdqu_r2m( xmm0, *data );
+        data += 16;
+    }
+
+    width *= 2;
+    while( width-- ) {
+        *data = 255 - *data;
+        data++;
+    }
+}
+#endif
+
 /*
 // this duplicates alternate lines in alternate frames to highlight or mute
 // the effects of chroma crawl. it is not a solution or proper filter. it's
@@ -1153,7 +1458,7 @@ static void interpolate_packed422_scanline_mmx( uint8_t *output, uint8_t *top,
         top += 8;
         bot += 8;
     }
-    width = width & 0x7;
+    width = width & 0x3;
 
     /* Handle last few pixels. */
     for( i = width * 2; i; --i ) {
@@ -1202,7 +1507,7 @@ static void interpolate_packed422_scanline_mmxext( uint8_t *output, uint8_t *top
         top += 8;
         bot += 8;
     }
-    width = width & 0x7;
+    width = width & 0x3;
 
     /* Handle last few pixels. */
     for( i = width * 2; i; --i ) {
@@ -1214,6 +1519,60 @@ static void interpolate_packed422_scanline_mmxext( uint8_t *output, uint8_t *top
 }
 #endif
 
+#if defined(ARCH_X86)
+static void interpolate_packed422_scanline_sse2( uint8_t *output, uint8_t *top,
+                                                 uint8_t *bot, int width )
+{
+    int i;
+
+    /* pavgb rounds up, take the carry off again to truncate like the C version. */
+    movdqa_m2r( dqwByteOnes, xmm7 );
+
+    for( i = width/16; i; --i ) {
+        movdqu_m2r( *top, xmm0 );
+        movdqu_m2r( *bot, xmm1 );
+        movdqu_m2r( *(top + 16), xmm2 );
+        movdqu_m2r( *(bot + 16), xmm3 );
+        movdqa_r2r( xmm0, xmm4 );
+        movdqa_r2r( xmm2, xmm5 );
+        pxor_r2r( xmm1, xmm4 );
+        pxor_r2r( xmm3, xmm5 );
+        pavgb_r2r( xmm1, xmm0 );
+        pavgb_r2r( xmm3, xmm2 );
+        pand_r2r( xmm7, xmm4 );
+        pand_r2r( xmm7, xmm5 );
+        psubb_r2r( xmm4, xmm0 );
+        psubb_r2r( xmm5, xmm2 );
+        movdqu_r2m( xmm0, *output );
+        movdqu_r2m( xmm2, *(output + 16) );
+        output += 32;
+        top += 32;
+        bot += 32;
+    }
+    width = (width & 0xf);
+
+    if( width >= 8 ) {
+        movdqu_m2r( *top, xmm0 );
+        movdqu_m2r( *bot, xmm1 );
+        movdqa_r2r( xmm0, xmm4 );
+        pxor_r2r( xmm1, xmm4 );
+        pavgb_r2r( xmm1, xmm0 );
+        pand_r2r( xmm7, xmm4 );
+        psubb_r2r( xmm4, xmm0 );
+        movdqu_r2m( xmm0, *output );
+        output += 16;
+        top += 16;
+        bot += 16;
+        width -= 8;
+    }
+
+    /* Handle last few pixels. */
+    for( i = width * 2; i; --i ) {
+        *output++ = ((*top++) + (*bot++)) >> 1;
+    }
+}
+#endif
+
 static void blit_colour_packed422_scanline_c( uint8_t *output, int width, int y, int cb, int cr )
 {
     uint32_t colour = cr << 24 | y << 16 | cb << 8 | y;
@@ -1248,7 +1607,7 @@ static void blit_colour_packed422_scanline_mmx( uint8_t *output, int width, int
         movq_r2m( mm2, *output );
         output += 8;
     }
-    width = (width & 0x7);
+    width = (width & 0x3);
 
     for( i = width / 2; i; --i ) {
         *((uint32_t *) output) = colour;
@@ -1288,7 +1647,7 @@ static void blit_colour_packed422_scanline_mmxext( uint8_t *output, int width, i
         movntq_r2m( mm2, *output );
         output += 8;
     }
-    width = (width & 0x7);
+    width = (width & 0x3);
 
     for( i = width / 2; i; --i ) {
         *((uint32_t *) output) = colour;
@@ -1305,6 +1664,36 @@ static void blit_colour_packed422_scanline_mmxext( uint8_t *output, int width, i
 }
 #endif
 
+#if defined(ARCH_X86)
+static void blit_colour_packed422_scanline_sse2( uint8_t *output, int width, int y, int cb, int cr )
+{
+    uint32_t colour = cr << 24 | y << 16 | cb << 8 | y;
+    uint32_t *o;
+    int i;
+
+    movd_m2r( colour, xmm0 );
+    pshufd_r2r( xmm0, xmm0, 0 );
+
+    for( i = width / 16; i; --i ) {
+        movdqu_r2m( xmm0, *output );
+        movdqu_r2m( xmm0, *(output + 16) );
+        output += 32;
+    }
+    width = (width & 0xf);
+
+    if( width >= 8 ) {
+        movdqu_r2m( xmm0, *output );
+        output += 16;
+        width -= 8;
+    }
+
+    o = (uint32_t *) output;
+    for( width /= 2; width; --width ) {
+        *o++ = colour;
+    }
+}
+#endif
+
 static void blit_colour_packed4444_scanline_c( uint8_t *output, int width,
                                                int alpha, int luma, int cb, int cr )
 {
@@ -1393,6 +1782,32 @@ static void blit_colour_packed4444_scanline_mmxext( uint8_t *output, int width,
 }
 #endif
 
+#if defined(ARCH_X86)
+static void blit_colour_packed4444_scanline_sse2( uint8_t *output, int width,
+                                                  int alpha, int luma,
+                                                  int cb, int cr )
+{
+    uint32_t colour = (cr << 24) | (cb << 16) | (luma << 8) | alpha;
+    uint32_t *o;
+    int i;
+
+    movd_m2r( colour, xmm0 );
+    pshufd_r2r( xmm0, xmm0, 0 );
+
+    for( i = width / 8; i; --i ) {
+        movdqu_r2m( xmm0, *output );
+        movdqu_r2m( xmm0, *(output + 16) );
+        output += 32;
+    }
+    width = (width & 0x7);
+
+    o = (uint32_t *) output;
+    while( width-- ) {
+        *o++ = colour;
+    }
+}
+#endif
+
 
 #define speedy_memcpy_c xine_fast_memcpy
 #define speedy_memcpy_mmx xine_fast_memcpy
@@ -2044,7 +2459,7 @@ static void quarter_blit_vertical_packed422_scanline_mmxext( uint8_t *output, ui
         one += 8;
         three += 8;
     }
-    width = width & 0x7;
+    width = width & 0x3;
 
     /* Handle last few pixels. */
     for( i = width * 2; i; --i ) {
@@ -2070,6 +2485,96 @@ static void quarter_blit_vertical_packed422_scanline_c( uint8_t *output, uint8_t
     }
 }
 
+#if defined(ARCH_X86)
+static void quarter_blit_vertical_packed422_scanline_sse2( uint8_t *output, uint8_t *one,
+                                                           uint8_t *three, int width )
+{
+    int i;
+
+    /* (one + 3 * three + 2) / 4 == pavgb( (one + three) >> 1, three ),
+     * with the truncating average done as in the interpolation. */
+    movdqa_m2r( dqwByteOnes, xmm7 );
+
+    for( i = width/8; i; --i ) {
+        movdqu_m2r( *one, xmm0 );
+        movdqu_m2r( *three, xmm1 );
+        movdqa_r2r( xmm0, xmm2 );
+        pxor_r2r( xmm1, xmm2 );
+        pavgb_r2r( xmm1, xmm0 );
+        pand_r2r( xmm7, xmm2 );
+        psubb_r2r( xmm2, xmm0 );
+        pavgb_r2r( xmm1, xmm0 );
+        movdqu_r2m( xmm0, *output );
+        output += 16;
+        one += 16;
+        three += 16;
+    }
+
+    for( i = (width & 7) * 2; i; --i ) {
+        *output++ = (*one + *three + *three + *three + 2) / 4;
+        one++;
+        three++;
+    }
+}
+#endif
+
+#if defined(ARCH_X86)
+static void blend_packed422_scanline_sse2( uint8_t *output, uint8_t *src1,
+                                           uint8_t *src2, int width, int pos )
+{
+    if( pos == 0 ) {
+        blit_packed422_scanline( output, src1, width );
+    } else if( pos == 256 ) {
+        blit_packed422_scanline( output, src2, width );
+    } else if( pos == 128 ) {
+        interpolate_packed422_scanline( output, src1, src2, width );
+    } else {
+        const sse_t round = { .uq = { 0x0080008000800080ULL, 0x0080008000800080ULL }};
+        int inv = 256 - pos;
+        int i;
+
+        movd_m2r( pos, xmm5 );
+        movd_m2r( inv, xmm4 );
+        pshuflw_r2r( xmm5, xmm5, 0 );
+        pshuflw_r2r( xmm4, xmm4, 0 );
+        pshufd_r2r( xmm5, xmm5, 0 );
+        pshufd_r2r( xmm4, xmm4, 0 );
+        movdqa_m2r( round, xmm6 );
+        pxor_r2r( xmm7, xmm7 );
+
+        for( i = width/8; i; --i ) {
+            movdqu_m2r( *src1, xmm0 );
+            movdqu_m2r( *src2, xmm2 );
+            movdqa_r2r( xmm0, xmm1 );
+            movdqa_r2r( xmm2, xmm3 );
+            punpcklbw_r2r( xmm7, xmm0 );
+            punpckhbw_r2r( xmm7, xmm1 );
+            punpcklbw_r2r( xmm7, xmm2 );
+            punpckhbw_r2r( xmm7, xmm3 );
+            pmullw_r2r( xmm4, xmm0 );
+            pmullw_r2r( xmm4, xmm1 );
+            pmullw_r2r( xmm5, xmm2 );
+            pmullw_r2r( xmm5, xmm3 );
+            paddw_r2r( xmm2, xmm0 );
+            paddw_r2r( xmm3, xmm1 );
+            paddw_r2r( xmm6, xmm0 );
+            paddw_r2r( xmm6, xmm1 );
+            psrlw_i2r( 8, xmm0 );
+            psrlw_i2r( 8, xmm1 );
+            packuswb_r2r( xmm1, xmm0 );
+            movdqu_r2m( xmm0, *output );
+            output += 16;
+            src1 += 16;
+            src2 += 16;
+        }
+
+        for( i = (width & 7) * 2; i; --i ) {
+            *output++ = ( (*src1++ * ( 256 - pos )) + (*src2++ * pos) + 0x80 ) >> 8;
+        }
+    }
+}
+#endif
+
 static void subpix_blit_vertical_packed422_scanline_c( uint8_t *output, uint8_t *top,
                                                        uint8_t *bot, int subpixpos, int width )
 {
@@ -2599,7 +3104,7 @@ void setup_speedy_calls( uint32_t accel, int verbose )
     blend_packed422_scanline = blend_packed422_scanline_c;
     filter_luma_121_packed422_inplace_scanline = filter_luma_121_packed422_inplace_scanline_c;
     filter_luma_14641_packed422_inplace_scanline = filter_luma_14641_packed422_inplace_scanline_c;
-    comb_factor_packed422_scanline = 0;
+    comb_factor_packed422_scanline = comb_factor_packed422_scanline_c;
     diff_factor_packed422_scanline = diff_factor_packed422_scanline_c;
     kill_chroma_packed422_inplace_scanline = kill_chroma_packed422_inplace_scanline_c;
     mirror_packed422_inplace_scanline = mirror_packed422_inplace_scanline_c;
@@ -2675,7 +3180,17 @@ void setup_speedy_calls( uint32_t accel, int verbose )
         if( verbose ) {
             printf( "speedycode: Using SSE2 optimized functions.\n" );
         }
+        interpolate_packed422_scanline = interpolate_packed422_scanline_sse2;
+        blit_colour_packed422_scanline = blit_colour_packed422_scanline_sse2;
+        blit_colour_packed4444_scanline = blit_colour_packed4444_scanline_sse2;
+        blend_packed422_scanline = blend_packed422_scanline_sse2;
         diff_factor_packed422_scanline = diff_factor_packed422_scanline_sse2;
+        comb_factor_packed422_scanline = comb_factor_packed422_scanline_sse2;
+        diff_packed422_block8x8 = diff_packed422_block8x8_sse2;
+        quarter_blit_vertical_packed422_scanline = quarter_blit_vertical_packed422_scanline_sse2;
+        kill_chroma_packed422_inplace_scanline = kill_chroma_packed422_inplace_scanline_sse2;
+        invert_colour_packed422_inplace_scanline = invert_colour_packed422_inplace_scanline_sse2;
+        vfilter_chroma_121_packed422_scanline = vfilter_chroma_121_packed422_scanline_sse2;
         vfilter_chroma_332_packed422_scanline = vfilter_chroma_332_packed422_scanline_sse2;
     }
 #endif
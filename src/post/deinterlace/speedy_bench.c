@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * speedy kernel check and benchmark: runs the scanline kernels of every
+ * available acceleration level on random lines of various widths and
+ * alignments, compares them with the reference version, and reports
+ * Mpixel/s per level at 1920 pixels wide.
+ *
+ * usage: speedy_bench [loops]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xineutils.h>
+
+#include "speedy.h"
+
+#define MAX_WIDTH 1920
+/* 8 lines of packed 4444, and room for misalignment */
+#define STRIDE    (MAX_WIDTH * 4 + 64)
+#define BUF_SIZE  (STRIDE * 8 + 64)
+
+typedef uint32_t (*run_t) (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width);
+
+static uint32_t _interpolate (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)c;
+  interpolate_packed422_scanline (out, a, b, width);
+  return 0;
+}
+
+static uint32_t _blend (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)c;
+  blend_packed422_scanline (out, a, b, width, 77);
+  return 0;
+}
+
+static uint32_t _quarter_blit (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)c;
+  quarter_blit_vertical_packed422_scanline (out, a, b, width);
+  return 0;
+}
+
+/* in place like the deinterlace chroma filter, out starts as a copy of a. */
+static uint32_t _vfilter_121 (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  vfilter_chroma_121_packed422_scanline (out, width, out, b, c);
+  return 0;
+}
+
+static uint32_t _vfilter_332 (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  vfilter_chroma_332_packed422_scanline (out, width, out, b, c);
+  return 0;
+}
+
+static uint32_t _kill_chroma (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  (void)b;
+  (void)c;
+  kill_chroma_packed422_inplace_scanline (out, width);
+  return 0;
+}
+
+static uint32_t _invert_colour (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  (void)b;
+  (void)c;
+  invert_colour_packed422_inplace_scanline (out, width);
+  return 0;
+}
+
+static uint32_t _blit_colour_422 (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  (void)b;
+  (void)c;
+  blit_colour_packed422_scanline (out, width, 81, 90, 240);
+  return 0;
+}
+
+static uint32_t _blit_colour_4444 (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)a;
+  (void)b;
+  (void)c;
+  blit_colour_packed4444_scanline (out, width, 200, 81, 90, 240);
+  return 0;
+}
+
+static uint32_t _diff_factor (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)out;
+  (void)c;
+  return diff_factor_packed422_scanline (a, b, width);
+}
+
+static uint32_t _comb_factor (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  (void)out;
+  return comb_factor_packed422_scanline (a, b, c, width);
+}
+
+/* a row of 8x8 blocks, like the pulldown detection. */
+static uint32_t _diff_block8x8 (uint8_t *out, uint8_t *a, uint8_t *b, uint8_t *c, int width) {
+  uint32_t h = 0;
+  int x;
+  (void)out;
+  (void)c;
+  for (x = 0; x + 8 <= width; x += 8) {
+    pulldown_metrics_t m;
+    diff_packed422_block8x8 (&m, a + x * 2, b + x * 2, STRIDE, STRIDE);
+    h = h * 31 + m.d;
+    h = h * 31 + m.e;
+    h = h * 31 + m.o;
+    h = h * 31 + m.s;
+    h = h * 31 + m.p;
+    h = h * 31 + m.t;
+  }
+  return h;
+}
+
+static const struct {
+  const char *name;
+  run_t       run;
+  int         lines;   /* per call */
+  int         ref;     /* the level giving the reference result */
+} kernels[] = {
+  { "interpolate",      _interpolate,      1, 0 },
+  { "blend",            _blend,            1, 0 },
+  { "quarter_blit",     _quarter_blit,     1, 0 },
+  { "vfilter_121",      _vfilter_121,      1, 0 },
+  { "vfilter_332",      _vfilter_332,      1, 0 },
+  { "kill_chroma",      _kill_chroma,      1, 0 },
+  { "invert_colour",    _invert_colour,    1, 0 },
+  { "blit_colour_422",  _blit_colour_422,  1, 0 },
+  { "blit_colour_4444", _blit_colour_4444, 1, 0 },
+  /* the simd versions compare single pixels, not groups of 4 */
+  { "diff_factor",      _diff_factor,      1, 1 },
+  { "comb_factor",      _comb_factor,      1, 0 },
+  { "diff_block8x8",    _diff_block8x8,    8, 0 },
+};
+
+static const struct {
+  const char *name;
+  uint32_t    accel;
+} levels[] = {
+  { "c",      0 },
+  { "mmx",    MM_ACCEL_X86_MMX },
+  { "mmxext", MM_ACCEL_X86_MMX | MM_ACCEL_X86_MMXEXT },
+  { "sse2",   MM_ACCEL_X86_MMX | MM_ACCEL_X86_MMXEXT | MM_ACCEL_X86_SSE2 },
+};
+
+#define NUM_KERNELS (int)(sizeof (kernels) / sizeof (kernels[0]))
+#define NUM_LEVELS  (int)(sizeof (levels) / sizeof (levels[0]))
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void _fill (uint8_t *buf, size_t size, unsigned int seed) {
+  size_t i;
+  for (i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    buf[i] = seed >> 16;
+  }
+}
+
+/* output buffer and return value of one kernel run. */
+static uint32_t _check_run (int k, uint8_t *out, uint8_t *in[3], int width, int offs) {
+  memcpy (out, in[0], BUF_SIZE - 64);
+  return kernels[k].run (out + offs, in[0] + offs, in[1] + ((offs * 3) & 15),
+                         in[2] + ((offs * 5) & 15), width);
+}
+
+/* 1 if level l gives the same results as the reference level. */
+static int _check (int k, int l, uint8_t *in[3], uint8_t *ref, uint8_t *out) {
+  static const int widths[] = { 8, 12, 16, 24, 62, 718, 720, 1918, 1920 };
+  static const int offsets[] = { 0, 1, 2, 6 };
+  size_t w, o;
+
+  for (w = 0; w < sizeof (widths) / sizeof (widths[0]); w++) {
+    for (o = 0; o < sizeof (offsets) / sizeof (offsets[0]); o++) {
+      uint32_t r1, r2;
+      setup_speedy_calls (levels[kernels[k].ref].accel, 0);
+      r1 = _check_run (k, ref, in, widths[w], offsets[o]);
+      setup_speedy_calls (levels[l].accel, 0);
+      r2 = _check_run (k, out, in, widths[w], offsets[o]);
+      if ((r1 != r2) || memcmp (ref, out, BUF_SIZE - 64))
+        return 0;
+    }
+  }
+  return 1;
+}
+
+static double _speed (int k, int l, uint8_t *in[3], uint8_t *out, int loops) {
+  double start;
+  int i;
+
+  setup_speedy_calls (levels[l].accel, 0);
+  memcpy (out, in[0], BUF_SIZE);
+  start = _now ();
+  for (i = 0; i < loops; i++)
+    kernels[k].run (out, in[0], in[1], in[2], MAX_WIDTH);
+  return (double)MAX_WIDTH * kernels[k].lines * loops / (_now () - start) * 1e-6;
+}
+
+int main (int argc, char **argv) {
+  int loops = argc > 1 ? atoi (argv[1]) : 20000;
+  uint32_t accel = xine_mm_accel ();
+  uint8_t *in[3], *ref, *out;
+  int k, l, i, failed = 0;
+
+  for (i = 0; i < 3; i++) {
+    in[i] = xine_mallocz_aligned (BUF_SIZE);
+    _fill (in[i], BUF_SIZE, i + 1);
+  }
+  ref = xine_mallocz_aligned (BUF_SIZE);
+  out = xine_mallocz_aligned (BUF_SIZE);
+
+  printf ("%-18s", "Mpixel/s");
+  for (l = 0; l < NUM_LEVELS; l++) {
+    if ((levels[l].accel & accel) == levels[l].accel)
+      printf (" %9s", levels[l].name);
+  }
+  printf ("\n");
+
+  for (k = 0; k < NUM_KERNELS; k++) {
+    printf ("%-18s", kernels[k].name);
+    for (l = 0; l < NUM_LEVELS; l++) {
+      int same = 1;
+      if ((levels[l].accel & accel) != levels[l].accel)
+        continue;
+      if (l > kernels[k].ref) {
+        same = _check (k, l, in, ref, out);
+        /* the older mmx kernels may round differently, sse2 must not */
+        if (!same && (levels[l].accel & MM_ACCEL_X86_SSE2))
+          failed++;
+      }
+      printf (" %8.1f%c", _speed (k, l, in, out, loops), same ? ' ' : '*');
+    }
+    printf ("\n");
+  }
+  printf ("* = differs from the reference\n");
+
+  for (i = 0; i < 3; i++)
+    xine_free_aligned (in[i]);
+  xine_free_aligned (ref);
+  xine_free_aligned (out);
+  return failed ? 1 : 0;
+}
@@ -32,6 +32,9 @@
 #include <stdint.h>
 #endif
 
+#include <xine/xineutils.h>
+#include <xine/worker_pool.h>
+
 #include "speedy.h"
 #include "deinterlace.h"
 #include "pulldown.h"
@@ -149,6 +152,150 @@ static void calculate_pulldown_score_vektor( tvtime_t *tvtime,
 }
 
 
+/**
+ * Band parallel processing.
+ *
+ * Scanline methods only read the input fields, so the output can be split
+ * into bands of interpolate/copy line pairs.  Each band runs the same per
+ * pair code as the serial loop, including the special first and last pairs,
+ * and the result is bit exact.
+ *
+ * Frame methods look at neighbouring lines of their input.  Each band is
+ * deinterlaced on a window extended by TVTIME_BAND_MARGIN lines above and
+ * below into a private buffer, and only its inner lines are copied to the
+ * output.  The window starts on an even line so field parity is kept, and
+ * the real frame edges stay edges.
+ */
+#define TVTIME_BAND_MARGIN    8
+#define TVTIME_BAND_MIN_LINES 32
+
+typedef struct {
+    tvtime_t *tvtime;
+    uint8_t *output;
+    uint8_t *curframe;
+    uint8_t *lastframe;
+    uint8_t *secondlastframe;
+    uint8_t *f3, *f4;
+    int bottom_field, second_field;
+    int width, frame_height;
+    int instride, outstride;
+    int bytes_left;
+    int num_pairs;
+    int num_bands;
+} tvtime_band_job_t;
+
+static void tvtime_build_scanline_pairs( tvtime_band_job_t *job, int first, int last )
+{
+    const deinterlace_method_t *method = job->tvtime->curmethod;
+    int instride = job->instride;
+    int width = job->width;
+    int k;
+
+    for( k = first; k < last; k++ ) {
+        deinterlace_scanline_data_t data;
+        uint8_t *curframe  = job->curframe  + k * instride * 2;
+        uint8_t *lastframe = job->lastframe + k * instride * 2;
+        uint8_t *f3        = job->f3        + k * instride * 2;
+        uint8_t *f4        = job->f4        + k * instride * 2;
+        uint8_t *output    = job->output    + k * job->outstride * 2;
+        int final = (k == job->num_pairs - 1);
+
+        data.bottom_field = job->bottom_field;
+        data.bytes_left = job->bytes_left - k * instride * 2;
+        data.t0  = curframe;
+        data.b0  = curframe + instride * 2;
+        data.tt1 = k ? f3 - instride : f3 + instride;
+        data.m1  = f3 + instride;
+        data.bb1 = final ? f3 + instride : f3 + instride * 3;
+        data.t2  = lastframe;
+        data.b2  = lastframe + instride * 2;
+        data.tt3 = k ? f4 - instride : f4 + instride;
+        data.m3  = f4 + instride;
+        data.bb3 = final ? f4 + instride : f4 + instride * 3;
+        method->interpolate_scanline (output, &data, width);
+        output += job->outstride;
+
+        data.tt0 = curframe;
+        data.m0  = curframe + instride * 2;
+        data.bb0 = final ? curframe + instride * 2 : curframe + instride * 4;
+        data.t1  = f3 + instride;
+        data.b1  = final ? f3 + instride : f3 + instride * 3;
+        data.tt2 = lastframe;
+        data.t2  = f4 + instride;
+        data.m2  = lastframe + instride * 2;
+        data.b2  = final ? f4 + instride : f4 + instride * 3;
+        data.bb2 = final ? lastframe + instride * 2 : lastframe + instride * 4;
+        method->copy_scanline (output, &data, width);
+    }
+}
+
+static void tvtime_scanline_band( void *data, int band )
+{
+    tvtime_band_job_t *job = (tvtime_band_job_t *)data;
+
+    tvtime_build_scanline_pairs( job, job->num_pairs * band / job->num_bands,
+                                 job->num_pairs * (band + 1) / job->num_bands );
+}
+
+static void tvtime_frame_band( void *data, int band )
+{
+    tvtime_band_job_t *job = (tvtime_band_job_t *)data;
+    tvtime_t *tvtime = job->tvtime;
+    deinterlace_frame_data_t fdata;
+    /* frame methods always address their input with width * 2 bytes per line */
+    int linesize = job->width * 2;
+    int y0, y1, ys, ye, y;
+    uint8_t *buf;
+
+    y0 = (job->frame_height * band / job->num_bands) & ~1;
+    if( band == job->num_bands - 1 )
+        y1 = job->frame_height;
+    else
+        y1 = (job->frame_height * (band + 1) / job->num_bands) & ~1;
+    ys = y0 - TVTIME_BAND_MARGIN;
+    if( ys < 0 ) ys = 0;
+    ye = y1 + TVTIME_BAND_MARGIN;
+    if( ye > job->frame_height ) ye = job->frame_height;
+
+    buf = tvtime->band_buf + band * tvtime->band_buf_size;
+
+    fdata.f0 = job->curframe + ys * linesize;
+    fdata.f1 = job->lastframe + ys * linesize;
+    fdata.f2 = job->secondlastframe + ys * linesize;
+    fdata.f3 = NULL;
+    tvtime->curmethod->deinterlace_frame( buf, tvtime->band_stride, &fdata,
+                                          job->bottom_field, job->second_field,
+                                          job->width, ye - ys );
+
+    for( y = y0; y < y1; y++ ) {
+        blit_packed422_scanline( job->output + y * job->outstride,
+                                 buf + (y - ys) * tvtime->band_stride, job->width );
+    }
+}
+
+static int tvtime_alloc_band_buffers( tvtime_t *tvtime, int width, int frame_height, int num_bands )
+{
+    int stride = (width * 2 + 31) & ~31;
+    size_t size = (size_t)stride * (frame_height / num_bands + 4 + 2 * TVTIME_BAND_MARGIN);
+
+    if( tvtime->band_buf && tvtime->band_buf_size >= size && tvtime->band_bufs >= num_bands ) {
+        tvtime->band_stride = stride;
+        return 1;
+    }
+
+    xine_free_aligned( tvtime->band_buf );
+    tvtime->band_buf = xine_malloc_aligned( size * num_bands );
+    if( !tvtime->band_buf ) {
+        tvtime->band_buf_size = 0;
+        tvtime->band_bufs = 0;
+        return 0;
+    }
+    tvtime->band_buf_size = size;
+    tvtime->band_bufs = num_bands;
+    tvtime->band_stride = stride;
+    return 1;
+}
+
 int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
                                              uint8_t *curframe,
                                              uint8_t *lastframe,
@@ -243,6 +390,63 @@ int tvtime_build_deinterlaced_frame( tvtime_t *tvtime, uint8_t *output,
         }
     }
 
+    if( tvtime->pool && frame_height >= 2 * TVTIME_BAND_MIN_LINES ) {
+        tvtime_band_job_t job;
+
+        job.num_bands = xine_worker_pool_size( tvtime->pool );
+        if( job.num_bands > frame_height / TVTIME_BAND_MIN_LINES )
+            job.num_bands = frame_height / TVTIME_BAND_MIN_LINES;
+        if( job.num_bands > TVTIME_MAX_THREADS )
+            job.num_bands = TVTIME_MAX_THREADS;
+
+        if( job.num_bands > 1 ) {
+            job.tvtime = tvtime;
+            job.bottom_field = bottom_field;
+            job.second_field = second_field;
+            job.width = width;
+            job.frame_height = frame_height;
+            job.instride = instride;
+            job.outstride = outstride;
+
+            if( !tvtime->curmethod->scanlinemode ) {
+                if( tvtime_alloc_band_buffers( tvtime, width, frame_height, job.num_bands ) ) {
+                    job.output = output;
+                    job.curframe = curframe;
+                    job.lastframe = lastframe;
+                    job.secondlastframe = secondlastframe;
+                    xine_worker_pool_run( tvtime->pool, tvtime_frame_band, &job, job.num_bands );
+                    return 1;
+                }
+            } else {
+                if (bottom_field) {
+                    curframe += instride;
+                    lastframe += instride;
+                    secondlastframe += instride;
+                    blit_packed422_scanline (output, curframe, width);
+                    output += outstride;
+                }
+                blit_packed422_scanline (output, curframe, width);
+                output += outstride;
+
+                job.output = output;
+                job.curframe = curframe;
+                job.lastframe = lastframe;
+                job.secondlastframe = secondlastframe;
+                job.f3 = second_field ? curframe : lastframe;
+                job.f4 = second_field ? lastframe : secondlastframe;
+                job.num_pairs = ((frame_height - 6) / 2) + 2;
+                job.bytes_left = (frame_height - 5) * instride;
+                xine_worker_pool_run( tvtime->pool, tvtime_scanline_band, &job, job.num_bands );
+
+                if (!bottom_field) {
+                    /* Double the bottom scanline. */
+                    blit_packed422_scanline (output + job.num_pairs * 2 * outstride,
+                                             curframe + job.num_pairs * 2 * instride, width);
+                }
+                return 1;
+            }
+        }
+    }
     if( !tvtime->curmethod->scanlinemode ) {
         deinterlace_frame_data_t data;
 
@@ -468,11 +672,36 @@ tvtime_t *tvtime_new_context(void)
 
   tvtime->curmethod = NULL;
 
+  tvtime->threads = 1;
+
   tvtime_reset_context(tvtime);
 
   return tvtime;
 }
 
+void tvtime_free_context( tvtime_t *tvtime )
+{
+  if( !tvtime )
+    return;
+  xine_worker_pool_delete( tvtime->pool );
+  xine_free_aligned( tvtime->band_buf );
+  free( tvtime );
+}
+
+void tvtime_set_threads( tvtime_t *tvtime, int threads )
+{
+  if( threads <= 0 )
+    threads = xine_cpu_count();
+  if( threads > TVTIME_MAX_THREADS )
+    threads = TVTIME_MAX_THREADS;
+  if( threads == tvtime->threads )
+    return;
+
+  tvtime->threads = threads;
+  xine_worker_pool_delete( tvtime->pool );
+  tvtime->pool = (threads > 1) ? xine_worker_pool_new( threads ) : NULL;
+}
+
 void tvtime_reset_context( tvtime_t *tvtime )
 {
   tvtime->last_topdiff = 0;
@@ -25,8 +25,15 @@
 #include <stdint.h>
 #endif
 
+#include <xine/worker_pool.h>
+
 #include "deinterlace.h"
 
+/**
+ * Upper limit for the number of threads deinterlacing one field.
+ */
+#define TVTIME_MAX_THREADS 16
+
 /**
  * Which pulldown algorithm we're using.
  */
@@ -71,6 +78,13 @@ typedef struct {
   int pdlastbusted;
   int filmmode;
 
+  /* band parallel processing */
+  int threads;
+  xine_worker_pool_t *pool;
+  uint8_t *band_buf;
+  size_t band_buf_size;
+  int band_bufs;
+  int band_stride;
 
 } tvtime_t;
 
@@ -95,6 +109,14 @@ int tvtime_build_copied_field( tvtime_t *this, uint8_t *output,
                                        int outstride );
 tvtime_t *tvtime_new_context(void);
 
+void tvtime_free_context( tvtime_t *this );
+
+/**
+ * Sets the number of threads deinterlacing a field, including the calling
+ * thread. 0 means one per cpu, 1 disables band parallel processing.
+ */
+void tvtime_set_threads( tvtime_t *this, int threads );
+
 void tvtime_reset_context( tvtime_t *this );
 
 
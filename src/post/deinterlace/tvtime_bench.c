@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * deinterlacer benchmark: fields per second of every available method
+ * at 576i and 1080i, single threaded and band parallel.
+ *
+ * usage: tvtime_bench [threads [fields]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xineutils.h>
+
+#include "speedy.h"
+#include "deinterlace.h"
+#include "tvtime.h"
+#include "plugins/plugins.h"
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void _fill (uint8_t *buf, size_t size, unsigned int seed) {
+  size_t i;
+  for (i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    buf[i] = seed >> 16;
+  }
+}
+
+static double _run (tvtime_t *tvtime, uint8_t *out, uint8_t **in,
+                    int width, int height, int fields) {
+  double start = _now ();
+  int i;
+
+  for (i = 0; i < fields; i++) {
+    int bottom = i & 1;
+    tvtime_build_deinterlaced_frame (tvtime, out, in[0], in[1], in[2],
+                                     bottom, bottom, width, height,
+                                     width * 2, width * 2);
+  }
+  return fields / (_now () - start);
+}
+
+int main (int argc, char **argv) {
+  static const struct { const char *name; int width, height; } sizes[] = {
+    { "576i",   720,  576 },
+    { "1080i", 1920, 1080 },
+  };
+  deinterlace_methods_t methods = NULL;
+  int threads = argc > 1 ? atoi (argv[1]) : 0;
+  int fields  = argc > 2 ? atoi (argv[2]) : 200;
+  tvtime_t *tvtime;
+  xine_t *xine;
+  int m, s, i;
+
+  /* sets up xine_fast_memcpy () */
+  xine = xine_new ();
+  xine_init (xine);
+
+  setup_speedy_calls (xine_mm_accel (), 0);
+
+  register_deinterlace_method (&methods, linear_get_method ());
+  register_deinterlace_method (&methods, linearblend_get_method ());
+  register_deinterlace_method (&methods, greedy_get_method ());
+  register_deinterlace_method (&methods, greedy2frame_get_method ());
+  register_deinterlace_method (&methods, weave_get_method ());
+  register_deinterlace_method (&methods, double_get_method ());
+  register_deinterlace_method (&methods, vfir_get_method ());
+  register_deinterlace_method (&methods, dscaler_greedyh_get_method ());
+  register_deinterlace_method (&methods, dscaler_tomsmocomp_get_method ());
+  filter_deinterlace_methods (&methods, xine_mm_accel (), 5);
+
+  tvtime = tvtime_new_context ();
+  tvtime_set_threads (tvtime, threads);
+  threads = tvtime->threads;
+
+  printf ("%-20s %-6s %12s %12s %8s %s\n", "method", "size", "fields/s 1T", "fields/s", "speedup", "exact");
+
+  for (s = 0; s < (int)(sizeof (sizes) / sizeof (sizes[0])); s++) {
+    int width = sizes[s].width, height = sizes[s].height;
+    size_t size = (size_t)width * 2 * height;
+    uint8_t *in[3], *ref, *out;
+
+    for (i = 0; i < 3; i++) {
+      in[i] = xine_malloc_aligned (size);
+      _fill (in[i], size, 17 * (i + 1));
+    }
+    ref = xine_malloc_aligned (size);
+    out = xine_malloc_aligned (size);
+
+    for (m = 0; m < get_num_deinterlace_methods (methods); m++) {
+      double fps1, fpsn;
+      int exact = 1, bottom;
+
+      tvtime->curmethod = get_deinterlace_method (methods, m);
+
+      for (bottom = 0; bottom < 2; bottom++) {
+        tvtime_set_threads (tvtime, 1);
+        memset (ref, 0, size);
+        tvtime_build_deinterlaced_frame (tvtime, ref, in[0], in[1], in[2], bottom, bottom,
+                                         width, height, width * 2, width * 2);
+        tvtime_set_threads (tvtime, threads);
+        memset (out, 0, size);
+        tvtime_build_deinterlaced_frame (tvtime, out, in[0], in[1], in[2], bottom, bottom,
+                                         width, height, width * 2, width * 2);
+        if (memcmp (ref, out, size))
+          exact = 0;
+      }
+
+      tvtime_set_threads (tvtime, 1);
+      fps1 = _run (tvtime, out, in, width, height, fields);
+      tvtime_set_threads (tvtime, threads);
+      fpsn = _run (tvtime, out, in, width, height, fields);
+
+      printf ("%-20s %-6s %12.1f %12.1f %7.2fx %s\n", tvtime->curmethod->short_name,
+              sizes[s].name, fps1, fpsn, fpsn / fps1, exact ? "yes" : "NO");
+    }
+
+    for (i = 0; i < 3; i++)
+      xine_free_aligned (in[i]);
+    xine_free_aligned (ref);
+    xine_free_aligned (out);
+  }
+
+  printf ("(%d threads)\n", threads);
+
+  tvtime_free_context (tvtime);
+  free_deinterlace_methods (&methods);
+  xine_exit (xine);
+  return 0;
+}
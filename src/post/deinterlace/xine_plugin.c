@@ -66,6 +66,7 @@ typedef struct deinterlace_parameters_s {
   int use_progressive_frame_flag;
   int chroma_filter;
   int cheap_mode;
+  int threads;
 
 } deinterlace_parameters_t;
 
@@ -91,6 +92,8 @@ PARAM_ITEM( POST_PARAM_TYPE_BOOL, chroma_filter, NULL, 0, 1, 0,
             "apply chroma filter after deinterlacing" )
 PARAM_ITEM( POST_PARAM_TYPE_BOOL, cheap_mode, NULL, 0, 1, 0,
             "skip image format conversion - cheaper but not 100% correct" )
+PARAM_ITEM( POST_PARAM_TYPE_INT, threads, NULL, 0, TVTIME_MAX_THREADS, 0,
+            "number of threads (0 = one per cpu)" )
 END_PARAM_DESCR( param_descr )
 
 
@@ -117,6 +120,7 @@ struct post_plugin_deinterlace_s {
   int                use_progressive_frame_flag;
   int                chroma_filter;
   int                cheap_mode;
+  int                threads;
   tvtime_t          *tvtime;
   int                tvtime_changed;
   int                tvtime_last_filmmode;
@@ -167,6 +171,8 @@ static int set_parameters (xine_post_t *this_gen, const void *param_gen) {
   this->use_progressive_frame_flag = param->use_progressive_frame_flag;
   this->chroma_filter = param->chroma_filter;
   this->cheap_mode = param->cheap_mode;
+  this->threads = param->threads;
+  tvtime_set_threads( this->tvtime, this->threads );
 
   this->tvtime_changed++;
 
@@ -188,6 +194,7 @@ static int get_parameters (xine_post_t *this_gen, void *param_gen) {
   param->use_progressive_frame_flag = this->use_progressive_frame_flag;
   param->chroma_filter = this->chroma_filter;
   param->cheap_mode = this->cheap_mode;
+  param->threads = this->threads;
 
   return 1;
 }
@@ -247,6 +254,9 @@ static char * get_static_help (void) {
            "systems to try deinterlace algorithms, in a tradeoff between quality "
            "and cpu usage.\n"
            "\n"
+           "  Threads: Split each field into horizontal bands that are deinterlaced "
+           "in parallel. 0 uses one thread per cpu, 1 disables band processing.\n"
+           "\n"
            "* Uses several algorithms from tvtime and dscaler projects.\n"
            "Deinterlacing methods: (Not all methods are available for all platforms)\n"
            "\n"
@@ -377,6 +387,7 @@ static post_plugin_t *deinterlace_open_plugin(post_class_t *class_gen, int input
     .use_progressive_frame_flag = 1,
     .chroma_filter              = 0,
     .cheap_mode                 = 0,
+    .threads                    = 0, /* one per cpu */
   };
 
   if (!this || !video_target || !video_target[0]) {
@@ -441,7 +452,7 @@ static void deinterlace_dispose(post_plugin_t *this_gen)
   if (_x_post_dispose(this_gen)) {
     _flush_frames(this);
     pthread_mutex_destroy(&this->lock);
-    free(this->tvtime);
+    tvtime_free_context(this->tvtime);
     free(this);
   }
 }
@@ -59,6 +59,7 @@ static void autoset_cpu_info (void)
 #ifdef CPU_X86
     if (mmx_supported()) CPU_FLAVOUR |= CPU_OPTION_MMX;
     if (xmmx_supported()) CPU_FLAVOUR |= CPU_OPTION_XMMX;
+    if (sse2_supported()) CPU_FLAVOUR |= CPU_OPTION_SSE2;
 #endif /* CPU_X86 */
 }
 
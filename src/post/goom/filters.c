@@ -87,12 +87,17 @@ static inline void getPixelRGB_ (Pixel *buffer, Uint x, Color * c)
 /* faire : a / sqrtperte <=> a >> PERTEDEC */
 #define PERTEDEC 4
 
-/* pure c version of the zoom filter */
-static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
+/* pure c version of the zoom filter, lines y0 .. y1 - 1 */
+static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD, int buffratio, int precalCoef[BUFFPOINTNB][BUFFPOINTNB], int y0, int y1);
 
 /* simple wrapper to give it the same proto than the others */
 void zoom_filter_c (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]) {
-    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef);
+    src[0].val = src[sizeX-1].val = src[sizeX*sizeY-1].val = src[sizeX*sizeY-sizeX].val = 0;
+    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef, 0, sizeY);
+}
+
+void zoom_filter_c_band (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y0, int y1) {
+    c_zoom(src, dest, sizeX, sizeY, brutS, brutD, buffratio, precalCoef, y0, y1);
 }
 
 static void generatePrecalCoef (int precalCoef[BUFFPOINTNB][BUFFPOINTNB]);
@@ -405,19 +410,17 @@ static void makeZoomBufferStripe(ZoomFilterFXWrapperData * data, int INTERLACE_I
 
 
 static void c_zoom (Pixel *expix1, Pixel *expix2, unsigned int prevX, unsigned int prevY, signed int *brutS, signed int *brutD,
-                    int buffratio, int precalCoef[16][16])
+                    int buffratio, int precalCoef[16][16], int y0, int y1)
 {
     int     myPos, myPos2;
     Color   couleur;
     
     unsigned int ax = (prevX - 1) << PERTEDEC, ay = (prevY - 1) << PERTEDEC;
     
-    int     bufsize = prevX * prevY * 2;
+    int     bufsize = prevX * y1 * 2;
     int     bufwidth = prevX;
     
-    expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
-    
-    for (myPos = 0; myPos < bufsize; myPos += 2) {
+    for (myPos = prevX * y0 * 2; myPos < bufsize; myPos += 2) {
         Color   col1, col2, col3, col4;
         int     c1, c2, c3, c4, px, py;
         int     pos;
@@ -512,6 +515,25 @@ static void generateTheWaterFXHorizontalDirectionBuffer(PluginInfo *goomInfo, Zo
 
 
 
+typedef struct {
+    PluginInfo *goomInfo;
+    ZoomFilterFXWrapperData *data;
+    Pixel *src, *dest;
+    int num_bands;
+} zoom_band_job_t;
+
+static void zoom_band (void *job_gen, int band)
+{
+    zoom_band_job_t *job = (zoom_band_job_t *)job_gen;
+    ZoomFilterFXWrapperData *data = job->data;
+    int y0 = data->prevY * band / job->num_bands;
+    int y1 = data->prevY * (band + 1) / job->num_bands;
+
+    job->goomInfo->methods.zoom_filter_band (data->prevX, data->prevY, job->src, job->dest,
+                                             data->brutS, data->brutD, data->buffratio, data->precalCoef,
+                                             y0, y1);
+}
+
 /**
 * Main work for the dynamic displacement map.
  * 
@@ -644,8 +666,22 @@ void zoomFilterFastRGB (PluginInfo *goomInfo, Pixel * pix1, Pixel * pix2, ZoomFi
     
     data->zoom_width = data->prevX;
     
-    goomInfo->methods.zoom_filter (data->prevX, data->prevY, pix1, pix2,
-                                   data->brutS, data->brutD, data->buffratio, data->precalCoef);
+    if (goomInfo->methods.zoom_filter_band && goomInfo->pool) {
+        /* xine: split into bands of lines. All of them read pix1 and
+         * write their own part of pix2 only. */
+        zoom_band_job_t job;
+
+        job.goomInfo = goomInfo;
+        job.data = data;
+        job.src = pix1;
+        job.dest = pix2;
+        job.num_bands = xine_worker_pool_size (goomInfo->pool);
+        pix1[0].val = pix1[resx-1].val = pix1[resx*resy-1].val = pix1[resx*resy-resx].val = 0;
+        xine_worker_pool_run (goomInfo->pool, zoom_band, &job, job.num_bands);
+    } else {
+        goomInfo->methods.zoom_filter (data->prevX, data->prevY, pix1, pix2,
+                                       data->brutS, data->brutD, data->buffratio, data->precalCoef);
+    }
 }
 
 static void generatePrecalCoef (int precalCoef[16][16])
@@ -10,6 +10,10 @@
 PluginInfo *goom_init (guint32 resx, guint32 resy);
 void goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy);
 
+/* xine: number of threads for the zoom filter, 0 = one per cpu, 1 = off. */
+#define GOOM_MAX_THREADS 16
+void goom_set_threads (PluginInfo *goomInfo, int threads);
+
 /*
  * forceMode == 0 : do nothing
  * forceMode == -1 : lock the FX
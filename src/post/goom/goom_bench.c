@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * goom benchmark: renders a fixed number of frames from a fixed, beat
+ * like audio signal at several resolutions, and reports frames/s with
+ * the C zoom filter, the default (SIMD) one, and the default one on all
+ * cpus. goom uses rand () and some static state, so every run is done
+ * in a fresh process with the same seed, and must give the same pictures;
+ * the frame checksums are compared.
+ *
+ * usage: goom_bench [frames] [threads]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <xine.h>
+#include <xine/xineutils.h>
+
+#include "goom.h"
+#include "goom_fx.h"
+
+#define NUMSAMPLES 512 /* hardcoded into goom api */
+
+static const struct {
+  int width, height;
+} sizes[] = {
+  {  320,  240 },
+  {  640,  480 },
+  { 1280,  720 },
+  { 1920, 1080 },
+};
+
+#define NUM_SIZES (int)(sizeof (sizes) / sizeof (sizes[0]))
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* 2 tones with a beat every 24 frames, and some noise. */
+static void _sound (gint16 data[2][NUMSAMPLES], int frame) {
+  double env = exp (-(frame % 24) / 4.0) * 0.8 + 0.1;
+  unsigned int seed = frame * 2654435761u;
+  int i;
+
+  for (i = 0; i < NUMSAMPLES; i++) {
+    double t = (double)(frame * NUMSAMPLES + i) / 44100.0;
+    double v = sin (t * 2 * M_PI * 110.0) * env + sin (t * 2 * M_PI * 1760.0) * 0.2;
+    seed = seed * 1103515245 + 12345;
+    v += ((int)(seed >> 16 & 0x7fff) - 0x4000) / (double)0x4000 * 0.05;
+    data[0][i] = v * 16000;
+    data[1][i] = v * 15000;
+  }
+}
+
+typedef struct {
+  double   fps;
+  uint32_t sum;
+} result_t;
+
+/* frames/s, and a checksum of all frames. */
+static void _render (int width, int height, int frames, int threads, int c_zoom, result_t *res) {
+  gint16 data[2][NUMSAMPLES];
+  PluginInfo *goom;
+  double start, elapsed = 0;
+  uint32_t h = 0;
+  int f;
+
+  srand (1);
+  goom = goom_init (width, height);
+  if (c_zoom) {
+    goom->methods.zoom_filter = zoom_filter_c;
+    goom->methods.zoom_filter_band = zoom_filter_c_band;
+  }
+  goom_set_threads (goom, threads);
+
+  for (f = 0; f < frames; f++) {
+    const uint32_t *out;
+    int i;
+
+    _sound (data, f);
+    start = _now ();
+    out = goom_update (goom, data, 0, 0, NULL, NULL);
+    elapsed += _now () - start;
+    for (i = 0; i < width * height; i++)
+      h = h * 31 + out[i];
+  }
+
+  goom_close (goom);
+  res->sum = h;
+  res->fps = frames / elapsed;
+}
+
+static int _run (int width, int height, int frames, int threads, int c_zoom, result_t *res) {
+  int fds[2], status;
+  pid_t pid;
+
+  if (pipe (fds) < 0)
+    return 0;
+  pid = fork ();
+  if (pid < 0) {
+    close (fds[0]);
+    close (fds[1]);
+    return 0;
+  }
+  if (pid == 0) {
+    /* sets up xine_fast_memcpy () */
+    xine_t *xine = xine_new ();
+    xine_init (xine);
+    _render (width, height, frames, threads, c_zoom, res);
+    xine_exit (xine);
+    _exit (write (fds[1], res, sizeof (*res)) == sizeof (*res) ? 0 : 1);
+  }
+  close (fds[1]);
+  status = read (fds[0], res, sizeof (*res)) == sizeof (*res);
+  close (fds[0]);
+  waitpid (pid, NULL, 0);
+  return status;
+}
+
+int main (int argc, char **argv) {
+  int frames = argc > 1 ? atoi (argv[1]) : 100;
+  int threads = argc > 2 ? atoi (argv[2]) : 0;
+  int s, failed = 0;
+
+  if (threads <= 0)
+    threads = xine_cpu_count ();
+  /* always check the band split */
+  if (threads < 2)
+    threads = 2;
+
+  printf ("%-10s %9s %9s %9s\n", "frames/s", "c", "simd", "threads");
+  for (s = 0; s < NUM_SIZES; s++) {
+    result_t c, simd, par;
+
+    if (!_run (sizes[s].width, sizes[s].height, frames, 1, 1, &c) ||
+        !_run (sizes[s].width, sizes[s].height, frames, 1, 0, &simd) ||
+        !_run (sizes[s].width, sizes[s].height, frames, threads, 0, &par)) {
+      printf ("%4dx%-5d failed\n", sizes[s].width, sizes[s].height);
+      failed++;
+      continue;
+    }
+    printf ("%4dx%-5d %9.1f %8.1f%c %8.1f%c\n", sizes[s].width, sizes[s].height,
+            c.fps, simd.fps, simd.sum == c.sum ? ' ' : '*', par.fps, par.sum == c.sum ? ' ' : '*');
+    failed += (simd.sum != c.sum) + (par.sum != c.sum);
+  }
+  printf ("* = differs from the C zoom filter, %d threads\n", threads);
+
+  return failed ? 1 : 0;
+}
@@ -136,6 +136,19 @@ void goom_set_resolution (PluginInfo *goomInfo, guint32 resx, guint32 resy)
     goom_lines_set_res (goomInfo->gmline2, resx, goomInfo->screen.height);
 }
 
+void goom_set_threads (PluginInfo *goomInfo, int threads)
+{
+    if (threads <= 0)
+        threads = xine_cpu_count();
+    if (threads > GOOM_MAX_THREADS)
+        threads = GOOM_MAX_THREADS;
+    if (threads == xine_worker_pool_size(goomInfo->pool))
+        return;
+
+    xine_worker_pool_delete(goomInfo->pool);
+    goomInfo->pool = (threads > 1) ? xine_worker_pool_new(threads) : NULL;
+}
+
 int goom_set_screenbuffer(PluginInfo *goomInfo, void *buffer)
 {
   goomInfo->outputBuf = (Pixel*)buffer;
@@ -787,6 +800,8 @@ void goom_close (PluginInfo *goomInfo)
 
     gfont_unload(&goomInfo->font);
 
+    xine_worker_pool_delete(goomInfo->pool);
+
     free(goomInfo->params);
     free(goomInfo->visuals);
     free(goomInfo->sound.params.params);
@@ -8,5 +8,7 @@ VisualFX convolve_create (void);
 VisualFX flying_star_create (void);
 
 void zoom_filter_c(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+/* xine: lines y0 .. y1 - 1 only, the caller clears the src corners. */
+void zoom_filter_c_band(int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y0, int y1);
 
 #endif
@@ -12,6 +12,8 @@
 #include "goom_tools.h"
 #include "goomsl.h"
 
+#include <xine/worker_pool.h>
+
 typedef struct {
 	char drawIFS;
 	char drawPoints;
@@ -161,7 +163,12 @@ struct _PLUGIN_INFO {
 	struct {
 		void (*draw_line) (Pixel *data, int x1, int y1, int x2, int y2, int col, int screenx, int screeny);
 		void (*zoom_filter) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+		/* xine: zoom_filter for lines y0 .. y1 - 1, NULL if there is none */
+		void (*zoom_filter_band) (int sizeX, int sizeY, Pixel *src, Pixel *dest, int *brutS, int *brutD, int buffratio, int precalCoef[16][16], int y0, int y1);
 	} methods;
+
+	/* xine: splits the zoom filter into bands, NULL = single threaded */
+	xine_worker_pool_t *pool;
 	
 	GoomRandom *gRandom;
     
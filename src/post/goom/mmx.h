@@ -246,6 +246,7 @@ mmx_ok(void)
 
 int mmx_supported (void);
 int xmmx_supported (void);
+int sse2_supported (void);
 
 
 /* MMX optimized implementations */
@@ -256,6 +257,13 @@ void zoom_filter_mmx (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
 void zoom_filter_xmmx (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
                        int *lbruS, int *lbruD, int buffratio, int precalCoef[16][16]);
 
+/* SSE2 optimized implementations, same results as the C versions */
+void zoom_filter_sse2 (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
+                       int *brutS, int *brutD, int buffratio, int precalCoef[16][16]);
+void zoom_filter_sse2_band (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
+                            int *brutS, int *brutD, int buffratio, int precalCoef[16][16],
+                            int y0, int y1);
+
 
 /*	Helper functions for the instruction macros that follow...
 	(note that memory-to-register, m2r, instructions are nearly
@@ -34,15 +34,25 @@ static void setOptimizedMethods(PluginInfo *p) {
     /* set default methods */
     p->methods.draw_line = draw_line;
     p->methods.zoom_filter = zoom_filter_c;
+    p->methods.zoom_filter_band = zoom_filter_c_band;
 /*    p->methods.create_output_with_brightness = create_output_with_brightness;*/
 
 #ifdef CPU_X86
-	if (cpuFlavour & CPU_OPTION_XMMX) {
+	if (cpuFlavour & CPU_OPTION_SSE2) {
+#ifdef VERBOSE
+		printf ("SSE2 detected. Using the fastest methods !\n");
+#endif
+		p->methods.draw_line = draw_line_mmx;
+		p->methods.zoom_filter = zoom_filter_sse2;
+		p->methods.zoom_filter_band = zoom_filter_sse2_band;
+	}
+	else if (cpuFlavour & CPU_OPTION_XMMX) {
 #ifdef VERBOSE
 		printf ("Extented MMX detected. Using the fastest methods !\n");
 #endif
 		p->methods.draw_line = draw_line_mmx;
 		p->methods.zoom_filter = zoom_filter_xmmx;
+		p->methods.zoom_filter_band = NULL;
 	}
 	else if (cpuFlavour & CPU_OPTION_MMX) {
 #ifdef VERBOSE
@@ -50,6 +60,7 @@ static void setOptimizedMethods(PluginInfo *p) {
 #endif
 		p->methods.draw_line = draw_line_mmx;
 		p->methods.zoom_filter = zoom_filter_mmx;
+		p->methods.zoom_filter_band = NULL;
 	}
 #ifdef VERBOSE
         else
@@ -59,6 +70,7 @@ static void setOptimizedMethods(PluginInfo *p) {
 	
 #ifdef CPU_POWERPC
 
+        p->methods.zoom_filter_band = NULL;
         if ((cpuFlavour & CPU_OPTION_64_BITS) != 0) {
 /*            p->methods.create_output_with_brightness = ppc_brightness_G5;        */
             p->methods.zoom_filter = ppc_zoom_generic;
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * SSE2 zoom filter. Unlike the mmx versions, this gives exactly the
+ * same result as zoom_filter_c (), and it can work on a band of lines.
+ * Two destination pixels are done per step: their 2x2 source pixels are
+ * weighted with the 4 coefficients as words, then summed, rounded and
+ * packed together.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef HAVE_MMX
+
+#include <stdint.h>
+
+#include <xine/xineutils.h>
+
+#include "mmx.h"
+#include "goom_graphic.h"
+
+#define BUFFPOINTNB 16
+
+/* faire : a % sqrtperte <=> a & pertemask */
+#define PERTEMASK 0xf
+/* faire : a / sqrtperte <=> a >> PERTEDEC */
+#define PERTEDEC 4
+
+int sse2_supported (void) {
+	return (xine_mm_accel () & MM_ACCEL_X86_SSE2) ? 1 : 0;
+}
+
+static const uint16_t ATTR_ALIGN(16) sse2_five[8] = { 5, 5, 5, 5, 5, 5, 5, 5 };
+
+/* the 2x2 source pixels at a and b, weighted with ca and cb. The C version
+ * subtracts 5 from sums above 5 before the shift, which is a saturating
+ * subtract here. Alpha is left undefined. */
+static inline uint64_t zoom_pair_sse2 (const Pixel *a, const Pixel *b, intptr_t width,
+                                       uint32_t ca, uint32_t cb) {
+	uint64_t res;
+
+	__asm__ __volatile__ (
+		"movq       (%1),      %%xmm0\n\t"  /* a1 a2 */
+		"movq       (%1,%3,4), %%xmm1\n\t"  /* a3 a4 */
+		"movq       (%2),      %%xmm2\n\t"  /* b1 b2 */
+		"movq       (%2,%3,4), %%xmm3\n\t"  /* b3 b4 */
+		"pxor       %%xmm7,    %%xmm7\n\t"
+		"punpcklqdq %%xmm1,    %%xmm0\n\t"  /* a1 a2 a3 a4 */
+		"punpcklqdq %%xmm3,    %%xmm2\n\t"  /* b1 b2 b3 b4 */
+		"movd       %4,        %%xmm4\n\t"  /* c4 c3 c2 c1 */
+		"movd       %5,        %%xmm5\n\t"
+		"punpcklbw  %%xmm4,    %%xmm4\n\t"
+		"punpcklbw  %%xmm5,    %%xmm5\n\t"
+		"punpcklwd  %%xmm4,    %%xmm4\n\t"  /* c4 x4 c3 x4 c2 x4 c1 x4 */
+		"punpcklwd  %%xmm5,    %%xmm5\n\t"
+
+		"movdqa     %%xmm0,    %%xmm1\n\t"
+		"movdqa     %%xmm4,    %%xmm6\n\t"
+		"punpcklbw  %%xmm7,    %%xmm0\n\t"  /* a1 a2 as words */
+		"punpckhbw  %%xmm7,    %%xmm1\n\t"  /* a3 a4 */
+		"punpcklbw  %%xmm7,    %%xmm4\n\t"  /* c1 c2 */
+		"punpckhbw  %%xmm7,    %%xmm6\n\t"  /* c3 c4 */
+		"pmullw     %%xmm4,    %%xmm0\n\t"
+		"pmullw     %%xmm6,    %%xmm1\n\t"
+		"paddw      %%xmm1,    %%xmm0\n\t"  /* a1c1+a3c3 a2c2+a4c4 */
+
+		"movdqa     %%xmm2,    %%xmm3\n\t"
+		"movdqa     %%xmm5,    %%xmm6\n\t"
+		"punpcklbw  %%xmm7,    %%xmm2\n\t"
+		"punpckhbw  %%xmm7,    %%xmm3\n\t"
+		"punpcklbw  %%xmm7,    %%xmm5\n\t"
+		"punpckhbw  %%xmm7,    %%xmm6\n\t"
+		"pmullw     %%xmm5,    %%xmm2\n\t"
+		"pmullw     %%xmm6,    %%xmm3\n\t"
+		"paddw      %%xmm3,    %%xmm2\n\t"  /* b1c1+b3c3 b2c2+b4c4 */
+
+		"movdqa     %%xmm0,    %%xmm1\n\t"
+		"punpcklqdq %%xmm2,    %%xmm0\n\t"
+		"punpckhqdq %%xmm2,    %%xmm1\n\t"
+		"paddw      %%xmm1,    %%xmm0\n\t"  /* a b */
+		"psubusw    %6,        %%xmm0\n\t"
+		"psrlw      $8,        %%xmm0\n\t"
+		"packuswb   %%xmm0,    %%xmm0\n\t"
+		"movq       %%xmm0,    %0\n\t"
+		: "=m" (res)
+		: "r" (a), "r" (b), "r" (width), "m" (ca), "m" (cb), "m" (sse2_five[0])
+		: "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7");
+	return res;
+}
+
+void zoom_filter_sse2_band (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
+                            int *brutS, int *brutD, int buffratio, int precalCoef[16][16],
+                            int y0, int y1)
+{
+	int ax = (prevX - 1) << PERTEDEC, ay = (prevY - 1) << PERTEDEC;
+	int loop = prevX * y0, end = prevX * y1;
+	int pos[2];
+	uint32_t coeffs[2], amask;
+	uint64_t res;
+	Pixel alpha;
+
+	/* the channels struct, not A_CHANNEL, tells where the C version keeps alpha */
+	alpha.val = 0;
+	alpha.channels.a = 0xff;
+	amask = alpha.val;
+
+	while (loop < end) {
+		int i, n = (end - loop) > 1 ? 2 : 1;
+
+		for (i = 0; i < n; i++) {
+			int myPos = (loop + i) << 1;
+			int px = brutS[myPos] + (((brutD[myPos] - brutS[myPos]) * buffratio) >> BUFFPOINTNB);
+			int py = brutS[myPos + 1] + (((brutD[myPos + 1] - brutS[myPos + 1]) * buffratio) >> BUFFPOINTNB);
+
+			if ((py >= ay) || (px >= ax)) {
+				pos[i] = 0;
+				coeffs[i] = 0;
+			} else {
+				pos[i] = (px >> PERTEDEC) + prevX * (py >> PERTEDEC);
+				/* coef en modulo 15 */
+				coeffs[i] = precalCoef[px & PERTEMASK][py & PERTEMASK];
+			}
+		}
+		if (n == 1) {
+			pos[1] = pos[0];
+			coeffs[1] = coeffs[0];
+		}
+
+		res = zoom_pair_sse2 (expix1 + pos[0], expix1 + pos[1], prevX, coeffs[0], coeffs[1]);
+
+		/* like the C version, keep the alpha channel of dest */
+		expix2[loop].val = ((uint32_t)res & ~amask) | (expix2[loop].val & amask);
+		if (n == 2)
+			expix2[loop + 1].val = ((uint32_t)(res >> 32) & ~amask) | (expix2[loop + 1].val & amask);
+		loop += n;
+	}
+}
+
+void zoom_filter_sse2 (int prevX, int prevY, Pixel *expix1, Pixel *expix2,
+                       int *brutS, int *brutD, int buffratio, int precalCoef[16][16])
+{
+	expix1[0].val=expix1[prevX-1].val=expix1[prevX*prevY-1].val=expix1[prevX*prevY-prevX].val=0;
+	zoom_filter_sse2_band (prevX, prevY, expix1, expix2, brutS, brutD, buffratio, precalCoef, 0, prevY);
+}
+
+#endif
@@ -78,6 +78,7 @@ struct post_class_goom_s {
   int width, height;
   int fps;
   int csc_method;
+  int threads;
 };
 
 struct post_plugin_goom_s {
@@ -105,6 +106,7 @@ struct post_plugin_goom_s {
   int width_back, height_back;
   double ratio;
   int csc_method;
+  int threads;
 
 
   int do_samples_skip; /* true = skipping samples, false reading samples*/
@@ -164,6 +166,11 @@ static void csc_method_changed_cb(void *data, xine_cfg_entry_t *cfg) {
   class->csc_method = cfg->num_value;
 }
 
+static void threads_changed_cb(void *data, xine_cfg_entry_t *cfg) {
+  post_class_goom_t *class = (post_class_goom_t*) data;
+  class->threads = cfg->num_value;
+}
+
 static void *goom_init_plugin (xine_t *xine, const void *data) {
   config_values_t   *cfg;
   post_class_goom_t *this = calloc (1, sizeof (*this));
@@ -206,6 +213,13 @@ static void *goom_init_plugin (xine_t *xine, const void *data) {
       "The available selections should be self-explaining."),
     20, csc_method_changed_cb, this);
 
+  this->threads = cfg->register_range (cfg, "effects.goom.threads", 0,
+    0, GOOM_MAX_THREADS,
+    _("number of threads"),
+    _("The zoom filter can be split into bands that are rendered in parallel.\n"
+      "0 means one thread per cpu, 1 turns it off."),
+    20, threads_changed_cb, this);
+
   return &this->class;
 }
 
@@ -242,6 +256,8 @@ static post_plugin_t *goom_open_plugin(post_class_t *class_gen, int inputs,
 
   srand((unsigned int)time((time_t *)NULL));
   this->goom = goom_init (this->width_back, this->height_back);
+  this->threads = class->threads;
+  goom_set_threads (this->goom, this->threads);
 
   this->ratio = (double)this->width_back/(double)this->height_back;
 
@@ -488,6 +504,10 @@ static void goom_port_put_buffer (xine_audio_port_t *port_gen,
 #ifdef BENCHMARK
         int elapsed = 0;
 #endif
+        if (this->threads != this->class->threads) {
+          this->threads = this->class->threads;
+          goom_set_threads (this->goom, this->threads);
+        }
         /* Try to be fast */
         goom_frame = (uint8_t *)goom_update (this->goom, this->data, 0, 0, NULL, NULL);
 
@@ -608,6 +628,7 @@ static void goom_port_put_buffer (xine_audio_port_t *port_gen,
       if ((width != this->width_back) || (height != this->height_back)) {
         goom_close(this->goom);
         this->goom = goom_init (width, height);
+        goom_set_threads (this->goom, this->threads);
         this->width_back = width;
         this->height_back = height;
         this->ratio = (double)width/(double)height;
@@ -20,6 +20,11 @@
 
 /*
  * simple video mosaico plugin
+ *
+ * every input scales its frames into a tile of the wanted size on its own
+ * (decoder) thread, so all inputs do this in parallel. the background thread
+ * then only copies the tiles into its frame. the last tile is kept, and only
+ * scaled again for a new input frame or a new size.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -36,6 +41,9 @@
 
 #include <xine/xine_internal.h>
 #include <xine/post.h>
+#include <xine/xineutils.h>
+
+#include "scale.h"
 
 /* FIXME: This plugin needs to handle overlays as well. */
 
@@ -61,11 +69,26 @@ END_PARAM_DESCR(mosaico_param_descr)
 typedef struct post_mosaico_s post_mosaico_t;
 
 /* plugin structures */
+
+/* a YV12 picture of the pip size, scaled from an input frame. */
+typedef struct {
+  uint8_t          *base[3];
+  int               pitches[3];
+  unsigned int      w, h;
+  mosaico_scaler_t  scaler[2]; /* luma, chroma */
+} mosaico_tile_t;
+
 typedef struct mosaico_pip_s mosaico_pip_t;
 struct mosaico_pip_s {
-  unsigned int  x, y, w, h;
-  vo_frame_t   *frame;
-  char         *input_name;
+  unsigned int    x, y, w, h;
+  vo_frame_t     *frame;
+  char           *input_name;
+  /* what the background thread pastes. */
+  mosaico_tile_t  tile;
+  /* the input thread scales here, then swaps with tile. */
+  mosaico_tile_t  next;
+  /* tile does not show frame. */
+  int             dirty;
 };
 
 struct post_mosaico_s {
@@ -78,6 +101,7 @@ struct post_mosaico_s {
   int              skip;
   pthread_mutex_t  mutex;
   unsigned int     pip_count;
+  uint32_t         accel;
 };
 
 /* parameter functions */
@@ -93,10 +117,12 @@ static int mosaico_set_parameters(xine_post_t *this_gen, const void *param_gen)
   const mosaico_parameters_t *param = (const mosaico_parameters_t *)param_gen;
 
   if (param->pip_num > this->pip_count) return 0;
+  pthread_mutex_lock(&this->mutex);
   this->pip[param->pip_num - 1].x = param->x;
   this->pip[param->pip_num - 1].y = param->y;
   this->pip[param->pip_num - 1].w = param->w;
   this->pip[param->pip_num - 1].h = param->h;
+  pthread_mutex_unlock(&this->mutex);
   return 1;
 }
 
@@ -189,68 +215,99 @@ static void frame_copy_content(vo_frame_t *to, vo_frame_t *from)
   }
 }
 
+static void tile_free(mosaico_tile_t *tile)
+{
+  mosaico_scaler_free(&tile->scaler[0]);
+  mosaico_scaler_free(&tile->scaler[1]);
+  xine_freep_aligned(&tile->base[0]);
+  tile->w = tile->h = 0;
+}
+
+static int tile_scale(mosaico_tile_t *tile, vo_frame_t *frame, unsigned int w, unsigned int h,
+                      uint32_t accel)
+{
+  unsigned int cw = (w + 1) / 2, ch = (h + 1) / 2;
+  int i;
+
+  if (!w || !h || (w > 8192) || (h > 8192) || (frame->width <= 0) || (frame->height <= 0))
+    return 0;
+
+  if ((tile->w != w) || (tile->h != h)) {
+    tile_free(tile);
+    tile->pitches[0] = (w + 15) & ~15;
+    tile->pitches[1] = tile->pitches[2] = (cw + 15) & ~15;
+    tile->base[0] = xine_malloc_aligned(tile->pitches[0] * h + 2 * tile->pitches[1] * ch);
+    if (!tile->base[0])
+      return 0;
+    tile->base[1] = tile->base[0] + tile->pitches[0] * h;
+    tile->base[2] = tile->base[1] + tile->pitches[1] * ch;
+  }
+  tile->w = tile->h = 0;
+
+  if (!mosaico_scaler_init(&tile->scaler[0], frame->width, frame->height, w, h, accel) ||
+      !mosaico_scaler_init(&tile->scaler[1], (frame->width + 1) / 2, (frame->height + 1) / 2,
+                           cw, ch, accel))
+    return 0;
+  for (i = 0; i < 3; i++)
+    mosaico_scale_plane(&tile->scaler[i ? 1 : 0], tile->base[i], tile->pitches[i],
+                        frame->base[i], frame->pitches[i]);
+  tile->w = w;
+  tile->h = h;
+  return 1;
+}
+
+static void tile_paste(mosaico_tile_t *tile, vo_frame_t *background, unsigned int x, unsigned int y)
+{
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    unsigned int bw = background->width, bh = background->height;
+    unsigned int px = x, py = y, w = tile->w, h = tile->h, j;
+    const uint8_t *src = tile->base[i];
+    uint8_t *dst;
+
+    if (i) {
+      bw = (bw + 1) / 2;
+      bh = (bh + 1) / 2;
+      px = (px + 1) / 2;
+      py = (py + 1) / 2;
+      w  = (w + 1) / 2;
+      h  = (h + 1) / 2;
+    }
+    if ((px >= bw) || (py >= bh))
+      return;
+    if (w > bw - px)
+      w = bw - px;
+    if (h > bh - py)
+      h = bh - py;
+    dst = background->base[i] + py * background->pitches[i] + px;
+    for (j = 0; j < h; j++) {
+      memcpy(dst, src, w);
+      dst += background->pitches[i];
+      src += tile->pitches[i];
+    }
+  }
+}
+
 static void frame_paste(post_mosaico_t *this, vo_frame_t *background, int pip_num)
 {
-  unsigned long target_width, target_height;
-  unsigned long source_width, source_height;
-  unsigned long background_width;
-  unsigned long scale_x, scale_y;
-  const int shift_x = 3, shift_y = 3;
-  unsigned long pos_x, pos_y, pos;
-  unsigned long target_offset, source_offset;
-  unsigned long i, j;
-
-  if (!this->pip[pip_num].frame) return;
-
-  target_width  = this->pip[pip_num].w;
-  target_height = this->pip[pip_num].h;
-  background_width = background->width;
-  source_width = this->pip[pip_num].frame->width;
-  source_height = this->pip[pip_num].frame->height;
-  scale_x = (source_width << shift_x) / target_width;
-  scale_y = (source_height << shift_y) / target_height;
-  pos_x = this->pip[pip_num].x;
-  pos_y = this->pip[pip_num].y;
-  pos = pos_y * background_width + pos_x;
-
-  switch (this->pip[pip_num].frame->format) {
+  mosaico_pip_t *pip = &this->pip[pip_num];
+
+  if (!pip->frame) return;
+
+  switch (pip->frame->format) {
   case XINE_IMGFMT_YUY2:
     /* TODO: implement YUY2 */
     break;
 
   case XINE_IMGFMT_YV12:
-    /* Y */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-        source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-        background->base[0][pos + target_offset] = this->pip[pip_num].frame->base[0][source_offset];
-      }
-
-    background_width = (background_width + 1) / 2;
-    source_width = (source_width + 1) / 2;
-    pos_x = (pos_x + 1) / 2;
-    pos_y = (pos_y + 1) / 2;
-    pos = pos_y * background_width + pos_x;
-    target_width = (target_width + 1) / 2;
-    target_height = (target_height + 1) / 2;
-
-    /* U */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-        source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-        background->base[1][pos + target_offset] = this->pip[pip_num].frame->base[1][source_offset];
-      }
-
-    /* V */
-    target_offset = 0;
-    for (j = 0; j < target_height; j++, target_offset += (background_width - target_width))
-      for (i = 0; i < target_width; i++, target_offset++) {
-        source_offset = ((i * scale_x) >> shift_x) + (((j * scale_y) >> shift_y) * source_width);
-        background->base[2][pos + target_offset] = this->pip[pip_num].frame->base[2][source_offset];
-      }
-
+    /* a new size, or the input thread could not do it. */
+    if (pip->dirty || (pip->tile.w != pip->w) || (pip->tile.h != pip->h)) {
+      if (!tile_scale(&pip->tile, pip->frame, pip->w, pip->h, this->accel))
+        return;
+      pip->dirty = 0;
+    }
+    tile_paste(&pip->tile, background, pip->x, pip->y);
     break;
   }
 }
@@ -313,15 +370,26 @@ static int mosaico_draw(vo_frame_t *frame, xine_stream_t *stream)
   post_video_port_t *port = (post_video_port_t *)frame->port;
   post_mosaico_t *this = (post_mosaico_t *)port->post;
   vo_frame_t *free_frame;
-  unsigned int pip_num;
-  int skip;
+  mosaico_pip_t *pip;
+  unsigned int pip_num, w, h;
+  int skip, scaled = 0;
 
   for (pip_num = 0; pip_num < this->pip_count; pip_num++)
     if (this->post.xine_post.video_input[pip_num+1] == frame->port) break;
   _x_assert(pip_num < this->pip_count);
+  pip = &this->pip[pip_num];
 
   frame->lock(frame);
 
+  /* scale here, without holding the lock. only this thread uses pip->next. */
+  if (port->stream && (frame->format == XINE_IMGFMT_YV12)) {
+    pthread_mutex_lock(&this->mutex);
+    w = pip->w;
+    h = pip->h;
+    pthread_mutex_unlock(&this->mutex);
+    scaled = tile_scale(&pip->next, frame, w, h, this->accel);
+  }
+
   pthread_mutex_lock(&this->mutex);
 
   /* the original output will never see this frame again */
@@ -329,9 +397,18 @@ static int mosaico_draw(vo_frame_t *frame, xine_stream_t *stream)
   while (frame->vpts > this->vpts_limit || !this->vpts_limit)
     /* we are too early */
     pthread_cond_wait(&this->vpts_limit_changed, &this->mutex);
-  free_frame = this->pip[pip_num].frame;
-  if (port->stream)
-    this->pip[pip_num].frame = frame;
+  free_frame = pip->frame;
+  if (port->stream) {
+    pip->frame = frame;
+    if (scaled && (pip->next.w == pip->w) && (pip->next.h == pip->h)) {
+      mosaico_tile_t tile = pip->tile;
+      pip->tile = pip->next;
+      pip->next = tile;
+      pip->dirty = 0;
+    } else {
+      pip->dirty = 1;
+    }
+  }
 
   if (this->skip && frame->vpts <= this->skip_vpts)
     skip = this->skip;
@@ -358,8 +435,11 @@ static void mosaico_dispose(post_plugin_t *this_gen)
 
   if (_x_post_dispose(this_gen)) {
     unsigned int i;
-    for (i = 0; i < this->pip_count; i++)
+    for (i = 0; i < this->pip_count; i++) {
       free(this->pip[i].input_name);
+      tile_free(&this->pip[i].tile);
+      tile_free(&this->pip[i].next);
+    }
     free(this->pip);
     pthread_cond_destroy(&this->vpts_limit_changed);
     pthread_mutex_destroy(&this->mutex);
@@ -403,6 +483,7 @@ static post_plugin_t *mosaico_open_plugin(post_class_t *class_gen, int inputs,
 
   this->pip       = (mosaico_pip_t *)calloc((inputs - 1), sizeof(mosaico_pip_t));
   this->pip_count = inputs - 1;
+  this->accel     = xine_mm_accel();
 
   pthread_cond_init(&this->vpts_limit_changed, NULL);
   pthread_mutex_init(&this->mutex, NULL);
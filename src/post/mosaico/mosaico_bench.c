@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * mosaico benchmark: composes a grid of YV12 inputs into one output frame,
+ * and reports frames/s for
+ *   nearest   the old per pixel nearest neighbour paste,
+ *   c         area averaging scaler, C only,
+ *   simd      area averaging scaler, SSE2 where available,
+ *   threads   simd, with the inputs scaled in parallel (like mosaico does
+ *             on the input threads),
+ *   paste     unchanged inputs, only the scaled tiles are copied.
+ * the simd and threaded pictures must match the C ones.
+ *
+ * usage: mosaico_bench [frames] [grid] [threads]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xineutils.h>
+#include <xine/worker_pool.h>
+
+#include "scale.h"
+
+#define IN_W  1920
+#define IN_H  1080
+#define OUT_W 1920
+#define OUT_H 1080
+
+typedef struct {
+  uint8_t *base[3];
+  int      pitches[3];
+  int      w, h;
+} plane3_t;
+
+typedef struct {
+  plane3_t          in, tile;
+  mosaico_scaler_t  scaler[2];
+  int               x, y;
+} input_t;
+
+typedef struct {
+  input_t  *inputs;
+  uint32_t  accel;
+} job_t;
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int _alloc (plane3_t *p, int w, int h) {
+  p->w = w;
+  p->h = h;
+  p->pitches[0] = (w + 15) & ~15;
+  p->pitches[1] = p->pitches[2] = ((w + 1) / 2 + 15) & ~15;
+  p->base[0] = xine_mallocz_aligned (p->pitches[0] * h + 2 * p->pitches[1] * ((h + 1) / 2));
+  if (!p->base[0])
+    return 0;
+  p->base[1] = p->base[0] + p->pitches[0] * h;
+  p->base[2] = p->base[1] + p->pitches[1] * ((h + 1) / 2);
+  return 1;
+}
+
+/* some detail, and different for every input. */
+static void _fill (plane3_t *p, int n) {
+  unsigned int seed = n * 2654435761u + 1;
+  int i, x, y;
+
+  for (i = 0; i < 3; i++) {
+    int w = i ? (p->w + 1) / 2 : p->w, h = i ? (p->h + 1) / 2 : p->h;
+    for (y = 0; y < h; y++) {
+      uint8_t *d = p->base[i] + y * p->pitches[i];
+      for (x = 0; x < w; x++) {
+        seed = seed * 1103515245 + 12345;
+        d[x] = ((x * (n + 1) + y * (i + 2)) & 0xff) ^ ((seed >> 16) & 0x1f);
+      }
+    }
+  }
+}
+
+static void _scale (input_t *in, uint32_t accel) {
+  int i;
+
+  mosaico_scaler_init (&in->scaler[0], in->in.w, in->in.h, in->tile.w, in->tile.h, accel);
+  mosaico_scaler_init (&in->scaler[1], (in->in.w + 1) / 2, (in->in.h + 1) / 2,
+                       (in->tile.w + 1) / 2, (in->tile.h + 1) / 2, accel);
+  for (i = 0; i < 3; i++)
+    mosaico_scale_plane (&in->scaler[i ? 1 : 0], in->tile.base[i], in->tile.pitches[i],
+                         in->in.base[i], in->in.pitches[i]);
+}
+
+static void _scale_job (void *data, int n) {
+  job_t *job = data;
+  _scale (&job->inputs[n], job->accel);
+}
+
+static void _paste (plane3_t *out, const input_t *in) {
+  int i, y;
+
+  for (i = 0; i < 3; i++) {
+    int w = i ? (in->tile.w + 1) / 2 : in->tile.w, h = i ? (in->tile.h + 1) / 2 : in->tile.h;
+    int px = i ? (in->x + 1) / 2 : in->x, py = i ? (in->y + 1) / 2 : in->y;
+    for (y = 0; y < h; y++)
+      memcpy (out->base[i] + (py + y) * out->pitches[i] + px, in->tile.base[i] + y * in->tile.pitches[i], w);
+  }
+}
+
+/* the old frame_paste (). */
+static void _nearest (plane3_t *out, const input_t *in) {
+  const int shift = 3;
+  int i, x, y;
+
+  for (i = 0; i < 3; i++) {
+    int sw = i ? (in->in.w + 1) / 2 : in->in.w;
+    int w = i ? (in->tile.w + 1) / 2 : in->tile.w, h = i ? (in->tile.h + 1) / 2 : in->tile.h;
+    int px = i ? (in->x + 1) / 2 : in->x, py = i ? (in->y + 1) / 2 : in->y;
+    unsigned long scale_x = ((unsigned long)in->in.w << shift) / in->tile.w;
+    unsigned long scale_y = ((unsigned long)in->in.h << shift) / in->tile.h;
+    for (y = 0; y < h; y++) {
+      uint8_t *d = out->base[i] + (py + y) * out->pitches[i] + px;
+      for (x = 0; x < w; x++)
+        d[x] = in->in.base[i][((x * scale_x) >> shift) + ((y * scale_y) >> shift) * sw];
+    }
+  }
+}
+
+static uint32_t _sum (const plane3_t *p) {
+  uint32_t h = 0;
+  int i, x, y;
+
+  for (i = 0; i < 3; i++) {
+    int w = i ? (p->w + 1) / 2 : p->w, hh = i ? (p->h + 1) / 2 : p->h;
+    for (y = 0; y < hh; y++)
+      for (x = 0; x < w; x++)
+        h = h * 31 + p->base[i][y * p->pitches[i] + x];
+  }
+  return h;
+}
+
+#define MODE_NEAREST 0
+#define MODE_C       1
+#define MODE_SIMD    2
+#define MODE_THREADS 3
+#define MODE_PASTE   4
+
+static double _run (int mode, int frames, plane3_t *out, input_t *inputs, int num,
+                    xine_worker_pool_t *pool, uint32_t *sum) {
+  job_t job = { inputs, mode == MODE_C ? 0 : xine_mm_accel () };
+  double start;
+  int f, i;
+
+  memset (out->base[0], 0, out->pitches[0] * out->h);
+  /* set up, and tiles for paste */
+  for (i = 0; i < num; i++)
+    _scale (&inputs[i], job.accel);
+
+  start = _now ();
+  for (f = 0; f < frames; f++) {
+    if (mode == MODE_THREADS)
+      xine_worker_pool_run (pool, _scale_job, &job, num);
+    for (i = 0; i < num; i++) {
+      if (mode == MODE_NEAREST)
+        _nearest (out, &inputs[i]);
+      else if ((mode == MODE_C) || (mode == MODE_SIMD))
+        _scale (&inputs[i], job.accel);
+      if (mode != MODE_NEAREST)
+        _paste (out, &inputs[i]);
+    }
+  }
+  start = _now () - start;
+  *sum = _sum (out);
+  return frames / start;
+}
+
+int main (int argc, char **argv) {
+  int frames = argc > 1 ? atoi (argv[1]) : 25;
+  int grid = argc > 2 ? atoi (argv[2]) : 4;
+  int threads = argc > 3 ? atoi (argv[3]) : 0;
+  static const char * const names[] = { "nearest", "c", "simd", "threads", "paste" };
+  xine_worker_pool_t *pool;
+  input_t *inputs;
+  plane3_t out;
+  uint32_t sums[5];
+  int i, num, failed = 0;
+
+  if (frames < 1)
+    frames = 1;
+  if ((grid < 1) || (grid > 16))
+    grid = 4;
+  num = grid * grid;
+
+  inputs = calloc (num, sizeof (*inputs));
+  if (!inputs || !_alloc (&out, OUT_W, OUT_H))
+    return 1;
+  for (i = 0; i < num; i++) {
+    input_t *in = &inputs[i];
+    if (!_alloc (&in->in, IN_W, IN_H) || !_alloc (&in->tile, OUT_W / grid, OUT_H / grid))
+      return 1;
+    _fill (&in->in, i);
+    in->x = (i % grid) * (OUT_W / grid);
+    in->y = (i / grid) * (OUT_H / grid);
+  }
+  pool = xine_worker_pool_new (threads);
+
+  printf ("%d inputs %dx%d -> %dx%d, %d threads, sse2 %s\n", num, IN_W, IN_H, OUT_W, OUT_H,
+          xine_worker_pool_size (pool), (xine_mm_accel () & MM_ACCEL_X86_SSE2) ? "yes" : "no");
+  printf ("%-10s %9s\n", "mode", "frames/s");
+  for (i = 0; i < 5; i++) {
+    double fps = _run (i, frames, &out, inputs, num, pool, &sums[i]);
+    int bad = (i >= MODE_SIMD) && (sums[i] != sums[MODE_C]);
+    printf ("%-10s %9.1f%s\n", names[i], fps, bad ? " differs from c" : "");
+    failed += bad;
+  }
+
+  xine_worker_pool_delete (pool);
+  for (i = 0; i < num; i++) {
+    mosaico_scaler_free (&inputs[i].scaler[0]);
+    mosaico_scaler_free (&inputs[i].scaler[1]);
+    xine_free_aligned (inputs[i].in.base[0]);
+    xine_free_aligned (inputs[i].tile.base[0]);
+  }
+  free (inputs);
+  xine_free_aligned (out.base[0]);
+  return failed ? 1 : 0;
+}
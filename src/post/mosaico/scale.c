@@ -0,0 +1,404 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * area averaging plane scaler for mosaico.
+ *
+ * the vertical pass runs first, and reduces the source rows of a destination
+ * line into one line of source width. this touches every source pixel, and
+ * is done 8 pixels at a time with SSE2 where available. the horizontal pass
+ * then only handles one line per destination line.
+ * both passes use the same integer math in C and SSE2, so the results are
+ * exactly the same.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <xine/xineutils.h>
+
+#include "scale.h"
+
+#define SCALE_BITS  14
+#define SCALE_ONE   (1 << SCALE_BITS)
+#define SCALE_ROUND (1 << (SCALE_BITS - 1))
+
+static void filter_free(mosaico_filter_t *f)
+{
+  free(f->first);
+  free(f->num);
+  free(f->weights);
+  memset(f, 0, sizeof(*f));
+}
+
+/* source pixel k covers [k * dst, (k + 1) * dst), destination pixel i covers
+ * [i * src, (i + 1) * src). the weight is the overlap. */
+static int filter_init(mosaico_filter_t *f, int src, int dst, int min_taps)
+{
+  int i, taps = min_taps <= src ? min_taps : 1;
+
+  filter_free(f);
+  for (i = 0; i < dst; i++) {
+    int n = ((i + 1) * src - 1) / dst - (i * src) / dst + 1;
+    if (taps < n)
+      taps = n;
+  }
+  f->first   = malloc(dst * sizeof(*f->first));
+  f->num     = malloc(dst * sizeof(*f->num));
+  f->weights = calloc(dst * taps, sizeof(*f->weights));
+  if (!f->first || !f->num || !f->weights) {
+    filter_free(f);
+    return 0;
+  }
+  f->src  = src;
+  f->dst  = dst;
+  f->taps = taps;
+
+  for (i = 0; i < dst; i++) {
+    int16_t *w = f->weights + i * taps;
+    int start = i * src, end = start + src;
+    int k, first = start / dst, last = (end - 1) / dst;
+    int sum = 0, big = 0;
+
+    for (k = first; k <= last; k++) {
+      int a = k * dst > start ? k * dst : start;
+      int b = (k + 1) * dst < end ? (k + 1) * dst : end;
+      int v = ((b - a) * SCALE_ONE + (src >> 1)) / src;
+      w[k - first] = v;
+      sum += v;
+      if (v > w[big])
+        big = k - first;
+    }
+    /* make it sum up exactly, no clipping needed then. */
+    w[big] += SCALE_ONE - sum;
+    f->first[i] = first;
+    f->num[i]   = last - first + 1;
+  }
+  return 1;
+}
+
+/* let all destination pixels use all taps, with zero weights where needed.
+ * this may move the first pixel to the left at the end of the line. */
+static void filter_fix_taps(mosaico_filter_t *f)
+{
+  int i, k;
+
+  for (i = 0; i < f->dst; i++) {
+    int16_t *w = f->weights + i * f->taps;
+    int d = f->first[i] + f->taps - f->src;
+
+    if (d > f->first[i])
+      d = f->first[i];
+    if (d > 0) {
+      for (k = f->taps - 1; k >= d; k--)
+        w[k] = w[k - d];
+      for (; k >= 0; k--)
+        w[k] = 0;
+      f->first[i] -= d;
+    }
+    f->num[i] = f->taps;
+  }
+}
+
+void mosaico_scaler_free(mosaico_scaler_t *s)
+{
+  filter_free(&s->x);
+  filter_free(&s->y);
+  xine_freep_aligned(&s->line);
+  xine_freep_aligned(&s->acc);
+  free(s->rows);
+  s->rows = NULL;
+}
+
+int mosaico_scaler_init(mosaico_scaler_t *s, int sw, int sh, int dw, int dh, uint32_t accel)
+{
+  int min_taps = 1;
+
+  if (s->line && (s->x.src == sw) && (s->y.src == sh) && (s->x.dst == dw) && (s->y.dst == dh) &&
+      (s->accel == accel))
+    return 1;
+  mosaico_scaler_free(s);
+  if ((sw <= 0) || (sh <= 0) || (dw <= 0) || (dh <= 0))
+    return 0;
+#if defined(ARCH_X86)
+  /* the SSE2 horizontal pass does 4 taps, with zero weights if needed. */
+  if ((accel & MM_ACCEL_X86_SSE2) && (sw != dw) && (sw < 4 * dw))
+    min_taps = 4;
+#endif
+  if (!filter_init(&s->x, sw, dw, min_taps) || !filter_init(&s->y, sh, dh, 1)) {
+    mosaico_scaler_free(s);
+    return 0;
+  }
+  filter_fix_taps(&s->x);
+  s->line = xine_malloc_aligned(sw + 16);
+  s->acc  = xine_malloc_aligned((sw + 16) * sizeof(*s->acc));
+  s->rows = malloc(s->y.taps * sizeof(*s->rows));
+  if (!s->line || !s->acc || !s->rows) {
+    mosaico_scaler_free(s);
+    return 0;
+  }
+  s->accel = accel;
+  return 1;
+}
+
+static void vscale_c(uint8_t *dst, int32_t *acc, const uint8_t **rows,
+                     const int16_t *w, int num, int x, int width)
+{
+  int k;
+
+  (void)acc;
+  for (; x < width; x++) {
+    int sum = SCALE_ROUND;
+    for (k = 0; k < num; k++)
+      sum += rows[k][x] * w[k];
+    dst[x] = sum >> SCALE_BITS;
+  }
+}
+
+#if defined(ARCH_X86)
+/* acc[0 .. 8 * n8 - 1] (+)= w[0] * a[] + w[1] * b[], unpacked to words
+ * and interleaved for pmaddwd. */
+#define VSCALE_SSE2_HEAD \
+  "movd       %4,     %%xmm6\n\t" \
+  "pshufd     $0,     %%xmm6, %%xmm6\n\t" \
+  "pxor       %%xmm7, %%xmm7\n\t" \
+  "1:\n\t" \
+  "movq       (%1),   %%xmm0\n\t" \
+  "movq       (%2),   %%xmm1\n\t" \
+  "punpcklbw  %%xmm7, %%xmm0\n\t" \
+  "punpcklbw  %%xmm7, %%xmm1\n\t" \
+  "movdqa     %%xmm0, %%xmm2\n\t" \
+  "punpcklwd  %%xmm1, %%xmm0\n\t" \
+  "punpckhwd  %%xmm1, %%xmm2\n\t" \
+  "pmaddwd    %%xmm6, %%xmm0\n\t" \
+  "pmaddwd    %%xmm6, %%xmm2\n\t"
+
+#define VSCALE_SSE2_TAIL \
+  "movdqu     %%xmm0, (%0)\n\t" \
+  "movdqu     %%xmm2, 16(%0)\n\t" \
+  "add        $8,     %1\n\t" \
+  "add        $8,     %2\n\t" \
+  "add        $32,    %0\n\t" \
+  "dec        %3\n\t" \
+  "jnz        1b\n\t"
+
+static void vscale_pair_sse2(int32_t *acc, const uint8_t *a, const uint8_t *b,
+                             int wa, int wb, int n8, int add)
+{
+  uint32_t wab = (uint16_t)wa | ((uint32_t)(uint16_t)wb << 16);
+
+  if (add) {
+    __asm__ __volatile__ (
+      VSCALE_SSE2_HEAD
+      "movdqu     (%0),   %%xmm3\n\t"
+      "movdqu     16(%0), %%xmm4\n\t"
+      "paddd      %%xmm3, %%xmm0\n\t"
+      "paddd      %%xmm4, %%xmm2\n\t"
+      VSCALE_SSE2_TAIL
+      : "+r" (acc), "+r" (a), "+r" (b), "+r" (n8)
+      : "r" (wab)
+      : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm6", "xmm7"
+    );
+  } else {
+    __asm__ __volatile__ (
+      VSCALE_SSE2_HEAD
+      VSCALE_SSE2_TAIL
+      : "+r" (acc), "+r" (a), "+r" (b), "+r" (n8)
+      : "r" (wab)
+      : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm6", "xmm7"
+    );
+  }
+}
+
+/* dst[0 .. 8 * n8 - 1] = (acc[] + round) >> 14, saturated. */
+static void vscale_pack_sse2(uint8_t *dst, const int32_t *acc, int n8)
+{
+  __asm__ __volatile__ (
+    "movd       %3,     %%xmm5\n\t"
+    "pshufd     $0,     %%xmm5, %%xmm5\n\t"
+    "1:\n\t"
+    "movdqu     (%1),   %%xmm0\n\t"
+    "movdqu     16(%1), %%xmm1\n\t"
+    "paddd      %%xmm5, %%xmm0\n\t"
+    "paddd      %%xmm5, %%xmm1\n\t"
+    "psrad      $14,    %%xmm0\n\t"
+    "psrad      $14,    %%xmm1\n\t"
+    "packssdw   %%xmm1, %%xmm0\n\t"
+    "packuswb   %%xmm0, %%xmm0\n\t"
+    "movq       %%xmm0, (%0)\n\t"
+    "add        $8,     %0\n\t"
+    "add        $32,    %1\n\t"
+    "dec        %2\n\t"
+    "jnz        1b\n\t"
+    : "+r" (dst), "+r" (acc), "+r" (n8)
+    : "r" (SCALE_ROUND)
+    : "memory", "cc", "xmm0", "xmm1", "xmm5"
+  );
+}
+
+static void vscale_sse2(uint8_t *dst, int32_t *acc, const uint8_t **rows,
+                        const int16_t *w, int num, int width)
+{
+  int n8 = width >> 3, k;
+
+  if (n8) {
+    for (k = 0; k < num; k += 2) {
+      if (k + 1 < num)
+        vscale_pair_sse2(acc, rows[k], rows[k + 1], w[k], w[k + 1], n8, k);
+      else
+        vscale_pair_sse2(acc, rows[k], rows[k], w[k], 0, n8, k);
+    }
+    vscale_pack_sse2(dst, acc, n8);
+  }
+  vscale_c(dst, acc, rows, w, num, n8 << 3, width);
+}
+
+/* 4 destination pixels per step. the 4 source pixels of each are unpacked
+ * to words, and weighted with pmaddwd. */
+static void hscale4_sse2(uint8_t *dst, const uint8_t *src, const int *first,
+                         const int16_t *w, int n4)
+{
+  const int *end = first + 4 * n4;
+  const int32_t round = SCALE_ROUND;
+  intptr_t tmp;
+
+  __asm__ __volatile__ (
+    "movd       %6,     %%xmm5\n\t"
+    "pshufd     $0,     %%xmm5, %%xmm5\n\t"
+    "pxor       %%xmm7, %%xmm7\n\t"
+    "1:\n\t"
+    "mov        (%1),   %k3\n\t"
+    "movd       (%4,%3), %%xmm0\n\t"
+    "mov        4(%1),  %k3\n\t"
+    "movd       (%4,%3), %%xmm1\n\t"
+    "mov        8(%1),  %k3\n\t"
+    "movd       (%4,%3), %%xmm2\n\t"
+    "mov        12(%1), %k3\n\t"
+    "movd       (%4,%3), %%xmm3\n\t"
+    "punpckldq  %%xmm1, %%xmm0\n\t"
+    "punpckldq  %%xmm3, %%xmm2\n\t"
+    "punpcklbw  %%xmm7, %%xmm0\n\t"
+    "punpcklbw  %%xmm7, %%xmm2\n\t"
+    "movdqu     (%2),   %%xmm4\n\t"
+    "movdqu     16(%2), %%xmm6\n\t"
+    "pmaddwd    %%xmm4, %%xmm0\n\t"  /* a01 a23 b01 b23 */
+    "pmaddwd    %%xmm6, %%xmm2\n\t"  /* c01 c23 d01 d23 */
+    "movdqa     %%xmm0, %%xmm1\n\t"
+    "shufps     $0x88,  %%xmm2, %%xmm0\n\t"  /* a01 b01 c01 d01 */
+    "shufps     $0xdd,  %%xmm2, %%xmm1\n\t"  /* a23 b23 c23 d23 */
+    "paddd      %%xmm1, %%xmm0\n\t"
+    "paddd      %%xmm5, %%xmm0\n\t"
+    "psrad      $14,    %%xmm0\n\t"
+    "packssdw   %%xmm0, %%xmm0\n\t"
+    "packuswb   %%xmm0, %%xmm0\n\t"
+    "movd       %%xmm0, (%0)\n\t"
+    "add        $4,     %0\n\t"
+    "add        $16,    %1\n\t"
+    "add        $32,    %2\n\t"
+    "cmp        %5,     %1\n\t"
+    "jb         1b\n\t"
+    : "+r" (dst), "+r" (first), "+r" (w), "=&r" (tmp)
+    : "r" (src), "m" (end), "m" (round)
+    : "memory", "cc", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7"
+  );
+}
+#endif
+
+/* all destination pixels use the same number of taps here, see filter_fix_taps (). */
+#define HSCALE_C(taps) \
+  for (i = 0; i < f->dst; i++, w += taps) { \
+    const uint8_t *p = src + f->first[i]; \
+    int sum = SCALE_ROUND; \
+    for (k = 0; k < taps; k++) \
+      sum += p[k] * w[k]; \
+    dst[i] = sum >> SCALE_BITS; \
+  }
+
+static void hscale(uint8_t *dst, const uint8_t *src, const mosaico_filter_t *f, uint32_t accel)
+{
+  const int16_t *w = f->weights;
+  int i = 0, k;
+
+#if defined(ARCH_X86)
+  if ((accel & MM_ACCEL_X86_SSE2) && (f->taps == 4) && (f->dst >= 4)) {
+    hscale4_sse2(dst, src, f->first, w, f->dst >> 2);
+    i = f->dst & ~3;
+    w += 4 * i;
+    for (; i < f->dst; i++, w += 4) {
+      const uint8_t *p = src + f->first[i];
+      dst[i] = (SCALE_ROUND + p[0] * w[0] + p[1] * w[1] + p[2] * w[2] + p[3] * w[3]) >> SCALE_BITS;
+    }
+    return;
+  }
+#else
+  (void)accel;
+#endif
+
+  switch (f->taps) {
+    case 1:
+      if (f->src == f->dst)
+        memcpy(dst, src, f->dst);
+      else
+        for (i = 0; i < f->dst; i++)
+          dst[i] = src[f->first[i]];
+      break;
+    /* let the compiler unroll the usual ones. */
+    case 2: HSCALE_C(2); break;
+    case 3: HSCALE_C(3); break;
+    case 4: HSCALE_C(4); break;
+    case 5: HSCALE_C(5); break;
+    default: HSCALE_C(f->taps);
+  }
+}
+
+void mosaico_scale_plane(mosaico_scaler_t *s, uint8_t *dst, int dst_pitch,
+                         const uint8_t *src, int src_pitch)
+{
+  const int16_t *w = s->y.weights;
+  int j, k;
+
+  for (j = 0; j < s->y.dst; j++, w += s->y.taps, dst += dst_pitch) {
+    const uint8_t *row = src + s->y.first[j] * src_pitch;
+    int num = s->y.num[j];
+    uint8_t *line = s->x.src == s->x.dst ? dst : s->line;
+
+    if ((num == 1) && (s->x.src == s->x.dst)) {
+      memcpy(dst, row, s->x.dst);
+      continue;
+    }
+    if (num == 1) {
+      /* weight is 1, use the source row as is. */
+      line = (uint8_t *)row;
+    } else {
+      for (k = 0; k < num; k++, row += src_pitch)
+        s->rows[k] = row;
+#if defined(ARCH_X86)
+      if (s->accel & MM_ACCEL_X86_SSE2)
+        vscale_sse2(line, s->acc, s->rows, w, num, s->x.src);
+      else
+#endif
+      vscale_c(line, s->acc, s->rows, w, num, 0, s->x.src);
+    }
+    if (line != dst)
+      hscale(dst, line, &s->x, s->accel);
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * area averaging plane scaler for mosaico.
+ */
+
+#ifndef MOSAICO_SCALE_H
+#define MOSAICO_SCALE_H
+
+#include <stdint.h>
+
+/* every destination pixel is the average of the source area it covers.
+ * weights are 14 bit fixed point, and sum up to exactly 1 << 14. */
+typedef struct {
+  int       src, dst;
+  int       taps;     /* max source pixels per destination pixel */
+  int      *first;    /* [dst] */
+  int      *num;      /* [dst] */
+  int16_t  *weights;  /* [dst * taps] */
+} mosaico_filter_t;
+
+typedef struct {
+  mosaico_filter_t  x, y;
+  /* vertical pass output, and its 32 bit sums. */
+  uint8_t          *line;
+  int32_t          *acc;
+  /* the rows for one destination line. */
+  const uint8_t   **rows;
+  uint32_t          accel;
+} mosaico_scaler_t;
+
+/* (re)configure for a sw x sh -> dw x dh plane. does nothing when the
+ * sizes did not change. accel is a MM_ACCEL_* mask, eg. xine_mm_accel ().
+ * returns 0 on failure. */
+int mosaico_scaler_init(mosaico_scaler_t *s, int sw, int sh, int dw, int dh, uint32_t accel);
+
+/* frees everything, and leaves s ready for a new init. */
+void mosaico_scaler_free(mosaico_scaler_t *s);
+
+void mosaico_scale_plane(mosaico_scaler_t *s, uint8_t *dst, int dst_pitch,
+                         const uint8_t *src, int src_pitch);
+
+#endif
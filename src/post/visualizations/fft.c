@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2000-2018 the xine project
+ * Copyright (C) 2000-2020 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -17,221 +17,245 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
  *
- * FFT code by Steve Haehnichen, originally licensed under GPL v1
- * modified by Thibaut Mattern (tmattern@noos.fr) to remove global vars
+ * Real input FFT: the N real samples are transformed as N/2 complex ones
+ * (even samples real, odd samples imaginary), and the spectrum is split
+ * afterwards. The complex FFT is an iterative radix 2 decimation in time,
+ * with a radix 4 first pass. Real and imaginary parts live in separate
+ * arrays, and each pass has its own contiguous twiddle table, so that the
+ * butterfly loops vectorize.
+ *
+ * Window function from the original FFT code by Steve Haehnichen.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
-#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <pthread.h>
 
-#include "fft.h"
-
-/**************************************************************************
- * fft specific decode functions
- *************************************************************************/
-
-# define                SINE(x)         (fft->SineTable[(x)])
-# define                COSINE(x)       (fft->CosineTable[(x)])
-# define                WINDOW(x)       (fft->WinTable[(x)])
+#include <xine/xineutils.h>
 
-#define PERMUTE(x, y)   reverse((x), (y))
-
-/* Number of samples in one "frame" */
-#define SAMPLES         (1 << bits)
-
-#define REAL(x)         wave[(x)].re
-#define IMAG(x)         wave[(x)].im
-#define ALPHA           0.54
+#include "fft.h"
 
-/*
- *  Bit reverser for unsigned ints
- *  Reverses 'bits' bits.
- */
-static inline unsigned int
-reverse (unsigned int val, int bits)
-{
-  unsigned int retn = 0;
-
-  while (bits--)
-    {
-      retn <<= 1;
-      retn |= (val & 1);
-      val >>= 1;
+#define FFT_MIN_BITS 2
+#define FFT_MAX_BITS 15
+
+#define ALPHA 0.54
+
+typedef struct {
+  int       refs;
+  int       bits;
+  /* complex size, N / 2 */
+  int       size;
+  /* size bit reversed indices */
+  uint16_t *rev;
+  /* twiddles of the pass with half size h are at [h .. 2h - 1], h >= 4 */
+  float    *pass_re, *pass_im;
+  /* exp (-2 pi i k / N) for the split */
+  float    *split_re, *split_im;
+  /* N, including the 1 / N scale */
+  float    *window;
+} fft_plan_t;
+
+struct fft_s {
+  fft_plan_t *plan;
+  float      *re, *im;
+};
+
+static pthread_mutex_t fft_plans_lock = PTHREAD_MUTEX_INITIALIZER;
+static fft_plan_t *fft_plans[FFT_MAX_BITS + 1];
+
+static fft_plan_t *fft_plan_new (int bits) {
+  fft_plan_t *plan;
+  int n = 1 << bits, m = n >> 1, i;
+  const double pi = atan (1.0) * 4.0;
+
+  plan = calloc (1, sizeof (*plan));
+  if (!plan)
+    return NULL;
+  /* 3 * N floats, then the bit reverse table */
+  plan->window = xine_mallocz_aligned (3 * n * sizeof (float) + m * sizeof (uint16_t));
+  if (!plan->window) {
+    free (plan);
+    return NULL;
+  }
+  plan->pass_re  = plan->window + n;
+  plan->pass_im  = plan->pass_re + m;
+  plan->split_re = plan->pass_im + m;
+  plan->split_im = plan->split_re + m;
+  plan->rev      = (uint16_t *)(plan->split_im + m);
+  plan->refs = 1;
+  plan->bits = bits;
+  plan->size = m;
+
+  for (i = 0; i < m; i++) {
+    unsigned int v = i, r = 0;
+    int b;
+    for (b = bits - 1; b > 0; b--) {
+      r = (r << 1) | (v & 1);
+      v >>= 1;
     }
-  return (retn);
-}
-
-/*
- *  Here is the real work-horse.
- *  It's a generic FFT, so nothing is lost or approximated.
- *  The samples in wave[] should be in order, and they
- *  will be decimated when fft() returns.
- */
-void fft_compute (fft_t *fft, complex_t wave[])
-{
-  int      loop;
-  unsigned i1;             /* going to right shift this */
-  int      i2;
-  int      bits = fft->bits;
-
-  i1 = SAMPLES / 2;
-  i2 = 1;
-
-  /* perform the butterflys */
-
-  for (loop = 0; loop < bits; loop++)
-    {
-      int loop1;
-      int i3, i4;
-
-      i3 = 0;
-      i4 = i1;
-
-      for (loop1 = 0; loop1 < i2; loop1++)
-        {
-          int loop2;
-          int y;
-          double z1, z2;
-
-          y  = fft->PermuteTable[(i3 / (int)i1) & fft->bmask];
-          z1 = COSINE(y);
-          z2 = -SINE(y);
-
-          for (loop2 = i3; loop2 < i4; loop2++)
-            {
-              double a1, a2, b1, b2;
+    plan->rev[i] = r;
+  }
 
-              a1 = REAL(loop2);
-              a2 = IMAG(loop2);
+  for (i = 4; i < m; i <<= 1) {
+    int j;
+    for (j = 0; j < i; j++) {
+      plan->pass_re[i + j] = cos (pi * j / i);
+      plan->pass_im[i + j] = -sin (pi * j / i);
+    }
+  }
 
-              b1 = z1 * REAL(loop2+i1) - z2 * IMAG(loop2+i1);
-              b2 = z2 * REAL(loop2+i1) + z1 * IMAG(loop2+i1);
+  for (i = 0; i < m; i++) {
+    plan->split_re[i] = cos (2.0 * pi * i / n);
+    plan->split_im[i] = -sin (2.0 * pi * i / n);
+  }
 
-              REAL(loop2) = a1 + b1;
-              IMAG(loop2) = a2 + b2;
+  /*
+   * Generalized Hamming window function.
+   * Set ALPHA to 0.54 for a hanning window. (Good idea)
+   */
+  for (i = 0; i < n; i++)
+    plan->window[i] = (ALPHA + (1.0 - ALPHA) * cos (2.0 * pi / (n - 1) * (i - n / 2))) / n;
 
-              REAL(loop2+i1) = a1 - b1;
-              IMAG(loop2+i1) = a2 - b2;
-            }
+  return plan;
+}
 
-          i3 += (i1 << 1);
-          i4 += (i1 << 1);
-        }
+static fft_plan_t *fft_plan_get (int bits) {
+  fft_plan_t *plan;
+
+  pthread_mutex_lock (&fft_plans_lock);
+  plan = fft_plans[bits];
+  if (plan)
+    plan->refs++;
+  else
+    plan = fft_plans[bits] = fft_plan_new (bits);
+  pthread_mutex_unlock (&fft_plans_lock);
+  return plan;
+}
 
-      i1 >>= 1;
-      i2 <<= 1;
-    }
+static void fft_plan_put (fft_plan_t *plan) {
+  pthread_mutex_lock (&fft_plans_lock);
+  if (--plan->refs == 0) {
+    fft_plans[plan->bits] = NULL;
+    xine_free_aligned (plan->window);
+    free (plan);
+  }
+  pthread_mutex_unlock (&fft_plans_lock);
 }
 
-/*
- *  Initializer for FFT routines.  Currently only sets up tables.
- *  - Generates scaled lookup tables for sin() and cos()
- *  - Fills a table for the Hamming window function
- */
-fft_t *fft_new (int bits)
-{
+fft_t *fft_new (int bits) {
   fft_t *fft;
-  int i;
-  const double   TWOPIoN   = (atan(1.0) * 8.0) / (double)SAMPLES;
-  const double   TWOPIoNm1 = (atan(1.0) * 8.0) / (double)(SAMPLES - 1);
 
-  /* printf("fft_new: bits=%d\n", bits); */
+  if ((bits < FFT_MIN_BITS) || (bits > FFT_MAX_BITS))
+    return NULL;
 
-  fft = malloc (sizeof (fft_t));
+  fft = malloc (sizeof (*fft));
   if (!fft)
     return NULL;
-
-  /* xine just uses 9 or 11. */
-  fft->bits = bits;
-  fft->bmask = SAMPLES - 1;
-  fft->PermuteTable = malloc (sizeof (int) * SAMPLES);
-  if (!fft->PermuteTable) {
+  fft->plan = fft_plan_get (bits);
+  if (!fft->plan) {
     free (fft);
     return NULL;
   }
-  for (i = 0; i < SAMPLES; i++) {
-    fft->PermuteTable[i] = PERMUTE (i, bits);
-  }
-
-  fft->SineTable   = malloc (3 * sizeof(double) * SAMPLES);
-  if (!fft->SineTable) {
-    free (fft->PermuteTable);
+  fft->re = xine_mallocz_aligned (fft->plan->size * 2 * sizeof (float));
+  if (!fft->re) {
+    fft_plan_put (fft->plan);
     free (fft);
     return NULL;
   }
-  fft->CosineTable = fft->SineTable + SAMPLES;
-  fft->WinTable    = fft->SineTable + 2 * SAMPLES;
-  for (i = 0; i < SAMPLES; i++) {
-    double a = (double) i * TWOPIoN;
-    fft->SineTable[i]   = sin (a);
-    fft->CosineTable[i] = cos (a);
-  }
-      /*
-       * Generalized Hamming window function.
-       * Set ALPHA to 0.54 for a hanning window. (Good idea)
-       */
-  for (i = 0; i < SAMPLES; i++)
-    fft->WinTable[i] = ALPHA + ((1.0 - ALPHA) * cos (TWOPIoNm1 * (i - SAMPLES/2)));
-
+  fft->im = fft->re + fft->plan->size;
   return fft;
 }
 
-void fft_dispose(fft_t *fft)
-{
-  if (fft)
-  {
-    free(fft->PermuteTable);
-    free(fft->SineTable);
-    free(fft);
+void fft_dispose (fft_t *fft) {
+  if (fft) {
+    xine_free_aligned (fft->re);
+    fft_plan_put (fft->plan);
+    free (fft);
   }
 }
 
-/*
- *  Apply some windowing function to the samples.
- */
-void fft_window (fft_t *fft, complex_t wave[])
-{
-  int i;
-  int bits = fft->bits;
-
-  for (i = 0; i < SAMPLES; i++)
-    {
-      REAL(i) *= WINDOW(i);
-      IMAG(i) *= WINDOW(i);
-    }
+/* one radix 2 pass over 2 * h values. */
+static void fft_pass (float *ar, float *ai, float *br, float *bi,
+                      const float *wr, const float *wi, int h) {
+  int j;
+
+  for (j = 0; j < h; j++) {
+    float tr = br[j] * wr[j] - bi[j] * wi[j];
+    float ti = br[j] * wi[j] + bi[j] * wr[j];
+    br[j] = ar[j] - tr;
+    bi[j] = ai[j] - ti;
+    ar[j] = ar[j] + tr;
+    ai[j] = ai[j] + ti;
+  }
 }
 
-/*
- *  Calculate amplitude of component n in the decimated wave[] array.
- */
-double fft_amp (int n, complex_t wave[], int bits)
-{
-  n = PERMUTE (n, bits);
-  return (hypot (REAL(n), IMAG(n)));
-}
+static void fft_complex (fft_plan_t *plan, float *re, float *im) {
+  int m = plan->size, h, s;
+
+  if (m < 4) {
+    float r = re[1], i = im[1];
+    re[1] = re[0] - r;
+    im[1] = im[0] - i;
+    re[0] += r;
+    im[0] += i;
+    return;
+  }
+
+  /* first 2 passes, twiddles 1 and -i. */
+  for (s = 0; s < m; s += 4) {
+    float r0 = re[s] + re[s + 1], i0 = im[s] + im[s + 1];
+    float r1 = re[s] - re[s + 1], i1 = im[s] - im[s + 1];
+    float r2 = re[s + 2] + re[s + 3], i2 = im[s + 2] + im[s + 3];
+    float r3 = re[s + 2] - re[s + 3], i3 = im[s + 2] - im[s + 3];
+    re[s]     = r0 + r2;
+    im[s]     = i0 + i2;
+    re[s + 2] = r0 - r2;
+    im[s + 2] = i0 - i2;
+    re[s + 1] = r1 + i3;
+    im[s + 1] = i1 - r3;
+    re[s + 3] = r1 - i3;
+    im[s + 3] = i1 + r3;
+  }
 
-double fft_amp2 (fft_t *fft, int n, complex_t wave[])
-{
-  n = fft->PermuteTable[n & fft->bmask];
-  return (hypot (REAL(n), IMAG(n)));
+  for (h = 4; h < m; h <<= 1) {
+    for (s = 0; s < m; s += 2 * h)
+      fft_pass (re + s, im + s, re + s + h, im + s + h, plan->pass_re + h, plan->pass_im + h, h);
+  }
 }
 
-/*
- *  Scale sampled values.
- *  Do this *before* the fft.
- */
-void fft_scale (complex_t wave[], int bits)
-{
-  int i, n = 1 << bits;
-  double m = (double)1 / n;
-
-  for (i = 0; i < n; i++)  {
-    wave[i].re *= m;
-    wave[i].im *= m;
+void fft_amp_real (fft_t *fft, const float *samples, float *amp, int num) {
+  fft_plan_t *plan = fft->plan;
+  const float *win = plan->window, *sr = plan->split_re, *si = plan->split_im;
+  float *re = fft->re, *im = fft->im;
+  int m = plan->size, k;
+
+  for (k = 0; k < m; k++) {
+    int r = plan->rev[k] * 2;
+    re[k] = samples[r] * win[r];
+    im[k] = samples[r + 1] * win[r + 1];
+  }
+
+  fft_complex (plan, re, im);
+
+  /* X[k] = E[k] + W^k O[k], with the spectra of the even and odd samples
+   * E[k] = (Z[k] + Z*[m - k]) / 2 and O[k] = -i (Z[k] - Z*[m - k]) / 2. */
+  if (num > m + 1)
+    num = m + 1;
+  if (num > 0)
+    amp[0] = fabsf (re[0] + im[0]);
+  for (k = 1; k < num && k < m; k++) {
+    float er = 0.5f * (re[k] + re[m - k]);
+    float ei = 0.5f * (im[k] - im[m - k]);
+    float odr = 0.5f * (im[k] + im[m - k]);
+    float odi = -0.5f * (re[k] - re[m - k]);
+    float xr = er + sr[k] * odr - si[k] * odi;
+    float xi = ei + sr[k] * odi + si[k] * odr;
+    amp[k] = sqrtf (xr * xr + xi * xi);
   }
+  if (num > m)
+    amp[m] = fabsf (re[0] - im[0]);
 }
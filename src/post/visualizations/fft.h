@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2000-2018 the xine project
+ * Copyright (C) 2000-2020 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -21,33 +21,18 @@
 #ifndef FFT_H
 #define FFT_H
 
-struct complex_s
-{
-  double re;
-  double im;
-};
-typedef struct complex_s complex_t;
-
-
-struct fft_s {
-  int bits;
-  double *SineTable;
-  double *CosineTable;
-  double *WinTable;
-  int    *PermuteTable;
-  int     bmask;
-};
+/* Single precision FFT of real samples. The sin/cos, bit reverse and window
+ * tables are shared by all users of the same size. Not thread safe per fft_t,
+ * but different fft_t of the same size may be used in parallel. */
 typedef struct fft_s fft_t;
 
+/* 1 << bits samples, bits 2..15. */
 fft_t  *fft_new (int bits);
-void    fft_dispose(fft_t *fft);
-
-void    fft_compute (fft_t *fft, complex_t wave[]);
-void    fft_window (fft_t *fft, complex_t wave[]);
-
-double  fft_amp (int n, complex_t wave[], int bits);
-void    fft_scale (complex_t wave[], int bits);
+void    fft_dispose (fft_t *fft);
 
-double  fft_amp2 (fft_t *fft, int n, complex_t wave[]);
+/* Apply the Hamming window to 1 << bits samples, transform, and return the
+ * amplitudes of the first num frequency bins, scaled by 1 / (1 << bits).
+ * num may be up to (1 << bits) / 2 + 1. samples is not modified. */
+void    fft_amp_real (fft_t *fft, const float *samples, float *amp, int num);
 
 #endif /* FFT_H */
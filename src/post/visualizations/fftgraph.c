@@ -66,7 +66,7 @@ struct post_plugin_fftgraph_s {
   double ratio;
 
   int data_idx;
-  complex_t wave[MAXCHANNELS][NUMSAMPLES];
+  float wave[MAXCHANNELS][NUMSAMPLES];
   audio_buffer_t buf;   /* dummy buffer just to hold a copy of audio data */
 
   int channels;
@@ -126,6 +126,7 @@ static void draw_fftgraph(post_plugin_fftgraph_t *this, vo_frame_t *frame) {
   int map_ptr;
   uint32_t yuy2_white;
   int line, line_min, line_max;
+  float amp[FFTGRAPH_WIDTH / 2];
 
   yuy2_white = be2me_32((0xFF << 24) |
 			(0x80 << 16) |
@@ -134,15 +135,13 @@ static void draw_fftgraph(post_plugin_fftgraph_t *this, vo_frame_t *frame) {
 
   for (c = 0; c < this->channels; c++){
     /* perform FFT for channel data */
-    fft_window(this->fft, this->wave[c]);
-    fft_scale(this->wave[c], this->fft->bits);
-    fft_compute(this->fft, this->wave[c]);
+    fft_amp_real (this->fft, this->wave[c], amp, FFTGRAPH_WIDTH / 2);
 
     /* plot the FFT points for the channel */
     line = this->cur_line + c * this->lines_per_channel;
 
     for (i = 0; i < FFTGRAPH_WIDTH / 2; i++) {
-      double amp_float = fft_amp2 (this->fft, i, this->wave[c]);
+      double amp_float = amp[i];
       this->map[line][i] = this->yuy2_colors[d2db (amp_float)];
     }
   }
@@ -345,8 +344,7 @@ static void fftgraph_port_put_buffer (xine_audio_port_t *port_gen,
       for( i = samples_used; i < buf->num_frames && this->data_idx < NUMSAMPLES;
            i++, this->data_idx++, data8 += this->channels ) {
         for( c = 0; c < this->channels; c++){
-          this->wave[c][this->data_idx].re = (double)(data8[c] << 8) - 0x8000;
-          this->wave[c][this->data_idx].im = 0;
+          this->wave[c][this->data_idx] = (float)((data8[c] << 8) - 0x8000);
         }
       }
     } else {
@@ -356,8 +354,7 @@ static void fftgraph_port_put_buffer (xine_audio_port_t *port_gen,
       for( i = samples_used; i < buf->num_frames && this->data_idx < NUMSAMPLES;
            i++, this->data_idx++, data += this->channels ) {
         for( c = 0; c < this->channels; c++){
-          this->wave[c][this->data_idx].re = (double)data[c];
-          this->wave[c][this->data_idx].im = 0;
+          this->wave[c][this->data_idx] = (float)data[c];
         }
       }
     }
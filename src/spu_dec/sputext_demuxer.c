@@ -38,6 +38,7 @@
 #include <string.h>
 #include <sys/types.h>
 #include <ctype.h>
+#include <limits.h>
 
 #define LOG_MODULE "demux_sputext"
 #define LOG_VERBOSE
@@ -54,6 +55,7 @@
 #define ERR           (void *)-1
 #define SUB_MAX_TEXT  5
 #define SUB_BUFSIZE   1024
+#define SUB_READSIZE  (64 << 10)
 #define LINE_LEN      1000
 #define LINE_LEN_QUOT "1000"
 
@@ -72,6 +74,19 @@ typedef struct {
 
 } subtitle_t;
 
+/* what stays in memory of a parsed subtitle. The text lines are stored
+ * one after another in a shared pool, each terminated by '\0'. */
+typedef struct {
+
+  long start;     /* csecs or frames */
+  long end;
+  long end_max;   /* latest end of this and all previous subtitles, for seeking */
+
+  uint32_t text;  /* offset into the text pool */
+  int lines;
+
+} sub_index_t;
+
 
 typedef struct {
 
@@ -81,21 +96,26 @@ typedef struct {
 
   int                status;
 
-  char               buf[SUB_BUFSIZE];
-  off_t              buflen;
+  /* input is read in big chunks, lines are taken from buf[bufpos..buflen[ */
+  size_t             bufpos, buflen;
+  int                bufeof;
 
   float              mpsub_position;
 
   int                uses_time;
   int                errs;
-  subtitle_t        *subtitles;
-  int                num;            /* number of subtitle structs */
+  sub_index_t       *subtitles;
+  char              *text;           /* text pool                  */
+  size_t             text_used, text_size;
+  int                num;            /* number of subtitles        */
   int                cur;            /* current subtitle           */
   int                format;         /* constants see below        */
   char               next_line[SUB_BUFSIZE]; /* a buffer for next line read from file */
 
   char              *encoding; /* charset. NULL if unknown. currently only "utf-8" autodetected. */
 
+  char               buf[SUB_READSIZE];
+
 } demux_sputext_t;
 
 /*
@@ -137,42 +157,58 @@ static inline void trail_space(char *s) {
 
 /*
  * Reimplementation of fgets() using the input->read() method.
+ * Lines longer than len are split.
  */
 static char *read_line_from_input(demux_sputext_t *this, char *line, off_t len) {
-  off_t nread = 0;
-  char *s;
-  int linelen;
+  size_t avail = this->buflen - this->bufpos, linelen;
+  char *s, *e;
+
+  /* refill with as much as fits, few big reads are much faster on network file systems. */
+  if ((avail < (size_t)len) && !this->bufeof) {
+    off_t nread;
 
-  if ((len - this->buflen) > 512 && len < SUB_BUFSIZE) {
-    if((nread = this->input->read(this->input,
-				  &this->buf[this->buflen], len - this->buflen)) < 0) {
+    if (this->bufpos) {
+      memmove (this->buf, this->buf + this->bufpos, avail);
+      this->bufpos = 0;
+      this->buflen = avail;
+    }
+    nread = this->input->read (this->input, this->buf + avail, SUB_READSIZE - avail);
+    if (nread < 0) {
       xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG, "read failed.\n");
       return NULL;
     }
+    if (nread == 0)
+      this->bufeof = 1;
+    this->buflen += nread;
+    avail += nread;
   }
 
-  this->buflen += nread;
-  this->buf[this->buflen] = '\0';
-
-  s = strchr(this->buf, '\n');
-
-  if (line && (s || this->buflen)) {
-
-    linelen = s ? (s - this->buf) + 1 : this->buflen;
+  if (!line || !avail)
+    return NULL;
 
-    memcpy(line, this->buf, linelen);
-    line[linelen] = '\0';
+  s = this->buf + this->bufpos;
+  linelen = avail < (size_t)len ? avail : (size_t)len;
+  e = memchr (s, '\n', linelen);
+  if (e)
+    linelen = e - s + 1;
+  memcpy (line, s, linelen);
+  line[linelen] = '\0';
+  this->bufpos += linelen;
 
-    memmove(this->buf, &this->buf[linelen], SUB_BUFSIZE - linelen);
-    this->buflen -= linelen;
+  return line;
+}
 
-    return line;
+/* go back to the start of the input. */
+static int sub_rewind (demux_sputext_t *this) {
+  this->bufpos = this->buflen = 0;
+  this->bufeof = 0;
+  if (this->input->seek (this->input, 0, SEEK_SET) == -1) {
+    xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "seek failed.\n");
+    return 0;
   }
-
-  return NULL;
+  return 1;
 }
 
-
 static subtitle_t *sub_read_line_sami(demux_sputext_t *this, subtitle_t *current) {
 
   static char line[LINE_LEN + 1];
@@ -1095,37 +1131,34 @@ static int sub_autodetect (demux_sputext_t *this) {
   return FORMAT_UNKNOWN;  /* too many bad lines */
 }
 
-static int detect_utf8(subtitle_t *subs, int num_subs)
+static int detect_utf8(const char *text, size_t size)
 {
   /* return:
      -1: unknown (ASCII?)
       0: not valid utf-8
       1: valid utf-8
   */
-  int i, l, utf8 = -1;
-
-  for (i = 0; i < num_subs; i++) {
-    for (l = 0; l < subs[i].lines && subs[i].text[l]; l++) {
-      const uint8_t *c = subs[i].text[l];
-      for (; *c; c++) {
-        if (*c & 0x80) {
-          if ( (c[0]>=0xC2 && c[0]<=0xDF) && (c[1]>=0x80 && c[1]<=0xBF) ) {
-            /* valid 2-byte */
-            utf8 = 1;
-            c++;
-          } else if ( ( c[0]==0xE0 && (c[1]>=0xA0 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF)) ||
-                      ( (c[0]>=0xE1 && c[0]<=0xEC) && (c[1]>=0x80 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF)) ||
-                      ( c[0]==0xED && (c[1]>=0x80 && c[1]<=0x9F) && (c[2]>=0x80 && c[1]<=0xBF))  ||
-                      ( c[0]==0xEE && (c[1]>=0xA4 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF) ) ||
-                      ( c[0]==0xEF && (c[1]>=0xA4 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF) )) {
-            /* valid 3-byte */
-            utf8 = 1;
-            c += 2;
-          } else {
-            /* TODO: 4-byte not checked */
-            return 0;
-          }
-        }
+  int utf8 = -1;
+
+  const uint8_t *c = (const uint8_t *)text, *e = c + size;
+  /* the '\0' between the lines stops all multibyte checks. */
+  for (; c < e; c++) {
+    if (*c & 0x80) {
+      if ( (c[0]>=0xC2 && c[0]<=0xDF) && (c[1]>=0x80 && c[1]<=0xBF) ) {
+        /* valid 2-byte */
+        utf8 = 1;
+        c++;
+      } else if ( ( c[0]==0xE0 && (c[1]>=0xA0 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF)) ||
+                  ( (c[0]>=0xE1 && c[0]<=0xEC) && (c[1]>=0x80 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF)) ||
+                  ( c[0]==0xED && (c[1]>=0x80 && c[1]<=0x9F) && (c[2]>=0x80 && c[1]<=0xBF))  ||
+                  ( c[0]==0xEE && (c[1]>=0xA4 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF) ) ||
+                  ( c[0]==0xEF && (c[1]>=0xA4 && c[1]<=0xBF) && (c[2]>=0x80 && c[1]<=0xBF) )) {
+        /* valid 3-byte */
+        utf8 = 1;
+        c += 2;
+      } else {
+        /* TODO: 4-byte not checked */
+        return 0;
       }
     }
   }
@@ -1133,11 +1166,50 @@ static int detect_utf8(subtitle_t *subs, int num_subs)
   return utf8;
 }
 
-static subtitle_t *sub_read_file (demux_sputext_t *this) {
+/* move the text of a parsed subtitle into the pool. */
+static int sub_add_text (demux_sputext_t *this, sub_index_t *index, subtitle_t *sub) {
+  size_t need = 0;
+  int l;
+
+  for (l = 0; l < sub->lines; l++)
+    need += (sub->text[l] ? strlen (sub->text[l]) : 0) + 1;
+
+  if (this->text_size - this->text_used < need) {
+    size_t size = this->text_size ? this->text_size : 4096;
+    char *text;
+    while (size - this->text_used < need)
+      size *= 2;
+    if (size > UINT32_MAX)
+      return 0;
+    text = realloc (this->text, size);
+    if (!text)
+      return 0;
+    this->text = text;
+    this->text_size = size;
+  }
+
+  index->start = sub->start;
+  index->end   = sub->end;
+  index->lines = sub->lines;
+  index->text  = this->text_used;
+  for (l = 0; l < sub->lines; l++) {
+    if (sub->text[l]) {
+      size_t len = strlen (sub->text[l]) + 1;
+      memcpy (this->text + this->text_used, sub->text[l], len);
+      this->text_used += len;
+      _x_freep (&sub->text[l]);
+    } else {
+      this->text[this->text_used++] = '\0';
+    }
+  }
+  return 1;
+}
+
+static sub_index_t *sub_read_file (demux_sputext_t *this) {
 
   int n_max;
   int timeout;
-  subtitle_t *first;
+  sub_index_t *first;
   subtitle_t * (*func[])(demux_sputext_t *this,subtitle_t *dest)=
   {
     sub_read_line_microdvd,
@@ -1157,11 +1229,8 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
   };
 
   /* Rewind (sub_autodetect() needs to read input from the beginning) */
-  if(this->input->seek(this->input, 0, SEEK_SET) == -1) {
-    xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "seek failed.\n");
+  if (!sub_rewind (this))
     return NULL;
-  }
-  this->buflen = 0;
 
   this->format=sub_autodetect (this);
   if (this->format==FORMAT_UNKNOWN) {
@@ -1172,14 +1241,11 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
   xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "Detected subtitle file format: %d\n",this->format);
 
   /* Rewind */
-  if(this->input->seek(this->input, 0, SEEK_SET) == -1) {
-    xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "seek failed.\n");
+  if (!sub_rewind (this))
     return NULL;
-  }
-  this->buflen = 0;
 
   this->num=0;n_max=32;
-  first = calloc(n_max, sizeof(subtitle_t));
+  first = calloc(n_max, sizeof(sub_index_t));
   if(!first) return NULL;
 
   {
@@ -1192,14 +1258,19 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
   else timeout *= 10;
 
   while(1) {
-    subtitle_t *sub;
+    subtitle_t current, *sub;
 
     if(this->num>=n_max){
-      n_max+=16;
-      first=realloc(first,n_max*sizeof(subtitle_t));
+      sub_index_t *more;
+      n_max += n_max >> 1;
+      more = realloc(first,n_max*sizeof(sub_index_t));
+      if (!more)
+        break;
+      first = more;
     }
 
-    sub = func[this->format] (this, &first[this->num]);
+    memset (&current, 0, sizeof (current));
+    sub = func[this->format] (this, &current);
 
     if (!sub)
       break;   /* EOF */
@@ -1207,6 +1278,8 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
     if (sub==ERR)
       ++this->errs;
     else {
+      if (!sub_add_text (this, &first[this->num], sub))
+        break;
       if (this->num > 0 && first[this->num-1].end == -1) {
 	/* end time not defined in the subtitle */
 	if (timeout > 0) {
@@ -1229,7 +1302,19 @@ static subtitle_t *sub_read_file (demux_sputext_t *this) {
       first[this->num-1].end = first[this->num-1].start + timeout;
     }
 
-  if (detect_utf8(first, this->num) > 0) {
+  /* for seeking */
+  {
+    long end_max = -1;
+    int i;
+    for (i = 0; i < this->num; i++) {
+      long end = first[i].end == -1 ? LONG_MAX : first[i].end;
+      if (end_max < end)
+        end_max = end;
+      first[i].end_max = end_max;
+    }
+  }
+
+  if (detect_utf8(this->text, this->text_used) > 0) {
     xprintf (this->stream->xine, XINE_VERBOSITY_LOG, "detected utf-8 subtitles\n");
     this->encoding = strdup("utf-8");
   }
@@ -1255,7 +1340,8 @@ static int demux_sputext_next (demux_sputext_t *this_gen) {
   buf_element_t *buf;
   uint32_t *val;
   char *str;
-  subtitle_t *sub;
+  sub_index_t *sub;
+  const char *text;
   int line;
 
   if (this->cur >= this->num)
@@ -1273,8 +1359,10 @@ static int demux_sputext_next (demux_sputext_t *this_gen) {
   *val++ = (this->uses_time) ? sub->start * 10 : sub->start;
   *val++ = (this->uses_time) ? sub->end * 10 : sub->end;
   str = (char *)val;
+  text = this->text + sub->text;
   for (line = 0; line < sub->lines; line++, str+=strlen(str)+1) {
-    strlcpy(str, sub->text[line], SUB_BUFSIZE);
+    strlcpy(str, text, SUB_BUFSIZE);
+    text += strlen (text) + 1;
   }
 
   if (this->encoding) {
@@ -1292,13 +1380,9 @@ static int demux_sputext_next (demux_sputext_t *this_gen) {
 
 static void demux_sputext_dispose (demux_plugin_t *this_gen) {
   demux_sputext_t *this = (demux_sputext_t *) this_gen;
-  int i, l;
 
-  for (i = 0; i < this->num; i++) {
-    for (l = 0; l < this->subtitles[i].lines; l++)
-      _x_freep(&this->subtitles[i].text[l]);
-  }
   _x_freep(&this->subtitles);
+  _x_freep(&this->text);
   _x_freep(&this->encoding);
   free(this);
 }
@@ -1335,13 +1419,26 @@ static int demux_sputext_seek (demux_plugin_t *this_gen,
   lprintf("seek() called\n");
 
   (void)start_pos;
-  (void)start_time;
   (void)playing;
 
-  /* simple seeking approach: just go back to start.
-   * decoder will discard subtitles until the desired position.
-   */
+  /* start with the first subtitle that may still be visible, the decoder
+   * will discard the rest until the desired position. Without time, just
+   * go back to start. */
   this->cur = 0;
+  if (this->uses_time && (start_time > 0)) {
+    int64_t offs = this->stream->master->metronom->get_option (this->stream->master->metronom,
+                                                               METRONOM_SPU_OFFSET);
+    long t = (start_time - offs / 90) / 10;
+    int lo = 0, hi = this->num;
+    while (lo < hi) {
+      int mid = (lo + hi) >> 1;
+      if (this->subtitles[mid].end_max < t)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    this->cur = lo;
+  }
   this->status = DEMUX_OK;
 
   _x_demux_flush_engine (this->stream);
@@ -1418,8 +1515,6 @@ static demux_plugin_t *open_demux_plugin (demux_class_t *class_gen, xine_stream_
   this->demux_plugin.get_optional_data = demux_sputext_get_optional_data;
   this->demux_plugin.demux_class       = class_gen;
 
-  this->buflen = 0;
-
   switch (stream->content_detection_method) {
   case METHOD_BY_MRL:
     {
@@ -1466,6 +1561,7 @@ static demux_plugin_t *open_demux_plugin (demux_class_t *class_gen, xine_stream_
     /* falling through is intended */
   }
 
+  free (this->text);
   free (this);
   return NULL;
 }
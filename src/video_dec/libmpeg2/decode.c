@@ -39,6 +39,7 @@
 
 #include <xine/xine_internal.h>
 #include <xine/video_out.h>
+#include <xine/worker_pool.h>
 
 #include "mpeg2.h"
 #include "mpeg2_internal.h"
@@ -52,6 +53,179 @@
 /* #define BUFFER_SIZE (224 * 1024) */
 #define BUFFER_SIZE (1194 * 1024) /* new buffer size for mpeg2dec 0.2.1 */
 
+/*
+ * slice threading
+ *
+ * Slices of a software decoded picture are copied aside, and decoded in
+ * parallel when the picture is complete. Each macroblock row is one job,
+ * working on its own copy of the decoder state. Slices only write their
+ * own macroblocks, and read reference pictures that are already complete.
+ */
+
+#define MAX_SLICE_THREADS 16
+/* zero bytes after each slice, the bit reader reads ahead */
+#define SLICE_PAD 16
+
+typedef struct {
+    uint32_t offset;
+    int code;
+} mpeg2_slice_t;
+
+struct mpeg2_slices_s {
+    xine_worker_pool_t * pool;
+    picture_t * picture;
+    uint8_t * buf;
+    uint32_t buf_used, buf_size;
+    mpeg2_slice_t * slices;
+    int num_slices, max_slices;
+    /* first slice of each job, and an end marker */
+    int * jobs;
+    /* the job has decoded the last macroblock row */
+    uint8_t * at_bottom;
+};
+
+static void mpeg2_slices_job (void * data, int job)
+{
+    mpeg2_slices_t * s = (mpeg2_slices_t *)data;
+    picture_t picture;
+    int i;
+
+    memcpy (&picture, s->picture, sizeof (picture));
+    s->at_bottom[job] = 0;
+    for (i = s->jobs[job]; i < s->jobs[job + 1]; i++) {
+	mpeg2_slice (&picture, s->slices[i].code, s->buf + s->slices[i].offset);
+	if (picture.v_offset > picture.limit_y ||
+	    picture.v_offset + 16 > picture.display_height)
+	    s->at_bottom[job] = 1;
+    }
+}
+
+/* decode all pending slices of the current picture. */
+static void mpeg2_slices_flush (mpeg2dec_t * mpeg2dec)
+{
+    mpeg2_slices_t * s = mpeg2dec->slices;
+    int i, num_jobs;
+
+    if (!s || !s->num_slices)
+	return;
+
+    num_jobs = 0;
+    for (i = 0; i < s->num_slices; i++) {
+	if (!i || (s->slices[i].code != s->slices[i - 1].code))
+	    s->jobs[num_jobs++] = i;
+    }
+    s->jobs[num_jobs] = s->num_slices;
+
+    s->picture = mpeg2dec->picture;
+    xine_worker_pool_run (s->pool, mpeg2_slices_job, s, num_jobs);
+
+    for (i = 0; i < num_jobs; i++) {
+	if (s->at_bottom[i])
+	    mpeg2dec->picture->current_frame->bad_frame = 0;
+    }
+
+    s->num_slices = 0;
+    s->buf_used = 0;
+}
+
+/* queue a slice for threaded decoding. returns 0 if it needs to be
+ * decoded right away. */
+static int mpeg2_slices_add (mpeg2dec_t * mpeg2dec, int code, uint8_t * buffer)
+{
+    mpeg2_slices_t * s = mpeg2dec->slices;
+    picture_t * picture = mpeg2dec->picture;
+    vo_frame_t * frame = picture->current_frame;
+    uint32_t size = mpeg2dec->chunk_size;
+
+    if (!s || frame->proc_slice || (frame->format != XINE_IMGFMT_YV12))
+	return 0;
+    /* let libmpeg2_accel_slice () handle missing references */
+    if ((frame->picture_coding_type == XINE_PICT_P_TYPE) ||
+	(frame->picture_coding_type == XINE_PICT_B_TYPE)) {
+	if (!picture->forward_reference_frame ||
+	    (picture->forward_reference_frame->format != frame->format))
+	    return 0;
+    }
+    if (frame->picture_coding_type == XINE_PICT_B_TYPE) {
+	if (!picture->backward_reference_frame ||
+	    (picture->backward_reference_frame->format != frame->format))
+	    return 0;
+    }
+
+    if (s->buf_used + size + SLICE_PAD > s->buf_size) {
+	uint32_t new_size = (s->buf_used + size + SLICE_PAD) * 3 / 2;
+	uint8_t * new_buf = realloc (s->buf, new_size);
+	if (!new_buf)
+	    return 0;
+	s->buf = new_buf;
+	s->buf_size = new_size;
+    }
+    if (s->num_slices >= s->max_slices) {
+	int new_max = s->max_slices ? 2 * s->max_slices : 128;
+	mpeg2_slice_t * new_slices = realloc (s->slices, new_max * sizeof (*new_slices));
+	int * new_jobs = realloc (s->jobs, (new_max + 1) * sizeof (*new_jobs));
+	uint8_t * new_at_bottom = realloc (s->at_bottom, new_max);
+	if (new_slices)
+	    s->slices = new_slices;
+	if (new_jobs)
+	    s->jobs = new_jobs;
+	if (new_at_bottom)
+	    s->at_bottom = new_at_bottom;
+	if (!new_slices || !new_jobs || !new_at_bottom)
+	    return 0;
+	s->max_slices = new_max;
+    }
+
+    s->slices[s->num_slices].offset = s->buf_used;
+    s->slices[s->num_slices].code = code;
+    s->num_slices++;
+    xine_fast_memcpy (s->buf + s->buf_used, buffer, size);
+    memset (s->buf + s->buf_used + size, 0, SLICE_PAD);
+    s->buf_used += size + SLICE_PAD;
+    return 1;
+}
+
+static void mpeg2_slices_free (mpeg2dec_t * mpeg2dec)
+{
+    mpeg2_slices_t * s = mpeg2dec->slices;
+
+    if (!s)
+	return;
+    mpeg2dec->slices = NULL;
+    xine_worker_pool_delete (s->pool);
+    free (s->buf);
+    free (s->slices);
+    free (s->jobs);
+    free (s->at_bottom);
+    free (s);
+}
+
+void mpeg2_set_threads (mpeg2dec_t * mpeg2dec, int threads)
+{
+    mpeg2_slices_t * s;
+
+    mpeg2_slices_flush (mpeg2dec);
+    mpeg2_slices_free (mpeg2dec);
+
+    if (threads <= 0)
+	threads = xine_cpu_count ();
+    if (threads > MAX_SLICE_THREADS)
+	threads = MAX_SLICE_THREADS;
+    /* hardware decoding does its own thing */
+    if ((threads < 2) || (mpeg2dec->frame_format != XINE_IMGFMT_YV12))
+	return;
+
+    s = calloc (1, sizeof (*s));
+    if (!s)
+	return;
+    s->pool = xine_worker_pool_new (threads);
+    if (!s->pool) {
+	free (s);
+	return;
+    }
+    mpeg2dec->slices = s;
+}
+
 static void process_userdata(mpeg2dec_t *mpeg2dec, uint8_t *buffer);
 
 void mpeg2_init (mpeg2dec_t * mpeg2dec, 
@@ -263,8 +437,10 @@ static inline int parse_chunk (mpeg2dec_t * mpeg2dec, int code,
     picture = mpeg2dec->picture;
     is_frame_done = mpeg2dec->in_slice && ((!code) || (code >= 0xb0));
 
-    if (is_frame_done)
+    if (is_frame_done) {
 	mpeg2dec->in_slice = 0;
+	mpeg2_slices_flush (mpeg2dec);
+    }
     
     if (is_frame_done && picture->current_frame != NULL) {
 
@@ -576,12 +752,14 @@ static inline int parse_chunk (mpeg2dec_t * mpeg2dec, int code,
 	  printf("slice target %08x past %08x future %08x\n",picture->current_frame,picture->forward_reference_frame,picture->backward_reference_frame);
 	  fflush(stdout);
 #endif
-	  libmpeg2_accel_slice(&mpeg2dec->accel, picture, code, buffer, mpeg2dec->chunk_size, 
-			       mpeg2dec->chunk_buffer);
+	  if (!mpeg2_slices_add (mpeg2dec, code, buffer)) {
+	    libmpeg2_accel_slice(&mpeg2dec->accel, picture, code, buffer, mpeg2dec->chunk_size, 
+				 mpeg2dec->chunk_buffer);
 
-	  if( picture->v_offset > picture->limit_y || 
-	      picture->v_offset + 16 > picture->display_height ) { 
-	    picture->current_frame->bad_frame = 0;
+	    if( picture->v_offset > picture->limit_y || 
+		picture->v_offset + 16 > picture->display_height ) { 
+	      picture->current_frame->bad_frame = 0;
+	    }
 	  }
 	}
     }
@@ -726,6 +904,7 @@ void mpeg2_discontinuity (mpeg2dec_t * mpeg2dec) {
   if( !picture )
     return;
   
+  mpeg2_slices_flush (mpeg2dec);
   mpeg2dec->in_slice = 0;
   mpeg2dec->pts = 0;  
   if ( picture->current_frame )
@@ -793,6 +972,8 @@ void mpeg2_flush (mpeg2dec_t * mpeg2dec) {
   if (!picture)
     return;
   
+  mpeg2_slices_flush (mpeg2dec);
+
   if (picture->current_frame && !picture->current_frame->drawn &&
       !picture->current_frame->bad_frame) {
     
@@ -819,6 +1000,9 @@ void mpeg2_close (mpeg2dec_t * mpeg2dec)
     }
     */
 
+    mpeg2_slices_flush (mpeg2dec);
+    mpeg2_slices_free (mpeg2dec);
+
     /* 
       dont remove any picture->*->free() below. doing so will cause buffer 
       leak, and we only have about 15 of them.
@@ -283,7 +283,17 @@ void mpeg2_idct_init (uint32_t mm_accel)
     mpeg2_zero_block = mpeg2_zero_block_c;
 
 #if defined(ARCH_X86)
-    if (mm_accel & MM_ACCEL_X86_MMXEXT) {
+    if (mm_accel & MM_ACCEL_X86_SSE2) {
+#ifdef LOG
+	fprintf (stderr, "Using SSE2 for IDCT transform\n");
+#endif
+	mpeg2_idct_copy = mpeg2_idct_copy_sse2;
+	mpeg2_idct_add = mpeg2_idct_add_sse2;
+	mpeg2_idct     = mpeg2_idct_sse2;
+	mpeg2_zero_block = mpeg2_zero_block_sse2;
+	/* same input order as mmx */
+	mpeg2_idct_mmx_init ();
+    } else if (mm_accel & MM_ACCEL_X86_MMXEXT) {
 #ifdef LOG
 	fprintf (stderr, "Using MMXEXT for IDCT transform\n");
 #endif
@@ -738,4 +738,284 @@ void mpeg2_idct_mmx_init (void)
     }
 }
 
+/* SSE2 IDCT
+ *
+ * Same arithmetic as the MMXEXT version, so the results are bit exact.
+ * The row pass does two rows at a time, the column pass all 8 columns.
+ */
+
+#define sse2_table(c1,c2,c3,c4,c5,c6,c7) {  c4,  c2, -c4, -c2,  c4,  c2, -c4, -c2,	\
+					    c4,  c6,  c4,  c6,  c4,  c6,  c4,  c6,	\
+					    c1,  c3, -c1, -c5,  c1,  c3, -c1, -c5,	\
+					    c5,  c7,  c3, -c7,  c5,  c7,  c3, -c7,	\
+					    c4, -c6,  c4, -c6,  c4, -c6,  c4, -c6,	\
+					   -c4,  c2,  c4, -c2, -c4,  c2,  c4, -c2,	\
+					    c5, -c1,  c3, -c1,  c5, -c1,  c3, -c1,	\
+					    c7,  c3,  c7, -c5,  c7,  c3,  c7, -c5 }
+
+#define sse2_rounder(bias1,bias2) {round (bias1), round (bias1), round (bias2), round (bias2)}
+
+static inline void sse2_row_pair (int16_t * row1, int16_t * row2,
+				  const int16_t * table, const int32_t * rounder)
+{
+    __asm__ __volatile__ (
+	"movdqa       (%0), %%xmm2 \n\t"	/* x7 x5 x3 x1 x6 x4 x2 x0 */
+	"movdqa       (%1), %%xmm0 \n\t"
+	"movdqa     %%xmm2, %%xmm5 \n\t"
+	"punpcklqdq %%xmm0, %%xmm2 \n\t"	/* even x of both rows */
+	"punpckhqdq %%xmm0, %%xmm5 \n\t"	/* odd x of both rows */
+	"movdqa     %%xmm2, %%xmm0 \n\t"
+	"movdqa       (%2), %%xmm3 \n\t"
+	"movdqa     %%xmm5, %%xmm6 \n\t"
+	"movdqa     16(%2), %%xmm4 \n\t"
+	"pmaddwd    %%xmm0, %%xmm3 \n\t"	/* -C4*x4-C2*x6 C4*x0+C2*x2 */
+	"pshufd $0xb1, %%xmm2, %%xmm2 \n\t"	/* x2 x0 x6 x4 */
+	"movdqa     32(%2), %%xmm1 \n\t"
+	"pmaddwd    %%xmm2, %%xmm4 \n\t"	/* C4*x0+C6*x2 C4*x4+C6*x6 */
+	"pmaddwd    64(%2), %%xmm0 \n\t"	/* C4*x4-C6*x6 C4*x0-C6*x2 */
+	"pshufd $0xb1, %%xmm6, %%xmm6 \n\t"	/* x3 x1 x7 x5 */
+	"movdqa     48(%2), %%xmm7 \n\t"
+	"pmaddwd    %%xmm5, %%xmm1 \n\t"	/* -C1*x5-C5*x7 C1*x1+C3*x3 */
+	"paddd        (%3), %%xmm3 \n\t"
+	"pmaddwd    %%xmm6, %%xmm7 \n\t"	/* C3*x1-C7*x3 C5*x5+C7*x7 */
+	"pmaddwd    80(%2), %%xmm2 \n\t"	/* C4*x0-C2*x2 -C4*x4+C2*x6 */
+	"paddd      %%xmm4, %%xmm3 \n\t"	/* a1 a0 + rounder */
+	"pmaddwd    96(%2), %%xmm5 \n\t"	/* C3*x5-C1*x7 C5*x1-C1*x3 */
+	"movdqa     %%xmm3, %%xmm4 \n\t"
+	"pmaddwd   112(%2), %%xmm6 \n\t"	/* C7*x1-C5*x3 C7*x5+C3*x7 */
+	"paddd      %%xmm7, %%xmm1 \n\t"	/* b1 b0 */
+	"paddd        (%3), %%xmm0 \n\t"
+	"psubd      %%xmm1, %%xmm3 \n\t"	/* a1-b1 a0-b0 + rounder */
+	"psrad         $11, %%xmm3 \n\t"	/* y6 y7 */
+	"paddd      %%xmm4, %%xmm1 \n\t"	/* a1+b1 a0+b0 + rounder */
+	"paddd      %%xmm2, %%xmm0 \n\t"	/* a3 a2 + rounder */
+	"psrad         $11, %%xmm1 \n\t"	/* y1 y0 */
+	"paddd      %%xmm6, %%xmm5 \n\t"	/* b3 b2 */
+	"movdqa     %%xmm0, %%xmm4 \n\t"
+	"paddd      %%xmm5, %%xmm0 \n\t"	/* a3+b3 a2+b2 + rounder */
+	"psubd      %%xmm5, %%xmm4 \n\t"	/* a3-b3 a2-b2 + rounder */
+	"psrad         $11, %%xmm0 \n\t"	/* y3 y2 */
+	"psrad         $11, %%xmm4 \n\t"	/* y4 y5 */
+	"packssdw   %%xmm0, %%xmm1 \n\t"
+	"packssdw   %%xmm3, %%xmm4 \n\t"
+	"pshufd $0xd8, %%xmm1, %%xmm1 \n\t"	/* y3 y2 y1 y0 of both rows */
+	"pshufd $0xd8, %%xmm4, %%xmm4 \n\t"
+	"pshuflw $0xb1, %%xmm4, %%xmm4 \n\t"
+	"pshufhw $0xb1, %%xmm4, %%xmm4 \n\t"	/* y7 y6 y5 y4 of both rows */
+	"movdqa     %%xmm1, %%xmm0 \n\t"
+	"punpcklqdq %%xmm4, %%xmm1 \n\t"
+	"punpckhqdq %%xmm4, %%xmm0 \n\t"
+	"movdqa     %%xmm1, (%0)   \n\t"
+	"movdqa     %%xmm0, (%1)   \n\t"
+	:
+	: "r" (row1), "r" (row2), "r" (table), "r" (rounder)
+	: "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7");
+}
+
+static inline void sse2_col (int16_t * col)
+{
+    static const short consts[4 * 8] ATTR_ALIGN(16) = {
+	T1, T1, T1, T1, T1, T1, T1, T1,
+	T2, T2, T2, T2, T2, T2, T2, T2,
+	(short)T3, (short)T3, (short)T3, (short)T3, (short)T3, (short)T3, (short)T3, (short)T3,
+	C4, C4, C4, C4, C4, C4, C4, C4
+    };
+
+    __asm__ __volatile__ (
+	"movdqa       (%1), %%xmm0 \n\t"	/* T1 */
+	"movdqa     16(%0), %%xmm1 \n\t"	/* x1 */
+	"movdqa     %%xmm0, %%xmm2 \n\t"
+	"movdqa    112(%0), %%xmm4 \n\t"	/* x7 */
+	"pmulhw     %%xmm1, %%xmm0 \n\t"	/* T1*x1 */
+	"movdqa     32(%1), %%xmm5 \n\t"	/* T3 */
+	"pmulhw     %%xmm4, %%xmm2 \n\t"	/* T1*x7 */
+	"movdqa     80(%0), %%xmm6 \n\t"	/* x5 */
+	"movdqa     %%xmm5, %%xmm7 \n\t"
+	"movdqa     48(%0), %%xmm3 \n\t"	/* x3 */
+	"psubsw     %%xmm4, %%xmm0 \n\t"	/* v17 */
+	"movdqa     16(%1), %%xmm4 \n\t"	/* T2 */
+	"pmulhw     %%xmm3, %%xmm5 \n\t"	/* (T3-1)*x3 */
+	"paddsw     %%xmm2, %%xmm1 \n\t"	/* u17 */
+	"pmulhw     %%xmm6, %%xmm7 \n\t"	/* (T3-1)*x5 */
+	"movdqa     %%xmm4, %%xmm2 \n\t"
+	"paddsw     %%xmm3, %%xmm5 \n\t"	/* T3*x3 */
+	"pmulhw     32(%0), %%xmm4 \n\t"	/* T2*x2 */
+	"paddsw     %%xmm6, %%xmm7 \n\t"	/* T3*x5 */
+	"psubsw     %%xmm6, %%xmm5 \n\t"	/* v35 */
+	"paddsw     %%xmm3, %%xmm7 \n\t"	/* u35 */
+	"movdqa     96(%0), %%xmm3 \n\t"	/* x6 */
+	"movdqa     %%xmm0, %%xmm6 \n\t"
+	"pmulhw     %%xmm3, %%xmm2 \n\t"	/* T2*x6 */
+	"psubsw     %%xmm5, %%xmm0 \n\t"	/* b3 */
+	"psubsw     %%xmm3, %%xmm4 \n\t"	/* v26 */
+	"paddsw     %%xmm6, %%xmm5 \n\t"	/* v12 */
+	"movdqa     %%xmm0, 48(%0) \n\t"	/* save b3 */
+	"movdqa     %%xmm1, %%xmm6 \n\t"
+	"paddsw     32(%0), %%xmm2 \n\t"	/* u26 */
+	"paddsw     %%xmm7, %%xmm6 \n\t"	/* b0 */
+	"psubsw     %%xmm7, %%xmm1 \n\t"	/* u12 */
+	"movdqa     %%xmm1, %%xmm7 \n\t"
+	"movdqa       (%0), %%xmm3 \n\t"	/* x0 */
+	"paddsw     %%xmm5, %%xmm1 \n\t"	/* u12+v12 */
+	"movdqa     48(%1), %%xmm0 \n\t"	/* C4/2 */
+	"psubsw     %%xmm5, %%xmm7 \n\t"	/* u12-v12 */
+	"movdqa     %%xmm6, 80(%0) \n\t"	/* save b0 */
+	"pmulhw     %%xmm0, %%xmm1 \n\t"	/* b1/2 */
+	"movdqa     %%xmm4, %%xmm6 \n\t"
+	"pmulhw     %%xmm0, %%xmm7 \n\t"	/* b2/2 */
+	"movdqa     64(%0), %%xmm5 \n\t"	/* x4 */
+	"movdqa     %%xmm3, %%xmm0 \n\t"
+	"psubsw     %%xmm5, %%xmm3 \n\t"	/* v04 */
+	"paddsw     %%xmm5, %%xmm0 \n\t"	/* u04 */
+	"paddsw     %%xmm3, %%xmm4 \n\t"	/* a1 */
+	"movdqa     %%xmm0, %%xmm5 \n\t"
+	"psubsw     %%xmm6, %%xmm3 \n\t"	/* a2 */
+	"paddsw     %%xmm2, %%xmm5 \n\t"	/* a0 */
+	"paddsw     %%xmm1, %%xmm1 \n\t"	/* b1 */
+	"psubsw     %%xmm2, %%xmm0 \n\t"	/* a3 */
+	"paddsw     %%xmm7, %%xmm7 \n\t"	/* b2 */
+	"movdqa     %%xmm3, %%xmm2 \n\t"
+	"movdqa     %%xmm4, %%xmm6 \n\t"
+	"paddsw     %%xmm7, %%xmm3 \n\t"	/* a2+b2 */
+	"psraw          $6, %%xmm3 \n\t"	/* y2 */
+	"paddsw     %%xmm1, %%xmm4 \n\t"	/* a1+b1 */
+	"psraw          $6, %%xmm4 \n\t"	/* y1 */
+	"psubsw     %%xmm1, %%xmm6 \n\t"	/* a1-b1 */
+	"movdqa     80(%0), %%xmm1 \n\t"	/* b0 */
+	"psubsw     %%xmm7, %%xmm2 \n\t"	/* a2-b2 */
+	"psraw          $6, %%xmm6 \n\t"	/* y6 */
+	"movdqa     %%xmm5, %%xmm7 \n\t"
+	"movdqa     %%xmm4, 16(%0) \n\t"	/* save y1 */
+	"psraw          $6, %%xmm2 \n\t"	/* y5 */
+	"movdqa     %%xmm3, 32(%0) \n\t"	/* save y2 */
+	"paddsw     %%xmm1, %%xmm5 \n\t"	/* a0+b0 */
+	"movdqa     48(%0), %%xmm4 \n\t"	/* b3 */
+	"psubsw     %%xmm1, %%xmm7 \n\t"	/* a0-b0 */
+	"psraw          $6, %%xmm5 \n\t"	/* y0 */
+	"movdqa     %%xmm0, %%xmm3 \n\t"
+	"movdqa     %%xmm2, 80(%0) \n\t"	/* save y5 */
+	"psubsw     %%xmm4, %%xmm3 \n\t"	/* a3-b3 */
+	"psraw          $6, %%xmm7 \n\t"	/* y7 */
+	"paddsw     %%xmm0, %%xmm4 \n\t"	/* a3+b3 */
+	"movdqa     %%xmm5, (%0)   \n\t"	/* save y0 */
+	"psraw          $6, %%xmm3 \n\t"	/* y4 */
+	"movdqa     %%xmm6, 96(%0) \n\t"	/* save y6 */
+	"psraw          $6, %%xmm4 \n\t"	/* y3 */
+	"movdqa     %%xmm7, 112(%0) \n\t"	/* save y7 */
+	"movdqa     %%xmm3, 64(%0) \n\t"	/* save y4 */
+	"movdqa     %%xmm4, 48(%0) \n\t"	/* save y3 */
+	:
+	: "r" (col), "r" (consts)
+	: "memory", "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5", "xmm6", "xmm7");
+}
+
+static inline void sse2_idct (int16_t * block)
+{
+    static const int16_t table04[] ATTR_ALIGN(16) =
+	sse2_table (22725, 21407, 19266, 16384, 12873,  8867, 4520);
+    static const int16_t table17[] ATTR_ALIGN(16) =
+	sse2_table (31521, 29692, 26722, 22725, 17855, 12299, 6270);
+    static const int16_t table26[] ATTR_ALIGN(16) =
+	sse2_table (29692, 27969, 25172, 21407, 16819, 11585, 5906);
+    static const int16_t table35[] ATTR_ALIGN(16) =
+	sse2_table (26722, 25172, 22654, 19266, 15137, 10426, 5315);
+    static const int32_t rounder04[] ATTR_ALIGN(16) =
+	sse2_rounder ((1 << (COL_SHIFT - 1)) - 0.5, 0);
+    static const int32_t rounder17[] ATTR_ALIGN(16) =
+	sse2_rounder (1.25683487303, -0.25);
+    static const int32_t rounder26[] ATTR_ALIGN(16) =
+	sse2_rounder (0.60355339059, -0.25);
+    static const int32_t rounder35[] ATTR_ALIGN(16) =
+	sse2_rounder (0.087788325588, -0.441341716183);
+
+    sse2_row_pair (block + 0*8, block + 4*8, table04, rounder04);
+    sse2_row_pair (block + 1*8, block + 7*8, table17, rounder17);
+    sse2_row_pair (block + 2*8, block + 6*8, table26, rounder26);
+    sse2_row_pair (block + 3*8, block + 5*8, table35, rounder35);
+    sse2_col (block);
+}
+
+static inline void sse2_block_copy (int16_t * block, uint8_t * dest, int stride)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+	__asm__ __volatile__ (
+	    "movdqa       (%0), %%xmm0 \n\t"
+	    "packuswb   16(%0), %%xmm0 \n\t"
+	    "movq       %%xmm0, (%1)   \n\t"
+	    "movhps     %%xmm0, (%1,%2) \n\t"
+	    :
+	    : "r" (block), "r" (dest), "r" ((intptr_t)stride)
+	    : "memory", "xmm0");
+	block += 2*8;
+	dest += 2 * stride;
+    }
+}
+
+static inline void sse2_block_add (int16_t * block, uint8_t * dest, int stride)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+	__asm__ __volatile__ (
+	    "pxor       %%xmm7, %%xmm7 \n\t"
+	    "movq         (%1), %%xmm0 \n\t"
+	    "movq      (%1,%2), %%xmm1 \n\t"
+	    "punpcklbw  %%xmm7, %%xmm0 \n\t"
+	    "punpcklbw  %%xmm7, %%xmm1 \n\t"
+	    "paddsw       (%0), %%xmm0 \n\t"
+	    "paddsw     16(%0), %%xmm1 \n\t"
+	    "packuswb   %%xmm1, %%xmm0 \n\t"
+	    "movq       %%xmm0, (%1)   \n\t"
+	    "movhps     %%xmm0, (%1,%2) \n\t"
+	    :
+	    : "r" (block), "r" (dest), "r" ((intptr_t)stride)
+	    : "memory", "xmm0", "xmm1", "xmm7");
+	block += 2*8;
+	dest += 2 * stride;
+    }
+}
+
+static inline void sse2_block_zero (int16_t * block)
+{
+    __asm__ __volatile__ (
+	"pxor       %%xmm0, %%xmm0 \n\t"
+	"movdqa     %%xmm0, (%0)   \n\t"
+	"movdqa     %%xmm0, 16(%0) \n\t"
+	"movdqa     %%xmm0, 32(%0) \n\t"
+	"movdqa     %%xmm0, 48(%0) \n\t"
+	"movdqa     %%xmm0, 64(%0) \n\t"
+	"movdqa     %%xmm0, 80(%0) \n\t"
+	"movdqa     %%xmm0, 96(%0) \n\t"
+	"movdqa     %%xmm0, 112(%0) \n\t"
+	:
+	: "r" (block)
+	: "memory", "xmm0");
+}
+
+void mpeg2_idct_copy_sse2 (int16_t * block, uint8_t * dest, int stride)
+{
+    sse2_idct (block);
+    sse2_block_copy (block, dest, stride);
+    sse2_block_zero (block);
+}
+
+void mpeg2_idct_add_sse2 (int16_t * block, uint8_t * dest, int stride)
+{
+    sse2_idct (block);
+    sse2_block_add (block, dest, stride);
+    sse2_block_zero (block);
+}
+
+void mpeg2_idct_sse2 (int16_t * block)
+{
+    sse2_idct (block);
+}
+
+void mpeg2_zero_block_sse2 (int16_t * block)
+{
+    sse2_block_zero (block);
+}
+
 #endif
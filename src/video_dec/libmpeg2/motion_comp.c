@@ -43,7 +43,12 @@ void mpeg2_mc_init (uint32_t mm_accel)
 #endif
 
 #if defined(ARCH_X86)
-    if (mm_accel & MM_ACCEL_X86_MMXEXT) {
+    if (mm_accel & MM_ACCEL_X86_SSE2) {
+#ifdef LOG
+	fprintf (stderr, "Using SSE2 for motion compensation\n");
+#endif
+	mpeg2_mc = mpeg2_mc_sse2;
+    } else if (mm_accel & MM_ACCEL_X86_MMXEXT) {
 #ifdef LOG
 	fprintf (stderr, "Using MMXEXT for motion compensation\n");
 #endif
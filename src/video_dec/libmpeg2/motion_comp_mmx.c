@@ -1010,4 +1010,144 @@ static void MC_put_xy_8_3dnow (uint8_t * dest, uint8_t * ref,
 
 MPEG2_MC_EXTERN (3dnow)
 
+/* SSE2 code - 16 pixel wide blocks, 8 pixel wide blocks use MMXEXT */
+
+#define SSE2_MC_LOOP(init,body,...)					\
+    __asm__ __volatile__ (						\
+	init								\
+	"1:                        \n\t"				\
+	body								\
+	"add            %3, %0     \n\t"				\
+	"add            %3, %1     \n\t"				\
+	"dec            %2         \n\t"				\
+	"jnz            1b         \n\t"				\
+	: "+r" (dest), "+r" (ref), "+r" (height)			\
+	: "r" ((intptr_t)stride)					\
+	: "memory", __VA_ARGS__)
+
+/* exact (a + b + c + d + 2) >> 2 from pavgb, like MC_put4_16 () */
+#define SSE2_AVG4							\
+	"movdqu       (%1), %%xmm0 \n\t"	/* a */			\
+	"movdqu  1(%1,%3), %%xmm1 \n\t"	/* d */			\
+	"movdqa     %%xmm0, %%xmm7 \n\t"				\
+	"movdqu      1(%1), %%xmm2 \n\t"	/* b */			\
+	"pxor       %%xmm1, %%xmm7 \n\t"				\
+	"movdqu    (%1,%3), %%xmm3 \n\t"	/* c */			\
+	"movdqa     %%xmm2, %%xmm6 \n\t"				\
+	"pxor       %%xmm3, %%xmm6 \n\t"				\
+	"pavgb      %%xmm1, %%xmm0 \n\t"				\
+	"pavgb      %%xmm3, %%xmm2 \n\t"				\
+	"por        %%xmm6, %%xmm7 \n\t"				\
+	"movdqa     %%xmm0, %%xmm6 \n\t"				\
+	"pxor       %%xmm2, %%xmm6 \n\t"				\
+	"pand       %%xmm6, %%xmm7 \n\t"				\
+	"pand       %%xmm5, %%xmm7 \n\t"				\
+	"pavgb      %%xmm2, %%xmm0 \n\t"				\
+	"psubusb    %%xmm7, %%xmm0 \n\t"
+
+/* xmm5 = 16 x 0x01 */
+#define SSE2_MASK_ONE							\
+	"pcmpeqb    %%xmm5, %%xmm5 \n\t"				\
+	"psrlw         $15, %%xmm5 \n\t"				\
+	"packuswb   %%xmm5, %%xmm5 \n\t"
+
+static void MC_put_o_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0");
+}
+
+static void MC_avg_o_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu       (%0), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1");
+}
+
+static void MC_put_x_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu      1(%1), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1");
+}
+
+static void MC_avg_x_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu      1(%1), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu       (%0), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1");
+}
+
+static void MC_put_y_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu    (%1,%3), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1");
+}
+
+static void MC_avg_y_16_sse2 (uint8_t * dest, uint8_t * ref,
+			      int stride, int height)
+{
+    SSE2_MC_LOOP ("",
+	"movdqu       (%1), %%xmm0 \n\t"
+	"movdqu    (%1,%3), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu       (%0), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1");
+}
+
+static void MC_put_xy_16_sse2 (uint8_t * dest, uint8_t * ref,
+			       int stride, int height)
+{
+    SSE2_MC_LOOP (SSE2_MASK_ONE,
+	SSE2_AVG4
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7");
+}
+
+static void MC_avg_xy_16_sse2 (uint8_t * dest, uint8_t * ref,
+			       int stride, int height)
+{
+    SSE2_MC_LOOP (SSE2_MASK_ONE,
+	SSE2_AVG4
+	"movdqu       (%0), %%xmm1 \n\t"
+	"pavgb      %%xmm1, %%xmm0 \n\t"
+	"movdqu     %%xmm0, (%0)   \n\t",
+	"xmm0", "xmm1", "xmm2", "xmm3", "xmm5", "xmm6", "xmm7");
+}
+
+#define MC_put_o_8_sse2  MC_put_o_8_mmxext
+#define MC_avg_o_8_sse2  MC_avg_o_8_mmxext
+#define MC_put_x_8_sse2  MC_put_x_8_mmxext
+#define MC_avg_x_8_sse2  MC_avg_x_8_mmxext
+#define MC_put_y_8_sse2  MC_put_y_8_mmxext
+#define MC_avg_y_8_sse2  MC_avg_y_8_mmxext
+#define MC_put_xy_8_sse2 MC_put_xy_8_mmxext
+#define MC_avg_xy_8_sse2 MC_avg_xy_8_mmxext
+
+MPEG2_MC_EXTERN (sse2)
+
 #endif
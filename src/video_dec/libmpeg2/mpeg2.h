@@ -26,6 +26,8 @@
 
 #include "libmpeg2_accel.h"
 
+typedef struct mpeg2_slices_s mpeg2_slices_t;
+
 typedef struct mpeg2dec_s {
     xine_video_port_t * output;
     uint32_t frame_format;
@@ -69,6 +71,9 @@ typedef struct mpeg2dec_s {
     spu_decoder_t *cc_dec;
     mpeg2dec_accel_t accel;
 
+    /* slice threading, NULL when off */
+    mpeg2_slices_t * slices;
+
 } mpeg2dec_t ;
 
 
@@ -86,6 +91,10 @@ int mpeg2_decode_data (mpeg2dec_t * mpeg2dec,
 void mpeg2_find_sequence_header (mpeg2dec_t * mpeg2dec,
 				 uint8_t * data_start, uint8_t * data_end);
 
+/* decode the slices of a picture with up to threads threads.
+ * 0 means one per cpu, 1 turns slice threading off. */
+void mpeg2_set_threads (mpeg2dec_t * mpeg2dec, int threads);
+
 void mpeg2_flush (mpeg2dec_t * mpeg2dec);
 void mpeg2_reset (mpeg2dec_t * mpeg2dec);
 void mpeg2_discontinuity (mpeg2dec_t * mpeg2dec);
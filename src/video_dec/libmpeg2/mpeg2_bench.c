@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * libmpeg2 decoding benchmark: decodes an MPEG-1/2 video elementary stream
+ * into memory as fast as possible, single threaded and slice threaded, and
+ * checks that both give the same pictures.
+ *
+ * usage: mpeg2_bench file.m2v [threads [loops]]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xine_internal.h>
+#include <xine/video_out.h>
+#include <xine/xineutils.h>
+
+#include "mpeg2.h"
+
+#define NUM_FRAMES 8
+
+typedef struct {
+  vo_frame_t  vo;
+  int         used;
+  size_t      size;
+} bench_frame_t;
+
+typedef struct {
+  xine_video_port_t port;
+  bench_frame_t     frames[NUM_FRAMES];
+  int               hash;
+  uint64_t          sum;
+  int               drawn;
+} bench_port_t;
+
+static bench_port_t bench;
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t _fnv (uint64_t h, const uint8_t *p, int width, int height, int pitch) {
+  int x, y;
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++)
+      h = (h ^ p[x]) * 0x100000001b3ULL;
+    p += pitch;
+  }
+  return h;
+}
+
+static int _frame_draw (vo_frame_t *frame, xine_stream_t *stream) {
+  (void)stream;
+  if (bench.hash && !frame->bad_frame) {
+    bench.sum = _fnv (bench.sum, frame->base[0], frame->width, frame->height, frame->pitches[0]);
+    bench.sum = _fnv (bench.sum, frame->base[1], frame->width / 2, frame->height / 2, frame->pitches[1]);
+    bench.sum = _fnv (bench.sum, frame->base[2], frame->width / 2, frame->height / 2, frame->pitches[2]);
+  }
+  bench.drawn++;
+  return 0;
+}
+
+static void _frame_free (vo_frame_t *frame) {
+  ((bench_frame_t *)frame)->used = 0;
+}
+
+static void _frame_field (vo_frame_t *frame, int which) {
+  (void)frame;
+  (void)which;
+}
+
+static uint32_t _port_get_capabilities (xine_video_port_t *port) {
+  (void)port;
+  return VO_CAP_YV12;
+}
+
+static vo_frame_t *_port_get_frame (xine_video_port_t *port, uint32_t width, uint32_t height,
+                                    double ratio, int format, int flags) {
+  bench_frame_t *f = NULL;
+  int i, pitch = (width + 15) & ~15;
+  size_t y_size = (size_t)pitch * height, size = y_size + y_size / 2;
+
+  (void)port;
+  for (i = 0; i < NUM_FRAMES; i++) {
+    if (!bench.frames[i].used) {
+      f = &bench.frames[i];
+      break;
+    }
+  }
+  if (!f) {
+    fprintf (stderr, "out of frames\n");
+    exit (1);
+  }
+
+  if (f->size < size) {
+    xine_free_aligned (f->vo.base[0]);
+    f->vo.base[0] = xine_mallocz_aligned (size);
+    f->size = size;
+  }
+  f->used = 1;
+  f->vo.width = width;
+  f->vo.height = height;
+  f->vo.ratio = ratio;
+  f->vo.format = format;
+  f->vo.flags = flags;
+  f->vo.pitches[0] = pitch;
+  f->vo.pitches[1] = f->vo.pitches[2] = pitch / 2;
+  f->vo.base[1] = f->vo.base[0] + y_size;
+  f->vo.base[2] = f->vo.base[1] + y_size / 4;
+  f->vo.proc_slice = NULL;
+  f->vo.draw = _frame_draw;
+  f->vo.free = _frame_free;
+  f->vo.field = _frame_field;
+  f->vo.id = i;
+  return &f->vo;
+}
+
+static double _decode (xine_stream_t *stream, uint8_t *data, size_t size, int threads, int loops, int hash) {
+  mpeg2dec_t mpeg2;
+  double start;
+  int l;
+
+  memset (&mpeg2, 0, sizeof (mpeg2));
+  mpeg2.stream = stream;
+  bench.hash = hash;
+  bench.sum = 0xcbf29ce484222325ULL;
+  bench.drawn = 0;
+
+  mpeg2_init (&mpeg2, &bench.port);
+  mpeg2_set_threads (&mpeg2, threads);
+  start = _now ();
+  for (l = 0; l < loops; l++) {
+    size_t pos;
+    for (pos = 0; pos < size; pos += 4096)
+      mpeg2_decode_data (&mpeg2, data + pos, data + (pos + 4096 < size ? pos + 4096 : size), 0);
+  }
+  mpeg2_close (&mpeg2);
+  return _now () - start;
+}
+
+int main (int argc, char **argv) {
+  int threads = argc > 2 ? atoi (argv[2]) : 0;
+  int loops = argc > 3 ? atoi (argv[3]) : 3;
+  xine_t *xine;
+  xine_video_port_t *vo, *saved;
+  xine_stream_t *stream;
+  uint8_t *data;
+  size_t size;
+  FILE *f;
+  double t1, tn;
+  uint64_t sum1, sumn;
+  int frames;
+
+  if (argc < 2) {
+    fprintf (stderr, "usage: %s file.m2v [threads [loops]]\n", argv[0]);
+    return 1;
+  }
+  if (threads <= 0)
+    threads = xine_cpu_count ();
+
+  f = fopen (argv[1], "rb");
+  if (!f) {
+    perror (argv[1]);
+    return 1;
+  }
+  fseek (f, 0, SEEK_END);
+  size = ftell (f);
+  fseek (f, 0, SEEK_SET);
+  data = malloc (size);
+  if (!data || (fread (data, 1, size, f) != size)) {
+    fprintf (stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+  fclose (f);
+
+  xine = xine_new ();
+  xine_init (xine);
+  vo = xine_open_video_driver (xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+  stream = vo ? xine_stream_new (xine, NULL, vo) : NULL;
+  if (!stream) {
+    fprintf (stderr, "cannot create a stream\n");
+    return 1;
+  }
+
+  bench.port.get_capabilities = _port_get_capabilities;
+  bench.port.get_frame = _port_get_frame;
+  saved = stream->video_out;
+  stream->video_out = &bench.port;
+
+  /* verify */
+  _decode (stream, data, size, 1, 1, 1);
+  sum1 = bench.sum;
+  frames = bench.drawn;
+  _decode (stream, data, size, threads, 1, 1);
+  sumn = bench.sum;
+
+  /* measure */
+  t1 = _decode (stream, data, size, 1, loops, 0);
+  tn = _decode (stream, data, size, threads, loops, 0);
+
+  printf ("%s: %d frames, accel 0x%08x\n", argv[1], frames, (unsigned int)xine_mm_accel ());
+  printf ("  1 thread:   %8.1f fps\n", frames * loops / t1);
+  printf ("  %d threads: %8.1f fps (%.2fx)\n", threads, frames * loops / tn, t1 / tn);
+  printf ("  output %s\n", sum1 == sumn ? "identical" : "DIFFERS");
+
+  stream->video_out = saved;
+  xine_dispose (stream);
+  xine_close_video_driver (xine, vo);
+  xine_exit (xine);
+  free (data);
+  return sum1 == sumn ? 0 : 1;
+}
@@ -70,7 +70,7 @@ typedef struct picture_s {
     /* next inside a slice, and is never used outside of mpeg2_slice() */
 
     /* DCT coefficients - should be kept aligned ! */
-    int16_t DCTblock[64];
+    int16_t DCTblock[64] ATTR_ALIGN(16);
 
     /* XvMC DCT block and macroblock data for XvMC acceleration */
     xine_macroblocks_t *mc;
@@ -245,6 +245,10 @@ void mpeg2_idct_add_mmx (int16_t * block, uint8_t * dest, int stride);
 void mpeg2_idct_mmx (int16_t * block);
 void mpeg2_zero_block_mmx (int16_t * block);
 void mpeg2_idct_mmx_init (void);
+void mpeg2_idct_copy_sse2 (int16_t * block, uint8_t * dest, int stride);
+void mpeg2_idct_add_sse2 (int16_t * block, uint8_t * dest, int stride);
+void mpeg2_idct_sse2 (int16_t * block);
+void mpeg2_zero_block_sse2 (int16_t * block);
 
 /* idct_altivec.c */
 # ifdef ENABLE_ALTIVEC
@@ -280,6 +284,7 @@ extern mpeg2_mc_t mpeg2_mc_c;
 extern mpeg2_mc_t mpeg2_mc_mmx;
 extern mpeg2_mc_t mpeg2_mc_mmxext;
 extern mpeg2_mc_t mpeg2_mc_3dnow;
+extern mpeg2_mc_t mpeg2_mc_sse2;
 extern mpeg2_mc_t mpeg2_mc_altivec;
 extern mpeg2_mc_t mpeg2_mc_mlib;
 extern mpeg2_mc_t mpeg2_mc_vis;
@@ -115,6 +115,7 @@ static void mpeg2dec_dispose (video_decoder_t *this_gen) {
 
 static video_decoder_t *open_plugin (video_decoder_class_t *class_gen, xine_stream_t *stream) {
   mpeg2dec_decoder_t *this ;
+  int threads;
 
   (void)class_gen;
   this = (mpeg2dec_decoder_t *) calloc(1, sizeof(mpeg2dec_decoder_t));
@@ -130,6 +131,16 @@ static video_decoder_t *open_plugin (video_decoder_class_t *class_gen, xine_stre
   this->mpeg2.stream = stream;
 
   mpeg2_init (&this->mpeg2, stream->video_out);
+
+  threads = stream->xine->config->register_range (stream->xine->config,
+    "video.processing.mpeg2_thread_count", 0, 0, 16,
+    _("MPEG-1/2 video decoding thread count"),
+    _("The libmpeg2 decoder can decode the slices of a picture in parallel.\n"
+      "0 uses one thread per cpu, 1 turns this off.\n"
+      "A change of this setting will take effect with playing the next stream."),
+    10, NULL, NULL);
+  mpeg2_set_threads (&this->mpeg2, threads);
+
   (stream->video_out->open) (stream->video_out, stream);
   this->mpeg2.force_aspect = this->mpeg2.force_pan_scan = 0;
 
@@ -61,7 +61,7 @@ typedef struct {
 
 static void vo_none_free_framedata(vo_none_frame_t* frame) {
   if(frame->vo_frame.base[0]) {
-    xine_free_aligned(frame->vo_frame.base[0]);
+    xine_frame_mem_free(frame->vo_frame.base[0]);
     frame->vo_frame.base[0] = NULL;
     frame->vo_frame.base[1] = NULL;
     frame->vo_frame.base[2] = NULL;
@@ -136,10 +136,11 @@ static void vo_none_update_frame_format(vo_driver_t *vo_driver, vo_frame_t *vo_f
 	frame->vo_frame.pitches[1] = 8*((width + 15) / 16);
 	frame->vo_frame.pitches[2] = 8*((width + 15) / 16);
 
-	y_size  = frame->vo_frame.pitches[0] * height;
-	uv_size = frame->vo_frame.pitches[1] * ((height+1)/2);
+	/* keep all plane starts aligned */
+	y_size  = (frame->vo_frame.pitches[0] * height + XINE_FRAME_MEM_ALIGN - 1) & ~(XINE_FRAME_MEM_ALIGN - 1);
+	uv_size = (frame->vo_frame.pitches[1] * ((height+1)/2) + XINE_FRAME_MEM_ALIGN - 1) & ~(XINE_FRAME_MEM_ALIGN - 1);
 
-	frame->vo_frame.base[0] = xine_malloc_aligned (y_size + 2*uv_size);
+	frame->vo_frame.base[0] = xine_frame_mem_alloc (y_size + 2*uv_size);
         if (frame->vo_frame.base[0]) {
           frame->vo_frame.base[1] = frame->vo_frame.base[0] + y_size;
           frame->vo_frame.base[2] = frame->vo_frame.base[0] + y_size + uv_size;
@@ -156,7 +157,7 @@ static void vo_none_update_frame_format(vo_driver_t *vo_driver, vo_frame_t *vo_f
 
     case XINE_IMGFMT_YUY2:
       frame->vo_frame.pitches[0] = 8*((width + 3) / 4);
-      frame->vo_frame.base[0] = xine_malloc_aligned(frame->vo_frame.pitches[0] * height);
+      frame->vo_frame.base[0] = xine_frame_mem_alloc(frame->vo_frame.pitches[0] * height);
       frame->vo_frame.base[1] = NULL;
       frame->vo_frame.base[2] = NULL;
       if (!frame->vo_frame.base[0]) {
@@ -736,7 +736,7 @@ static void opengl2_frame_dispose( vo_frame_t *vo_img )
 {
   opengl2_frame_t  *frame = (opengl2_frame_t *) vo_img ;
 
-  xine_free_aligned (frame->vo_frame.base[0]);
+  xine_frame_mem_free (frame->vo_frame.base[0]);
   pthread_mutex_destroy (&frame->vo_frame.mutex);
   free (frame);
 }
@@ -781,18 +781,19 @@ static void opengl2_update_frame_format( vo_driver_t *this_gen, vo_frame_t *fram
   if ( (frame->width != (int)width) || (frame->height != (int)height) || (frame->format != format) ) {
 
     /* (re-) allocate render space */
-    xine_freep_aligned (&frame->vo_frame.base[0]);
+    xine_frame_mem_freep (&frame->vo_frame.base[0]);
     frame->vo_frame.base[1] = NULL;
     frame->vo_frame.base[2] = NULL;
 
     if (format == XINE_IMGFMT_YV12) {
       int w = (width + 15) & ~15;
-      int ysize = w * height;
-      int uvsize = (w >> 1) * ((height + 1) >> 1);
+      /* keep all plane starts aligned */
+      int ysize = (w * height + XINE_FRAME_MEM_ALIGN - 1) & ~(XINE_FRAME_MEM_ALIGN - 1);
+      int uvsize = ((w >> 1) * ((height + 1) >> 1) + XINE_FRAME_MEM_ALIGN - 1) & ~(XINE_FRAME_MEM_ALIGN - 1);
       frame->vo_frame.pitches[0] = w;
       frame->vo_frame.pitches[1] = w >> 1;
       frame->vo_frame.pitches[2] = w >> 1;
-      frame->vo_frame.base[0] = xine_malloc_aligned (ysize + 2 * uvsize);
+      frame->vo_frame.base[0] = xine_frame_mem_alloc (ysize + 2 * uvsize);
       if (!frame->vo_frame.base[0]) {
         frame->width = 0;
         frame->vo_frame.width = 0; /* tell vo_get_frame () to retry later */
@@ -804,7 +805,7 @@ static void opengl2_update_frame_format( vo_driver_t *this_gen, vo_frame_t *fram
       frame->vo_frame.base[2] = frame->vo_frame.base[1] + uvsize;
     } else if (format == XINE_IMGFMT_YUY2){
       frame->vo_frame.pitches[0] = ((width + 15) & ~15) << 1;
-      frame->vo_frame.base[0] = xine_malloc_aligned (frame->vo_frame.pitches[0] * height);
+      frame->vo_frame.base[0] = xine_frame_mem_alloc (frame->vo_frame.pitches[0] * height);
       if (frame->vo_frame.base[0]) {
         const union {uint8_t bytes[4]; uint32_t word;} black = {{0, 128, 0, 128}};
         uint32_t *q = (uint32_t *)frame->vo_frame.base[0];
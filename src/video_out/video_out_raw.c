@@ -219,10 +219,10 @@ static void raw_frame_dispose (vo_frame_t *vo_img)
 
   frame->yuv2rgb->dispose (frame->yuv2rgb);
 
-  xine_free_aligned (frame->vo_frame.base[0]);
-  xine_free_aligned (frame->vo_frame.base[1]);
-  xine_free_aligned (frame->vo_frame.base[2]);
-  xine_free_aligned (frame->rgb);
+  xine_frame_mem_free (frame->vo_frame.base[0]);
+  xine_frame_mem_free (frame->vo_frame.base[1]);
+  xine_frame_mem_free (frame->vo_frame.base[2]);
+  xine_frame_mem_free (frame->rgb);
   free (frame);
 }
 
@@ -280,25 +280,25 @@ static void raw_update_frame_format (vo_driver_t *this_gen, vo_frame_t *frame_ge
 /*     lprintf ("updating frame to %d x %d (ratio=%g, format=%08x)\n", width, height, ratio, format); */
 
     /* (re-) allocate render space */
-    xine_free_aligned (frame->vo_frame.base[0]);
-    xine_free_aligned (frame->vo_frame.base[1]);
-    xine_free_aligned (frame->vo_frame.base[2]);
-    xine_free_aligned (frame->rgb);
+    xine_frame_mem_free (frame->vo_frame.base[0]);
+    xine_frame_mem_free (frame->vo_frame.base[1]);
+    xine_frame_mem_free (frame->vo_frame.base[2]);
+    xine_frame_mem_free (frame->rgb);
 
     if (format == XINE_IMGFMT_YV12) {
       frame->vo_frame.pitches[0] = 8*((width + 7) / 8);
       frame->vo_frame.pitches[1] = 8*((width + 15) / 16);
       frame->vo_frame.pitches[2] = 8*((width + 15) / 16);
-      frame->vo_frame.base[0] = xine_mallocz_aligned (frame->vo_frame.pitches[0] * height);
-      frame->vo_frame.base[1] = xine_mallocz_aligned (frame->vo_frame.pitches[1] * ((height+1)/2));
-      frame->vo_frame.base[2] = xine_mallocz_aligned (frame->vo_frame.pitches[2] * ((height+1)/2));
+      frame->vo_frame.base[0] = xine_frame_mem_allocz (frame->vo_frame.pitches[0] * height);
+      frame->vo_frame.base[1] = xine_frame_mem_allocz (frame->vo_frame.pitches[1] * ((height+1)/2));
+      frame->vo_frame.base[2] = xine_frame_mem_allocz (frame->vo_frame.pitches[2] * ((height+1)/2));
     } else {
       frame->vo_frame.pitches[0] = 8*((width + 3) / 4);
-      frame->vo_frame.base[0] = xine_mallocz_aligned (frame->vo_frame.pitches[0] * height);
+      frame->vo_frame.base[0] = xine_frame_mem_allocz (frame->vo_frame.pitches[0] * height);
       frame->vo_frame.base[1] = NULL;
       frame->vo_frame.base[2] = NULL;
     }
-    frame->rgb = xine_mallocz_aligned (BYTES_PER_PIXEL*width*height);
+    frame->rgb = xine_frame_mem_allocz (BYTES_PER_PIXEL*width*height);
 
     /* set up colorspace converter */
     switch (flags & VO_BOTH_FIELDS) {
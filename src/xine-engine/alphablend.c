@@ -1152,6 +1152,499 @@ static uint8_t *(*blend_yuv_grow_extra_data(alphablend_t *extra_data, int osd_wi
   return &(header->data);
 }
 
+/*
+ * Pre-rendered overlays for exact blending.
+ *
+ * Subtitles and OSD usually stay unchanged for many frames. Instead of
+ * walking the rle and palettes again for each of them, we render an overlay
+ * once into premultiplied planes, and blend them as
+ *
+ *   dst = p + dst * t / 255
+ *
+ * with p = colour * opacity, and t = 255 - opacity. A chroma sample holds
+ * the exact blending average of the 4 (yv12) or 2 (yuy2) luma pixels it
+ * covers. Each row also knows its first and last visible pixel, so
+ * transparent borders cost nothing.
+ *
+ * Overlays are identified by address, geometry and a hash over their rle
+ * data, palettes and highlight area. A few of them are kept per driver.
+ * alphablend_t is part of the driver ABI, so the caches live in a list
+ * here, keyed by the driver's alphablend_t address.
+ */
+
+#define OVL_CACHE_ENTRIES 4
+
+typedef struct {
+  /* identity */
+  const vo_overlay_t *ovl;
+  uint64_t            hash;
+  int                 format;      /* 420 or 422 */
+  int                 x_odd, y_odd;
+  unsigned int        used;
+
+  /* luma planes, width x height */
+  int                 width, height;
+  uint8_t            *y_p, *y_t;
+  /* chroma planes, c_width x c_height */
+  int                 c_width, c_height;
+  uint8_t            *cr_p, *cb_p, *c_t;
+  /* [first, end) of visible pixels per row */
+  int                *y_span, *c_span;
+
+  void               *mem;
+  size_t              mem_size;
+} ovl_cache_entry_t;
+
+typedef struct ovl_cache_s ovl_cache_t;
+
+struct ovl_cache_s {
+  ovl_cache_t        *next;
+  const alphablend_t *owner;
+  unsigned int        clock;
+  ovl_cache_entry_t   entries[OVL_CACHE_ENTRIES];
+};
+
+static struct {
+  pthread_mutex_t     mutex;
+  ovl_cache_t        *first;
+} ovl_caches = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static void ovl_blend_row_c (uint8_t *dst, const uint8_t *p, const uint8_t *t, int n) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    uint32_t v = (uint32_t)dst[i] * t[i];
+    v = ((v + 1 + (v >> 8)) >> 8) + p[i];
+    dst[i] = v > 255 ? 255 : v;
+  }
+}
+
+/* same for interleaved samples, step bytes apart. */
+static void ovl_blend_row_packed (uint8_t *dst, const uint8_t *p, const uint8_t *t, int n, int step) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    uint32_t v = (uint32_t)dst[step * i] * t[i];
+    v = ((v + 1 + (v >> 8)) >> 8) + p[i];
+    dst[step * i] = v > 255 ? 255 : v;
+  }
+}
+
+#if defined(ARCH_X86)
+static void ovl_blend_row_sse2 (uint8_t *dst, const uint8_t *p, const uint8_t *t, int n) {
+  while (n >= 16) {
+    /* skip fully transparent parts */
+    if ((((const uint32_t *)t)[0] & ((const uint32_t *)t)[1] &
+         ((const uint32_t *)t)[2] & ((const uint32_t *)t)[3]) != 0xffffffff) {
+      __asm__ __volatile__(
+        "pxor      %%xmm7, %%xmm7 \n\t"
+        "pcmpeqw   %%xmm6, %%xmm6 \n\t"
+        "psrlw        $15, %%xmm6 \n\t"  /* 8 x 1                                */
+        "movdqu      (%0), %%xmm0 \n\t"  /* 16 dst                               */
+        "movdqu      (%2), %%xmm1 \n\t"  /* 16 t                                 */
+        "movdqa    %%xmm0, %%xmm2 \n\t"
+        "movdqa    %%xmm1, %%xmm3 \n\t"
+        "punpcklbw %%xmm7, %%xmm0 \n\t"
+        "punpckhbw %%xmm7, %%xmm2 \n\t"
+        "punpcklbw %%xmm7, %%xmm1 \n\t"
+        "punpckhbw %%xmm7, %%xmm3 \n\t"
+        "pmullw    %%xmm1, %%xmm0 \n\t"  /* v = dst * t                          */
+        "pmullw    %%xmm3, %%xmm2 \n\t"
+        "movdqa    %%xmm0, %%xmm1 \n\t"
+        "movdqa    %%xmm2, %%xmm3 \n\t"
+        "psrlw         $8, %%xmm1 \n\t"
+        "psrlw         $8, %%xmm3 \n\t"
+        "paddw     %%xmm6, %%xmm0 \n\t"
+        "paddw     %%xmm6, %%xmm2 \n\t"
+        "paddw     %%xmm1, %%xmm0 \n\t"  /* (v + 1 + (v >> 8)) >> 8 = v / 255    */
+        "paddw     %%xmm3, %%xmm2 \n\t"
+        "psrlw         $8, %%xmm0 \n\t"
+        "psrlw         $8, %%xmm2 \n\t"
+        "packuswb  %%xmm2, %%xmm0 \n\t"
+        "movdqu      (%1), %%xmm1 \n\t"  /* 16 p                                 */
+        "paddusb   %%xmm1, %%xmm0 \n\t"
+        "movdqu    %%xmm0, (%0)   \n\t"
+        :
+        : "r" (dst), "r" (p), "r" (t)
+        : "memory"
+#ifdef __SSE__
+          , "xmm0", "xmm1", "xmm2", "xmm3", "xmm6", "xmm7"
+#endif
+      );
+    }
+    dst += 16; p += 16; t += 16; n -= 16;
+  }
+  ovl_blend_row_c (dst, p, t, n);
+}
+#endif
+
+static void (*ovl_blend_row) (uint8_t *dst, const uint8_t *p, const uint8_t *t, int n) = ovl_blend_row_c;
+
+static uint64_t ovl_hash (uint64_t h, const void *data, size_t size) {
+  const uint8_t *d = (const uint8_t *)data;
+  size_t i;
+
+  /* FNV-1a, 4 bytes at a time */
+  for (i = 0; i + 4 <= size; i += 4) {
+    uint32_t w;
+    memcpy (&w, d + i, 4);
+    h = (h ^ w) * 0x100000001b3ULL;
+  }
+  for (; i < size; i++)
+    h = (h ^ d[i]) * 0x100000001b3ULL;
+  return h;
+}
+
+static uint64_t ovl_cache_hash (const vo_overlay_t *ovl) {
+  int32_t geom[8];
+  uint64_t h = 0xcbf29ce484222325ULL;
+
+  geom[0] = ovl->width;
+  geom[1] = ovl->height;
+  geom[2] = ovl->num_rle;
+  geom[3] = ovl->hili_top;
+  geom[4] = ovl->hili_bottom;
+  geom[5] = ovl->hili_left;
+  geom[6] = ovl->hili_right;
+  geom[7] = ovl->rgb_clut;
+  h = ovl_hash (h, geom, sizeof (geom));
+  h = ovl_hash (h, ovl->rle, ovl->num_rle * sizeof (*ovl->rle));
+  h = ovl_hash (h, ovl->color, sizeof (ovl->color));
+  h = ovl_hash (h, ovl->trans, sizeof (ovl->trans));
+  h = ovl_hash (h, ovl->hili_color, sizeof (ovl->hili_color));
+  h = ovl_hash (h, ovl->hili_trans, sizeof (ovl->hili_trans));
+  return h;
+}
+
+static void ovl_cache_spans (int *span, const uint8_t *t, int width, int height) {
+  int y;
+
+  for (y = 0; y < height; y++) {
+    int first = 0, end = width;
+    while ((first < end) && (t[first] == 255))
+      first++;
+    while ((end > first) && (t[end - 1] == 255))
+      end--;
+    span[2 * y] = first;
+    span[2 * y + 1] = end;
+    t += width;
+  }
+}
+
+static int ovl_cache_render (ovl_cache_entry_t *e, const vo_overlay_t *ovl) {
+  const rle_elem_t *rle = ovl->rle, *rle_limit = rle + ovl->num_rle;
+  int w = ovl->width, h = ovl->height;
+  int cw, ch, cx, cy, sx, sy, run = 0, x, y;
+  size_t y_size, c_size, need;
+  uint8_t *o, *cr, *cb, clr = 0;
+
+  if ((w <= 0) || (h <= 0))
+    return 0;
+
+  if (e->format == 420) {
+    cw = (w + e->x_odd + 1) >> 1;
+    ch = (h + e->y_odd + 1) >> 1;
+    sy = 2;
+  } else {
+    cw = (w + e->x_odd + 1) >> 1;
+    ch = h;
+    sy = 1;
+  }
+  sx = 2;
+
+  /* planes, plus opacity and chroma of the luma pixels while rendering. */
+  y_size = (size_t)w * h;
+  c_size = (size_t)cw * ch;
+  need = 5 * y_size + 3 * c_size + 2 * sizeof (int) * (h + ch);
+  if (e->mem_size < need) {
+    free (e->mem);
+    e->mem_size = 0;
+    e->mem = malloc (need);
+    if (!e->mem)
+      return 0;
+    e->mem_size = need;
+  }
+  e->y_span = (int *)e->mem;
+  e->c_span = e->y_span + 2 * h;
+  e->y_p    = (uint8_t *)(e->c_span + 2 * ch);
+  e->y_t    = e->y_p + y_size;
+  e->cr_p   = e->y_t + y_size;
+  e->cb_p   = e->cr_p + c_size;
+  e->c_t    = e->cb_p + c_size;
+  o         = e->c_t + c_size;
+  cr        = o + y_size;
+  cb        = cr + y_size;
+  e->width    = w;
+  e->height   = h;
+  e->c_width  = cw;
+  e->c_height = ch;
+
+  /* luma. rle runs may continue on the next line. */
+  memset (e->y_p, 0, y_size);
+  memset (e->y_t, 255, y_size);
+  memset (o, 0, y_size);
+  for (y = 0; y < h; y++) {
+    int hili_y = (y >= ovl->hili_top) && (y < ovl->hili_bottom);
+    for (x = 0; x < w; x++) {
+      const uint32_t *clut;
+      union {
+        uint32_t u32;
+        clut_t   c;
+      } color;
+      int i = y * w + x, a;
+      uint8_t op;
+
+      while (!run) {
+        if (rle >= rle_limit)
+          goto rle_done;
+        run = rle->len;
+        clr = rle->color;
+        rle++;
+      }
+      run--;
+
+      if (hili_y && (x >= ovl->hili_left) && (x < ovl->hili_right)) {
+        clut = ovl->hili_color;
+        op = ovl->hili_trans[clr];
+      } else {
+        clut = ovl->color;
+        op = ovl->trans[clr];
+      }
+      if (op > 15)
+        op = 15;
+      color.u32 = clut[clr];
+      o[i]  = op;
+      cr[i] = color.c.cr;
+      cb[i] = color.c.cb;
+      a = op * 17;
+      e->y_p[i] = (color.c.y * a + 127) / 255;
+      e->y_t[i] = 255 - a;
+    }
+  }
+ rle_done:
+
+  /* chroma, see blend_yuv_exact () and blend_yuy2_exact (). */
+  for (cy = 0; cy < ch; cy++) {
+    for (cx = 0; cx < cw; cx++) {
+      int osum = 0, crsum = 0, cbsum = 0, crall = 0, cball = 0, n = 0, full = sx * sy * 15;
+      int i = cy * cw + cx, dy, dx;
+
+      for (dy = 0; dy < sy; dy++) {
+        y = cy * sy - (sy == 2 ? e->y_odd : 0) + dy;
+        if ((y < 0) || (y >= h))
+          continue;
+        for (dx = 0; dx < sx; dx++) {
+          int j;
+          x = cx * sx - e->x_odd + dx;
+          if ((x < 0) || (x >= w))
+            continue;
+          j = y * w + x;
+          osum  += o[j];
+          crsum += cr[j] * o[j];
+          cbsum += cb[j] * o[j];
+          crall += cr[j];
+          cball += cb[j];
+          n++;
+        }
+      }
+      if (!osum) {
+        e->cr_p[i] = e->cb_p[i] = 0;
+        e->c_t[i] = 255;
+      } else if (osum >= full) {
+        e->cr_p[i] = crall / n;
+        e->cb_p[i] = cball / n;
+        e->c_t[i] = 0;
+      } else {
+        e->cr_p[i] = (crsum + (full >> 1)) / full;
+        e->cb_p[i] = (cbsum + (full >> 1)) / full;
+        e->c_t[i] = ((full - osum) * 255 + (full >> 1)) / full;
+      }
+    }
+  }
+
+  ovl_cache_spans (e->y_span, e->y_t, w, h);
+  ovl_cache_spans (e->c_span, e->c_t, cw, ch);
+  return 1;
+}
+
+static ovl_cache_entry_t *ovl_cache_get (alphablend_t *extra_data, const vo_overlay_t *ovl,
+                                         int format, int x_odd, int y_odd) {
+  ovl_cache_t *cache;
+  ovl_cache_entry_t *e, *oldest;
+  uint64_t hash;
+  int i;
+
+  if (!ovl->rle || (ovl->num_rle <= 0))
+    return NULL;
+
+  pthread_mutex_lock (&ovl_caches.mutex);
+  for (cache = ovl_caches.first; cache; cache = cache->next) {
+    if (cache->owner == extra_data)
+      break;
+  }
+  if (!cache) {
+    cache = calloc (1, sizeof (*cache));
+    if (cache) {
+      cache->owner = extra_data;
+      cache->next = ovl_caches.first;
+      ovl_caches.first = cache;
+    }
+  }
+  pthread_mutex_unlock (&ovl_caches.mutex);
+  if (!cache)
+    return NULL;
+
+  hash = ovl_cache_hash (ovl);
+  cache->clock++;
+  oldest = &cache->entries[0];
+  for (i = 0; i < OVL_CACHE_ENTRIES; i++) {
+    e = &cache->entries[i];
+    if ((e->ovl == ovl) && (e->hash == hash) && (e->format == format) &&
+        (e->x_odd == x_odd) && (e->y_odd == y_odd)) {
+      e->used = cache->clock;
+      return e;
+    }
+    if (cache->clock - e->used > cache->clock - oldest->used)
+      oldest = e;
+  }
+
+  e = oldest;
+  e->ovl    = ovl;
+  e->hash   = hash;
+  e->format = format;
+  e->x_odd  = x_odd;
+  e->y_odd  = y_odd;
+  e->used   = cache->clock;
+  if (!ovl_cache_render (e, ovl)) {
+    e->ovl = NULL;
+    return NULL;
+  }
+  return e;
+}
+
+static void ovl_cache_free (alphablend_t *extra_data) {
+  ovl_cache_t *cache, **prev;
+  int i;
+
+  pthread_mutex_lock (&ovl_caches.mutex);
+  for (prev = &ovl_caches.first; (cache = *prev) != NULL; prev = &cache->next) {
+    if (cache->owner == extra_data) {
+      *prev = cache->next;
+      break;
+    }
+  }
+  pthread_mutex_unlock (&ovl_caches.mutex);
+  if (!cache)
+    return;
+  for (i = 0; i < OVL_CACHE_ENTRIES; i++)
+    free (cache->entries[i].mem);
+  free (cache);
+}
+
+/* clip [first, end) of row r to [lo, hi). */
+static int ovl_span (const int *span, int r, int lo, int hi, int *first) {
+  int f = span[2 * r], e = span[2 * r + 1];
+  if (f < lo)
+    f = lo;
+  if (e > hi)
+    e = hi;
+  *first = f;
+  return e - f;
+}
+
+static int blend_yuv_cached (uint8_t *dst_base[3], vo_overlay_t *ovl,
+                             int dst_width, int dst_height, int dst_pitches[3],
+                             alphablend_t *extra_data) {
+  int x_off = ovl->x + extra_data->offset_x;
+  int y_off = ovl->y + extra_data->offset_y;
+  ovl_cache_entry_t *e = ovl_cache_get (extra_data, ovl, 420, x_off & 1, y_off & 1);
+  int x0, x1, y0, y1, y, first, n, cx_off, cy_off;
+
+  if (!e)
+    return 0;
+
+  /* luma */
+  x0 = x_off < 0 ? -x_off : 0;
+  y0 = y_off < 0 ? -y_off : 0;
+  x1 = dst_width - x_off < e->width ? dst_width - x_off : e->width;
+  y1 = dst_height - y_off < e->height ? dst_height - y_off : e->height;
+  for (y = y0; y < y1; y++) {
+    n = ovl_span (e->y_span, y, x0, x1, &first);
+    if (n > 0)
+      ovl_blend_row (dst_base[0] + (y + y_off) * dst_pitches[0] + x_off + first,
+                     e->y_p + y * e->width + first, e->y_t + y * e->width + first, n);
+  }
+
+  /* chroma */
+  cx_off = (x_off - e->x_odd) / 2;
+  cy_off = (y_off - e->y_odd) / 2;
+  x0 = cx_off < 0 ? -cx_off : 0;
+  y0 = cy_off < 0 ? -cy_off : 0;
+  x1 = ((dst_width + 1) >> 1) - cx_off;
+  if (x1 > e->c_width)
+    x1 = e->c_width;
+  y1 = ((dst_height + 1) >> 1) - cy_off;
+  if (y1 > e->c_height)
+    y1 = e->c_height;
+  for (y = y0; y < y1; y++) {
+    n = ovl_span (e->c_span, y, x0, x1, &first);
+    if (n > 0) {
+      const uint8_t *t = e->c_t + y * e->c_width + first;
+      ovl_blend_row (dst_base[2] + (y + cy_off) * dst_pitches[2] + cx_off + first,
+                     e->cr_p + y * e->c_width + first, t, n);
+      ovl_blend_row (dst_base[1] + (y + cy_off) * dst_pitches[1] + cx_off + first,
+                     e->cb_p + y * e->c_width + first, t, n);
+    }
+  }
+
+  return 1;
+}
+
+static int blend_yuy2_cached (uint8_t *dst_img, vo_overlay_t *ovl,
+                              int dst_width, int dst_height, int dst_pitch,
+                              alphablend_t *extra_data) {
+  int x_off = ovl->x + extra_data->offset_x;
+  int y_off = ovl->y + extra_data->offset_y;
+  ovl_cache_entry_t *e = ovl_cache_get (extra_data, ovl, 422, x_off & 1, 0);
+  int x0, x1, y0, y1, y, first, n, cx_off;
+
+  if (!e)
+    return 0;
+
+  y0 = y_off < 0 ? -y_off : 0;
+  y1 = dst_height - y_off < e->height ? dst_height - y_off : e->height;
+
+  /* luma */
+  x0 = x_off < 0 ? -x_off : 0;
+  x1 = dst_width - x_off < e->width ? dst_width - x_off : e->width;
+  for (y = y0; y < y1; y++) {
+    n = ovl_span (e->y_span, y, x0, x1, &first);
+    if (n > 0)
+      ovl_blend_row_packed (dst_img + (y + y_off) * dst_pitch + 2 * (x_off + first),
+                            e->y_p + y * e->width + first, e->y_t + y * e->width + first, n, 2);
+  }
+
+  /* chroma: cb at byte 1, cr at byte 3 of each pixel pair. */
+  cx_off = (x_off - e->x_odd) / 2;
+  x0 = cx_off < 0 ? -cx_off : 0;
+  x1 = (dst_width >> 1) - cx_off;
+  if (x1 > e->c_width)
+    x1 = e->c_width;
+  for (y = y0; y < y1; y++) {
+    n = ovl_span (e->c_span, y, x0, x1, &first);
+    if (n > 0) {
+      uint8_t *d = dst_img + (y + y_off) * dst_pitch + 4 * (cx_off + first);
+      const uint8_t *t = e->c_t + y * e->c_width + first;
+      ovl_blend_row_packed (d + 1, e->cb_p + y * e->c_width + first, t, n, 4);
+      ovl_blend_row_packed (d + 3, e->cr_p + y * e->c_width + first, t, n, 4);
+    }
+  }
+
+  return 1;
+}
+
 void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
                 int dst_width, int dst_height, int dst_pitches[3],
                 alphablend_t *extra_data)
@@ -1185,6 +1678,9 @@ void _x_blend_yuv (uint8_t *dst_base[3], vo_overlay_t * img_overl,
   uint8_t *dst_y = dst_base[0] + dst_pitches[0] * y_off + x_off;
   uint8_t *dst_cr = dst_base[2] + (y_off / 2) * dst_pitches[1] + (x_off / 2);
   uint8_t *dst_cb = dst_base[1] + (y_off / 2) * dst_pitches[2] + (x_off / 2);
+
+  if (enable_exact_blending && blend_yuv_cached (dst_base, img_overl, dst_width, dst_height, dst_pitches, extra_data))
+    return;
 #ifdef LOG_BLEND_YUV
   printf("overlay_blend started x=%d, y=%d, w=%d h=%d\n",img_overl->x,img_overl->y,img_overl->width,img_overl->height);
 #endif
@@ -1639,6 +2135,9 @@ void _x_blend_yuy2 (uint8_t * dst_img, vo_overlay_t * img_overl,
   uint8_t *dst_y = dst_img + dst_pitch * y_off + 2 * x_off;
   uint8_t *dst;
 
+  if (enable_exact_blending && blend_yuy2_cached (dst_img, img_overl, dst_width, dst_height, dst_pitch, extra_data))
+    return;
+
   my_clut = img_overl->hili_color;
   my_trans = img_overl->hili_trans;
 
@@ -2166,6 +2665,13 @@ void _x_alphablend_init(alphablend_t *extra_data, xine_t *xine)
   extra_data->buffer_size = 0;
   extra_data->offset_x = 0;
   extra_data->offset_y = 0;
+  /* a previous user of this address may have missed _x_alphablend_free (). */
+  ovl_cache_free (extra_data);
+
+#if defined(ARCH_X86)
+  if (xine_mm_accel () & MM_ACCEL_X86_SSE2)
+    ovl_blend_row = ovl_blend_row_sse2;
+#endif
 
   extra_data->disable_exact_blending =
     config->register_bool(config, "video.output.disable_exact_alphablend", 0,
@@ -2182,6 +2688,8 @@ void _x_alphablend_free(alphablend_t *extra_data)
   _x_freep(&extra_data->buffer);
 
   extra_data->buffer_size = 0;
+
+  ovl_cache_free (extra_data);
 }
 
 #define saturate(v) if (v & ~255) v = (~((uint32_t)v)) >> 24
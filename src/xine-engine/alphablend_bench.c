@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * overlay blending benchmark: cost per 1080p yv12 and yuy2 frame of
+ * typical subtitle and OSD overlays, with fast, exact (re-rendered every
+ * frame) and exact (cached) blending.
+ *
+ * usage: alphablend_bench [frames]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xine_internal.h>
+#include <xine/video_out.h>
+#include <xine/alphablend.h>
+
+#define WIDTH  1920
+#define HEIGHT 1080
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned int _rand (unsigned int *seed) {
+  *seed = *seed * 1103515245 + 12345;
+  return *seed >> 16;
+}
+
+/* text like lines: outlined glyphs on a transparent background. */
+static void _make_overlay (vo_overlay_t *ovl, int x, int y, int width, int height, int lines) {
+  static const struct { uint8_t y, cr, cb, trans; } pal[4] = {
+    {  16, 128, 128,  0 },   /* background */
+    { 235, 128, 128, 15 },   /* text */
+    {  16, 128, 128, 10 },   /* outline */
+    { 210, 146,  16,  6 },   /* anti aliasing */
+  };
+  unsigned int seed = width * 31 + height;
+  int num = 0, max = width * height / 2 + height, row, i;
+
+  memset (ovl, 0, sizeof (*ovl));
+  ovl->rle = calloc (max, sizeof (rle_elem_t));
+  ovl->data_size = max * sizeof (rle_elem_t);
+  ovl->x = x;
+  ovl->y = y;
+  ovl->width = width;
+  ovl->height = height;
+  for (i = 0; i < 4; i++) {
+    clut_t c = { .y = pal[i].y, .cr = pal[i].cr, .cb = pal[i].cb };
+    memcpy (&ovl->color[i], &c, sizeof (c));
+    memcpy (&ovl->hili_color[i], &c, sizeof (c));
+    ovl->trans[i] = ovl->hili_trans[i] = pal[i].trans;
+  }
+
+  for (row = 0; row < height; row++) {
+    int in_text = (row % (height / lines)) > (height / lines) / 5;
+    int xx = 0;
+    while (xx < width) {
+      int len, clr;
+      if (!in_text || (xx < width / 8) || (xx >= width - width / 8)) {
+        len = in_text ? (xx < width / 8 ? width / 8 - xx : width - xx) : width - xx;
+        clr = 0;
+      } else {
+        len = 1 + _rand (&seed) % 6;
+        clr = _rand (&seed) & 3;
+      }
+      if (len > width - xx)
+        len = width - xx;
+      if (num < max) {
+        ovl->rle[num].len = len;
+        ovl->rle[num].color = clr;
+        num++;
+      }
+      xx += len;
+    }
+  }
+  ovl->num_rle = num;
+}
+
+/* the exact blending formulas of alphablend.c, pixel by pixel. */
+static void _reference_yuv (uint8_t *dst[3], int pitches[3], const vo_overlay_t *ovl) {
+  int w = ovl->width, h = ovl->height, run = 0, x, y, clr = 0;
+  const rle_elem_t *rle = ovl->rle, *end = rle + ovl->num_rle;
+  uint8_t *o = calloc (w * h, 1), *cr = calloc (w * h, 1), *cb = calloc (w * h, 1);
+
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      clut_t c;
+      int i = y * w + x, a;
+      while (!run && (rle < end)) {
+        run = rle->len;
+        clr = rle->color;
+        rle++;
+      }
+      if (!run)
+        break;
+      run--;
+      memcpy (&c, &ovl->color[clr], sizeof (c));
+      a = ovl->trans[clr] > 15 ? 15 : ovl->trans[clr];
+      o[i] = a;
+      cr[i] = c.cr;
+      cb[i] = c.cb;
+      if (a >= 15)
+        dst[0][(y + ovl->y) * pitches[0] + x + ovl->x] = c.y;
+      else if (a) {
+        uint8_t *d = &dst[0][(y + ovl->y) * pitches[0] + x + ovl->x];
+        *d = ((((int)c.y - *d) * (a * 0x1111 + 1)) >> 16) + *d;
+      }
+    }
+  }
+
+  for (y = 0; y < h; y += 2) {
+    for (x = 0; x < w; x += 2) {
+      int i = y * w + x, os = o[i] + o[i + 1] + o[i + w] + o[i + w + 1];
+      uint8_t *dcr = &dst[2][((y + ovl->y) >> 1) * pitches[2] + ((x + ovl->x) >> 1)];
+      uint8_t *dcb = &dst[1][((y + ovl->y) >> 1) * pitches[1] + ((x + ovl->x) >> 1)];
+      if (!os)
+        continue;
+      if (os >= 60) {
+        *dcr = (cr[i] + cr[i + 1] + cr[i + w] + cr[i + w + 1]) / 4;
+        *dcb = (cb[i] + cb[i + 1] + cb[i + w] + cb[i + w + 1]) / 4;
+      } else {
+        *dcr = ((*dcr * (60 - os) + cr[i] * o[i] + cr[i + 1] * o[i + 1] + cr[i + w] * o[i + w] +
+                 cr[i + w + 1] * o[i + w + 1]) * (0x1111 + 1)) >> 18;
+        *dcb = ((*dcb * (60 - os) + cb[i] * o[i] + cb[i + 1] * o[i + 1] + cb[i + w] * o[i + w] +
+                 cb[i + w + 1] * o[i + w + 1]) * (0x1111 + 1)) >> 18;
+      }
+    }
+  }
+
+  free (o);
+  free (cr);
+  free (cb);
+}
+
+int main (int argc, char **argv) {
+  static const struct { const char *name; int x, y, width, height, lines; } tests[] = {
+    { "dvd sub",  600,  920,  720,  120, 2 },
+    { "dvb sub",  160,  860, 1600,  180, 2 },
+    { "osd",        0,    0, 1920, 1080, 8 },
+  };
+  int frames = argc > 1 ? atoi (argv[1]) : 200;
+  size_t y_size = WIDTH * HEIGHT, c_size = y_size / 4;
+  uint8_t *frame, *ref, *yuy2, *planes[3], *ref_planes[3];
+  int pitches[3] = { WIDTH, WIDTH / 2, WIDTH / 2 };
+  unsigned int seed = 1;
+  alphablend_t ab;
+  xine_t *xine;
+  size_t i;
+  int t;
+
+  xine = xine_new ();
+  xine_init (xine);
+  _x_alphablend_init (&ab, xine);
+
+  frame = malloc (y_size + 2 * c_size);
+  ref = malloc (y_size + 2 * c_size);
+  yuy2 = malloc (2 * y_size);
+  planes[0] = frame;
+  planes[1] = frame + y_size;
+  planes[2] = frame + y_size + c_size;
+  ref_planes[0] = ref;
+  ref_planes[1] = ref + y_size;
+  ref_planes[2] = ref + y_size + c_size;
+
+  printf ("%-8s %-5s %10s %14s %14s %8s %s\n", "overlay", "frame",
+          "fast ms", "exact new ms", "exact same ms", "speedup", "max error");
+
+  for (t = 0; t < (int)(sizeof (tests) / sizeof (tests[0])); t++) {
+    vo_overlay_t ovl;
+    double start, fast, fresh, cached;
+    int f, maxerr = 0;
+
+    _make_overlay (&ovl, tests[t].x, tests[t].y, tests[t].width, tests[t].height, tests[t].lines);
+
+    /* yv12 */
+    for (i = 0; i < y_size + 2 * c_size; i++)
+      frame[i] = _rand (&seed);
+    memcpy (ref, frame, y_size + 2 * c_size);
+    ab.disable_exact_blending = 0;
+    _x_blend_yuv (planes, &ovl, WIDTH, HEIGHT, pitches, &ab);
+    _reference_yuv (ref_planes, pitches, &ovl);
+    for (i = 0; i < y_size + 2 * c_size; i++) {
+      int d = frame[i] > ref[i] ? frame[i] - ref[i] : ref[i] - frame[i];
+      if (d > maxerr)
+        maxerr = d;
+    }
+
+    ab.disable_exact_blending = 1;
+    start = _now ();
+    for (f = 0; f < frames; f++)
+      _x_blend_yuv (planes, &ovl, WIDTH, HEIGHT, pitches, &ab);
+    fast = (_now () - start) * 1000.0 / frames;
+
+    ab.disable_exact_blending = 0;
+    start = _now ();
+    for (f = 0; f < frames; f++) {
+      /* a new palette each time */
+      ovl.trans[3] = 4 + (f & 7);
+      _x_blend_yuv (planes, &ovl, WIDTH, HEIGHT, pitches, &ab);
+    }
+    fresh = (_now () - start) * 1000.0 / frames;
+
+    start = _now ();
+    for (f = 0; f < frames; f++)
+      _x_blend_yuv (planes, &ovl, WIDTH, HEIGHT, pitches, &ab);
+    cached = (_now () - start) * 1000.0 / frames;
+
+    printf ("%-8s %-5s %10.3f %14.3f %14.3f %7.2fx %d\n", tests[t].name, "yv12",
+            fast, fresh, cached, fresh / cached, maxerr);
+
+    /* yuy2 */
+    for (i = 0; i < 2 * y_size; i++)
+      yuy2[i] = _rand (&seed);
+
+    ab.disable_exact_blending = 1;
+    start = _now ();
+    for (f = 0; f < frames; f++)
+      _x_blend_yuy2 (yuy2, &ovl, WIDTH, HEIGHT, 2 * WIDTH, &ab);
+    fast = (_now () - start) * 1000.0 / frames;
+
+    ab.disable_exact_blending = 0;
+    start = _now ();
+    for (f = 0; f < frames; f++) {
+      ovl.trans[3] = 4 + (f & 7);
+      _x_blend_yuy2 (yuy2, &ovl, WIDTH, HEIGHT, 2 * WIDTH, &ab);
+    }
+    fresh = (_now () - start) * 1000.0 / frames;
+
+    start = _now ();
+    for (f = 0; f < frames; f++)
+      _x_blend_yuy2 (yuy2, &ovl, WIDTH, HEIGHT, 2 * WIDTH, &ab);
+    cached = (_now () - start) * 1000.0 / frames;
+
+    printf ("%-8s %-5s %10.3f %14.3f %14.3f %7.2fx\n", tests[t].name, "yuy2",
+            fast, fresh, cached, fresh / cached);
+
+    free (ovl.rle);
+  }
+
+  _x_alphablend_free (&ab);
+  free (frame);
+  free (ref);
+  free (yuy2);
+  xine_exit (xine);
+  return 0;
+}
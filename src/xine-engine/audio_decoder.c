@@ -43,277 +43,314 @@
 #include <xine/xineutils.h>
 #include "xine_private.h"
 
-static void *audio_decoder_loop (void *stream_gen) {
-
-  xine_stream_private_t *stream = (xine_stream_private_t *)stream_gen;
-  xine_private_t *xine = (xine_private_t *)stream->s.xine;
-  xine_ticket_t   *running_ticket = xine->port_ticket;
-  buf_element_t   *headers_first = NULL, **headers_add = &headers_first, *headers_replay = NULL;
-  int              running = 1;
-  int              prof_audio_decode = -1;
-  uint32_t         buftype_unknown = 0;
-  int              audio_channel_user = stream->audio_channel_user;
-  int              headers_num = 0;
-  /* generic bitrate estimation. */
-  int64_t          audio_br_lasttime = 0;
-  uint32_t         audio_br_lastsize = 0;
-  uint32_t         audio_br_time     = 1;
-  uint32_t         audio_br_bytes    = 0;
-  int              audio_br_num      = 20;
-  int              audio_br_value    = 0;
-  /* list of seen audio channels, sorted by number.
-   * audio_track_map[foo] & 0xff000000 is always BUF_AUDIO_BASE,
-   * and bit 31 may serve as an end marker. */
+/* list of seen audio channels, sorted by number.
+ * audio_track_map[foo] & 0xff000000 is always BUF_AUDIO_BASE,
+ * and bit 31 may serve as an end marker. */
 #define AUDIO_TRACK_MAP_MAX 50
 #define AUDIO_TRACK_MAP_MASK 0x8000ffff
 #define AUDIO_TRACK_MAP_END 0x80000000
-  uint32_t         audio_track_map[AUDIO_TRACK_MAP_MAX + 1];
 #define BUFTYPE_BASE(type) ((type) >> 24)
 #define BUFTYPE_SUB(type)  (((type) & 0x00ff0000) >> 16)
 
-  if (prof_audio_decode == -1)
-    prof_audio_decode = xine_profiler_allocate_slot ("audio decoder/output");
-
-  audio_track_map[0] = AUDIO_TRACK_MAP_END;
-
-  running_ticket->acquire (running_ticket, 0);
-
-  while (running) {
-    int handled, ignore;
-    buf_element_t *buf;
-
-    lprintf ("audio_loop: waiting for package...\n");
-
-    buf = headers_replay;
-    if (!buf)
-      buf = stream->s.audio_fifo->tget (stream->s.audio_fifo, running_ticket);
-
-    lprintf ("audio_loop: got package pts = %"PRId64", type = %08x\n", buf->pts, buf->type);
+/* decoder state, owned by either audio_decoder_loop () or a decoder pool worker. */
+typedef struct {
+  xine_decoder_job_t     job;
+  xine_stream_private_t *stream;
+  xine_ticket_t         *running_ticket;
+  buf_element_t         *headers_first, **headers_add, *headers_replay;
+  int                    headers_num;
+  int                    audio_channel_user;
+  /* BUF_CONTROL_END is waiting for audio out (1) or the video decoder (2). */
+  int                    end_wait;
+  /* discontinuity is waiting for the video decoder. */
+  int                    disc_wait;
+  uint32_t               buftype_unknown;
+  /* generic bitrate estimation. */
+  int64_t                audio_br_lasttime;
+  uint32_t               audio_br_lastsize;
+  uint32_t               audio_br_time;
+  uint32_t               audio_br_bytes;
+  int                    audio_br_num;
+  int                    audio_br_value;
+  uint32_t               audio_track_map[AUDIO_TRACK_MAP_MAX + 1];
+} audio_decoder_state_t;
+
+static void audio_decoder_state_init (audio_decoder_state_t *ad, xine_stream_private_t *stream) {
+  xine_private_t *xine = (xine_private_t *)stream->s.xine;
 
-    _x_extra_info_merge( stream->audio_decoder_extra_info, buf->extra_info );
-    stream->audio_decoder_extra_info->seek_count = stream->video_seek_count;
+  ad->job.fifo           = stream->s.audio_fifo;
+  ad->stream             = stream;
+  ad->running_ticket     = xine->port_ticket;
+  ad->headers_first      = NULL;
+  ad->headers_add        = &ad->headers_first;
+  ad->headers_replay     = NULL;
+  ad->headers_num        = 0;
+  ad->audio_channel_user = stream->audio_channel_user;
+  ad->end_wait           = 0;
+  ad->disc_wait          = 0;
+  ad->buftype_unknown    = 0;
+  ad->audio_br_lasttime  = 0;
+  ad->audio_br_lastsize  = 0;
+  ad->audio_br_time      = 1;
+  ad->audio_br_bytes     = 0;
+  ad->audio_br_num       = 20;
+  ad->audio_br_value     = 0;
+  ad->audio_track_map[0] = AUDIO_TRACK_MAP_END;
+}
 
-    switch (BUFTYPE_BASE (buf->type)) {
+/* handle 1 buf. it is freed, kept as a header, or left alone if XINE_DECODER_STEP_WAIT. */
+static int audio_decoder_step (xine_decoder_job_t *job, buf_element_t *buf) {
+  audio_decoder_state_t *ad = (audio_decoder_state_t *)job;
+  xine_stream_private_t *stream = ad->stream;
+  xine_ticket_t *running_ticket = ad->running_ticket;
+  int handled, ignore;
+  int ret = XINE_DECODER_STEP_OK;
+
+  lprintf ("audio_loop: got package pts = %"PRId64", type = %08x\n", buf->pts, buf->type);
+
+  if (ad->disc_wait) {
+    if (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 2)
+      return XINE_DECODER_STEP_WAIT;
+    ad->disc_wait = 0;
+    goto done;
+  }
 
-      case BUFTYPE_BASE (BUF_AUDIO_BASE):
+  _x_extra_info_merge( stream->audio_decoder_extra_info, buf->extra_info );
+  stream->audio_decoder_extra_info->seek_count = stream->video_seek_count;
 
-        if ((buf->type & 0xffff0000) == BUF_AUDIO_UNKNOWN)
-          break;
-        xine_rwlock_rdlock (&stream->info_lock);
-        handled = stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED];
-        ignore  = stream->stream_info[XINE_STREAM_INFO_IGNORE_AUDIO];
-        xine_rwlock_unlock (&stream->info_lock);
-        (void)handled; /* dont optimize away the read. */
-        if (ignore)
-          break;
-        xine_profiler_start_count (prof_audio_decode);
+  switch (BUFTYPE_BASE (buf->type)) {
 
-        /* running_ticket->acquire (running_ticket, 0); */
+    case BUFTYPE_BASE (BUF_AUDIO_BASE):
 
-        {
-          uint32_t audio_type = 0;
-          int      i;
-          uint32_t chan;
-          /* printf ("audio_decoder: buf_type=%08x auto=%08x user=%08x\n",
-               buf->type, stream->audio_channel_auto, audio_channel_user); */
-
-          /* update track map */
-          chan = buf->type & 0x0000ffff;
-          i = 0;
-          while ((audio_track_map[i] & AUDIO_TRACK_MAP_MASK) < chan)
-            i++;
-          if ((audio_track_map[i] & AUDIO_TRACK_MAP_MASK) != chan) {
-            xine_event_t  ui_event;
-            int j = stream->audio_track_map_entries;
-            if (j >= AUDIO_TRACK_MAP_MAX) {
-              xine_profiler_stop_count (prof_audio_decode);
-              break;
-            }
-            while (j >= i) {
-              audio_track_map[j + 1] = audio_track_map[j];
-              j--;
-            }
-            audio_track_map[i] = buf->type;
-            stream->audio_track_map_entries++;
-            /* implicit channel change - reopen decoder below */
-            if ((i == 0) && (audio_channel_user == -1) && (stream->s.audio_channel_auto < 0))
-              stream->audio_decoder_streamtype = -1;
-            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-            ui_event.data_length = 0;
-            xine_event_send (&stream->s, &ui_event);
+      if ((buf->type & 0xffff0000) == BUF_AUDIO_UNKNOWN)
+        break;
+      xine_rwlock_rdlock (&stream->info_lock);
+      handled = stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED];
+      ignore  = stream->stream_info[XINE_STREAM_INFO_IGNORE_AUDIO];
+      xine_rwlock_unlock (&stream->info_lock);
+      (void)handled; /* dont optimize away the read. */
+      if (ignore)
+        break;
+      /* try not to block a shared thread in audio_port.get_buffer ().
+       * if it still does, the pool starts a stand in meanwhile. */
+      if (ad->job.pool && stream->audio_decoder_plugin) {
+        int free_bufs = stream->s.audio_out->get_property (stream->s.audio_out, AO_PROP_BUFS_FREE);
+        if ((free_bufs >= 0) && (free_bufs < 2))
+          return XINE_DECODER_STEP_WAIT;
+      }
+      XINE_PROFILER_BEGIN ("audio decode");
+
+      /* running_ticket->acquire (running_ticket, 0); */
+
+      {
+        uint32_t audio_type = 0;
+        int      i;
+        uint32_t chan;
+        /* printf ("audio_decoder: buf_type=%08x auto=%08x user=%08x\n",
+             buf->type, stream->audio_channel_auto, ad->audio_channel_user); */
+
+        /* update track map */
+        chan = buf->type & 0x0000ffff;
+        i = 0;
+        while ((ad->audio_track_map[i] & AUDIO_TRACK_MAP_MASK) < chan)
+          i++;
+        if ((ad->audio_track_map[i] & AUDIO_TRACK_MAP_MASK) != chan) {
+          xine_event_t  ui_event;
+          int j = stream->audio_track_map_entries;
+          if (j >= AUDIO_TRACK_MAP_MAX) {
+            XINE_PROFILER_END ();
+            break;
           }
+          while (j >= i) {
+            ad->audio_track_map[j + 1] = ad->audio_track_map[j];
+            j--;
+          }
+          ad->audio_track_map[i] = buf->type;
+          stream->audio_track_map_entries++;
+          /* implicit channel change - reopen decoder below */
+          if ((i == 0) && (ad->audio_channel_user == -1) && (stream->s.audio_channel_auto < 0))
+            stream->audio_decoder_streamtype = -1;
+          ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+          ui_event.data_length = 0;
+          xine_event_send (&stream->s, &ui_event);
+        }
 
-          /* find out which audio type to decode */
-          lprintf ("audio_channel_user = %d, map[0]=%08x\n", audio_channel_user, audio_track_map[0]);
-          if (audio_channel_user > -2) {
-            if (audio_channel_user == -1) {
-              /* auto */
-              lprintf ("audio_channel_auto = %d\n", stream->s.audio_channel_auto);
-              if (stream->s.audio_channel_auto >= 0) {
-                if ((int)(buf->type & 0xFF) == stream->s.audio_channel_auto) {
-                  audio_type = buf->type;
-                } else
-                  audio_type = -1;
+        /* find out which audio type to decode */
+        lprintf ("ad->audio_channel_user = %d, map[0]=%08x\n", ad->audio_channel_user, ad->audio_track_map[0]);
+        if (ad->audio_channel_user > -2) {
+          if (ad->audio_channel_user == -1) {
+            /* auto */
+            lprintf ("audio_channel_auto = %d\n", stream->s.audio_channel_auto);
+            if (stream->s.audio_channel_auto >= 0) {
+              if ((int)(buf->type & 0xFF) == stream->s.audio_channel_auto) {
+                audio_type = buf->type;
               } else
-                audio_type = audio_track_map[0];
-            } else {
-              if (audio_channel_user <= stream->audio_track_map_entries)
-                audio_type = audio_track_map[audio_channel_user];
-              else
                 audio_type = -1;
-            }
+            } else
+              audio_type = ad->audio_track_map[0];
+          } else {
+            if (ad->audio_channel_user <= stream->audio_track_map_entries)
+              audio_type = ad->audio_track_map[ad->audio_channel_user];
+            else
+              audio_type = -1;
+          }
 
-            /* now, decode stream buffer if it's the right audio type */
-            if (buf->type == audio_type) {
+          /* now, decode stream buffer if it's the right audio type */
+          if (buf->type == audio_type) {
 
-              int streamtype = (buf->type>>16) & 0xFF;
-              /* close old decoder of audio type has changed */
-              if (buf->type != buftype_unknown &&
-                (stream->audio_decoder_streamtype != streamtype ||
-                !stream->audio_decoder_plugin)) {
-                if (stream->audio_decoder_plugin) {
-                  _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
-                }
-                stream->audio_decoder_streamtype = streamtype;
-                stream->audio_decoder_plugin = _x_get_audio_decoder (&stream->s, streamtype);
-                handled = (stream->audio_decoder_plugin != NULL);
-                xine_rwlock_wrlock (&stream->info_lock);
-                stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED] = handled;
-                xine_rwlock_unlock (&stream->info_lock);
-                /* audio_br_reset */
-                audio_br_lasttime = 0;
-                audio_br_lastsize = 0;
-                audio_br_time     = 1; /* No / 0 please. */
-                audio_br_bytes    = 0;
-                audio_br_num      = 20;
-                audio_br_value    = 0;
+            int streamtype = (buf->type>>16) & 0xFF;
+            /* close old decoder of audio type has changed */
+            if (buf->type != ad->buftype_unknown &&
+              (stream->audio_decoder_streamtype != streamtype ||
+              !stream->audio_decoder_plugin)) {
+              if (stream->audio_decoder_plugin) {
+                _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
               }
-              if (audio_type != stream->audio_type) {
-                if (stream->audio_decoder_plugin) {
-                  xine_event_t event;
-                  stream->audio_type = audio_type;
-                  event.type         = XINE_EVENT_UI_CHANNELS_CHANGED;
-                  event.data_length  = 0;
-                  xine_event_send (&stream->s, &event);
-                }
+              stream->audio_decoder_streamtype = streamtype;
+              stream->audio_decoder_plugin = _x_get_audio_decoder (&stream->s, streamtype);
+              handled = (stream->audio_decoder_plugin != NULL);
+              xine_rwlock_wrlock (&stream->info_lock);
+              stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED] = handled;
+              xine_rwlock_unlock (&stream->info_lock);
+              /* audio_br_reset */
+              ad->audio_br_lasttime = 0;
+              ad->audio_br_lastsize = 0;
+              ad->audio_br_time     = 1; /* No / 0 please. */
+              ad->audio_br_bytes    = 0;
+              ad->audio_br_num      = 20;
+              ad->audio_br_value    = 0;
+            }
+            if (audio_type != stream->audio_type) {
+              if (stream->audio_decoder_plugin) {
+                xine_event_t event;
+                stream->audio_type = audio_type;
+                event.type         = XINE_EVENT_UI_CHANNELS_CHANGED;
+                event.data_length  = 0;
+                xine_event_send (&stream->s, &event);
               }
+            }
 
-              /* audio_br_add. some decoders reset buf->pts, do this first. */
-              if (buf->pts) {
-                int64_t d = buf->pts - audio_br_lasttime;
-                if (d > 0) {
-                  if (d < 220000) {
-                    audio_br_time += d;
-                    audio_br_bytes += audio_br_lastsize;
-                    audio_br_lastsize = 0;
-                    if (--audio_br_num < 0) {
-                      int br, bdiff;
-                      audio_br_num = 20;
-                      if ((audio_br_bytes | audio_br_time) & 0x80000000) {
-                        audio_br_bytes >>= 1;
-                        audio_br_time  >>= 1;
-                      }
-                      br = xine_uint_mul_div (audio_br_bytes, 90000 * 8, audio_br_time);
-                      bdiff = br - audio_br_value;
-                      if (bdiff < 0)
-                        bdiff = -bdiff;
-                      if (bdiff > (br >> 6)) {
-                        audio_br_value = br;
-                        xine_rwlock_wrlock (&stream->info_lock);
-                        stream->stream_info[XINE_STREAM_INFO_AUDIO_BITRATE] = br;
-                        xine_rwlock_unlock (&stream->info_lock);
-                      }
+            /* audio_br_add. some decoders reset buf->pts, do this first. */
+            if (buf->pts) {
+              int64_t d = buf->pts - ad->audio_br_lasttime;
+              if (d > 0) {
+                if (d < 220000) {
+                  ad->audio_br_time += d;
+                  ad->audio_br_bytes += ad->audio_br_lastsize;
+                  ad->audio_br_lastsize = 0;
+                  if (--ad->audio_br_num < 0) {
+                    int br, bdiff;
+                    ad->audio_br_num = 20;
+                    if ((ad->audio_br_bytes | ad->audio_br_time) & 0x80000000) {
+                      ad->audio_br_bytes >>= 1;
+                      ad->audio_br_time  >>= 1;
+                    }
+                    br = xine_uint_mul_div (ad->audio_br_bytes, 90000 * 8, ad->audio_br_time);
+                    bdiff = br - ad->audio_br_value;
+                    if (bdiff < 0)
+                      bdiff = -bdiff;
+                    if (bdiff > (br >> 6)) {
+                      ad->audio_br_value = br;
+                      xine_rwlock_wrlock (&stream->info_lock);
+                      stream->stream_info[XINE_STREAM_INFO_AUDIO_BITRATE] = br;
+                      xine_rwlock_unlock (&stream->info_lock);
                     }
                   }
-                  audio_br_lasttime = buf->pts;
-                } else {
-                  /* Do we really need to care for reordered audio? So what. */
-                  if (d <= -220000)
-                    audio_br_lasttime = buf->pts;
-                }
-              }
-              audio_br_lastsize += buf->size;
-
-              /* finally - decode data */
-              if (stream->audio_decoder_plugin)
-                stream->audio_decoder_plugin->decode_data (stream->audio_decoder_plugin, buf);
-
-              /* no need to lock again. it may have been reset from this thread inside
-               * audio_decoder_plugin->decode_data (), if at all.
-               * XXX: should we try a different decoder then? */
-              handled = stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED];
-              if (!handled && (buf->type != buftype_unknown)) {
-                const char *aname = _x_buf_audio_name (buf->type);
-
-                xine_log (stream->s.xine, XINE_LOG_MSG,
-                  _("audio_decoder: no plugin available to handle '%s'\n"), aname);
-                if (!_x_meta_info_get (&stream->s, XINE_META_INFO_AUDIOCODEC))
-                  _x_meta_info_set_utf8 (&stream->s, XINE_META_INFO_AUDIOCODEC, aname);
-                buftype_unknown = buf->type;
-                /* fatal error - dispose plugin */
-                if (stream->audio_decoder_plugin) {
-                  _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
-                  stream->audio_decoder_plugin = NULL;
                 }
+                ad->audio_br_lasttime = buf->pts;
+              } else {
+                /* Do we really need to care for reordered audio? So what. */
+                if (d <= -220000)
+                  ad->audio_br_lasttime = buf->pts;
               }
             }
-          }
-        }
-        /* if (running_ticket->ticket_revoked)
-         *   running_ticket->renew (running_ticket, 0);
-         * running_ticket->release (running_ticket, 0);
-         */
-        xine_profiler_stop_count (prof_audio_decode);
-        break;
+            ad->audio_br_lastsize += buf->size;
 
-      case BUFTYPE_BASE (BUF_CONTROL_BASE):
+            /* finally - decode data */
+            if (stream->audio_decoder_plugin)
+              stream->audio_decoder_plugin->decode_data (stream->audio_decoder_plugin, buf);
 
-        switch (BUFTYPE_SUB (buf->type)) {
-          int t;
+            /* no need to lock again. it may have been reset from this thread inside
+             * audio_decoder_plugin->decode_data (), if at all.
+             * XXX: should we try a different decoder then? */
+            handled = stream->stream_info[XINE_STREAM_INFO_AUDIO_HANDLED];
+            if (!handled && (buf->type != ad->buftype_unknown)) {
+              const char *aname = _x_buf_audio_name (buf->type);
 
-          case BUFTYPE_SUB (BUF_CONTROL_HEADERS_DONE):
-            pthread_mutex_lock (&stream->counter.lock);
-            stream->counter.headers_audio++;
-            if (stream->video_thread_created) {
-              /* avoid useless wakes on an incomplete pair */
-              if (stream->counter.headers_audio <= stream->counter.headers_video)
-                pthread_cond_broadcast (&stream->counter.changed);
-            } else {
-              pthread_cond_broadcast (&stream->counter.changed);
+              xine_log (stream->s.xine, XINE_LOG_MSG,
+                _("audio_decoder: no plugin available to handle '%s'\n"), aname);
+              if (!_x_meta_info_get (&stream->s, XINE_META_INFO_AUDIOCODEC))
+                _x_meta_info_set_utf8 (&stream->s, XINE_META_INFO_AUDIOCODEC, aname);
+              ad->buftype_unknown = buf->type;
+              /* fatal error - dispose plugin */
+              if (stream->audio_decoder_plugin) {
+                _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
+                stream->audio_decoder_plugin = NULL;
+              }
             }
-            pthread_mutex_unlock (&stream->counter.lock);
-            break;
+          }
+        }
+      }
+      /* if (running_ticket->ticket_revoked)
+       *   running_ticket->renew (running_ticket, 0);
+       * running_ticket->release (running_ticket, 0);
+       */
+      XINE_PROFILER_END ();
+      break;
+
+    case BUFTYPE_BASE (BUF_CONTROL_BASE):
+
+      switch (BUFTYPE_SUB (buf->type)) {
+        int t;
+
+        case BUFTYPE_SUB (BUF_CONTROL_HEADERS_DONE):
+          pthread_mutex_lock (&stream->counter.lock);
+          stream->counter.headers_audio++;
+          if (stream->video_thread_created) {
+            /* avoid useless wakes on an incomplete pair */
+            if (stream->counter.headers_audio <= stream->counter.headers_video)
+              pthread_cond_broadcast (&stream->counter.changed);
+          } else {
+            pthread_cond_broadcast (&stream->counter.changed);
+          }
+          pthread_mutex_unlock (&stream->counter.lock);
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_START):
-            lprintf ("start\n");
-            /* decoder dispose might call port functions */
-            /* running_ticket->acquire(running_ticket, 0); */
-            if (stream->audio_decoder_plugin) {
-              lprintf ("close old decoder\n");
-              stream->keep_ao_driver_open = !!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW);
-              _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
-              stream->audio_decoder_plugin = NULL;
-              stream->audio_type = 0;
-              stream->keep_ao_driver_open = 0;
-            }
-            /* running_ticket->release(running_ticket, 0); */
-            audio_track_map[0] = AUDIO_TRACK_MAP_END;
-            stream->audio_track_map_entries = 0;
-            if (!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW)) {
-              running_ticket->release (running_ticket, 0);
-              stream->s.metronom->handle_audio_discontinuity (stream->s.metronom, DISC_STREAMSTART, 0);
-              running_ticket->acquire (running_ticket, 0);
-            }
-            buftype_unknown = 0;
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_START):
+          lprintf ("start\n");
+          /* decoder dispose might call port functions */
+          /* running_ticket->acquire(running_ticket, 0); */
+          if (stream->audio_decoder_plugin) {
+            lprintf ("close old decoder\n");
+            stream->keep_ao_driver_open = !!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW);
+            _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
+            stream->audio_decoder_plugin = NULL;
+            stream->audio_type = 0;
+            stream->keep_ao_driver_open = 0;
+          }
+          /* running_ticket->release(running_ticket, 0); */
+          ad->audio_track_map[0] = AUDIO_TRACK_MAP_END;
+          stream->audio_track_map_entries = 0;
+          if (!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW)) {
+            running_ticket->release (running_ticket, 0);
+            stream->s.metronom->handle_audio_discontinuity (stream->s.metronom, DISC_STREAMSTART, 0);
+            running_ticket->acquire (running_ticket, 0);
+            ad->disc_wait = ad->job.pool &&
+              (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 2);
+          }
+          ad->buftype_unknown = 0;
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_END):
+        case BUFTYPE_SUB (BUF_CONTROL_END):
+          if (ad->end_wait == 0) {
             /* free all held header buffers, see comments below */
-            _x_free_buf_elements (headers_first);
-            headers_first  = NULL;
-            headers_add    = &headers_first;
-            headers_replay = NULL;
-            headers_num    = 0;
+            _x_free_buf_elements (ad->headers_first);
+            ad->headers_first  = NULL;
+            ad->headers_add    = &ad->headers_first;
+            ad->headers_replay = NULL;
+            ad->headers_num    = 0;
+          }
+          if (ad->end_wait < 2) {
             /* wait the output fifos to run dry before sending the notification event
              * to the frontend. this test is only valid if there is only a single
              * stream attached to the current output port. */
@@ -324,6 +361,11 @@ static void *audio_decoder_loop (void *stream_gen) {
               num_streams = stream->s.audio_out->get_property (stream->s.audio_out, AO_PROP_NUM_STREAMS);
               /* running_ticket->release(running_ticket, 0); */
               if( num_bufs > 0 && num_streams == 1 && !stream->early_finish_event) {
+                if (ad->job.pool) {
+                  /* this pool worker has better things to do meanwhile. */
+                  ad->end_wait = 1;
+                  return XINE_DECODER_STEP_WAIT;
+                }
                 running_ticket->release (running_ticket, 0);
                 xine_usec_sleep (10000);
                 running_ticket->acquire (running_ticket, 0);
@@ -331,194 +373,260 @@ static void *audio_decoder_loop (void *stream_gen) {
                 break;
             }
             running_ticket->release (running_ticket, 0);
-            /* wait for video to reach this marker, if necessary */
             pthread_mutex_lock (&stream->counter.lock);
             stream->counter.finisheds_audio++;
             lprintf ("reached end marker # %d\n", stream->counter.finisheds_audio);
-            if (stream->video_thread_created) {
-              if (stream->counter.finisheds_audio > stream->counter.finisheds_video) {
-                do {
-                  struct timespec ts = {0, 0};
-                  xine_gettime (&ts);
-                  ts.tv_sec += 1;
-                  /* use timedwait to workaround buggy pthread broadcast implementations */
-                  pthread_cond_timedwait (&stream->counter.changed, &stream->counter.lock, &ts);
-                } while (stream->counter.finisheds_audio > stream->counter.finisheds_video);
-              } else if (stream->counter.finisheds_audio == stream->counter.finisheds_video) {
-                pthread_cond_broadcast (&stream->counter.changed);
+          } else {
+            running_ticket->release (running_ticket, 0);
+            pthread_mutex_lock (&stream->counter.lock);
+          }
+          /* wait for video to reach this marker, if necessary */
+          if (stream->video_thread_created) {
+            if (stream->counter.finisheds_audio > stream->counter.finisheds_video) {
+              if (ad->job.pool) {
+                /* the video decoder may need this pool worker. come back later. */
+                pthread_mutex_unlock (&stream->counter.lock);
+                running_ticket->acquire (running_ticket, 0);
+                ad->end_wait = 2;
+                return XINE_DECODER_STEP_WAIT;
               }
-            } else {
+              do {
+                struct timespec ts = {0, 0};
+                xine_gettime (&ts);
+                ts.tv_sec += 1;
+                /* use timedwait to workaround buggy pthread broadcast implementations */
+                pthread_cond_timedwait (&stream->counter.changed, &stream->counter.lock, &ts);
+              } while (stream->counter.finisheds_audio > stream->counter.finisheds_video);
+            } else if (stream->counter.finisheds_audio == stream->counter.finisheds_video) {
               pthread_cond_broadcast (&stream->counter.changed);
             }
-            pthread_mutex_unlock (&stream->counter.lock);
-            stream->s.audio_channel_auto = -1;
-            running_ticket->acquire (running_ticket, 0);
-            break;
-
-          case BUFTYPE_SUB (BUF_CONTROL_QUIT):
-            /* decoder dispose might call port functions */
-            /* running_ticket->acquire(running_ticket, 0); */
-            if (stream->audio_decoder_plugin) {
-              _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
-              stream->audio_decoder_plugin = NULL;
-              stream->audio_type = 0;
-            }
-            /* running_ticket->release(running_ticket, 0); */
-            audio_track_map[0] = AUDIO_TRACK_MAP_END;
-            stream->audio_track_map_entries = 0;
-            running = 0;
-            break;
-
-          case BUFTYPE_SUB (BUF_CONTROL_NOP):
-            break;
+          } else {
+            pthread_cond_broadcast (&stream->counter.changed);
+          }
+          ad->end_wait = 0;
+          pthread_mutex_unlock (&stream->counter.lock);
+          stream->s.audio_channel_auto = -1;
+          running_ticket->acquire (running_ticket, 0);
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_RESET_DECODER):
-            lprintf ("reset\n");
-            _x_extra_info_reset (stream->audio_decoder_extra_info);
-            if (stream->audio_decoder_plugin) {
-              /* running_ticket->acquire(running_ticket, 0); */
-              stream->audio_decoder_plugin->reset (stream->audio_decoder_plugin);
-              /* running_ticket->release(running_ticket, 0); */
-            }
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_QUIT):
+          /* decoder dispose might call port functions */
+          /* running_ticket->acquire(running_ticket, 0); */
+          if (stream->audio_decoder_plugin) {
+            _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
+            stream->audio_decoder_plugin = NULL;
+            stream->audio_type = 0;
+          }
+          /* running_ticket->release(running_ticket, 0); */
+          ad->audio_track_map[0] = AUDIO_TRACK_MAP_END;
+          stream->audio_track_map_entries = 0;
+          ret = XINE_DECODER_STEP_QUIT;
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_DISCONTINUITY):
-            t = DISC_RELATIVE;
-            goto handle_disc;
+        case BUFTYPE_SUB (BUF_CONTROL_NOP):
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_NEWPTS):
-            t = (buf->decoder_flags & BUF_FLAG_SEEK) ? DISC_STREAMSEEK : DISC_ABSOLUTE;
-          handle_disc:
-            if (stream->audio_decoder_plugin) {
-              /* running_ticket->acquire(running_ticket, 0); */
-              stream->audio_decoder_plugin->discontinuity (stream->audio_decoder_plugin);
-              /* running_ticket->release(running_ticket, 0); */
-            }
-            running_ticket->release (running_ticket, 0);
-            stream->s.metronom->handle_audio_discontinuity (stream->s.metronom, t, buf->disc_off);
-            running_ticket->acquire (running_ticket, 0);
-            /* audio_br_discontinuity */
-            audio_br_lasttime = 0;
-            audio_br_lastsize = 0;
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_RESET_DECODER):
+          lprintf ("reset\n");
+          _x_extra_info_reset (stream->audio_decoder_extra_info);
+          if (stream->audio_decoder_plugin) {
+            /* running_ticket->acquire(running_ticket, 0); */
+            stream->audio_decoder_plugin->reset (stream->audio_decoder_plugin);
+            /* running_ticket->release(running_ticket, 0); */
+          }
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_AUDIO_CHANNEL):
-            xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
-              "audio_decoder: suggested switching to stream_id %02x\n", buf->decoder_info[0]);
-            stream->s.audio_channel_auto = buf->decoder_info[0] & 0xff;
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_DISCONTINUITY):
+          t = DISC_RELATIVE;
+          goto handle_disc;
 
-          case BUFTYPE_SUB (BUF_CONTROL_RESET_TRACK_MAP):
-            if (stream->audio_track_map_entries) {
-              xine_event_t ui_event;
-              audio_track_map[0] = AUDIO_TRACK_MAP_END;
-              stream->audio_track_map_entries = 0;
-              ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-              ui_event.data_length = 0;
-              xine_event_send (&stream->s, &ui_event);
-            }
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_NEWPTS):
+          t = (buf->decoder_flags & BUF_FLAG_SEEK) ? DISC_STREAMSEEK : DISC_ABSOLUTE;
+        handle_disc:
+          if (stream->audio_decoder_plugin) {
+            /* running_ticket->acquire(running_ticket, 0); */
+            stream->audio_decoder_plugin->discontinuity (stream->audio_decoder_plugin);
+            /* running_ticket->release(running_ticket, 0); */
+          }
+          running_ticket->release (running_ticket, 0);
+          stream->s.metronom->handle_audio_discontinuity (stream->s.metronom, t, buf->disc_off);
+          running_ticket->acquire (running_ticket, 0);
+          ad->disc_wait = ad->job.pool &&
+            (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 2);
+          /* audio_br_discontinuity */
+          ad->audio_br_lasttime = 0;
+          ad->audio_br_lastsize = 0;
+          break;
 
-          default:
-            if (buf->type != buftype_unknown) {
-              xine_log (stream->s.xine, XINE_LOG_MSG,
-              _("audio_decoder: error, unknown buffer type: %08x\n"), buf->type);
-              buftype_unknown = buf->type;
-            }
+        case BUFTYPE_SUB (BUF_CONTROL_AUDIO_CHANNEL):
+          xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+            "audio_decoder: suggested switching to stream_id %02x\n", buf->decoder_info[0]);
+          stream->s.audio_channel_auto = buf->decoder_info[0] & 0xff;
+          break;
 
-        } /* case BUFTYPE_BASE (BUF_CONTROL_BASE) */
-        break;
+        case BUFTYPE_SUB (BUF_CONTROL_RESET_TRACK_MAP):
+          if (stream->audio_track_map_entries) {
+            xine_event_t ui_event;
+            ad->audio_track_map[0] = AUDIO_TRACK_MAP_END;
+            stream->audio_track_map_entries = 0;
+            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+            ui_event.data_length = 0;
+            xine_event_send (&stream->s, &ui_event);
+          }
+          break;
 
-      default:
-        if (buf->type != buftype_unknown) {
-          xine_log (stream->s.xine, XINE_LOG_MSG,
+        default:
+          if (buf->type != ad->buftype_unknown) {
+            xine_log (stream->s.xine, XINE_LOG_MSG,
             _("audio_decoder: error, unknown buffer type: %08x\n"), buf->type);
-          buftype_unknown = buf->type;
-        }
+            ad->buftype_unknown = buf->type;
+          }
 
-    } /* switch (BUFTYPE_BASE (buf->type)) */
+      } /* case BUFTYPE_BASE (BUF_CONTROL_BASE) */
+      break;
 
-    /* some decoders require a full reinitialization when audio
-     * channel is changed (rate might be change and even a
-     * different codec may be used).
-     *
-     * we must close the old decoder and process all the headers
-     * again, since they are needed for decoder initialization.
-     */
-    if (headers_replay) {
-      headers_replay = headers_replay->next;
+    default:
+      if (buf->type != ad->buftype_unknown) {
+        xine_log (stream->s.xine, XINE_LOG_MSG,
+          _("audio_decoder: error, unknown buffer type: %08x\n"), buf->type);
+        ad->buftype_unknown = buf->type;
+      }
+
+  } /* switch (BUFTYPE_BASE (buf->type)) */
+
+  /* keep buf until video has been here as well. */
+  if (ad->disc_wait)
+    return XINE_DECODER_STEP_WAIT;
+
+ done:
+  /* some decoders require a full reinitialization when audio
+   * channel is changed (rate might be change and even a
+   * different codec may be used).
+   *
+   * we must close the old decoder and process all the headers
+   * again, since they are needed for decoder initialization.
+   */
+  if (ad->headers_replay) {
+    ad->headers_replay = ad->headers_replay->next;
+  } else {
+    if (ad->audio_channel_user != stream->audio_channel_user) {
+      ad->audio_channel_user = stream->audio_channel_user;
+      if (stream->audio_decoder_plugin) {
+        /* decoder dispose might call port functions */
+        /* running_ticket->acquire (running_ticket, 0); */
+        _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
+        /* running_ticket->release (running_ticket, 0); */
+        stream->audio_decoder_plugin = NULL;
+        ad->audio_track_map[0] = AUDIO_TRACK_MAP_END;
+        stream->audio_track_map_entries = 0;
+        stream->audio_type = 0;
+      }
+      buf->free_buffer (buf);
+      ad->headers_replay = ad->headers_first;
+      xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+        "audio_decoder: replaying %d headers.\n", ad->headers_num);
     } else {
-      if (audio_channel_user != stream->audio_channel_user) {
-        audio_channel_user = stream->audio_channel_user;
-        if (stream->audio_decoder_plugin) {
-          /* decoder dispose might call port functions */
-          /* running_ticket->acquire (running_ticket, 0); */
-          _x_free_audio_decoder (&stream->s, stream->audio_decoder_plugin);
-          /* running_ticket->release (running_ticket, 0); */
-          stream->audio_decoder_plugin = NULL;
-          audio_track_map[0] = AUDIO_TRACK_MAP_END;
-          stream->audio_track_map_entries = 0;
-          stream->audio_type = 0;
-        }
-        buf->free_buffer (buf);
-        headers_replay = headers_first;
-        xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
-          "audio_decoder: replaying %d headers.\n", headers_num);
-      } else {
-        /* header buffers are never freed. instead they
-         * are added to a list to allow replaying them
-         * in case of a channel change. */
-        if (buf->decoder_flags & BUF_FLAG_HEADER) {
-          /* drop outdated headers. */
-          int num = 0;
-          buf_element_t *here = headers_first, **add = &headers_first;
-          while (here) {
-            buf_element_t *next = here->next;
-            uint32_t d = here->type ^ buf->type;
-            if (((d & 0x0000ffff) == 0) &&
-              (((d & 0xffff0000) != 0) || (here->decoder_flags == buf->decoder_flags))) {
-              *add = next;
-              here->next = NULL;
-              here->free_buffer (here);
-              headers_num--;
-              num++;
-            } else {
-              add = &here->next;
-            }
-            here = next;
+      /* header buffers are never freed. instead they
+       * are added to a list to allow replaying them
+       * in case of a channel change. */
+      if (buf->decoder_flags & BUF_FLAG_HEADER) {
+        /* drop outdated headers. */
+        int num = 0;
+        buf_element_t *here = ad->headers_first, **add = &ad->headers_first;
+        while (here) {
+          buf_element_t *next = here->next;
+          uint32_t d = here->type ^ buf->type;
+          if (((d & 0x0000ffff) == 0) &&
+            (((d & 0xffff0000) != 0) || (here->decoder_flags == buf->decoder_flags))) {
+            *add = next;
+            here->next = NULL;
+            here->free_buffer (here);
+            ad->headers_num--;
+            num++;
+          } else {
+            add = &here->next;
           }
-          headers_add = add;
-          if (num)
-            xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
-              "audio_decoder: dropped %d outdated headers for track #%u.\n",
-              num, (unsigned int)(buf->type & 0x0000ffff));
-          *headers_add = buf;
-          headers_add  = &buf->next;
-          buf->next = NULL;
-          headers_num++;
-        } else {
-          buf->free_buffer (buf);
+          here = next;
         }
+        ad->headers_add = add;
+        if (num)
+          xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+            "audio_decoder: dropped %d outdated headers for track #%u.\n",
+            num, (unsigned int)(buf->type & 0x0000ffff));
+        *ad->headers_add = buf;
+        ad->headers_add  = &buf->next;
+        buf->next = NULL;
+        ad->headers_num++;
+      } else {
+        buf->free_buffer (buf);
       }
     }
   }
 
-  running_ticket->release (running_ticket, 0);
+  if (ret == XINE_DECODER_STEP_QUIT) {
+    /* free all held header buffers */
+    _x_free_buf_elements (ad->headers_first);
+    ad->headers_first  = NULL;
+    ad->headers_add    = &ad->headers_first;
+    ad->headers_replay = NULL;
+    ad->headers_num    = 0;
+  }
+
+  return ret;
+}
 
-  /* free all held header buffers */
-  _x_free_buf_elements (headers_first);
+/* replay held headers first after a channel change. */
+static buf_element_t *audio_decoder_get (xine_decoder_job_t *job) {
+  audio_decoder_state_t *ad = (audio_decoder_state_t *)job;
+
+  if (ad->headers_replay)
+    return ad->headers_replay;
+  return job->fifo->try_get (job->fifo);
+}
+
+static void *audio_decoder_loop (void *stream_gen) {
+
+  xine_stream_private_t *stream = (xine_stream_private_t *)stream_gen;
+  audio_decoder_state_t ad;
+
+  XINE_PROFILER_THREAD ("audio decoder");
+
+  audio_decoder_state_init (&ad, stream);
+  ad.job.pool = NULL;
+
+  ad.running_ticket->acquire (ad.running_ticket, 0);
+
+  while (1) {
+    buf_element_t *buf;
+
+    lprintf ("audio_loop: waiting for package...\n");
+
+    buf = ad.headers_replay;
+    if (!buf) {
+      XINE_PROFILER_BEGIN ("audio fifo wait");
+      buf = stream->s.audio_fifo->tget (stream->s.audio_fifo, ad.running_ticket);
+      XINE_PROFILER_END ();
+    }
+
+    if (audio_decoder_step (&ad.job, buf) == XINE_DECODER_STEP_QUIT)
+      break;
+  }
+
+  ad.running_ticket->release (ad.running_ticket, 0);
 
   return NULL;
 }
 
 int _x_audio_decoder_init (xine_stream_t *s) {
   xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  xine_private_t *xine;
 
   if (!stream)
     return 0;
   stream = stream->side_streams[0];
   if (stream->s.audio_fifo)
     return 1;
+  xine = (xine_private_t *)stream->s.xine;
 
   if (stream->s.audio_out == NULL) {
 
@@ -565,6 +673,25 @@ int _x_audio_decoder_init (xine_stream_t *s) {
      * stream->audio_temp = lrb_new (100, stream->audio_fifo);
      */
 
+    /* engine.decoder.pool_threads: let the shared workers do it. */
+    if (xine->decoder_pool) {
+      audio_decoder_state_t *ad = malloc (sizeof (*ad));
+      if (!ad) {
+        stream->s.audio_fifo->dispose (stream->s.audio_fifo);
+        stream->s.audio_fifo = NULL;
+        return 0;
+      }
+      audio_decoder_state_init (ad, stream);
+      ad->job.get  = audio_decoder_get;
+      ad->job.step = audio_decoder_step;
+      stream->audio_decoder_job = &ad->job;
+      /* never block a shared thread in a/v discontinuity sync. */
+      stream->s.metronom->set_option (stream->s.metronom, METRONOM_DISC_NONBLOCK, 1);
+      stream->audio_thread_created = 1;
+      _x_decoder_pool_join (xine->decoder_pool, &ad->job);
+      return 1;
+    }
+
     pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
     pthread_attr_getschedparam(&pth_attrs, &pth_params);
@@ -605,7 +732,13 @@ void _x_audio_decoder_shutdown (xine_stream_t *s) {
     buf->type = BUF_CONTROL_QUIT;
     stream->s.audio_fifo->put (stream->s.audio_fifo, buf);
 
-    pthread_join (stream->audio_thread, &p);
+    if (stream->audio_decoder_job) {
+      _x_decoder_pool_leave (stream->audio_decoder_job);
+      free (stream->audio_decoder_job);
+      stream->audio_decoder_job = NULL;
+    } else {
+      pthread_join (stream->audio_thread, &p);
+    }
     stream->audio_thread_created = 0;
   }
 
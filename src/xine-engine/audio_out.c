@@ -290,6 +290,33 @@ typedef struct {
     xine_stream_private_t *buf_streams[NUM_AUDIO_BUFFERS];
   } out_fifo;
 
+  /* optional filter and conversion thread, running ahead of ao_loop.
+   * buf states and cur/busy are protected by out_fifo.mutex, filter and
+   * conversion settings by prep.mutex. */
+  struct {
+#define PREP_NEW      0 /* not yet touched */
+#define PREP_BUSY     1 /* worker is on it */
+#define PREP_LOOP     2 /* ao_loop is on it */
+#define PREP_FILTERED 3 /* filters applied in place, still needs conversion */
+#define PREP_DONE     4 /* ready for the driver in res[] */
+    pthread_mutex_t  mutex;
+    pthread_cond_t   wake;
+    pthread_cond_t   done;
+    pthread_t        thread;
+    int              running;
+    int              waiting;
+    int              depth;                /* 0 (off), or max bufs to prepare ahead */
+    uint32_t         gen;                  /* increments with every settings change */
+    audio_buffer_t  *cur;                  /* the buf ao_loop is working on */
+    audio_buffer_t  *busy;                 /* the buf the worker is working on */
+    uint8_t          state[NUM_AUDIO_BUFFERS];
+    uint32_t         bgen[NUM_AUDIO_BUFFERS];
+    audio_buffer_t  *res[NUM_AUDIO_BUFFERS];
+    /* conversion results, swapped with frame_buf[0]. the last one belongs to ao_loop. */
+    audio_buffer_t  *out[NUM_AUDIO_BUFFERS + 1];
+    audio_buffer_t   base_out[NUM_AUDIO_BUFFERS + 1];
+  } prep;
+
   struct {
     uint32_t         speed;
     int              trick;
@@ -314,6 +341,7 @@ typedef struct {
   int64_t         last_audio_vpts;
 
   int16_t	  last_sample[RESAMPLE_MAX_CHANNELS];
+  float           last_sample_f[RESAMPLE_MAX_CHANNELS];
   audio_buffer_t *frame_buf[2];         /* two buffers for "stackable" conversions */
   int16_t        *zero_space;
 
@@ -681,6 +709,30 @@ static void ao_out_fifo_apply_vpts_step (aos_t *this, int step) {
   pthread_mutex_unlock (&this->out_fifo.mutex);
 }
 
+static int ao_prep_index (aos_t *this, audio_buffer_t *buf) {
+  return PTR_IN_RANGE (buf, this->base_buf, NUM_AUDIO_BUFFERS * sizeof (*buf)) ? buf - this->base_buf : -1;
+}
+
+/* have this->out_fifo.mutex locked */
+static void ao_prep_wake (aos_t *this) {
+  if (this->prep.waiting)
+    pthread_cond_signal (&this->prep.wake);
+}
+
+/* have this->out_fifo.mutex locked. dont hand out a buf that the worker still modifies. */
+static void ao_prep_wait (aos_t *this) {
+  while (this->prep.busy)
+    pthread_cond_wait (&this->prep.done, &this->out_fifo.mutex);
+}
+
+/* have this->out_fifo.mutex locked */
+static void ao_prep_append (aos_t *this, audio_buffer_t *buf) {
+  int i = ao_prep_index (this, buf);
+  if (i >= 0)
+    this->prep.state[i] = PREP_NEW;
+  ao_prep_wake (this);
+}
+
 static void ao_out_fifo_reref_append (aos_t *this, audio_buffer_t *buf, int is_first) {
   xine_stream_private_t **s, *olds, *news;
 
@@ -707,6 +759,7 @@ static void ao_out_fifo_reref_append (aos_t *this, audio_buffer_t *buf, int is_f
       pthread_cond_signal (&this->out_fifo.not_empty);
     if (is_first)
       this->out_fifo.seek_count1 = buf->extra_info->seek_count;
+    ao_prep_append (this, buf);
     pthread_mutex_unlock (&this->out_fifo.mutex);
     if (olds)
       xine_refs_sub (&olds->refs, 1); /* this may involve stream dispose. */
@@ -722,6 +775,7 @@ static void ao_out_fifo_reref_append (aos_t *this, audio_buffer_t *buf, int is_f
       pthread_cond_signal (&this->out_fifo.not_empty);
     if (is_first)
       this->out_fifo.seek_count1 = buf->extra_info->seek_count;
+    ao_prep_append (this, buf);
     pthread_mutex_unlock (&this->out_fifo.mutex);
 
   }
@@ -778,6 +832,7 @@ static audio_buffer_t *ao_out_fifo_get (aos_t *this, audio_buffer_t *buf) {
       audio_buffer_t *list, **add;
       int n;
 
+      ao_prep_wait (this);
       this->rp.last_flush_vpts = this->clock->get_current_time (this->clock);
       this->rp.ei_read = this->rp.ei_write = 0;
 
@@ -895,6 +950,8 @@ static audio_buffer_t *ao_out_fifo_get (aos_t *this, audio_buffer_t *buf) {
   }
 
   this->out_fifo.wake_now = 0;
+  this->prep.cur = buf;
+  ao_prep_wake (this);
   pthread_mutex_unlock (&this->out_fifo.mutex);
 
   if (dry)
@@ -926,6 +983,7 @@ static audio_buffer_t *ao_free_fifo_get (aos_t *this) {
       /* O dear. Port rewiring ahead. Try unblock. */
       if (this->clock->speed == XINE_SPEED_PAUSE) {
         pthread_mutex_lock (&this->out_fifo.mutex);
+        ao_prep_wait (this);
         if (this->out_fifo.first) {
           buf = ao_out_fifo_pop_int (this);
           pthread_mutex_unlock (&this->out_fifo.mutex);
@@ -941,7 +999,9 @@ static audio_buffer_t *ao_free_fifo_get (aos_t *this) {
       xine_gettime (&ts);
       ts.tv_sec += 1;
       this->free_fifo.num_waiters++;
+      _x_decoder_pool_wait_begin ();
       pthread_cond_timedwait (&this->free_fifo.not_empty, &this->free_fifo.mutex, &ts);
+      _x_decoder_pool_wait_end ();
       this->free_fifo.num_waiters--;
     }
   }
@@ -973,6 +1033,7 @@ static int ao_fifo_num_buffers (audio_fifo_t *fifo) {
 
 /* have this->out_fifo.mutex locked */
 static void ao_out_fifo_manual_flush (aos_t *this) {
+  ao_prep_wait (this);
   if (this->out_fifo.first) {
     audio_buffer_t *list = NULL, **add = &list;
     int n = this->out_fifo.num_buffers;
@@ -1284,6 +1345,38 @@ static void audio_filter_compress (aos_t *this, int16_t *mem, int num_frames) {
   }
 }
 
+static void audio_filter_compress_float (aos_t *this, float *mem, int num_frames) {
+  int    i;
+  float  maxs, f;
+  const int total = num_frames * this->in_channels;
+
+  if (!total)
+    return;
+
+  /* measure */
+  maxs = 0.0f;
+  for (i = 0; i < total; i++) {
+    float sample = mem[i] < 0.0f ? -mem[i] : mem[i];
+    if (sample > maxs)
+      maxs = sample;
+  }
+
+  /* calc maximum possible & allowed factor */
+  if (maxs > 0.0f) {
+    double f_max = 1.0 / maxs;
+    this->compression_factor = this->compression_factor * 0.999 + f_max * 0.001;
+    if (this->compression_factor > f_max)
+      this->compression_factor = f_max;
+    if (this->compression_factor > this->compression_factor_max)
+      this->compression_factor = this->compression_factor_max;
+  }
+
+  /* apply it. no 0.98 safety margin here, floats do not overflow. */
+  f = this->compression_factor * this->amp_factor;
+  for (i = 0; i < total; i++)
+    mem[i] *= f;
+}
+
 static void audio_filter_amp (aos_t *this, void *buf, int num_frames) {
   double amp_factor;
   int    i;
@@ -1332,6 +1425,13 @@ static void audio_filter_amp (aos_t *this, void *buf, int num_frames) {
       }
       mem[i] = test;
     }
+  } else if (this->input.bits == 32) {
+    /* float has headroom, leave clipping to the final conversion. */
+    float *mem = (float *)buf;
+    float f = amp_factor;
+
+    for (i = 0; i < total_frames; i++)
+      mem[i] *= f;
   }
 }
 
@@ -1430,13 +1530,88 @@ static void audio_filter_equalize (aos_t *this,
 
 }
 
-static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
-  double          acc_output_frames;
-  int             num_output_frames ;
+static void audio_filter_equalize_float (aos_t *this, float *data, int num_frames) {
+  int       index, band, channel;
+  int       length;
+  int       num_channels;
 
-  /*
-   * volume / compressor / equalizer filter
-   */
+  num_channels = this->in_channels;
+  if (!num_channels)
+    return;
+
+  length = num_frames * num_channels;
+
+  for (index = 0; index < length; index += num_channels) {
+
+    for (channel = 0; channel < num_channels; channel++) {
+
+      /* same fixed point filter as above. 1.0 maps to 1 << 25, leaving
+       * 30dB of headroom instead of saturating at full scale. */
+      float fpcm = data[index + channel] * (float)(1 << (FP_FRBITS - 3));
+      int scaledpcm = fpcm >= (float)(1 << 30) ? (1 << 30) - 1 : fpcm <= -(float)(1 << 30) ? -(1 << 30) : (int)fpcm;
+      int64_t out = 0;
+      for (band = 0; band < EQ_BANDS; band++) {
+        int64_t l;
+        int v;
+        int *p = &this->eq_data_history[channel][band][0];
+        l = (int64_t)iir_cf[band].alpha * (scaledpcm - p[1])
+          + (int64_t)iir_cf[band].gamma * p[2]
+          - (int64_t)iir_cf[band].beta  * p[3];
+        p[1] = p[0]; p[0] = scaledpcm;
+        p[3] = p[2]; p[2] = v = (int)(l >> FP_FRBITS);
+        l = (int64_t)v * this->eq_gain[band];
+        out += l >> FP_FRBITS;
+      }
+      data[index + channel] = (float)out * (1.0f / (float)(1 << (FP_FRBITS - 3)));
+    }
+  }
+}
+
+/* float32 input: filter, resample and remix in float, convert to the
+ * driver format once at the end. */
+static audio_buffer_t *prepare_samples_float (aos_t *this, audio_buffer_t *buf, int num_output_frames) {
+
+  if ((this->resample_sync_method || this->do_resample) &&
+      buf->num_frames != num_output_frames &&
+      this->in_channels > 0 && this->in_channels <= RESAMPLE_MAX_CHANNELS) {
+    ensure_buffer_size (this->frame_buf[1], sizeof (float) * this->in_channels, num_output_frames);
+    _x_audio_out_resample_float (this->last_sample_f, (const float *)buf->mem, buf->num_frames,
+                                 (float *)this->frame_buf[1]->mem, num_output_frames, this->in_channels);
+    buf = swap_frame_buffers (this);
+  } else if (buf->num_frames > 0 && this->in_channels > 0 && this->in_channels <= RESAMPLE_MAX_CHANNELS) {
+    /* maintain last_sample in case we need it */
+    memcpy (this->last_sample_f, (float *)buf->mem + (buf->num_frames - 1) * this->in_channels,
+            this->in_channels * sizeof (this->last_sample_f[0]));
+  }
+
+  /* mode conversion */
+  if ((this->input.mode == AO_CAP_MODE_MONO) && (this->output.mode == AO_CAP_MODE_STEREO)) {
+    ensure_buffer_size (this->frame_buf[1], sizeof (float) * 2, buf->num_frames);
+    _x_audio_out_resample_monotostereo_float ((const float *)buf->mem, (float *)this->frame_buf[1]->mem, buf->num_frames);
+    buf = swap_frame_buffers (this);
+  } else if ((this->input.mode == AO_CAP_MODE_STEREO) && (this->output.mode == AO_CAP_MODE_MONO)) {
+    ensure_buffer_size (this->frame_buf[1], sizeof (float), buf->num_frames);
+    _x_audio_out_resample_stereotomono_float ((const float *)buf->mem, (float *)this->frame_buf[1]->mem, buf->num_frames);
+    buf = swap_frame_buffers (this);
+  }
+
+  /* driver does not take float */
+  if (this->output.bits != 32) {
+    int samples = this->out_channels * buf->num_frames;
+    ensure_buffer_size (this->frame_buf[1], 2 * this->out_channels, buf->num_frames);
+    _x_audio_out_resample_floatto16 ((const float *)buf->mem, this->frame_buf[1]->mem, samples);
+    buf = swap_frame_buffers (this);
+    if (this->output.bits == 8) {
+      ensure_buffer_size (this->frame_buf[1], this->out_channels, buf->num_frames);
+      _x_audio_out_resample_16to8 (buf->mem, (int8_t *)this->frame_buf[1]->mem, samples);
+      buf = swap_frame_buffers (this);
+    }
+  }
+  return buf;
+}
+
+/* volume / compressor / equalizer filter, in place. */
+static void prepare_filters (aos_t *this, audio_buffer_t *buf) {
 
   if (this->amp_factor == 0) {
     if (this->do_amp)
@@ -1451,12 +1626,21 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
   } else if (this->input.bits == 8) {
     if (this->do_amp)
       audio_filter_amp (this, buf->mem, buf->num_frames);
+  } else if (this->input.bits == 32) {
+    if (this->do_equ)
+      audio_filter_equalize_float (this, (float *)buf->mem, buf->num_frames);
+    if (this->do_compress)
+      audio_filter_compress_float (this, (float *)buf->mem, buf->num_frames);
+    if (this->do_amp)
+      audio_filter_amp (this, buf->mem, buf->num_frames);
   }
+}
 
-
-  /*
-   * resample and output audio data
-   */
+/* resample and convert to driver format. leaves buf->mem untouched,
+ * and returns either buf itself or this->frame_buf[0]. */
+static audio_buffer_t *prepare_convert (aos_t *this, audio_buffer_t *buf) {
+  double          acc_output_frames;
+  int             num_output_frames ;
 
   /* calculate number of output frames (after resampling) */
   acc_output_frames = (double) buf->num_frames * this->frame_rate_factor
@@ -1473,6 +1657,9 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
 
   lprintf ("outputting %d frames\n", num_output_frames);
 
+  if (this->input.bits == 32)
+    return prepare_samples_float (this, buf, num_output_frames);
+
   /* convert 8 bit samples as needed */
   if ( this->input.bits == 8 &&
        (this->resample_sync_method || this->do_resample ||
@@ -1584,6 +1771,153 @@ static audio_buffer_t* prepare_samples( aos_t *this, audio_buffer_t *buf) {
   return buf;
 }
 
+static audio_buffer_t *prepare_samples (aos_t *this, audio_buffer_t *buf) {
+  prepare_filters (this, buf);
+  return prepare_convert (this, buf);
+}
+
+/********************************************************************
+ * prepare ahead                                                    *
+ *******************************************************************/
+
+/* have this->out_fifo.mutex locked. keep order, the filters and the
+ * resampler carry state from one buf to the next. */
+static audio_buffer_t *ao_prep_next (aos_t *this) {
+  audio_buffer_t *buf;
+  int n;
+
+  if (this->out_fifo.discard_buffers)
+    return NULL;
+  buf = this->prep.cur;
+  if (buf) {
+    int i = ao_prep_index (this, buf);
+    if ((i < 0) || (this->prep.state[i] == PREP_LOOP))
+      return NULL;
+    if (this->prep.state[i] == PREP_NEW)
+      return buf;
+  }
+  for (buf = this->out_fifo.first, n = this->prep.depth; buf && (n > 0); buf = buf->next, n--) {
+    int i = ao_prep_index (this, buf);
+    if (i < 0)
+      return NULL;
+    if (this->prep.state[i] == PREP_NEW)
+      return buf;
+  }
+  return NULL;
+}
+
+static void *ao_prep_loop (void *this_gen) {
+  aos_t *this = (aos_t *)this_gen;
+
+  XINE_PROFILER_THREAD ("audio prepare");
+
+  pthread_mutex_lock (&this->out_fifo.mutex);
+  while (this->prep.running) {
+    audio_buffer_t *buf = ao_prep_next (this);
+    int i, state;
+
+    if (!buf) {
+      this->prep.waiting++;
+      pthread_cond_wait (&this->prep.wake, &this->out_fifo.mutex);
+      this->prep.waiting--;
+      continue;
+    }
+    i = buf - this->base_buf;
+    this->prep.state[i] = PREP_BUSY;
+    this->prep.busy = buf;
+    pthread_mutex_unlock (&this->out_fifo.mutex);
+
+    state = PREP_NEW;
+    pthread_mutex_lock (&this->prep.mutex);
+    /* a format change needs ao_loop to reconfigure the driver first. */
+    if (this->driver.open && (buf->format.bits == this->input.bits)
+      && (buf->format.rate == this->input.rate) && (buf->format.mode == this->input.mode)) {
+      prepare_filters (this, buf);
+      this->prep.res[i] = buf;
+      state = PREP_FILTERED;
+      /* the drift correction factor is computed by ao_loop right before output. */
+      if (!this->resample_sync_method) {
+        audio_buffer_t *out = prepare_convert (this, buf);
+        if (out != buf) {
+          _x_assert (out == this->frame_buf[0]);
+          this->frame_buf[0] = this->prep.out[i];
+          this->prep.out[i]  = out;
+        }
+        this->prep.res[i] = out;
+        state = PREP_DONE;
+      }
+      this->prep.bgen[i] = this->prep.gen;
+    }
+    pthread_mutex_unlock (&this->prep.mutex);
+
+    pthread_mutex_lock (&this->out_fifo.mutex);
+    this->prep.state[i] = state;
+    this->prep.busy = NULL;
+    pthread_cond_broadcast (&this->prep.done);
+    if ((state == PREP_NEW) && this->prep.running) {
+      this->prep.waiting++;
+      pthread_cond_wait (&this->prep.wake, &this->out_fifo.mutex);
+      this->prep.waiting--;
+    }
+  }
+  pthread_mutex_unlock (&this->out_fifo.mutex);
+
+  return NULL;
+}
+
+/* ao_loop: the samples of buf, ready for the driver. */
+static audio_buffer_t *ao_prep_get (aos_t *this, audio_buffer_t *buf) {
+  audio_buffer_t *out;
+  int i = ao_prep_index (this, buf), state = PREP_NEW;
+
+  if (i >= 0) {
+    pthread_mutex_lock (&this->out_fifo.mutex);
+    while (this->prep.busy == buf)
+      pthread_cond_wait (&this->prep.done, &this->out_fifo.mutex);
+    state = this->prep.state[i];
+    if (state == PREP_NEW)
+      this->prep.state[i] = PREP_LOOP;
+    pthread_mutex_unlock (&this->out_fifo.mutex);
+  }
+
+  pthread_mutex_lock (&this->prep.mutex);
+  if ((state == PREP_DONE) && (this->prep.bgen[i] == this->prep.gen) && !this->resample_sync_method) {
+    out = this->prep.res[i];
+  } else {
+    /* not there yet, or settings changed in the meantime. */
+    if (state == PREP_NEW)
+      prepare_filters (this, buf);
+    out = prepare_convert (this, buf);
+    if (out != buf) {
+      this->frame_buf[0] = this->prep.out[NUM_AUDIO_BUFFERS];
+      this->prep.out[NUM_AUDIO_BUFFERS] = out;
+    }
+    /* ao_loop may come back here with the same buf. */
+    if (i >= 0) {
+      this->prep.res[i]  = out;
+      this->prep.bgen[i] = this->prep.gen;
+    }
+  }
+  pthread_mutex_unlock (&this->prep.mutex);
+
+  if ((i >= 0) && (state != PREP_DONE)) {
+    pthread_mutex_lock (&this->out_fifo.mutex);
+    this->prep.state[i] = PREP_DONE;
+    ao_prep_wake (this);
+    pthread_mutex_unlock (&this->out_fifo.mutex);
+  }
+  return out;
+}
+
+/* ao_loop: done with buf. */
+static void ao_prep_release (aos_t *this) {
+  pthread_mutex_lock (&this->out_fifo.mutex);
+  while (this->prep.busy && (this->prep.busy == this->prep.cur))
+    pthread_cond_wait (&this->prep.done, &this->out_fifo.mutex);
+  this->prep.cur = NULL;
+  pthread_mutex_unlock (&this->out_fifo.mutex);
+}
+
 
 static int resample_rate_adjust(aos_t *this, int64_t gap, audio_buffer_t *buf) {
 
@@ -1727,6 +2061,8 @@ static void *ao_loop (void *this_gen) {
   int64_t         next_sync_time = SYNC_TIME_INTERVAL;
   int             bufs_since_sync = 0;
 
+  XINE_PROFILER_THREAD ("audio out");
+
   pthread_mutex_lock (&this->driver.mutex);
   this->rp.speed = this->driver.speed;
   this->rp.trick = this->driver.trick;
@@ -1745,7 +2081,9 @@ static void *ao_loop (void *this_gen) {
       {
         audio_buffer_t *last = in_buf;
         lprintf ("loop: get buf from fifo\n");
+        XINE_PROFILER_BEGIN ("audio out fifo wait");
         in_buf = ao_out_fifo_get (this, in_buf);
+        XINE_PROFILER_END ();
         if (!in_buf)
           break;
         if (in_buf->num_frames <= 0) {
@@ -1777,7 +2115,9 @@ static void *ao_loop (void *this_gen) {
       this->rp.trick = this->driver.trick;
       if (this->rp.speed != this->driver.speed) {
         this->rp.speed = this->driver.speed;
+        pthread_mutex_lock (&this->prep.mutex);
         ao_update_resample_factor (this);
+        pthread_mutex_unlock (&this->prep.mutex);
       }
 
       if ((this->rp.speed == XINE_SPEED_PAUSE) ||
@@ -2074,7 +2414,7 @@ static void *ao_loop (void *this_gen) {
           printf ("\n");
         }
 #endif
-        out_buf = prepare_samples (this, in_buf);
+        out_buf = this->prep.depth ? ao_prep_get (this, in_buf) : prepare_samples (this, in_buf);
 #if 0
         {
           int count;
@@ -2095,7 +2435,9 @@ static void *ao_loop (void *this_gen) {
           if (!ao_driver_lock_2 (this))
             continue;
           if (this->driver.open) {
+            XINE_PROFILER_BEGIN ("audio out write");
             result = this->driver.d->write (this->driver.d, out_buf->mem, out_buf->num_frames);
+            XINE_PROFILER_END ();
           }
           pthread_mutex_unlock (&this->driver.mutex);
         }
@@ -2128,6 +2470,8 @@ static void *ao_loop (void *this_gen) {
 
     if (drop) {
       lprintf ("loop: next buf from fifo\n");
+      if (this->prep.depth)
+        ao_prep_release (this);
       ao_free_fifo_append (this, in_buf);
       in_buf = NULL;
     }
@@ -2135,8 +2479,11 @@ static void *ao_loop (void *this_gen) {
     ao_driver_test_intr (this);
   }
 
-  if (in_buf)
+  if (in_buf) {
+    if (this->prep.depth)
+      ao_prep_release (this);
     ao_free_fifo_append (this, in_buf);
+  }
 
   if (this->step) {
     pthread_mutex_lock (&this->step_mutex);
@@ -2296,12 +2643,14 @@ static int ao_update_resample_factor(aos_t *this) {
 
   ao_resend_init (this);
   ao_eq_update (this);
+  /* samples prepared ahead with old settings need conversion again. */
+  this->prep.gen++;
 
   lprintf ("audio_step %" PRIu32 " pts per 32768 frames\n", this->audio_step);
   return this->output.rate;
 }
 
-static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits, uint32_t rate, int mode) {
+static int ao_change_settings_unlocked (aos_t *this, xine_stream_t *stream, uint32_t bits, uint32_t rate, int mode) {
   int output_sample_rate;
 
   if (this->driver.open && !this->grab_only)
@@ -2320,6 +2669,12 @@ static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits
       xprintf (&this->xine->x, XINE_VERBOSITY_LOG,
                _("8 bits not supported by driver, converting to 16 bits.\n"));
     }
+    /* we always accept float, see ao_get_capabilities (). */
+    if ((this->input.bits == 32) && !(caps & AO_CAP_FLOAT32)) {
+      bits = 16;
+      xprintf (&this->xine->x, XINE_VERBOSITY_DEBUG,
+               "audio_out: float not supported by driver, converting to 16 bits.\n");
+    }
     /* provide mono->stereo and stereo->mono conversions */
     if ((this->input.mode == AO_CAP_MODE_MONO) && !(caps & AO_CAP_MODE_MONO)) {
       mode = AO_CAP_MODE_STEREO;
@@ -2359,6 +2714,16 @@ static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits
   return ao_update_resample_factor (this);
 }
 
+/* have this->driver.mutex locked */
+static int ao_change_settings (aos_t *this, xine_stream_t *stream, uint32_t bits, uint32_t rate, int mode) {
+  int ret;
+
+  pthread_mutex_lock (&this->prep.mutex);
+  ret = ao_change_settings_unlocked (this, stream, bits, rate, mode);
+  pthread_mutex_unlock (&this->prep.mutex);
+  return ret;
+}
+
 
 /*
  * open the audio device for writing to
@@ -2572,6 +2937,17 @@ static void ao_exit(xine_audio_port_t *this_gen) {
     pthread_join (this->audio_thread, &p);
   }
 
+  if (this->prep.running) {
+    void *p;
+
+    pthread_mutex_lock (&this->out_fifo.mutex);
+    this->prep.running = 0;
+    pthread_cond_signal (&this->prep.wake);
+    pthread_mutex_unlock (&this->out_fifo.mutex);
+
+    pthread_join (this->prep.thread, &p);
+  }
+
   if (!this->grab_only) {
     ao_driver_t *driver;
     int vol = 0, prop, caps;
@@ -2614,12 +2990,22 @@ static void ao_exit(xine_audio_port_t *this_gen) {
   pthread_mutex_destroy (&this->step_mutex);
   pthread_cond_destroy  (&this->done_stepping);
 
+  pthread_mutex_destroy (&this->prep.mutex);
+  pthread_cond_destroy  (&this->prep.wake);
+  pthread_cond_destroy  (&this->prep.done);
+
   ao_force_unref_all (this, 1);
   ao_free_fifo_close (this);
   ao_out_fifo_close (this);
 
-  _x_freep (&this->frame_buf[0]->mem);
-  _x_freep (&this->frame_buf[1]->mem);
+  /* frame_buf[] and prep.out[] may have been swapped around. */
+  _x_freep (&this->base_buf[NUM_AUDIO_BUFFERS].mem);
+  _x_freep (&this->base_buf[NUM_AUDIO_BUFFERS + 1].mem);
+  {
+    int i;
+    for (i = 0; i < NUM_AUDIO_BUFFERS + 1; i++)
+      _x_freep (&this->prep.base_out[i].mem);
+  }
   xine_freep_aligned (&this->base_samp);
 
   free (this);
@@ -2640,6 +3026,9 @@ static uint32_t ao_get_capabilities (xine_audio_port_t *this_gen) {
     ao_driver_lock (this);
     result = this->driver.d->get_capabilities (this->driver.d);
     ao_driver_unlock (this);
+    /* prepare_samples () converts float to whatever the driver takes.
+     * decoders producing float natively should send it as is. */
+    result |= AO_CAP_FLOAT32;
   }
   return result;
 }
@@ -2784,7 +3173,9 @@ static int ao_set_property (xine_audio_port_t *this_gen, int property, int value
   case AO_PROP_EQ_8000HZ:
   case AO_PROP_EQ_16000HZ:
     this->eq_settings[property - AO_PROP_EQ_30HZ] = value;
+    pthread_mutex_lock (&this->prep.mutex);
     ao_eq_update (this);
+    pthread_mutex_unlock (&this->prep.mutex);
     ret = value;
     break;
 
@@ -3055,6 +3446,15 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
   pthread_mutex_init (&this->step_mutex, NULL);
   pthread_cond_init  (&this->done_stepping, NULL);
 
+  pthread_mutex_init (&this->prep.mutex, NULL);
+  pthread_cond_init  (&this->prep.wake, NULL);
+  pthread_cond_init  (&this->prep.done, NULL);
+  {
+    int i;
+    for (i = 0; i < NUM_AUDIO_BUFFERS + 1; i++)
+      this->prep.out[i] = &this->prep.base_out[i];
+  }
+
   if (!grab_only)
     this->gap_tolerance = driver->get_gap_tolerance (driver);
 
@@ -3083,6 +3483,7 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
       20, ao_update_av_sync_method, this);
     this->resample_sync_method = this->av_sync_method_conf == 1 ? 1 : 0;
     this->resample_sync_info.valid = 0;
+    this->resample_sync_factor = 1.0;
   }
 
   {
@@ -3131,6 +3532,17 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
       "If want to experiment preserving the pitch you may try the 'stretch' audio post plugin instead."),
     10, ao_update_slow_fast, this);
 
+  this->prep.depth = config->register_range (
+    config, "audio.output.prepare_ahead", 0, 0, NUM_AUDIO_BUFFERS / 2,
+    _("number of audio buffers to prepare ahead"),
+    _("Run volume, equalizer, compressor, resampling and format conversion on a separate "
+      "thread, up to this many buffers ahead of the sound card. This keeps the output "
+      "thread short and steady on busy systems.\n"
+      "0 does all of it right before writing to the sound card."),
+    20, NULL, NULL);
+  if (grab_only)
+    this->prep.depth = 0;
+
   this->compression_factor = 2.0;
   this->amp_factor         = 1.0;
 
@@ -3209,8 +3621,21 @@ xine_audio_port_t *_x_ao_new_port (xine_t *xine, ao_driver_t *driver,
     pthread_attr_t pth_attrs;
     int err;
     /*
-     * start output thread
+     * start prepare and output threads
      */
+    if (this->prep.depth) {
+      this->prep.running = 1;
+      err = pthread_create (&this->prep.thread, NULL, ao_prep_loop, this);
+      if (err != 0) {
+        xprintf (&this->xine->x, XINE_VERBOSITY_LOG,
+          "audio_out: can't create prepare thread (%s), preparing samples on output.\n", strerror (err));
+        this->prep.running = 0;
+        this->prep.depth = 0;
+      } else {
+        xprintf (&this->xine->x, XINE_VERBOSITY_DEBUG,
+          "audio_out: preparing up to %d buffers ahead.\n", this->prep.depth);
+      }
+    }
 
     this->audio_loop_running = 1;
 
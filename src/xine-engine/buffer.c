@@ -149,6 +149,7 @@ static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
    * decoder flushes that would need a buffer in buffer_pool_try_alloc() */
   n += 2;
   if (this->buffer_pool_num_free < n) {
+    XINE_PROFILER_BEGIN ("fifo full wait");
     /* Paranoia: someone else than demux calling this in parallel ?? */
     if (this->buffer_pool_large_wait != LARGE_NUM) {
       this->buffer_pool_num_waiters++;
@@ -163,6 +164,7 @@ static buf_element_t *buffer_pool_size_alloc_int (fifo_buffer_t *this, int n) {
       } while (this->buffer_pool_num_free < n);
       this->buffer_pool_large_wait = LARGE_NUM;
     }
+    XINE_PROFILER_END ();
   }
   n -= 2;
 
@@ -245,11 +247,13 @@ static buf_element_t *buffer_pool_alloc (fifo_buffer_t *this) {
   /* we always keep one free buffer for emergency situations like
    * decoder flushes that would need a buffer in buffer_pool_try_alloc() */
   if (this->buffer_pool_num_free < 2) {
+    XINE_PROFILER_BEGIN ("fifo full wait");
     this->buffer_pool_num_waiters++;
     do {
       pthread_cond_wait (&this->buffer_pool_cond_not_empty, &this->buffer_pool_mutex);
     } while (this->buffer_pool_num_free < 2);
     this->buffer_pool_num_waiters--;
+    XINE_PROFILER_END ();
   }
 
   buf = (be_ei_t *)this->buffer_pool_top;
@@ -424,6 +428,8 @@ static void fifo_buffer_put (fifo_buffer_t *fifo, buf_element_t *element) {
 
   if (fifo->fifo_num_waiters)
     pthread_cond_signal (&fifo->not_empty);
+  if (fifo->notify)
+    fifo->notify (fifo->notify_data);
 
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -466,6 +472,8 @@ static void fifo_buffer_insert (fifo_buffer_t *fifo, buf_element_t *element) {
 
   if (fifo->fifo_num_waiters)
     pthread_cond_signal (&fifo->not_empty);
+  if (fifo->notify)
+    fifo->notify (fifo->notify_data);
 
   pthread_mutex_unlock (&fifo->mutex);
 }
@@ -517,6 +525,41 @@ static buf_element_t *fifo_buffer_get (fifo_buffer_t *fifo) {
   return buf;
 }
 
+/*
+ * get element from fifo buffer, or NULL if it is empty
+ */
+static buf_element_t *fifo_buffer_try_get (fifo_buffer_t *fifo) {
+  buf_element_t *buf;
+  int i;
+
+  pthread_mutex_lock (&fifo->mutex);
+
+  buf = fifo->first;
+  if (!buf) {
+    pthread_mutex_unlock (&fifo->mutex);
+    return NULL;
+  }
+
+  fifo->first = buf->next;
+  if (fifo->first==NULL)
+    fifo->last = NULL;
+
+  if (buf->free_buffer == buffer_pool_free) {
+    be_ei_t *beei = (be_ei_t *)buf;
+    fifo->fifo_size -= beei->nbufs;
+  } else {
+    fifo->fifo_size -= 1;
+  }
+  fifo->fifo_data_size -= buf->size;
+
+  for(i = 0; fifo->get_cb[i]; i++)
+    fifo->get_cb[i](fifo, buf, fifo->get_cb_data[i]);
+
+  pthread_mutex_unlock (&fifo->mutex);
+
+  return buf;
+}
+
 static buf_element_t *fifo_buffer_tget (fifo_buffer_t *fifo, xine_ticket_t *ticket) {
   /* Optimization: let decoders hold port ticket by default.
    * Unfortunately, fifo callbacks are 1 big freezer, as they run with fifo locked,
@@ -896,6 +939,8 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   this->alloc_cb_data[0]        = NULL;
   this->get_cb_data[0]          = NULL;
   this->put_cb_data[0]          = NULL;
+  this->notify                  = NULL;
+  this->notify_data             = NULL;
 #endif
 
   /* printf ("Allocating %d buffers of %ld bytes in one chunk\n", num_buffers, (long int) buf_size); */
@@ -909,6 +954,7 @@ fifo_buffer_t *_x_fifo_buffer_new (int num_buffers, uint32_t buf_size) {
   this->insert              = fifo_buffer_insert;
   this->get                 = fifo_buffer_get;
   this->tget                = fifo_buffer_tget;
+  this->try_get             = fifo_buffer_try_get;
   this->clear               = fifo_buffer_clear;
   this->size                = fifo_buffer_size;
   this->num_free            = fifo_buffer_num_free;
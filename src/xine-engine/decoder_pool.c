@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * shared decoder worker threads.
+ * with many streams open, 2 decoder threads per stream mostly sleep on
+ * their fifos, and cost a context switch for every buf. here, a few
+ * workers serve a queue of decoders that have something to do.
+ *
+ * decoders check for free output frames/bufs before they step, but a
+ * decoder may still need more of them for a single buf, and then block in
+ * video_port.get_frame () or audio_port.get_buffer (). these tell us via
+ * _x_decoder_pool_wait_begin (), and we let a spare thread take over the
+ * worker's place meanwhile.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define LOG_MODULE "decoder_pool"
+#define LOG_VERBOSE
+/*
+#define LOG
+*/
+
+#include <xine/xine_internal.h>
+#include <xine/xineutils.h>
+#include "xine_private.h"
+
+/* bufs per turn. */
+#define POOL_QUANTUM 8
+/* how long to park a job after XINE_DECODER_STEP_WAIT. */
+#define POOL_RETRY_NSEC 5000000
+
+#define JOB_IDLE    0
+#define JOB_QUEUED  1
+#define JOB_RUNNING 2
+#define JOB_PARKED  3
+#define JOB_DONE    4
+
+struct xine_decoder_pool_s {
+  xine_t              *xine;
+  xine_ticket_t       *ticket;
+
+  pthread_mutex_t      lock;
+  pthread_cond_t       wake;
+  pthread_cond_t       done;
+  xine_decoder_job_t  *first, **add;
+  /* same delay for all, so this is sorted by due time. */
+  xine_decoder_job_t  *parked, **park_add;
+  int                  quit;
+
+  /* workers that wait for a free frame/buf, and workers that wait for work. */
+  int                  num_blocked;
+  int                  num_idle;
+
+  /* the first num_base threads are always there, up to as many spares
+   * are started when workers block. */
+  int                  num_base;
+  int                  num_threads;
+  pthread_t            threads[1];
+};
+
+/* the pool of the calling worker thread. */
+static pthread_key_t  _pool_key;
+static pthread_once_t _pool_once = PTHREAD_ONCE_INIT;
+
+static void _pool_key_init (void) {
+  pthread_key_create (&_pool_key, NULL);
+}
+
+/* pool->lock held. */
+static void _pool_queue (xine_decoder_pool_t *pool, xine_decoder_job_t *job) {
+  job->state = JOB_QUEUED;
+  job->next = NULL;
+  *pool->add = job;
+  pool->add = &job->next;
+  pthread_cond_signal (&pool->wake);
+}
+
+/* pool->lock held. */
+static void _pool_park (xine_decoder_pool_t *pool, xine_decoder_job_t *job) {
+  xine_gettime (&job->due);
+  job->due.tv_nsec += POOL_RETRY_NSEC;
+  if (job->due.tv_nsec >= 1000000000) {
+    job->due.tv_nsec -= 1000000000;
+    job->due.tv_sec++;
+  }
+  job->state = JOB_PARKED;
+  job->next = NULL;
+  *pool->park_add = job;
+  pool->park_add = &job->next;
+}
+
+/* pool->lock held. queue parked jobs that are due, and return when the next one will be. */
+static struct timespec *_pool_unpark (xine_decoder_pool_t *pool) {
+  struct timespec now = {0, 0};
+
+  xine_gettime (&now);
+  while (pool->parked) {
+    xine_decoder_job_t *job = pool->parked;
+    if ((job->due.tv_sec > now.tv_sec) ||
+      ((job->due.tv_sec == now.tv_sec) && (job->due.tv_nsec > now.tv_nsec)))
+      return &job->due;
+    pool->parked = job->next;
+    if (!pool->parked)
+      pool->park_add = &pool->parked;
+    _pool_queue (pool, job);
+  }
+  return NULL;
+}
+
+/* fifo->notify (), called with fifo->mutex held. */
+static void _pool_notify (void *data) {
+  xine_decoder_job_t *job = data;
+  xine_decoder_pool_t *pool = job->pool;
+
+  pthread_mutex_lock (&pool->lock);
+  if (job->state == JOB_IDLE)
+    _pool_queue (pool, job);
+  else if ((job->state == JOB_RUNNING) || (job->state == JOB_PARKED))
+    job->pending = 1;
+  pthread_mutex_unlock (&pool->lock);
+}
+
+static int _pool_run (xine_decoder_pool_t *pool, xine_decoder_job_t *job, int *n) {
+  int ret = XINE_DECODER_STEP_OK;
+
+  pool->ticket->acquire (pool->ticket, 0);
+  for (*n = 0; *n < POOL_QUANTUM; (*n)++) {
+    buf_element_t *buf = job->retry;
+
+    if (buf) {
+      job->retry = NULL;
+    } else {
+      buf = job->get (job);
+      if (!buf)
+        break;
+    }
+    XINE_PROFILER_BEGIN ("decoder pool step");
+    ret = job->step (job, buf);
+    XINE_PROFILER_END ();
+    if (ret == XINE_DECODER_STEP_WAIT)
+      job->retry = buf;
+    if (ret != XINE_DECODER_STEP_OK)
+      break;
+    if (pool->ticket->ticket_revoked)
+      pool->ticket->renew (pool->ticket, 0);
+  }
+  pool->ticket->release (pool->ticket, 0);
+  return ret;
+}
+
+static void *_pool_loop (void *data) {
+  xine_decoder_pool_t *pool = data;
+
+  XINE_PROFILER_THREAD ("decoder pool");
+  pthread_setspecific (_pool_key, pool);
+
+  pthread_mutex_lock (&pool->lock);
+  while (1) {
+    xine_decoder_job_t *job;
+    int ret, n;
+
+    if (pool->parked || !pool->first) {
+      struct timespec *due = _pool_unpark (pool);
+      if (!pool->first) {
+        if (pool->quit && !due)
+          break;
+        pool->num_idle++;
+        if (due) {
+          struct timespec ts = *due;
+          pthread_cond_timedwait (&pool->wake, &pool->lock, &ts);
+        } else {
+          pthread_cond_wait (&pool->wake, &pool->lock);
+        }
+        pool->num_idle--;
+        continue;
+      }
+    }
+
+    job = pool->first;
+    pool->first = job->next;
+    if (!pool->first)
+      pool->add = &pool->first;
+    job->next = NULL;
+    job->state = JOB_RUNNING;
+    job->pending = 0;
+    pthread_mutex_unlock (&pool->lock);
+
+    ret = _pool_run (pool, job, &n);
+
+    pthread_mutex_lock (&pool->lock);
+    if (ret == XINE_DECODER_STEP_QUIT) {
+      job->state = JOB_DONE;
+      pthread_cond_broadcast (&pool->done);
+    } else if (ret == XINE_DECODER_STEP_WAIT) {
+      /* do something else meanwhile. */
+      _pool_park (pool, job);
+    } else if (job->pending || (n >= POOL_QUANTUM)) {
+      /* let the others have their turn first. */
+      _pool_queue (pool, job);
+    } else {
+      job->state = JOB_IDLE;
+    }
+  }
+  pthread_mutex_unlock (&pool->lock);
+
+  return NULL;
+}
+
+xine_decoder_pool_t *_x_decoder_pool_new (xine_t *xine, int threads) {
+  xine_decoder_pool_t *pool;
+  int i;
+
+  if (threads < 1)
+    return NULL;
+  pool = calloc (1, sizeof (*pool) + (2 * threads - 1) * sizeof (pool->threads[0]));
+  if (!pool)
+    return NULL;
+#ifndef HAVE_ZERO_SAFE_MEM
+  pool->first       = NULL;
+  pool->parked      = NULL;
+  pool->quit        = 0;
+  pool->num_blocked = 0;
+  pool->num_idle    = 0;
+  pool->num_threads = 0;
+#endif
+  pthread_once (&_pool_once, _pool_key_init);
+  pool->xine     = xine;
+  pool->ticket   = ((xine_private_t *)xine)->port_ticket;
+  pool->add      = &pool->first;
+  pool->park_add = &pool->parked;
+  pthread_mutex_init (&pool->lock, NULL);
+  pthread_cond_init (&pool->wake, NULL);
+  pthread_cond_init (&pool->done, NULL);
+
+  for (i = 0; i < threads; i++) {
+    int err = pthread_create (&pool->threads[i], NULL, _pool_loop, pool);
+    if (err) {
+      xprintf (xine, XINE_VERBOSITY_LOG,
+        LOG_MODULE ": can't create new thread (%s)\n", strerror (err));
+      break;
+    }
+  }
+  pool->num_threads = pool->num_base = i;
+  if (!i) {
+    _x_decoder_pool_delete (&pool);
+    return NULL;
+  }
+
+  xprintf (xine, XINE_VERBOSITY_DEBUG, LOG_MODULE ": %d threads.\n", i);
+  return pool;
+}
+
+void _x_decoder_pool_delete (xine_decoder_pool_t **p) {
+  xine_decoder_pool_t *pool = *p;
+  int i;
+
+  if (!pool)
+    return;
+  *p = NULL;
+
+  pthread_mutex_lock (&pool->lock);
+  pool->quit = 1;
+  pthread_cond_broadcast (&pool->wake);
+  pthread_mutex_unlock (&pool->lock);
+  /* no spares are started after quit. */
+  for (i = 0; i < pool->num_threads; i++)
+    pthread_join (pool->threads[i], NULL);
+
+  pthread_cond_destroy (&pool->done);
+  pthread_cond_destroy (&pool->wake);
+  pthread_mutex_destroy (&pool->lock);
+  free (pool);
+}
+
+void _x_decoder_pool_join (xine_decoder_pool_t *pool, xine_decoder_job_t *job) {
+  fifo_buffer_t *fifo = job->fifo;
+
+  job->pool    = pool;
+  job->next    = NULL;
+  job->retry   = NULL;
+  job->state   = JOB_IDLE;
+  job->pending = 0;
+
+  pthread_mutex_lock (&fifo->mutex);
+  fifo->notify_data = job;
+  fifo->notify = _pool_notify;
+  if (fifo->fifo_size)
+    _pool_notify (job);
+  pthread_mutex_unlock (&fifo->mutex);
+}
+
+void _x_decoder_pool_leave (xine_decoder_job_t *job) {
+  xine_decoder_pool_t *pool = job->pool;
+  fifo_buffer_t *fifo = job->fifo;
+
+  pthread_mutex_lock (&pool->lock);
+  while (job->state != JOB_DONE)
+    pthread_cond_wait (&pool->done, &pool->lock);
+  pthread_mutex_unlock (&pool->lock);
+
+  pthread_mutex_lock (&fifo->mutex);
+  fifo->notify = NULL;
+  fifo->notify_data = NULL;
+  pthread_mutex_unlock (&fifo->mutex);
+}
+
+void _x_decoder_pool_wait_begin (void) {
+  xine_decoder_pool_t *pool;
+
+  pthread_once (&_pool_once, _pool_key_init);
+  pool = pthread_getspecific (_pool_key);
+  if (!pool)
+    return;
+
+  pthread_mutex_lock (&pool->lock);
+  pool->num_blocked++;
+  if (pool->num_idle > 0) {
+    /* that one may serve the queue now. */
+    pthread_cond_signal (&pool->wake);
+  } else if (!pool->quit && (pool->num_threads - pool->num_blocked < pool->num_base)
+    && (pool->num_threads < 2 * pool->num_base)) {
+    int err = pthread_create (&pool->threads[pool->num_threads], NULL, _pool_loop, pool);
+    if (!err) {
+      pool->num_threads++;
+      xprintf (pool->xine, XINE_VERBOSITY_DEBUG,
+        LOG_MODULE ": %d workers wait for output, started spare thread #%d.\n",
+        pool->num_blocked, pool->num_threads);
+    }
+  }
+  pthread_mutex_unlock (&pool->lock);
+}
+
+void _x_decoder_pool_wait_end (void) {
+  xine_decoder_pool_t *pool = pthread_getspecific (_pool_key);
+
+  if (!pool)
+    return;
+  pthread_mutex_lock (&pool->lock);
+  pool->num_blocked--;
+  pthread_mutex_unlock (&pool->lock);
+}
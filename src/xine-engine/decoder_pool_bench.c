@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * decoder thread benchmark: play 1 ... max streams at once with the
+ * "none" output drivers, using per stream decoder threads first, and
+ * engine.decoder.pool_threads shared ones then. half of the streams are
+ * raw video (y4m), the other half pcm audio (wav), both written to /tmp.
+ * reports wall and cpu time, context switches, and peak thread count.
+ *
+ * usage: decoder_pool_bench [max_streams] [pool_threads]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+#include <xine.h>
+
+#define W 320
+#define H 240
+#define FRAMES 100
+#define RATE 48000
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int _threads (void) {
+  char line[256];
+  int n = 0;
+  FILE *f = fopen ("/proc/self/status", "r");
+
+  if (!f)
+    return 0;
+  while (fgets (line, sizeof (line), f)) {
+    if (!strncmp (line, "Threads:", 8)) {
+      n = atoi (line + 8);
+      break;
+    }
+  }
+  fclose (f);
+  return n;
+}
+
+static int _write_y4m (const char *name) {
+  static uint8_t frame[W * H * 3 / 2];
+  FILE *f = fopen (name, "wb");
+  int i;
+
+  if (!f)
+    return 0;
+  fprintf (f, "YUV4MPEG2 W%d H%d F25:1 Ip A1:1 C420jpeg\n", W, H);
+  for (i = 0; i < FRAMES; i++) {
+    memset (frame, i * 2, W * H);
+    memset (frame + W * H, 128, W * H / 2);
+    fprintf (f, "FRAME\n");
+    fwrite (frame, 1, sizeof (frame), f);
+  }
+  fclose (f);
+  return 1;
+}
+
+static void _put_le (uint8_t *p, uint32_t v, int n) {
+  while (n--) {
+    *p++ = v;
+    v >>= 8;
+  }
+}
+
+static int _write_wav (const char *name) {
+  /* same length as the video. */
+  uint32_t size = RATE * 2 * 2 * FRAMES / 25;
+  uint8_t head[44];
+  uint8_t *data;
+  FILE *f = fopen (name, "wb");
+
+  if (!f)
+    return 0;
+  data = calloc (1, size);
+  memcpy (head, "RIFF\0\0\0\0WAVEfmt ", 16);
+  _put_le (head + 4, 36 + size, 4);
+  _put_le (head + 16, 16, 4);
+  _put_le (head + 20, 1, 2);
+  _put_le (head + 22, 2, 2);
+  _put_le (head + 24, RATE, 4);
+  _put_le (head + 28, RATE * 4, 4);
+  _put_le (head + 32, 4, 2);
+  _put_le (head + 34, 16, 2);
+  memcpy (head + 36, "data", 4);
+  _put_le (head + 40, size, 4);
+  fwrite (head, 1, sizeof (head), f);
+  if (data)
+    fwrite (data, 1, size, f);
+  free (data);
+  fclose (f);
+  return !!data;
+}
+
+typedef struct {
+  xine_video_port_t  *vo;
+  xine_audio_port_t  *ao;
+  xine_stream_t      *stream;
+  xine_event_queue_t *queue;
+  int                 done;
+} player_t;
+
+static void _run (int pool, int num, const char *video, const char *audio) {
+  char cfg[64];
+  xine_t *xine;
+  player_t *p;
+  struct rusage r1, r2;
+  double t1, t2, cpu;
+  int i, left, threads = 0, ok = 0;
+
+  /* the pool is set up by xine_init (), so load this first. */
+  snprintf (cfg, sizeof (cfg), "/tmp/decoder_pool_bench.%d.cfg", (int)getpid ());
+  {
+    FILE *f = fopen (cfg, "w");
+    if (f) {
+      fprintf (f, "engine.decoder.pool_threads:%d\n", pool);
+      fclose (f);
+    }
+  }
+  xine = xine_new ();
+  xine_config_load (xine, cfg);
+  xine_init (xine);
+  unlink (cfg);
+
+  p = calloc (num, sizeof (*p));
+  if (!p)
+    return;
+  for (i = 0; i < num; i++) {
+    p[i].vo = xine_open_video_driver (xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+    p[i].ao = xine_open_audio_driver (xine, "none", NULL);
+    p[i].stream = xine_stream_new (xine, p[i].ao, p[i].vo);
+    if (p[i].stream) {
+      p[i].queue = xine_event_new_queue (p[i].stream);
+      ok += xine_open (p[i].stream, (i & 1) ? audio : video);
+    }
+  }
+
+  getrusage (RUSAGE_SELF, &r1);
+  t1 = _now ();
+  for (i = 0; i < num; i++) {
+    if (p[i].stream) {
+      xine_play (p[i].stream, 0, 0);
+      /* decode faster than real time. */
+      xine_set_param (p[i].stream, XINE_PARAM_SPEED, XINE_SPEED_FAST_4);
+    }
+  }
+  left = num;
+  while (left > 0) {
+    int n = _threads ();
+    if (threads < n)
+      threads = n;
+    usleep (10000);
+    for (i = 0; i < num; i++) {
+      xine_event_t *e;
+      if (!p[i].queue || p[i].done)
+        continue;
+      while ((e = xine_event_get (p[i].queue))) {
+        if (e->type == XINE_EVENT_UI_PLAYBACK_FINISHED) {
+          p[i].done = 1;
+          left--;
+        }
+        xine_event_free (e);
+      }
+    }
+    if (_now () - t1 > 60.0) {
+      printf ("timeout.\n");
+      break;
+    }
+  }
+  t2 = _now ();
+  getrusage (RUSAGE_SELF, &r2);
+
+  cpu = (r2.ru_utime.tv_sec - r1.ru_utime.tv_sec) + (r2.ru_stime.tv_sec - r1.ru_stime.tv_sec)
+      + ((r2.ru_utime.tv_usec - r1.ru_utime.tv_usec) + (r2.ru_stime.tv_usec - r1.ru_stime.tv_usec)) * 1e-6;
+  printf ("%-7s %7d %7d %9.3f %9.3f %9ld %9ld %7d\n", pool ? "pool" : "threads", num, ok,
+          t2 - t1, cpu, r2.ru_nvcsw - r1.ru_nvcsw, r2.ru_nivcsw - r1.ru_nivcsw, threads);
+
+  for (i = 0; i < num; i++) {
+    if (p[i].stream) {
+      xine_close (p[i].stream);
+      xine_event_dispose_queue (p[i].queue);
+      xine_dispose (p[i].stream);
+    }
+    if (p[i].ao)
+      xine_close_audio_driver (xine, p[i].ao);
+    if (p[i].vo)
+      xine_close_video_driver (xine, p[i].vo);
+  }
+  free (p);
+  xine_exit (xine);
+}
+
+int main (int argc, char **argv) {
+  int max = argc > 1 ? atoi (argv[1]) : 32;
+  int pool = argc > 2 ? atoi (argv[2]) : 0;
+  char video[64], audio[64];
+  int num;
+
+  if (max < 1)
+    max = 1;
+  if (pool < 1) {
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    pool = n > 0 ? n : 2;
+  }
+
+  snprintf (video, sizeof (video), "/tmp/decoder_pool_bench.%d.y4m", (int)getpid ());
+  snprintf (audio, sizeof (audio), "/tmp/decoder_pool_bench.%d.wav", (int)getpid ());
+  if (!_write_y4m (video) || !_write_wav (audio)) {
+    fprintf (stderr, "cannot write test files.\n");
+    return 1;
+  }
+
+  printf ("%-7s %7s %7s %9s %9s %9s %9s %7s\n",
+          "mode", "streams", "opened", "wall s", "cpu s", "vol cs", "invol cs", "threads");
+  for (num = 1; num <= max; num *= 2) {
+    _run (0, num, video, audio);
+    _run (pool, num, video, audio);
+  }
+
+  unlink (video);
+  unlink (audio);
+  return 0;
+}
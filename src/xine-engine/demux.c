@@ -32,7 +32,11 @@
 #include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 
 #define LOG_MODULE "demux"
 #define LOG_VERBOSE
@@ -43,6 +47,7 @@
 #include <xine/xine_internal.h>
 #include <xine/demux.h>
 #include <xine/buffer.h>
+#include <xine/io_helper.h>
 #include "xine_private.h"
 
 #ifdef WIN32
@@ -348,6 +353,7 @@ static void *demux_loop (void *stream_gen) {
   struct timespec seek_time = {0, 0};
 
   lprintf ("loop starting...\n");
+  XINE_PROFILER_THREAD ("demux");
 
   xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
     "demux: starting stream %p.\n", (void *)stream);
@@ -378,16 +384,20 @@ static void *demux_loop (void *stream_gen) {
     while (status == DEMUX_OK && stream->demux.thread_running && !m->emergency_brake) {
 
       iterations++;
+      XINE_PROFILER_BEGIN ("demux send_chunk");
       status = stream->demux.plugin->send_chunk (stream->demux.plugin);
+      XINE_PROFILER_END ();
 
       /* someone may want to interrupt us */
       if (stream->demux.action_pending > 0) {
         pthread_mutex_lock (&stream->demux.action_lock);
         if (stream->demux.action_pending > 0) {
           pthread_mutex_unlock (&stream->demux.lock);
+          XINE_PROFILER_BEGIN ("demux suspended");
           do {
             pthread_cond_wait (&stream->demux.resume, &stream->demux.action_lock);
           } while (stream->demux.action_pending > 0);
+          XINE_PROFILER_END ();
           pthread_mutex_unlock (&stream->demux.action_lock);
           pthread_mutex_lock (&stream->demux.lock);
           xine_gettime (&seek_time);
@@ -725,19 +735,13 @@ off_t _x_read_abort (xine_stream_t *stream, int fd, char *buf, off_t todo) {
   while (left) {
 
     while (1) {
-      fd_set rset;
-      struct timeval timeout;
-
-      FD_ZERO (&rset);
-      FD_SET  (fd, &rset);
-      timeout.tv_sec  = 0;
-      timeout.tv_usec = 50000;
-
-      if (select (fd + 1, &rset, NULL, NULL, &timeout) > 0)
+      int r = _x_io_select (stream, fd, XIO_READ_READY, 1000);
+      /* errors are reported by read () below. */
+      if ((r == XIO_READY) || (r == XIO_ERROR))
         break;
       /* aborts current read if action pending. otherwise xine
        * cannot be stopped when no more data is available. */
-      if (_x_action_pending (stream))
+      if (r == XIO_ABORTED)
         return have;
     }
 
@@ -773,6 +777,8 @@ int _x_action_pending (xine_stream_t *s) {
   int a;
   if (!stream)
     return 0;
+  if (stream->actions_from_master)
+    stream = stream->side_streams[0];
   a = stream->demux.action_pending & 0xffff;
   if (a) {
     /* On seek, xine_play_internal () sets this, waits for demux to stop,
@@ -792,6 +798,7 @@ void _x_action_raise (xine_stream_t *s) {
   xine_stream_private_t *stream = (xine_stream_private_t *)s;
   pthread_mutex_lock (&stream->demux.action_lock);
   stream->demux.action_pending += 0x10001;
+  xine_action_wakeup_update (stream);
   pthread_mutex_unlock (&stream->demux.action_lock);
 }
 
@@ -800,11 +807,86 @@ void _x_action_lower (xine_stream_t *s) {
   xine_stream_private_t *stream = (xine_stream_private_t *)s;
   pthread_mutex_lock (&stream->demux.action_lock);
   stream->demux.action_pending -= 0x10001;
+  xine_action_wakeup_update (stream);
   if (stream->demux.action_pending <= 0)
     pthread_cond_signal (&stream->demux.resume);
   pthread_mutex_unlock (&stream->demux.action_lock);
 }
 
+/* The wakeup fd lets input wait for data and for actions in the same poll (),
+ * instead of checking action_pending every 50ms. It is an eventfd where
+ * available, or a pipe. It is readable exactly while the low half of
+ * action_pending is not 0. */
+void xine_action_wakeup_update (xine_stream_private_t *stream) {
+#ifndef WIN32
+  uint32_t set = (stream->demux.action_pending & 0xffff) ? 1 : 0;
+
+  if ((stream->demux.wakeup_fd[0] < 0) || (set == stream->demux.wakeup_set))
+    return;
+  stream->demux.wakeup_set = set;
+  if (set) {
+    static const uint64_t one = 1;
+    if (write (stream->demux.wakeup_fd[1], &one, sizeof (one)) < 0)
+      xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG, "demux: wakeup write failed (%d).\n", errno);
+  } else {
+    uint64_t v;
+    /* both are non blocking. */
+    while (read (stream->demux.wakeup_fd[0], &v, sizeof (v)) > 0) ;
+  }
+#else
+  (void)stream;
+#endif
+}
+
+int xine_action_wakeup_fd (xine_stream_private_t *stream) {
+#ifndef WIN32
+  int fd;
+
+  if (stream->actions_from_master)
+    stream = stream->side_streams[0];
+  pthread_mutex_lock (&stream->demux.action_lock);
+  if (stream->demux.wakeup_fd[0] < 0) {
+# ifdef HAVE_SYS_EVENTFD_H
+    fd = eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd >= 0) {
+      stream->demux.wakeup_fd[0] = stream->demux.wakeup_fd[1] = fd;
+    } else
+# endif
+    {
+      int fds[2];
+      if (pipe (fds) == 0) {
+        fcntl (fds[0], F_SETFL, fcntl (fds[0], F_GETFL) | O_NONBLOCK);
+        fcntl (fds[1], F_SETFL, fcntl (fds[1], F_GETFL) | O_NONBLOCK);
+        _x_set_file_close_on_exec (fds[0]);
+        _x_set_file_close_on_exec (fds[1]);
+        stream->demux.wakeup_fd[0] = fds[0];
+        stream->demux.wakeup_fd[1] = fds[1];
+      }
+    }
+    if (stream->demux.wakeup_fd[0] >= 0) {
+      stream->demux.wakeup_set = 0;
+      xine_action_wakeup_update (stream);
+    }
+  }
+  fd = stream->demux.wakeup_fd[0];
+  pthread_mutex_unlock (&stream->demux.action_lock);
+  return fd;
+#else
+  (void)stream;
+  return -1;
+#endif
+}
+
+void xine_action_wakeup_close (xine_stream_private_t *stream) {
+#ifndef WIN32
+  if (stream->demux.wakeup_fd[1] >= 0 && stream->demux.wakeup_fd[1] != stream->demux.wakeup_fd[0])
+    close (stream->demux.wakeup_fd[1]);
+  if (stream->demux.wakeup_fd[0] >= 0)
+    close (stream->demux.wakeup_fd[0]);
+#endif
+  stream->demux.wakeup_fd[0] = stream->demux.wakeup_fd[1] = -1;
+}
+
 /*
  * demuxer helper function to send data to fifo, breaking into smaller
  * pieces (bufs) as needed.
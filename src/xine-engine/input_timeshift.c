@@ -0,0 +1,681 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Timeshift Input Plugin for live streams
+ *
+ * A writer thread records everything the main input plugin delivers into
+ * a fixed size ring file. Playback reads from that file, so it can pause,
+ * seek back, and catch up again, while the writer keeps draining the
+ * source at its own pace. When the ring is full, the oldest data gets
+ * overwritten, and readers that fell behind skip forward.
+ *
+ * Usage:
+ *     xine stream_mrl#timeshift
+ *     xine stream_mrl#timeshift:2048   (ring size in MiB)
+ *
+ * Time based seeking uses the time since start of recording.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define LOG_MODULE "input_timeshift"
+#define LOG_VERBOSE
+/*
+#define LOG
+*/
+
+#include <xine/xine_internal.h>
+#include "xine_private.h"
+
+#define TS_CHUNK       (16 << 10)  /* writer read size */
+#define TS_MIN_SIZE    16          /* MiB */
+#define TS_MAX_SIZE    (1 << 20)   /* MiB */
+#define TS_INDEX_SIZE  4096        /* time index entries */
+#define TS_INDEX_STEP  250         /* initial ms between them */
+
+typedef struct {
+  uint32_t          ms;                /* since start of recording */
+  off_t             pos;               /* stream offset */
+} ts_index_t;
+
+typedef struct {
+  input_plugin_t    input_plugin;      /* inherited structure */
+
+  input_plugin_t   *main_input_plugin; /* original input plugin */
+  xine_stream_t    *stream;
+  xine_stream_t    *main_stream;       /* what main_input_plugin was made for */
+
+  int               wfd, rfd;          /* ring file */
+  off_t             ring_size;
+
+  pthread_t         writer;
+  int               writer_running;
+  pthread_mutex_t   mutex;
+  pthread_cond_t    data_cond;         /* new data, or writer finished */
+
+  /* protected by mutex */
+  off_t             live;              /* bytes recorded so far */
+  int               ended;             /* 1 = end of stream, -1 = error */
+  int               quit;
+  off_t             curpos;            /* read position */
+  struct timeval    start;
+  ts_index_t        index[TS_INDEX_SIZE];
+  int               index_used;
+  uint32_t          index_step;
+
+  uint8_t           preview[MAX_PREVIEW_SIZE];
+  int               preview_size;
+} timeshift_input_plugin_t;
+
+
+/* first stream offset that is safe to read. The writer may be busy
+ * overwriting up to 1 chunk below it. */
+static off_t ts_oldest (timeshift_input_plugin_t *this) {
+  off_t oldest = this->live + TS_CHUNK - this->ring_size;
+  return oldest > 0 ? oldest : 0;
+}
+
+static uint32_t ts_elapsed (timeshift_input_plugin_t *this) {
+  struct timeval now;
+  xine_monotonic_clock (&now, NULL);
+  return (now.tv_sec - this->start.tv_sec) * 1000 + (now.tv_usec - this->start.tv_usec) / 1000;
+}
+
+/* remember when this->live was reached. */
+static void ts_index_add (timeshift_input_plugin_t *this) {
+  uint32_t ms = ts_elapsed (this);
+  int i, n;
+
+  if (this->index_used && (ms - this->index[this->index_used - 1].ms < this->index_step))
+    return;
+
+  if (this->index_used >= TS_INDEX_SIZE) {
+    /* drop entries for overwritten data, but keep the last of them as lower bound. */
+    off_t oldest = ts_oldest (this);
+    for (n = 0; (n + 1 < this->index_used) && (this->index[n + 1].pos <= oldest); n++) ;
+    if (n > 0) {
+      memmove (this->index, this->index + n, (this->index_used - n) * sizeof (this->index[0]));
+      this->index_used -= n;
+    }
+  }
+  if (this->index_used >= TS_INDEX_SIZE) {
+    /* thin out. */
+    for (i = 0; i < TS_INDEX_SIZE / 2; i++)
+      this->index[i] = this->index[2 * i];
+    this->index_used = TS_INDEX_SIZE / 2;
+    this->index_step *= 2;
+  }
+
+  this->index[this->index_used].ms  = ms;
+  this->index[this->index_used].pos = this->live;
+  this->index_used++;
+}
+
+static uint32_t ts_pos_to_ms (timeshift_input_plugin_t *this, off_t pos) {
+  int a = 0, b = this->index_used - 1;
+  const ts_index_t *e = this->index;
+
+  if (b < 0 || pos <= e[0].pos)
+    return b < 0 ? 0 : e[0].ms;
+  if (pos >= e[b].pos)
+    return e[b].ms;
+  while (b - a > 1) {
+    int m = (a + b) >> 1;
+    if (e[m].pos <= pos)
+      a = m;
+    else
+      b = m;
+  }
+  return e[a].ms + (uint32_t)((double)(pos - e[a].pos) * (e[b].ms - e[a].ms) / (e[b].pos - e[a].pos));
+}
+
+static off_t ts_ms_to_pos (timeshift_input_plugin_t *this, int64_t ms) {
+  int a = 0, b = this->index_used - 1;
+  const ts_index_t *e = this->index;
+
+  if (b < 0 || ms <= e[0].ms)
+    return b < 0 ? 0 : e[0].pos;
+  if (ms >= e[b].ms)
+    return this->live;
+  while (b - a > 1) {
+    int m = (a + b) >> 1;
+    if (e[m].ms <= ms)
+      a = m;
+    else
+      b = m;
+  }
+  return e[a].pos + (off_t)((double)(ms - e[a].ms) * (e[b].pos - e[a].pos) / (e[b].ms - e[a].ms));
+}
+
+static int ts_file_write (timeshift_input_plugin_t *this, const uint8_t *buf, off_t pos, off_t len) {
+  while (len > 0) {
+    off_t rpos = pos % this->ring_size, part = this->ring_size - rpos;
+    ssize_t r;
+    if (part > len)
+      part = len;
+    if (lseek (this->wfd, rpos, SEEK_SET) != rpos)
+      return -1;
+    r = write (this->wfd, buf, part);
+    if (r <= 0) {
+      if ((r < 0) && (errno == EINTR))
+        continue;
+      return -1;
+    }
+    buf += r;
+    pos += r;
+    len -= r;
+  }
+  return 0;
+}
+
+static int ts_file_read (timeshift_input_plugin_t *this, uint8_t *buf, off_t pos, off_t len) {
+  while (len > 0) {
+    off_t rpos = pos % this->ring_size, part = this->ring_size - rpos;
+    ssize_t r;
+    if (part > len)
+      part = len;
+    if (lseek (this->rfd, rpos, SEEK_SET) != rpos)
+      return -1;
+    r = read (this->rfd, buf, part);
+    if (r <= 0) {
+      if ((r < 0) && (errno == EINTR))
+        continue;
+      return -1;
+    }
+    buf += r;
+    pos += r;
+    len -= r;
+  }
+  return 0;
+}
+
+/*
+ * writer thread: drain the main input plugin. This never waits for the reader.
+ */
+static void *ts_writer_loop (void *data) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)data;
+  input_plugin_t *main_plugin = this->main_input_plugin;
+  uint8_t *buf = malloc (TS_CHUNK);
+  int ended = buf ? 1 : -1;
+
+  while (buf) {
+    off_t n;
+
+    pthread_mutex_lock (&this->mutex);
+    n = this->quit;
+    pthread_mutex_unlock (&this->mutex);
+    if (n)
+      break;
+
+    n = main_plugin->read (main_plugin, buf, TS_CHUNK);
+    if (n <= 0) {
+      /* only ts_plugin_dispose () interrupts network io here. */
+      if (_x_action_pending (this->main_stream)) {
+        xine_usec_sleep (10000);
+        continue;
+      }
+      ended = n < 0 ? -1 : 1;
+      break;
+    }
+
+    /* only the writer changes this->live. */
+    if (ts_file_write (this, buf, this->live, n) < 0) {
+      xine_log (this->stream->xine, XINE_LOG_MSG,
+        _("input_timeshift: error writing to ring file: %s\n"), strerror (errno));
+      ended = -1;
+      break;
+    }
+
+    pthread_mutex_lock (&this->mutex);
+    this->live += n;
+    ts_index_add (this);
+    pthread_cond_broadcast (&this->data_cond);
+    pthread_mutex_unlock (&this->mutex);
+  }
+
+  pthread_mutex_lock (&this->mutex);
+  this->ended = ended;
+  pthread_cond_broadcast (&this->data_cond);
+  pthread_mutex_unlock (&this->mutex);
+
+  lprintf ("writer finished (%d)\n", ended);
+  free (buf);
+  return NULL;
+}
+
+/*
+ * read recorded data. blocks until len bytes are there, the stream ended,
+ * or the engine wants the demuxer to do something else.
+ */
+static off_t ts_plugin_read (input_plugin_t *this_gen, void *buf_gen, off_t len) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  uint8_t *buf = (uint8_t *)buf_gen;
+  off_t done = 0;
+
+  if (len <= 0)
+    return 0;
+
+  pthread_mutex_lock (&this->mutex);
+  while (done < len) {
+    off_t oldest = ts_oldest (this), pos, n;
+
+    if (this->curpos < oldest) {
+      xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG,
+        "input_timeshift: reader fell behind, %" PRId64 " bytes dropped.\n", (int64_t)(oldest - this->curpos));
+      this->curpos = oldest;
+    }
+    n = this->live - this->curpos;
+    if (n <= 0) {
+      struct timespec ts = {0, 0};
+      if (this->ended || _x_action_pending (this->stream))
+        break;
+      xine_gettime (&ts);
+      ts.tv_nsec += 100000000;
+      if (ts.tv_nsec >= 1000000000) {
+        ts.tv_nsec -= 1000000000;
+        ts.tv_sec++;
+      }
+      pthread_cond_timedwait (&this->data_cond, &this->mutex, &ts);
+      continue;
+    }
+    if (n > len - done)
+      n = len - done;
+
+    pos = this->curpos;
+    pthread_mutex_unlock (&this->mutex);
+    n = ts_file_read (this, buf + done, pos, n) < 0 ? -1 : n;
+    pthread_mutex_lock (&this->mutex);
+    if (n < 0) {
+      xine_log (this->stream->xine, XINE_LOG_MSG,
+        _("input_timeshift: error reading from ring file: %s\n"), strerror (errno));
+      break;
+    }
+    /* overwritten while we read it? */
+    if (pos < ts_oldest (this))
+      continue;
+    if (this->curpos == pos)
+      this->curpos += n;
+    done += n;
+  }
+  pthread_mutex_unlock (&this->mutex);
+
+  return done;
+}
+
+static buf_element_t *ts_plugin_read_block (input_plugin_t *this_gen, fifo_buffer_t *fifo, off_t todo) {
+  buf_element_t *buf;
+  off_t n;
+
+  if (todo <= 0)
+    return NULL;
+
+  buf = fifo->buffer_pool_alloc (fifo);
+  if (todo > buf->max_size)
+    todo = buf->max_size;
+  buf->content = buf->mem;
+  buf->type = BUF_DEMUX_BLOCK;
+  n = ts_plugin_read (this_gen, buf->content, todo);
+  if (n <= 0) {
+    buf->free_buffer (buf);
+    return NULL;
+  }
+  buf->size = n;
+  return buf;
+}
+
+/*
+ * open should never be called
+ */
+static int ts_plugin_open (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+
+  xine_log (this->stream->xine, XINE_LOG_MSG,
+    _("input_timeshift: open() function should never be called\n"));
+  return 0;
+}
+
+static uint32_t ts_plugin_get_capabilities (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  uint32_t caps;
+
+  caps = this->main_input_plugin->get_capabilities (this->main_input_plugin);
+  /* we can pause and seek now, but not clone or switch mrl. */
+  caps &= ~(INPUT_CAP_PREVIEW | INPUT_CAP_SIZED_PREVIEW | INPUT_CAP_SLOW_SEEKABLE |
+            INPUT_CAP_LIVE | INPUT_CAP_CLONE | INPUT_CAP_NEW_MRL);
+  caps |= INPUT_CAP_SEEKABLE | INPUT_CAP_TIME_SEEKABLE;
+  if (this->preview_size > 0)
+    caps |= INPUT_CAP_PREVIEW | INPUT_CAP_SIZED_PREVIEW;
+  return caps;
+}
+
+/*
+ * Positions before the oldest recorded byte snap to it. Positions beyond
+ * the live edge are fine, reading just waits until data arrives there.
+ */
+static off_t ts_plugin_seek (input_plugin_t *this_gen, off_t offset, int origin) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  off_t pos, oldest;
+
+  pthread_mutex_lock (&this->mutex);
+  switch (origin) {
+    case SEEK_SET: pos = offset; break;
+    case SEEK_CUR: pos = this->curpos + offset; break;
+    case SEEK_END: pos = this->live + offset; break;
+    default:
+      pthread_mutex_unlock (&this->mutex);
+      return -1;
+  }
+  oldest = ts_oldest (this);
+  if (pos < oldest)
+    pos = oldest;
+  this->curpos = pos;
+  pthread_mutex_unlock (&this->mutex);
+
+  lprintf ("seek to %" PRId64 "\n", (int64_t)pos);
+  return pos;
+}
+
+static off_t ts_plugin_seek_time (input_plugin_t *this_gen, int time_offset, int origin) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  int64_t ms;
+  off_t pos;
+
+  pthread_mutex_lock (&this->mutex);
+  switch (origin) {
+    case SEEK_SET: ms = time_offset; break;
+    case SEEK_CUR: ms = (int64_t)ts_pos_to_ms (this, this->curpos) + time_offset; break;
+    case SEEK_END: ms = (int64_t)ts_elapsed (this) + time_offset; break;
+    default:
+      pthread_mutex_unlock (&this->mutex);
+      return -1;
+  }
+  pos = ts_ms_to_pos (this, ms);
+  pthread_mutex_unlock (&this->mutex);
+
+  return ts_plugin_seek (this_gen, pos, SEEK_SET);
+}
+
+static off_t ts_plugin_get_current_pos (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  off_t pos;
+
+  pthread_mutex_lock (&this->mutex);
+  pos = this->curpos;
+  pthread_mutex_unlock (&this->mutex);
+  return pos;
+}
+
+static int ts_plugin_get_current_time (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  int ms;
+
+  pthread_mutex_lock (&this->mutex);
+  ms = ts_pos_to_ms (this, this->curpos);
+  pthread_mutex_unlock (&this->mutex);
+  return ms;
+}
+
+static off_t ts_plugin_get_length (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+  off_t length;
+
+  pthread_mutex_lock (&this->mutex);
+  length = this->live;
+  pthread_mutex_unlock (&this->mutex);
+  return length;
+}
+
+static uint32_t ts_plugin_get_blocksize (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+
+  return this->main_input_plugin->get_blocksize (this->main_input_plugin);
+}
+
+static const char *ts_plugin_get_mrl (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+
+  return this->main_input_plugin->get_mrl (this->main_input_plugin);
+}
+
+static int ts_plugin_get_optional_data (input_plugin_t *this_gen, void *data, int data_type) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+
+  switch (data_type) {
+    case INPUT_OPTIONAL_DATA_PREVIEW:
+      if (!data || (this->preview_size <= 0))
+        return INPUT_OPTIONAL_UNSUPPORTED;
+      memcpy (data, this->preview, this->preview_size);
+      return this->preview_size;
+    case INPUT_OPTIONAL_DATA_SIZED_PREVIEW: {
+      int want;
+      if (!data || (this->preview_size <= 0))
+        return INPUT_OPTIONAL_UNSUPPORTED;
+      memcpy (&want, data, sizeof (want));
+      if (want > this->preview_size)
+        want = this->preview_size;
+      if (want <= 0)
+        return INPUT_OPTIONAL_UNSUPPORTED;
+      memcpy (data, this->preview, want);
+      return want;
+    }
+    case INPUT_OPTIONAL_DATA_DURATION:
+      if (!data)
+        return INPUT_OPTIONAL_UNSUPPORTED;
+      pthread_mutex_lock (&this->mutex);
+      *(int32_t *)data = ts_elapsed (this);
+      pthread_mutex_unlock (&this->mutex);
+      return INPUT_OPTIONAL_SUCCESS;
+    case INPUT_OPTIONAL_DATA_CLONE:
+    case INPUT_OPTIONAL_DATA_NEW_MRL:
+      return INPUT_OPTIONAL_UNSUPPORTED;
+    default:
+      /* the main plugin is busy in the writer thread, but the remaining
+       * requests (language, mime type, demuxer) just return stored info. */
+      return this->main_input_plugin->get_optional_data (this->main_input_plugin, data, data_type);
+  }
+}
+
+/*
+ * dispose main input plugin and self
+ */
+static void ts_plugin_dispose (input_plugin_t *this_gen) {
+  timeshift_input_plugin_t *this = (timeshift_input_plugin_t *)this_gen;
+
+  if (this->writer_running) {
+    pthread_mutex_lock (&this->mutex);
+    this->quit = 1;
+    pthread_mutex_unlock (&this->mutex);
+    /* wake up network io. */
+    _x_action_raise (this->main_stream);
+    pthread_join (this->writer, NULL);
+    _x_action_lower (this->main_stream);
+  }
+
+  _x_free_input_plugin (this->stream, this->main_input_plugin);
+  close (this->wfd);
+  close (this->rfd);
+  pthread_cond_destroy (&this->data_cond);
+  pthread_mutex_destroy (&this->mutex);
+  free (this);
+}
+
+/*
+ * create the ring file. it is unlinked right away, and goes when we close it.
+ */
+static int ts_open_file (timeshift_input_plugin_t *this, const char *dir) {
+  char name[1024];
+  int r;
+
+  if (!dir || !dir[0]) {
+    dir = getenv ("TMPDIR");
+    if (!dir || !dir[0])
+      dir = "/tmp";
+  }
+  snprintf_buf (name, "%s/xine-timeshift-XXXXXX", dir);
+  this->wfd = mkstemp (name);
+  if (this->wfd < 0) {
+    xine_log (this->stream->xine, XINE_LOG_MSG,
+      _("input_timeshift: error creating ring file in %s: %s\n"), dir, strerror (errno));
+    return 0;
+  }
+  this->rfd = xine_open_cloexec (name, O_RDONLY);
+  unlink (name);
+  if (this->rfd < 0) {
+    xine_log (this->stream->xine, XINE_LOG_MSG,
+      _("input_timeshift: error opening ring file: %s\n"), strerror (errno));
+    close (this->wfd);
+    return 0;
+  }
+
+  /* reserve the disk space now, so we do not run out of it in the middle
+   * of a recording. some file systems cannot do that, and get a sparse file. */
+#ifdef HAVE_POSIX_FALLOCATE
+  r = posix_fallocate (this->wfd, 0, this->ring_size);
+  if (!r)
+    return 1;
+  xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG,
+    "input_timeshift: preallocation failed (%s), using a sparse file.\n", strerror (r));
+#endif
+  r = ftruncate (this->wfd, this->ring_size);
+  if (r) {
+    xine_log (this->stream->xine, XINE_LOG_MSG,
+      _("input_timeshift: error sizing ring file: %s\n"), strerror (errno));
+    close (this->wfd);
+    close (this->rfd);
+    return 0;
+  }
+  return 1;
+}
+
+/*
+ * create self instance. size_mb <= 0 means configured default.
+ * main_stream should be a hidden side stream of stream, so the reader's
+ * seeks do not abort the writer's reads (and drop their data).
+ */
+input_plugin_t *_x_timeshift_plugin_get_instance (xine_stream_t *stream, xine_stream_t *main_stream, int size_mb) {
+  config_values_t *config = stream->xine->config;
+  input_plugin_t *main_plugin = stream->input_plugin;
+  timeshift_input_plugin_t *this;
+  const char *dir;
+  uint32_t caps;
+
+  if (!main_plugin) {
+    xine_log (stream->xine, XINE_LOG_MSG, _("input_timeshift: input plugin not defined!\n"));
+    return NULL;
+  }
+
+  caps = main_plugin->get_capabilities (main_plugin);
+#ifndef SAVING_ALWAYS_PERMIT
+  if (caps & INPUT_CAP_RIP_FORBIDDEN) {
+    xine_log (stream->xine, XINE_LOG_MSG,
+      _("input_timeshift: ripping/caching of this source is not permitted!\n"));
+    return NULL;
+  }
+#endif
+
+  dir = config->register_filename (config,
+    "media.timeshift.directory", "", XINE_CONFIG_STRING_IS_DIRECTORY_NAME,
+    _("directory for timeshift buffers"),
+    _("Live streams opened with the #timeshift mrl option are recorded into a temporary "
+      "file in this directory. Empty means $TMPDIR or /tmp."),
+    XINE_CONFIG_SECURITY, NULL, NULL);
+  if (size_mb <= 0)
+    size_mb = config->register_num (config,
+      "media.timeshift.size", 1024,
+      _("timeshift buffer size in MiB"),
+      _("How much of a live stream opened with the #timeshift mrl option is kept "
+        "for pausing and seeking back."),
+      20, NULL, NULL);
+  if (size_mb < TS_MIN_SIZE)
+    size_mb = TS_MIN_SIZE;
+  if (size_mb > TS_MAX_SIZE)
+    size_mb = TS_MAX_SIZE;
+  if (sizeof (off_t) < 8 && size_mb > 2047)
+    size_mb = 2047;
+
+  this = calloc (1, sizeof (*this));
+  if (!this)
+    return NULL;
+
+  this->main_input_plugin = main_plugin;
+  this->stream            = stream;
+  this->main_stream       = main_stream;
+  this->ring_size         = (off_t)size_mb << 20;
+  this->index_step        = TS_INDEX_STEP;
+
+  if (!ts_open_file (this, dir)) {
+    free (this);
+    return NULL;
+  }
+
+  /* the first bytes are the same as the main preview. */
+  if (caps & INPUT_CAP_PREVIEW) {
+    this->preview_size = main_plugin->get_optional_data (main_plugin, this->preview, INPUT_OPTIONAL_DATA_PREVIEW);
+    if (this->preview_size < 0)
+      this->preview_size = 0;
+    if (this->preview_size > MAX_PREVIEW_SIZE)
+      this->preview_size = MAX_PREVIEW_SIZE;
+  }
+
+  pthread_mutex_init (&this->mutex, NULL);
+  pthread_cond_init (&this->data_cond, NULL);
+  xine_monotonic_clock (&this->start, NULL);
+
+  if (pthread_create (&this->writer, NULL, ts_writer_loop, this)) {
+    xine_log (stream->xine, XINE_LOG_MSG, _("input_timeshift: cannot start writer thread\n"));
+    pthread_cond_destroy (&this->data_cond);
+    pthread_mutex_destroy (&this->mutex);
+    close (this->wfd);
+    close (this->rfd);
+    free (this);
+    return NULL;
+  }
+  this->writer_running = 1;
+
+  xine_log (stream->xine, XINE_LOG_MSG, _("input_timeshift: recording into a %d MiB ring\n"), size_mb);
+
+  this->input_plugin.open                = ts_plugin_open;
+  this->input_plugin.get_capabilities    = ts_plugin_get_capabilities;
+  this->input_plugin.read                = ts_plugin_read;
+  this->input_plugin.read_block          = ts_plugin_read_block;
+  this->input_plugin.seek                = ts_plugin_seek;
+  this->input_plugin.seek_time           = ts_plugin_seek_time;
+  this->input_plugin.get_current_pos     = ts_plugin_get_current_pos;
+  this->input_plugin.get_current_time    = ts_plugin_get_current_time;
+  this->input_plugin.get_length          = ts_plugin_get_length;
+  this->input_plugin.get_blocksize       = ts_plugin_get_blocksize;
+  this->input_plugin.get_mrl             = ts_plugin_get_mrl;
+  this->input_plugin.get_optional_data   = ts_plugin_get_optional_data;
+  this->input_plugin.dispose             = ts_plugin_dispose;
+  this->input_plugin.input_class         = main_plugin->input_class;
+
+  return &this->input_plugin;
+}
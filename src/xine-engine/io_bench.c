@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * network i/o benchmark: system calls per MB received through
+ * _x_io_tcp_part_read () and _x_io_tcp_read (), and how long it takes
+ * until a read that waits for data is aborted by _x_action_raise ().
+ * recv (), poll () and select () are counted by wrapping them here, this
+ * needs them to be exported from the program.
+ *
+ * usage: io_bench [MB] [stops]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* RTLD_NEXT */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <poll.h>
+
+#include <xine.h>
+#include <xine/xine_internal.h>
+#include <xine/io_helper.h>
+
+static int n_recv, n_poll, n_select;
+
+ssize_t recv (int s, void *buf, size_t len, int flags) EXPORTED;
+ssize_t recv (int s, void *buf, size_t len, int flags) {
+  static ssize_t (*real) (int, void *, size_t, int) = NULL;
+  if (!real)
+    real = (ssize_t (*) (int, void *, size_t, int))dlsym (RTLD_NEXT, "recv");
+  n_recv++;
+  return real (s, buf, len, flags);
+}
+
+int poll (struct pollfd *fds, nfds_t n, int timeout) EXPORTED;
+int poll (struct pollfd *fds, nfds_t n, int timeout) {
+  static int (*real) (struct pollfd *, nfds_t, int) = NULL;
+  if (!real)
+    real = (int (*) (struct pollfd *, nfds_t, int))dlsym (RTLD_NEXT, "poll");
+  n_poll++;
+  return real (fds, n, timeout);
+}
+
+int select (int n, fd_set *r, fd_set *w, fd_set *e, struct timeval *t) EXPORTED;
+int select (int n, fd_set *r, fd_set *w, fd_set *e, struct timeval *t) {
+  static int (*real) (int, fd_set *, fd_set *, fd_set *, struct timeval *) = NULL;
+  if (!real)
+    real = (int (*) (int, fd_set *, fd_set *, fd_set *, struct timeval *))dlsym (RTLD_NEXT, "select");
+  n_select++;
+  return real (n, r, w, e, t);
+}
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+  int    fd;
+  size_t bytes, chunk;
+} writer_t;
+
+static void *_writer (void *data) {
+  writer_t *w = data;
+  char *buf = calloc (1, w->chunk);
+  size_t done = 0;
+
+  while (buf && (done < w->bytes)) {
+    ssize_t r = write (w->fd, buf, w->chunk);
+    if (r <= 0)
+      break;
+    done += r;
+  }
+  free (buf);
+  shutdown (w->fd, SHUT_WR);
+  return NULL;
+}
+
+/* receive mb MB, written in chunk byte pieces. */
+static void _throughput (xine_stream_t *stream, int mb, size_t chunk, int part) {
+  writer_t w;
+  pthread_t thread;
+  int fds[2];
+  uint8_t buf[65536];
+  size_t total = 0;
+  double start, t;
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    return;
+  w.fd = fds[1];
+  w.bytes = (size_t)mb << 20;
+  w.chunk = chunk;
+  n_recv = n_poll = n_select = 0;
+  start = _now ();
+  pthread_create (&thread, NULL, _writer, &w);
+  while (1) {
+    ssize_t r = part ? _x_io_tcp_part_read (stream, fds[0], buf, 1, sizeof (buf))
+                     : _x_io_tcp_read (stream, fds[0], buf, 4096);
+    if (r <= 0)
+      break;
+    total += r;
+  }
+  t = _now () - start;
+  pthread_join (thread, NULL);
+  close (fds[0]);
+  close (fds[1]);
+  printf ("%-9s %6zu %9.1f %9.1f %9.1f %9.0f\n", part ? "part_read" : "read", chunk,
+          n_recv * 1048576.0 / total, n_poll * 1048576.0 / total, n_select * 1048576.0 / total,
+          total / t / 1048576.0);
+}
+
+typedef struct {
+  xine_stream_t *stream;
+  int            fd;
+  off_t          got;
+  double         done;
+} reader_t;
+
+static void *_reader (void *data) {
+  reader_t *r = data;
+  uint8_t b;
+
+  r->got = _x_io_tcp_read (r->stream, r->fd, &b, 1);
+  r->done = _now ();
+  return NULL;
+}
+
+static void _stop_latency (xine_stream_t *stream, int stops) {
+  double sum = 0, max = 0;
+  int fds[2], i;
+
+  if (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)
+    return;
+  for (i = 0; i < stops; i++) {
+    reader_t r = { stream, fds[0], 0, 0 };
+    pthread_t thread;
+    double start, d;
+
+    pthread_create (&thread, NULL, _reader, &r);
+    /* let it wait a while, at a random phase of polling. */
+    usleep (20000 + rand () % 50000);
+    start = _now ();
+    _x_action_raise (stream);
+    pthread_join (thread, NULL);
+    _x_action_lower (stream);
+    d = r.done - start;
+    sum += d;
+    if (max < d)
+      max = d;
+  }
+  close (fds[0]);
+  close (fds[1]);
+  printf ("stop latency: %.3f ms average, %.3f ms max (%d stops)\n", sum * 1e3 / stops, max * 1e3, stops);
+}
+
+int main (int argc, char **argv) {
+  int mb = argc > 1 ? atoi (argv[1]) : 256;
+  int stops = argc > 2 ? atoi (argv[2]) : 20;
+  xine_t *xine;
+  xine_video_port_t *vo;
+  xine_stream_t *stream;
+
+  if (mb < 1)
+    mb = 1;
+  if (stops < 1)
+    stops = 1;
+
+  xine = xine_new ();
+  xine_init (xine);
+  vo = xine_open_video_driver (xine, "none", XINE_VISUAL_TYPE_NONE, NULL);
+  stream = vo ? xine_stream_new (xine, NULL, vo) : NULL;
+  if (!stream) {
+    fprintf (stderr, "cannot create stream.\n");
+    return 1;
+  }
+
+  printf ("%-9s %6s %9s %9s %9s %9s\n", "per MB", "chunk", "recv", "poll", "select", "MB/s");
+  _throughput (stream, mb, 1500, 1);
+  _throughput (stream, mb, 16384, 1);
+  _throughput (stream, mb, 1500, 0);
+  _throughput (stream, mb, 16384, 0);
+  _stop_latency (stream, stops);
+
+  xine_dispose (stream);
+  xine_close_video_driver (xine, vo);
+  xine_exit (xine);
+  return 0;
+}
@@ -39,6 +39,10 @@
 #include <netdb.h>
 #endif
 #include <errno.h>
+#if defined(HAVE_POLL_H) && !defined(WIN32)
+#  define XIO_USE_POLL
+#  include <poll.h>
+#endif
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -375,7 +379,9 @@ int _x_io_tcp_handshake_connect (xine_stream_t *stream, const char *host, int po
 
 int _x_io_select (xine_stream_t *stream, int fd, int state, int timeout_msec) {
 
+#ifndef XIO_USE_POLL
   int timeout_usec, total_time_usec;
+#endif
   int ret;
 #ifdef WIN32
   HANDLE h;
@@ -392,8 +398,10 @@ int _x_io_select (xine_stream_t *stream, int fd, int state, int timeout_msec) {
     default: h = INVALID_HANDLE_VALUE;
   }
 #endif
+#ifndef XIO_USE_POLL
   timeout_usec = 1000 * timeout_msec;
   total_time_usec = 0;
+#endif
 
 #ifdef WIN32
   if (h != INVALID_HANDLE_VALUE) {
@@ -434,6 +442,57 @@ int _x_io_select (xine_stream_t *stream, int fd, int state, int timeout_msec) {
   }
 #endif
 
+#ifdef XIO_USE_POLL
+  {
+    /* wait for the fd and the stream wakeup fd together. without the latter,
+     * check action_pending every XIO_POLLING_INTERVAL. */
+    struct pollfd pfd[2];
+    struct timespec now;
+    int n = 1, wait_msec;
+    int64_t deadline;
+
+    if (!timeout_msec && _x_action_pending (stream)) {
+      errno = EINTR;
+      return XIO_ABORTED;
+    }
+
+    pfd[0].fd = fd;
+    pfd[0].events = ((state & XIO_READ_READY) ? POLLIN : 0) | ((state & XIO_WRITE_READY) ? POLLOUT : 0);
+    pfd[1].events = POLLIN;
+    pfd[1].fd = (stream && timeout_msec) ? xine_action_wakeup_fd ((xine_stream_private_t *)stream) : -1;
+    if (pfd[1].fd >= 0)
+      n = 2;
+
+    xine_gettime (&now);
+    deadline = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 + timeout_msec;
+    wait_msec = timeout_msec;
+
+    while (1) {
+      if ((n == 1) && stream && (wait_msec > XIO_POLLING_INTERVAL / 1000))
+        wait_msec = XIO_POLLING_INTERVAL / 1000;
+      pfd[0].revents = pfd[1].revents = 0;
+      ret = poll (pfd, n, wait_msec);
+      if ((ret < 0) && (errno != EINTR)) {
+        /* poll error */
+        return XIO_ERROR;
+      }
+      if (pfd[0].revents) {
+        /* fd is ready, or will report its error on i/o */
+        return XIO_READY;
+      }
+      /* aborts current read if action pending. otherwise xine
+       * cannot be stopped when no more data is available. */
+      if (_x_action_pending (stream)) {
+        errno = EINTR;
+        return XIO_ABORTED;
+      }
+      xine_gettime (&now);
+      wait_msec = deadline - ((int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+      if (wait_msec <= 0)
+        return XIO_TIMEOUT;
+    }
+  }
+#else
   if (timeout_msec == 0) {
     struct timeval select_timeout = {0, 0};
     fd_set fdset;
@@ -489,6 +548,7 @@ int _x_io_select (xine_stream_t *stream, int fd, int state, int timeout_msec) {
     total_time_usec += XIO_POLLING_INTERVAL;
   }
   return XIO_TIMEOUT;
+#endif /* XIO_USE_POLL */
 }
 
 
@@ -541,6 +601,20 @@ static off_t xio_err (xine_stream_t *stream, int ret) {
   return ret;
 }
 
+/* receive what is there already, or wait for it.
+ * returns -2 if waiting failed, timed out, or was aborted. */
+static ssize_t xio_recv (xine_stream_t *stream, int s, void *buf, size_t len, int timeout) {
+#ifdef MSG_DONTWAIT
+  /* this saves the poll () while data is flowing. */
+  ssize_t ret = recv (s, buf, len, MSG_DONTWAIT);
+  if ((ret >= 0) || !IF_EAGAIN)
+    return ret;
+#endif
+  if (_x_io_select (stream, s, XIO_READ_READY, timeout) != XIO_READY)
+    return -2;
+  return recv (s, buf, len, 0);
+}
+
 off_t _x_io_tcp_read (xine_stream_t *stream, int s, void *buf_gen, off_t todo) {
   uint8_t *buf = buf_gen;
   unsigned int timeout;
@@ -557,10 +631,9 @@ off_t _x_io_tcp_read (xine_stream_t *stream, int s, void *buf_gen, off_t todo) {
 
   while (have < want) {
     ssize_t ret;
-    ret = _x_io_select (stream, s, XIO_READ_READY, timeout);
-    if (ret != XIO_READY)
+    ret = xio_recv (stream, s, buf + have, want - have, timeout);
+    if (ret == -2)
       return -1;
-    ret = recv (s, buf + have, want - have, 0);
     /* check EOF */
     if (!ret)
       break;
@@ -606,10 +679,9 @@ ssize_t _x_io_tcp_part_read (xine_stream_t *stream, int s, void *buf_gen, size_t
 
   while (have < min) {
     ssize_t ret;
-    ret = _x_io_select (stream, s, XIO_READ_READY, timeout);
-    if (ret != XIO_READY)
+    ret = xio_recv (stream, s, buf + have, max - have, timeout);
+    if (ret == -2)
       return -1;
-    ret = recv (s, buf + have, max - have, 0);
     /* check EOF */
     if (!ret)
       break;
@@ -493,6 +493,7 @@ typedef struct {
     int             handled_count;
     int             num_video_waiters;
     int             num_audio_waiters;
+    int             nonblock;
     pthread_cond_t  video_reached;
     pthread_cond_t  audio_reached;
   } disc;
@@ -853,7 +854,10 @@ static void metronom_handle_video_discontinuity (metronom_t *this_gen, int type,
   this->disc.last_offs = disc_off;
 
   waited = 0;
-  if (this->disc.have_audio) {
+  if (this->disc.have_audio && this->disc.nonblock) {
+    /* let audio do it when it gets here. */
+    waited = this->disc.audio_count < this->disc.video_count;
+  } else if (this->disc.have_audio) {
     while (this->disc.audio_count <
 	   this->disc.video_count) {
 
@@ -1081,7 +1085,10 @@ static void metronom_handle_audio_discontinuity (metronom_t *this_gen, int type,
   }
 
   waited = 0;
-  if (this->disc.have_video) {
+  if (this->disc.have_video && this->disc.nonblock) {
+    /* let video do it when it gets here. */
+    waited = this->disc.audio_count > this->disc.video_count;
+  } else if (this->disc.have_video) {
     while ( this->disc.audio_count >
             this->disc.video_count ) {
 
@@ -1306,6 +1313,9 @@ static void metronom_set_option (metronom_t *this_gen, int option, int64_t value
   case METRONOM_VDR_TRICK_PTS:
     metronom_handle_vdr_trick_pts (this, value);
     break;
+  case METRONOM_DISC_NONBLOCK:
+    this->disc.nonblock = !!value;
+    break;
   default:
     xprintf(this->xine, XINE_VERBOSITY_NONE,
       "metronom: unknown option in set_option: %d.\n", option);
@@ -1376,7 +1386,11 @@ static int64_t metronom_get_option (metronom_t *this_gen, int option) {
         result = this->audio.vpts;
       break;
   case METRONOM_WAITING:
-    result = (this->disc.num_audio_waiters ? 1 : 0) | (this->disc.num_video_waiters ? 2 : 0);
+    if (this->disc.nonblock)
+      result = (this->disc.have_audio && (this->disc.audio_count < this->disc.video_count) ? 1 : 0)
+             | (this->disc.have_video && (this->disc.audio_count > this->disc.video_count) ? 2 : 0);
+    else
+      result = (this->disc.num_audio_waiters ? 1 : 0) | (this->disc.num_video_waiters ? 2 : 0);
     break;
   case METRONOM_VDR_TRICK_PTS:
     result = this->video.vpts;
@@ -1657,6 +1671,7 @@ metronom_t * _x_metronom_init (int have_video, int have_audio, xine_t *xine) {
   this->disc.audio_count       = 0;
   this->disc.num_audio_waiters = 0;
   this->disc.num_video_waiters = 0;
+  this->disc.nonblock          = 0;
   this->disc.last_offs         = 0;
   this->disc.last_type         = 0;
 #endif
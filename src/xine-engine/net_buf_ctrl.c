@@ -49,6 +49,10 @@
 #define FIFO_PUT                   0
 #define FIFO_GET                   1
 
+/* live mode: speed steps of 0.5%, one per this much latency error. */
+#define LIVE_STEP_MS              50
+#define LIVE_MAX_STEPS             6
+
 typedef struct {
   /* pointer */
   fifo_buffer_t   *fifo;
@@ -99,6 +103,16 @@ struct xine_nbc_st {
   int dvbs_center, dvbs_width, dvbs_audio_fill, dvbs_video_fill;
   int64_t dvbs_audio_in, dvbs_audio_out;
   int64_t dvbs_video_in, dvbs_video_out;
+
+  /* live mode: prebuffer to live_target ms, then keep the buffered time
+     there by playing up to 3% slower or faster instead of pausing.
+     live_avg is the smoothed latency * 16, live_step the current speed
+     offset in 0.5% units. */
+  int      live;
+  int      live_target;
+  int      live_avg;
+  int      live_latency;
+  int      live_step;
 };
 
 static void report_progress (xine_stream_t *stream, int p) {
@@ -134,6 +148,18 @@ static void nbc_set_speed_normal (xine_nbc_t *this) {
   stream->xine->clock->set_option (stream->xine->clock, CLOCK_SCR_ADJUSTABLE, 1);
 }
 
+/* speed changes of a few % must not mute the sound. */
+static void nbc_enable_slow_fast_audio (xine_nbc_t *this) {
+  xine_t *xine = this->stream->xine;
+  xine_cfg_entry_t entry;
+
+  if (xine_config_lookup_entry (xine, "audio.synchronization.slow_fast_audio",
+    &entry) && (entry.num_value == 0)) {
+    xine->config->update_num (xine->config, "audio.synchronization.slow_fast_audio", 1);
+    xprintf (xine, XINE_VERBOSITY_DEBUG, "net_buf_ctrl: slow/fast audio playback enabled\n");
+  }
+}
+
 static void dvbspeed_init (xine_nbc_t *this) {
   int use_dvbs = 0;
   if (this->stream->input_plugin) {
@@ -162,11 +188,7 @@ static void dvbspeed_init (xine_nbc_t *this) {
       xine_t *xine = this->stream->xine;
       config_values_t *config = xine->config;
       xine_cfg_entry_t entry;
-      if (xine_config_lookup_entry (xine, "audio.synchronization.slow_fast_audio",
-        &entry) && (entry.num_value == 0)) {
-        config->update_num (config, "audio.synchronization.slow_fast_audio", 1);
-        xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG, "net_buf_ctrl: slow/fast audio playback enabled\n");
-      }
+      nbc_enable_slow_fast_audio (this);
       if (xine_config_lookup_entry (xine, "engine.buffers.video_num_buffers",
         &entry) && (entry.num_value < 800)) {
         config->update_num (config, "engine.buffers.video_num_buffers", 800);
@@ -349,6 +371,86 @@ static int dvbspeed_get (xine_nbc_t *this, fifo_buffer_t * fifo, buf_element_t *
   return pause;
 }
 
+static void live_init (xine_nbc_t *this) {
+  input_plugin_t *input = this->stream->input_plugin;
+
+  this->live = 0;
+  this->live_step = 0;
+  this->live_avg = -1;
+  this->live_latency = 0;
+  _x_stream_info_set (this->stream, XINE_STREAM_INFO_LIVE_LATENCY, 0);
+  if ((this->live_target <= 0) || !input)
+    return;
+  /* live input, or no end known (eg. rtp, http without length). */
+  if (!(input->get_capabilities (input) & INPUT_CAP_LIVE) && (input->get_length (input) > 0))
+    return;
+  this->live = 1;
+  nbc_enable_slow_fast_audio (this);
+  xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG,
+    "net_buf_ctrl: live mode, latency target %d ms\n", this->live_target);
+}
+
+static void live_close (xine_nbc_t *this) {
+  if (this->live_step)
+    _x_set_fine_speed (this->stream, XINE_FINE_SPEED_NORMAL);
+  this->live_step = 0;
+  this->live = 0;
+}
+
+/* called after nbc_compute_fifo_length () on get, when not buffering.
+ * returns the new fine speed, or 0 for no change. */
+static int live_adjust (xine_nbc_t *this, fifo_buffer_t *fifo) {
+  int latency, err, band, step;
+
+  /* audio is what drives the clock. */
+  if (this->has_audio) {
+    if (fifo != this->audio.fifo)
+      return 0;
+    latency = this->audio.fifo_length;
+    if (_x_lock_port_rewiring (this->stream->xine, 0)) {
+      latency += this->stream->audio_out->get_property (this->stream->audio_out, AO_PROP_PTS_IN_FIFO) / 90;
+      _x_unlock_port_rewiring (this->stream->xine);
+    }
+  } else {
+    if (fifo != this->video.fifo)
+      return 0;
+    latency = this->video.fifo_length;
+  }
+
+  /* smooth out network bursts, about 16 buffers. */
+  if (this->live_avg < 0)
+    this->live_avg = latency << 4;
+  else
+    this->live_avg += latency - (this->live_avg >> 4);
+  latency = this->live_avg >> 4;
+  if (latency != this->live_latency) {
+    this->live_latency = latency;
+    _x_stream_info_set (this->stream, XINE_STREAM_INFO_LIVE_LATENCY, latency);
+  }
+
+  err = latency - this->live_target;
+  band = this->live_target >> 3;
+  if (band < 20)
+    band = 20;
+  if (err > band)
+    step = (err - band) / LIVE_STEP_MS + 1;
+  else if (err < -band)
+    step = (err + band) / LIVE_STEP_MS - 1;
+  else
+    step = 0;
+  if (step > LIVE_MAX_STEPS)
+    step = LIVE_MAX_STEPS;
+  else if (step < -LIVE_MAX_STEPS)
+    step = -LIVE_MAX_STEPS;
+
+  if (step == this->live_step)
+    return 0;
+  xprintf (this->stream->xine, XINE_VERBOSITY_DEBUG,
+    "net_buf_ctrl: live %d ms, speed %d per mille\n", latency, 1000 + step * 5);
+  this->live_step = step;
+  return XINE_FINE_SPEED_NORMAL + step * (XINE_FINE_SPEED_NORMAL / 200);
+}
+
 void xine_nbc_event (xine_stream_private_t *stream, uint32_t type) {
   if (stream && (type == XINE_NBC_EVENT_AUDIO_DRY)) {
     stream = stream->side_streams[0];
@@ -556,32 +658,34 @@ static void nbc_put_cb (fifo_buffer_t *fifo,
            * be sure that the next buffer_pool_alloc() call will not deadlock,
            * we need at least 2 buffers (see buffer.c)
            */
+          /* live mode: just fill up to the latency target. */
+          int mark = this->live ? this->live_target : this->high_water_mark;
           int progress;
           if (this->has_video) {
             if (this->has_audio) {
-              if ((this->video.fifo_length > this->high_water_mark) &&
-                  (this->audio.fifo_length > this->high_water_mark)) {
+              if ((this->video.fifo_length > mark) &&
+                  (this->audio.fifo_length > mark)) {
                 progress = 100;
                 this->buffering = 0;
               } else {
                 /*  compute the buffering progress, 50%: video, 50%: audio */
-                progress = (this->video.fifo_length + this->audio.fifo_length) * 50 / this->high_water_mark;
+                progress = (this->video.fifo_length + this->audio.fifo_length) * 50 / mark;
               }
             } else {
-              if (this->video.fifo_length > this->high_water_mark) {
+              if (this->video.fifo_length > mark) {
                 progress = 100;
                 this->buffering = 0;
               } else {
-                progress = this->video.fifo_length * 100 / this->high_water_mark;
+                progress = this->video.fifo_length * 100 / mark;
               }
             }
           } else {
             if (this->has_audio) {
-              if (this->audio.fifo_length > this->high_water_mark) {
+              if (this->audio.fifo_length > mark) {
                 progress = 100;
                 this->buffering = 0;
               } else {
-                progress = this->audio.fifo_length * 100 / this->high_water_mark;
+                progress = this->audio.fifo_length * 100 / mark;
               }
             } else {
               progress = 0;
@@ -628,7 +732,9 @@ static void nbc_put_cb (fifo_buffer_t *fifo,
           this->audio.last_pts    = 0;
           this->video.fifo_length = 0;
           this->audio.fifo_length = 0;
-          dvbspeed_init (this);
+          live_init (this);
+          if (!this->live)
+            dvbspeed_init (this);
           if (!this->dvbspeed) pause = 1;
           this->progress = 0;
           report_progress (this->stream, 0);
@@ -642,6 +748,7 @@ static void nbc_put_cb (fifo_buffer_t *fifo,
       case BUF_CONTROL_QUIT:
         lprintf("BUF_CONTROL_END\n");
         dvbspeed_close (this);
+        live_close (this);
         if (this->enabled) {
           /* end of stream :
            *   - disable the nbc
@@ -696,7 +803,7 @@ static void nbc_put_cb (fifo_buffer_t *fifo,
 static void nbc_get_cb (fifo_buffer_t *fifo,
 			buf_element_t *buf, void *this_gen) {
   xine_nbc_t *this = this_gen;
-  int pause = 0;
+  int pause = 0, speed = 0;
 
   lprintf("enter nbc_get_cb\n");
   pthread_mutex_lock(&this->mutex);
@@ -725,9 +832,14 @@ static void nbc_get_cb (fifo_buffer_t *fifo,
               xprintf(this->stream->xine, XINE_VERBOSITY_DEBUG,
                       "\nnet_buf_ctrl: nbc_get_cb: starts buffering, vid: %d, aud: %d\n",
                       this->video.fifo_fill, this->audio.fifo_fill);
+              /* latency restarts from the prebuffer, drop the old average. */
+              this->live_step = 0;
+              this->live_avg = -1;
               pause = 1;
             }
           }
+          if (this->live && !pause)
+            speed = live_adjust (this, fifo);
           report_stats (this, 1);
           if (this->stream->xine->verbosity >= XINE_VERBOSITY_DEBUG)
             display_stats (this);
@@ -762,6 +874,8 @@ static void nbc_get_cb (fifo_buffer_t *fifo,
   pthread_mutex_unlock(&this->mutex);
   if (pause)
     nbc_set_speed_pause (this);
+  else if (speed)
+    _x_set_fine_speed (this->stream, speed);
   lprintf("exit nbc_get_cb\n");
 }
 
@@ -830,6 +944,15 @@ xine_nbc_t *xine_nbc_init (xine_stream_t *stream) {
   else
     this->high_water_mark = (double)DEFAULT_HIGH_WATER_MARK * audio_fifo_factor;
 
+  this->live_target = stream->xine->config->register_num (stream->xine->config,
+    "engine.buffers.live_latency", 0,
+    _("Latency target for live streams (ms)"),
+    _("When set, live network streams are buffered up to this many milliseconds, "
+      "and then kept there by playing up to 3% slower or faster, instead of "
+      "pausing whenever the buffer runs low or dropping data when it runs full.\n"
+      "0 keeps the old buffering behaviour."),
+    20, NULL, NULL);
+
   video_fifo->register_alloc_cb(video_fifo, nbc_alloc_cb, this);
   video_fifo->register_put_cb(video_fifo, nbc_put_cb, this);
   video_fifo->register_get_cb(video_fifo, nbc_get_cb, this);
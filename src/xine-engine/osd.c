@@ -218,15 +218,153 @@ struct osd_font_s {
 };
 
 #ifdef HAVE_FT2
+/* rendered glyphs are kept per (size, unicode) until the face changes.
+ * The glyphs and their 8 bit bitmaps are packed into pages of
+ * OSD_GLYPH_PAGE_SIZE bytes. When more than OSD_GLYPH_CACHE_MAX bytes
+ * are in use, the whole cache is dropped. */
+#define OSD_GLYPH_HASH_SIZE 256
+#define OSD_GLYPH_PAGE_SIZE (64 << 10)
+#define OSD_GLYPH_CACHE_MAX (2 << 20)
+
+typedef struct osd_glyph_s osd_glyph_t;
+struct osd_glyph_s {
+  osd_glyph_t   *next;
+  const uint8_t *bmp;             /* width * rows, no padding */
+  FT_UInt        index;           /* for kerning */
+  uint16_t       unicode;
+  uint16_t       size;
+  int            left, top;       /* bitmap_left, bitmap_top */
+  int            width, rows;
+  int            advance;         /* pixels */
+};
+
+typedef struct osd_glyph_page_s osd_glyph_page_t;
+struct osd_glyph_page_s {
+  osd_glyph_page_t *next;
+  size_t            used, total;
+  /* data follows */
+};
+
 struct osd_ft2context_s {
   FT_Library library;
   FT_Face    face;
   int        size;
+  char      *fontname;            /* of face */
+
+  osd_glyph_t      *glyphs[OSD_GLYPH_HASH_SIZE];
+  osd_glyph_page_t *pages;
+  size_t            cache_bytes;
 };
 
+static void osd_ft2_flush_glyphs (osd_ft2context_t *ft2) {
+  osd_glyph_page_t *page = ft2->pages;
+
+  while (page) {
+    osd_glyph_page_t *next = page->next;
+    free (page);
+    page = next;
+  }
+  ft2->pages = NULL;
+  ft2->cache_bytes = 0;
+  memset (ft2->glyphs, 0, sizeof (ft2->glyphs));
+}
+
+static void *osd_ft2_glyph_alloc (osd_ft2context_t *ft2, size_t size) {
+  osd_glyph_page_t *page = ft2->pages;
+  uint8_t *mem;
+
+  size = (size + 7) & ~(size_t)7;
+  if (!page || (page->total - page->used < size)) {
+    size_t total = size > OSD_GLYPH_PAGE_SIZE ? size : OSD_GLYPH_PAGE_SIZE;
+    if (ft2->cache_bytes + total > OSD_GLYPH_CACHE_MAX)
+      osd_ft2_flush_glyphs (ft2);
+    page = malloc (sizeof (*page) + total);
+    if (!page)
+      return NULL;
+    page->next = ft2->pages;
+    page->used = 0;
+    page->total = total;
+    ft2->pages = page;
+    ft2->cache_bytes += total;
+  }
+  mem = (uint8_t *)(page + 1) + page->used;
+  page->used += size;
+  return mem;
+}
+
+/* get a rendered glyph from the cache, or load it there.
+ * Glyphs that fail to load are cached empty. */
+static const osd_glyph_t *osd_ft2_get_glyph (osd_object_t *osd, uint16_t unicode) {
+  osd_ft2context_t *ft2 = osd->ft2;
+  FT_GlyphSlot slot = ft2->face->glyph;
+  osd_glyph_t *glyph, **bucket = &ft2->glyphs[(unicode ^ (ft2->size << 4)) & (OSD_GLYPH_HASH_SIZE - 1)];
+  FT_UInt index;
+  int ok, width = 0, rows = 0;
+
+  for (glyph = *bucket; glyph; glyph = glyph->next) {
+    if ((glyph->unicode == unicode) && (glyph->size == ft2->size))
+      return glyph;
+  }
+
+  index = FT_Get_Char_Index (ft2->face, unicode);
+  ok = !FT_Load_Glyph (ft2->face, index, FT_LOAD_FLAGS);
+  if (!ok) {
+    xprintf (osd->renderer->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph %u\n"), (unsigned int)index);
+  } else {
+    if (slot->format != ft_glyph_format_bitmap) {
+      if (FT_Render_Glyph (slot, ft_render_mode_normal))
+        xprintf (osd->renderer->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering glyph\n"));
+    }
+    width = slot->bitmap.width;
+    rows = slot->bitmap.rows;
+  }
+
+  glyph = osd_ft2_glyph_alloc (ft2, sizeof (*glyph) + width * rows);
+  if (!glyph)
+    return NULL;
+  /* the allocation may have flushed the cache. */
+  bucket = &ft2->glyphs[(unicode ^ (ft2->size << 4)) & (OSD_GLYPH_HASH_SIZE - 1)];
+
+  glyph->index   = index;
+  glyph->unicode = unicode;
+  glyph->size    = ft2->size;
+  glyph->width   = width;
+  glyph->rows    = rows;
+  glyph->bmp     = (const uint8_t *)(glyph + 1);
+  if (ok) {
+    uint8_t *d = (uint8_t *)(glyph + 1);
+    const uint8_t *s = slot->bitmap.buffer;
+    int y;
+    glyph->left    = slot->bitmap_left;
+    glyph->top     = slot->bitmap_top;
+    glyph->advance = slot->advance.x / 64;
+    for (y = 0; y < rows; y++) {
+      if (slot->bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+        int x;
+        for (x = 0; x < width; x++)
+          d[x] = (s[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
+      } else {
+        memcpy (d, s, width);
+      }
+      s += slot->bitmap.pitch;
+      d += width;
+    }
+  } else {
+    glyph->left    = 0;
+    glyph->top     = 0;
+    glyph->advance = 0;
+  }
+
+  glyph->next = *bucket;
+  *bucket = glyph;
+  return glyph;
+}
+
 static void osd_free_ft2 (osd_object_t *osd)
 {
   if( osd->ft2 ) {
+    osd_ft2_flush_glyphs (osd->ft2);
+    _x_freep (&osd->ft2->fontname);
     if ( osd->ft2->face )
       FT_Done_Face (osd->ft2->face);
     if ( osd->ft2->library )
@@ -1209,6 +1347,18 @@ static int osd_set_font_freetype2( osd_object_t *osd, const char *fontname, int
     }
   }
 
+  /* same font again, just set the size. */
+  if (osd->ft2->face && osd->ft2->fontname && !strcmp (osd->ft2->fontname, fontname)) {
+    if (size == osd->ft2->size)
+      return 1;
+    if (!FT_Set_Pixel_Sizes (osd->ft2->face, 0, size)) {
+      osd->ft2->size = size;
+      return 1;
+    }
+  }
+
+  osd_ft2_flush_glyphs (osd->ft2);
+  _x_freep (&osd->ft2->fontname);
   if (osd->ft2->face) {
       FT_Done_Face (osd->ft2->face);
       osd->ft2->face = NULL;
@@ -1253,6 +1403,7 @@ static int osd_set_font_freetype2( osd_object_t *osd, const char *fontname, int
   }
 
   osd->ft2->size = size;
+  osd->ft2->fontname = strdup (fontname);
   return 1;
 }
 #endif
@@ -1318,6 +1469,54 @@ static int osd_search(osd_fontchar_t *array, size_t n, uint16_t code) {
 
 
 #ifdef HAVE_ICONV
+/* UTF-8 does not need iconv. It is marked by an encoding without a
+ * conversion descriptor. */
+static int osd_is_utf8 (const char *encoding) {
+  return !strcasecmp (encoding, "UTF-8") || !strcasecmp (encoding, "UTF8");
+}
+
+/*
+ * decode one UTF-8 character. Like iconv, a bad sequence skips one byte,
+ * and characters wider than 16 bits are not supported.
+ */
+static uint16_t osd_utf8_getunicode (xine_t *xine, const char **inbuf, size_t *inbytesleft) {
+  const uint8_t *p = (const uint8_t *)*inbuf;
+  uint32_t v = p[0];
+  size_t n, i;
+
+  if (v < 0x80) {
+    (*inbuf)++;
+    (*inbytesleft)--;
+    return v;
+  }
+  if ((v & 0xe0) == 0xc0)
+    n = 2, v &= 0x1f;
+  else if ((v & 0xf0) == 0xe0)
+    n = 3, v &= 0x0f;
+  else if ((v & 0xf8) == 0xf0)
+    n = 4, v &= 0x07;
+  else
+    n = 0;
+  if (n && (n <= *inbytesleft)) {
+    for (i = 1; i < n; i++) {
+      if ((p[i] & 0xc0) != 0x80)
+        break;
+      v = (v << 6) | (p[i] & 0x3f);
+    }
+    /* no overlong forms and surrogates */
+    if ((i == n) && (v >= (n == 2 ? 0x80u : n == 3 ? 0x800u : 0x10000u)) && ((v & 0xfffff800) != 0xd800) && (v < 0x10000)) {
+      *inbuf += n;
+      *inbytesleft -= n;
+      return v;
+    }
+  }
+  xprintf (xine, XINE_VERBOSITY_LOG,
+    _("osd: unknown sequence starting with byte 0x%02X in encoding \"%s\", skipping\n"), p[0], "UTF-8");
+  (*inbuf)++;
+  (*inbytesleft)--;
+  return ALIAS_CHARACTER_CONV;
+}
+
 /*
  * get next unicode value
  */
@@ -1343,6 +1542,8 @@ static uint16_t osd_iconv_getunicode(xine_t *xine,
       }
       return ALIAS_CHARACTER_CONV;
     }
+  } else if (encoding) {
+    return osd_utf8_getunicode (xine, (const char **)inbuf, inbytesleft);
   } else {
     /* direct mapping without iconv */
     unicode = (unsigned char)(*inbuf)[0];
@@ -1354,6 +1555,19 @@ static uint16_t osd_iconv_getunicode(xine_t *xine,
 }
 #endif
 
+/* get next unicode value in current encoding */
+static uint16_t osd_getunicode (osd_object_t *osd, const char **inbuf, size_t *inbytesleft) {
+#ifdef HAVE_ICONV
+  return osd_iconv_getunicode (osd->renderer->stream->xine, osd->cd, osd->encoding,
+    (ICONV_CONST char **)inbuf, inbytesleft);
+#else
+  uint16_t unicode = (unsigned char)(*inbuf)[0];
+  (*inbuf)++;
+  (*inbytesleft)--;
+  return unicode;
+#endif
+}
+
 
 /*
  * free iconv encoding
@@ -1379,14 +1593,16 @@ static int osd_set_encoding (osd_object_t *osd, const char *encoding) {
 #ifdef HAVE_ICONV
   char *enc;
 
-  osd_free_encoding(osd);
-
   lprintf("osd=%p, encoding=%s\n", (void*)osd, encoding ? (encoding[0] ? encoding : "locale") : "no conversion");
   /* no conversion, use latin1 */
-  if (!encoding) return 1;
+  if (!encoding) {
+    osd_free_encoding (osd);
+    return 1;
+  }
   /* get encoding from system */
   if (!encoding[0]) {
     if ((enc = xine_get_system_encoding()) == NULL) {
+      osd_free_encoding (osd);
       xprintf(osd->renderer->stream->xine, XINE_VERBOSITY_LOG,
 	      _("osd: can't find out current locale character set\n"));
       return 0;
@@ -1394,6 +1610,22 @@ static int osd_set_encoding (osd_object_t *osd, const char *encoding) {
     lprintf("locale encoding='%s'\n", enc);
   } else
     enc = strdup(encoding);
+  if (!enc) {
+    osd_free_encoding (osd);
+    return 0;
+  }
+
+  /* subtitle decoders set the encoding for every text, keep it when unchanged. */
+  if (osd->encoding && !strcmp (osd->encoding, enc)) {
+    free (enc);
+    return 1;
+  }
+  osd_free_encoding (osd);
+
+  if (osd_is_utf8 (enc)) {
+    osd->encoding = enc;
+    return 1;
+  }
 
   /* prepare conversion to UCS-2 */
   if ((osd->cd = iconv_open(UCS2_ENCODING, enc)) == (iconv_t)-1) {
@@ -1458,15 +1690,8 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
       ctab[i] = i / 25 + color_base;
 
     while (inbytesleft) {
-      FT_GlyphSlot slot;
-#ifdef HAVE_ICONV
-      unicode = osd_iconv_getunicode (this->stream->xine, osd->cd, osd->encoding,
-        (ICONV_CONST char **)&inbuf, &inbytesleft);
-#else
-      unicode = inbuf[0];
-      inbuf++;
-      inbytesleft--;
-#endif
+      const osd_glyph_t *glyph;
+      unicode = osd_getunicode (osd, &inbuf, &inbytesleft);
       if (unicode == '\n') {
         y1 += osd->ft2->face->size->metrics.height / 64;
         if (!first)
@@ -1483,45 +1708,36 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
       if (x1 >= osd->width)
         continue;
 
-      slot = osd->ft2->face->glyph;
-      i = FT_Get_Char_Index (osd->ft2->face, unicode);
+      glyph = osd_ft2_get_glyph (osd, unicode);
+      if (!glyph)
+        continue;
 
       /* add kerning relative to the previous letter */
-      if (use_kerning && previous && i) {
+      if (use_kerning && previous && glyph->index) {
         FT_Vector delta;
-        FT_Get_Kerning(osd->ft2->face, previous, i, KERNING_DEFAULT, &delta);
+        FT_Get_Kerning(osd->ft2->face, previous, glyph->index, KERNING_DEFAULT, &delta);
         x1 += delta.x / 64;
       }
-      previous = i;
-
-      if (FT_Load_Glyph(osd->ft2->face, i, FT_LOAD_FLAGS)) {
-        xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph\n"));
-        continue;
-      }
-
-      if (slot->format != ft_glyph_format_bitmap) {
-        if (FT_Render_Glyph(slot, ft_render_mode_normal))
-          xprintf(this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering glyph\n"));
-      }
+      previous = glyph->index;
 
       /* if the first letter has a bearing not on the basepoint, shift the
        * whole output to be sure that we are inside the bounding box
        */
-      if (first) x1 -= slot->bitmap_left;
+      if (first) x1 -= glyph->left;
       first = 0;
 
       {
-        const uint8_t *s = (const uint8_t *)slot->bitmap.buffer;
-        uint8_t *d = osd->area + x1 + slot->bitmap_left;
-        int y, yt, lines = slot->bitmap.rows, cols = slot->bitmap.width;
-        size_t pads = slot->bitmap.pitch - cols;
+        const uint8_t *s = glyph->bmp;
+        uint8_t *d = osd->area + x1 + glyph->left;
+        int y, yt, lines = glyph->rows, cols = glyph->width;
+        size_t pads = 0;
         size_t padd = osd->width - cols;
         /* we shift the whole glyph down by it's ascender so that the specified
          * coordinate is the top left corner which is much more practical than
          * the baseline as the user normally has no idea where the baseline is */
-        yt = osd->ft2->face->size->metrics.ascender / 64 - slot->bitmap_top;
+        yt = osd->ft2->face->size->metrics.ascender / 64 - glyph->top;
         if (yt < 0) { /* paranoia? */
-          s -= yt * slot->bitmap.pitch;
+          s -= yt * glyph->width;
           lines += yt;
           yt = 0;
         }
@@ -1529,7 +1745,7 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
         d += yt * osd->width;
         /* clip top (XXX: is this at all possible?) */
         if (yt < 0) {
-          s -= yt * slot->bitmap.pitch;
+          s -= yt * glyph->width;
           d -= yt * osd->width;
           lines += yt;
         }
@@ -1566,7 +1782,7 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
           d += padd;
         }
       }
-      x1 += slot->advance.x / 64;
+      x1 += glyph->advance;
       if (x1 >= osd->width)
         break;
     }
@@ -1590,14 +1806,7 @@ static int osd_render_text (osd_object_t *osd, int x1, int y1,
       return 0;
     }
     while (inbytesleft) {
-#ifdef HAVE_ICONV
-      unicode = osd_iconv_getunicode (this->stream->xine, osd->cd, osd->encoding,
-        (ICONV_CONST char **)&inbuf, &inbytesleft);
-#else
-      unicode = inbuf[0];
-      inbuf++;
-      inbytesleft--;
-#endif
+      unicode = osd_getunicode (osd, &inbuf, &inbytesleft);
       if (unicode == '\n') {
         y1 += font->size;
         if (lineheight)
@@ -1706,75 +1915,58 @@ static int osd_get_text_size(osd_object_t *osd, const char *text, int *width, in
     /* not all free type fonts provide kerning */
     FT_Bool use_kerning = FT_HAS_KERNING (osd->ft2->face);
     FT_UInt previous = 0;
-    int first_glyph = 1;
+    const osd_glyph_t *last = NULL;
     while (inbytesleft) {
-      FT_GlyphSlot slot;
-#ifdef HAVE_ICONV
-      unicode = osd_iconv_getunicode (this->stream->xine, osd->cd, osd->encoding,
-        (ICONV_CONST char **)&inbuf, &inbytesleft);
-#else
-      unicode = inbuf[0];
-      inbuf++;
-      inbytesleft--;
-#endif
+      const osd_glyph_t *glyph;
+      unicode = osd_getunicode (osd, &inbuf, &inbytesleft);
       if (unicode == '\n') {
         y1 += osd->ft2->face->size->metrics.height / 64;
         /* see last char comment below */
-        if (!first_glyph) {
+        if (last) {
           *height = y1;
-          if (osd->ft2->face->glyph->bitmap.width)
-            linewidth -= osd->ft2->face->glyph->advance.x / 64;
-          linewidth += osd->ft2->face->glyph->bitmap.width;
-          linewidth += osd->ft2->face->glyph->bitmap_left;
+          if (last->width)
+            linewidth -= last->advance;
+          linewidth += last->width;
+          linewidth += last->left;
         }
         if (*width < linewidth)
           *width = linewidth;
         linewidth = 0;
         previous = 0;
-        first_glyph = 1;
+        last = NULL;
         continue;
       }
-      slot = osd->ft2->face->glyph;
-      i = FT_Get_Char_Index (osd->ft2->face, unicode);
+      glyph = osd_ft2_get_glyph (osd, unicode);
+      if (!glyph)
+        continue;
       /* kerning add the relative to the previous letter */
-      if (use_kerning && previous && i) {
+      if (use_kerning && previous && glyph->index) {
         FT_Vector delta;
-        FT_Get_Kerning (osd->ft2->face, previous, i, KERNING_DEFAULT, &delta);
+        FT_Get_Kerning (osd->ft2->face, previous, glyph->index, KERNING_DEFAULT, &delta);
         linewidth += delta.x / 64;
       }
-      previous = i;
-      if (FT_Load_Glyph (osd->ft2->face, i, FT_LOAD_DEFAULT | FT_LOAD_NO_HINTING)) {
-        xprintf (this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error loading glyph %i\n"), i);
-        text++;
-        continue;
-      }
-      if (slot->format != ft_glyph_format_bitmap) {
-        if (FT_Render_Glyph(osd->ft2->face->glyph, ft_render_mode_normal))
-          xprintf (this->stream->xine, XINE_VERBOSITY_LOG, _("osd: error in rendering\n"));
-      }
+      previous = glyph->index;
       /* left shows the left edge relative to the base point. A positive value means the
        * letter is shifted right, so we need to subtract the value from the width
        */
-      if (first_glyph) linewidth -= slot->bitmap_left;
-      first_glyph = 0;
-      linewidth += slot->advance.x / 64;
-      text++;
+      if (!last) linewidth -= glyph->left;
+      last = glyph;
+      linewidth += glyph->advance;
     }
     y1 += osd->ft2->face->size->metrics.height / 64;
     /* if we have a true type font we need to do some corrections for the last
-     * letter. As this one is still in the gylph slot we can still work with
-     * it. For the last letter be must not use advance and width but the real
+     * letter. For the last letter be must not use advance and width but the real
      * width of the bitmap. We're right from the base point so we subtract the
      * advance value that was added in the for-loop and add the width. We have
      * to also add the left bearing because the letter might be shifted left or
      * right and then the right edge is also shifted
      */
-    if (!first_glyph) {
+    if (last) {
       *height = y1;
-      if (osd->ft2->face->glyph->bitmap.width)
-        linewidth -= osd->ft2->face->glyph->advance.x / 64;
-      linewidth += osd->ft2->face->glyph->bitmap.width;
-      linewidth += osd->ft2->face->glyph->bitmap_left;
+      if (last->width)
+        linewidth -= last->advance;
+      linewidth += last->width;
+      linewidth += last->left;
     }
     if (*width < linewidth)
       *width = linewidth;
@@ -1790,14 +1982,7 @@ static int osd_get_text_size(osd_object_t *osd, const char *text, int *width, in
       return 0;
     }
     while (inbytesleft) {
-#ifdef HAVE_ICONV
-      unicode = osd_iconv_getunicode (this->stream->xine, osd->cd, osd->encoding,
-        (ICONV_CONST char **)&inbuf, &inbytesleft);
-#else
-      unicode = inbuf[0];
-      inbuf++;
-      inbytesleft--;
-#endif
+      unicode = osd_getunicode (osd, &inbuf, &inbytesleft);
       if (unicode == '\n') {
         y1 += font->size;
         if (lineheight)
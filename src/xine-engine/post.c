@@ -837,7 +837,7 @@ void _x_post_intercept_overlay_manager(video_overlay_manager_t *original, post_v
 
 
 /* dummy intercept functions that just pass the call on to the original port */
-static uint32_t post_audio_get_capabilities(xine_audio_port_t *port_gen) {
+static uint32_t post_audio_get_capabilities_float (xine_audio_port_t *port_gen) {
   post_audio_port_t *port = (post_audio_port_t *)port_gen;
   uint32_t caps;
 
@@ -847,6 +847,16 @@ static uint32_t post_audio_get_capabilities(xine_audio_port_t *port_gen) {
   return caps;
 }
 
+uint32_t _x_post_audio_get_capabilities_float (xine_audio_port_t *port_gen) {
+  return post_audio_get_capabilities_float (port_gen);
+}
+
+/* audio out always takes float now. dont send it to plugins that never
+ * asked for it. */
+static uint32_t post_audio_get_capabilities (xine_audio_port_t *port_gen) {
+  return post_audio_get_capabilities_float (port_gen) & ~AO_CAP_FLOAT32;
+}
+
 static int post_audio_get_property(xine_audio_port_t *port_gen, int property) {
   post_audio_port_t *port = (post_audio_port_t *)port_gen;
   int prop;
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2000-2009 the xine project
+ * Copyright (C) 2000-2020 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -359,3 +359,79 @@ void _x_audio_out_resample_stereotomono(int16_t* input_samples,
     *output_samples++ = os;
   }
 }
+
+void _x_audio_out_resample_float(float *last_sample, const float *input_samples, uint32_t in_frames,
+                                 float *output_samples, uint32_t out_frames, int channels)
+{
+  unsigned int osample;
+  int c;
+  /* 16+16 fixed point position, same stepping as the int16 versions. */
+  uint32_t isample = 0xFFFF0000U;
+  uint32_t istep = (in_frames << 16) / out_frames + 1;
+
+  for (osample = 0; osample < out_frames && isample >= 0xFFFF0000U; osample++) {
+    float t = (float)(isample & 0xffff) * (1.0f / 65536.0f);
+    for (c = 0; c < channels; c++)
+      output_samples[c] = last_sample[c] + (input_samples[c] - last_sample[c]) * t;
+    output_samples += channels;
+    isample += istep;
+  }
+
+  for (; osample < out_frames; osample++) {
+    const float *s1 = input_samples + (isample >> 16) * channels;
+    float t = (float)(isample & 0xffff) * (1.0f / 65536.0f);
+    for (c = 0; c < channels; c++)
+      output_samples[c] = s1[c] + (s1[c + channels] - s1[c]) * t;
+    output_samples += channels;
+    isample += istep;
+  }
+  memcpy (last_sample, &input_samples[(in_frames - 1) * channels], channels * sizeof (last_sample[0]));
+}
+
+void _x_audio_out_resample_16tofloat(const int16_t *input_samples,
+                                     float *output_samples, uint32_t samples)
+{
+  while (samples--)
+    *output_samples++ = (float)(*input_samples++) * (1.0f / 32768.0f);
+}
+
+void _x_audio_out_resample_floatto16(const float *input_samples,
+                                     int16_t *output_samples, uint32_t samples)
+{
+  while (samples--) {
+    float v = *input_samples++ * 32768.0f;
+    if (v >= 32767.0f)
+      *output_samples++ = 32767;
+    else if (v <= -32768.0f)
+      *output_samples++ = -32768;
+    else
+      /* round to nearest without libm. */
+      *output_samples++ = (int)(v + 32768.5f) - 32768;
+  }
+}
+
+void _x_audio_out_resample_s32tofloat(const int32_t *input_samples,
+                                      float *output_samples, uint32_t samples)
+{
+  while (samples--)
+    *output_samples++ = (float)(*input_samples++) * (1.0f / 2147483648.0f);
+}
+
+void _x_audio_out_resample_monotostereo_float(const float *input_samples,
+                                              float *output_samples, uint32_t frames)
+{
+  while (frames--) {
+    float os = *input_samples++;
+    *output_samples++ = os;
+    *output_samples++ = os;
+  }
+}
+
+void _x_audio_out_resample_stereotomono_float(const float *input_samples,
+                                              float *output_samples, uint32_t frames)
+{
+  while (frames--) {
+    *output_samples++ = (input_samples[0] + input_samples[1]) * 0.5f;
+    input_samples += 2;
+  }
+}
@@ -28,6 +28,7 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 #include <sys/time.h>
 
 #define LOG_MODULE "video_decoder"
@@ -75,6 +76,9 @@ int _x_spu_decoder_sleep (xine_stream_t *s, int64_t next_spu_vpts) {
 
   if (!stream)
     return 0;
+  /* never sleep on a decoder pool worker. */
+  if (stream->side_streams[0]->video_decoder_job)
+    return 0;
 
   /* we wait until one second before the next SPU is due */
   next_spu_vpts -= 90000;
@@ -110,312 +114,528 @@ int _x_spu_decoder_sleep (xine_stream_t *s, int64_t next_spu_vpts) {
   return thread_vacant;
 }
 
-static void *video_decoder_loop (void *stream_gen) {
-
-  xine_stream_private_t *stream = (xine_stream_private_t *)stream_gen;
-  xine_private_t *xine = (xine_private_t *)stream->s.xine;
-  xine_ticket_t   *running_ticket = xine->port_ticket;
-  int              running = 1;
-  int              restart = 1;
-  int              streamtype;
-  int              prof_video_decode = -1;
-  int              prof_spu_decode = -1;
-  uint32_t         buftype_unknown = 0;
-  /* generic bitrate estimation. */
-  int64_t          video_br_lasttime = 0;
-  uint32_t         video_br_lastsize = 0;
-  uint32_t         video_br_time     = 1;
-  uint32_t         video_br_bytes    = 0;
-  int              video_br_num      = 20;
-  int              video_br_value    = 0;
-  /* list of seen spu channels, sorted by number.
-   * spu_track_map[foo] & 0xff000000 is always BUF_SPU_BASE,
-   * and bit 31 may serve as an end marker. */
+/* list of seen spu channels, sorted by number.
+ * spu_track_map[foo] & 0xff000000 is always BUF_SPU_BASE,
+ * and bit 31 may serve as an end marker. */
 #define SPU_TRACK_MAP_MAX 50
 #define SPU_TRACK_MAP_MASK 0x8000ffff
 #define SPU_TRACK_MAP_END 0x80000000
-  uint32_t         spu_track_map[SPU_TRACK_MAP_MAX + 1];
 #define BUFTYPE_BASE(type) ((type) >> 24)
 #define BUFTYPE_SUB(type)  (((type) & 0x00ff0000) >> 16)
 
-#ifndef WIN32
-  errno = 0;
-  if (nice(-1) == -1 && errno)
-    xine_log (stream->s.xine, XINE_LOG_MSG, "video_decoder: can't raise nice priority by 1: %s\n", strerror(errno));
-#endif /* WIN32 */
+/* early frame drop: when decoding falls behind, skip frames before they are
+ * decoded. level 1 drops the ones marked BUF_FLAG_DISPOSABLE, level 2 all
+ * but keyframes. the level is set once per DROP_WINDOW frames from the decode
+ * time vs. the real time those frames cover, and the video out queue depth.
+ * after level 2 dropped a reference frame, the frames up to the next keyframe
+ * are dropped at any level, they would decode to garbage anyway. */
+#define DROP_WINDOW    16
+/* % of real time spent decoding, with the output queue running dry. */
+#define DROP_HIGH      90
+/* % we expect to spend at the next lower level. */
+#define DROP_LOW       70
+/* dont rely on keyframes that did not show up for so many frames. */
+#define DROP_MAX_GOP  600
+
+/* decoder state, owned by either video_decoder_loop () or a decoder pool worker. */
+typedef struct {
+  xine_decoder_job_t     job;
+  xine_stream_private_t *stream;
+  xine_ticket_t         *running_ticket;
+  int                    restart;
+  /* demuxer marks keyframes, so we can filter for XINE_PARAM_KEYFRAMES_ONLY. */
+  int                    keyframes_seen;
+  /* BUF_CONTROL_END is waiting for video out (1) or the audio decoder (2). */
+  int                    end_wait;
+  /* discontinuity is waiting for the audio decoder. */
+  int                    disc_wait;
+  uint32_t               buftype_unknown;
+  /* generic bitrate estimation. */
+  int64_t                video_br_lasttime;
+  uint32_t               video_br_lastsize;
+  uint32_t               video_br_time;
+  uint32_t               video_br_bytes;
+  int                    video_br_num;
+  int                    video_br_value;
+  /* early frame drop, see DROP_WINDOW. */
+  int                    drop_enable;
+  int                    drop_level;
+  int                    drop_calm;       /* windows in a row we could do with less */
+  int                    drop_calm_need;  /* grows when a lower level did not hold */
+  int                    drop_age;        /* windows since last level down */
+  int                    drop_since_key;
+  int                    drop_need_key;   /* a reference frame was dropped */
+  uint32_t               drop_flags;      /* of the current frame so far */
+  int                    drop_decoded;    /* current frame reached the decoder */
+  int                    drop_skip;       /* current frame is dropped, -1 = not decided yet */
+  int                    drop_frames, drop_used, drop_key, drop_ref;
+  int                    drop_depth;
+  int64_t                drop_busy;       /* ns */
+  uint32_t               spu_track_map[SPU_TRACK_MAP_MAX + 1];
+} video_decoder_state_t;
+
+/* thread cpu time does not count waiting for a free frame. */
+static int64_t video_decoder_time (void) {
+  struct timespec ts = {0, 0};
+#if defined(HAVE_POSIX_TIMERS) && defined(CLOCK_THREAD_CPUTIME_ID)
+  if (!clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts))
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+  xine_gettime (&ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
 
-  if (prof_video_decode == -1)
-    prof_video_decode = xine_profiler_allocate_slot ("video decoder");
-  if (prof_spu_decode == -1)
-    prof_spu_decode = xine_profiler_allocate_slot ("spu decoder");
+static void video_decoder_drop_window (video_decoder_state_t *vd) {
+  vd->drop_frames = 0;
+  vd->drop_used   = 0;
+  vd->drop_key    = 0;
+  vd->drop_ref    = 0;
+  vd->drop_depth  = 1 << 30;
+  vd->drop_busy   = 0;
+}
 
-  spu_track_map[0] = SPU_TRACK_MAP_END;
+static void video_decoder_drop_set (video_decoder_state_t *vd, int level) {
+  xine_stream_private_t *stream = vd->stream;
 
-  running_ticket->acquire (running_ticket, 0);
+  if (level == vd->drop_level)
+    return;
+  xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+    "video_decoder: early frame drop level %d -> %d.\n", vd->drop_level, level);
+  vd->drop_level = level;
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_VIDEO_DROP_LEVEL, level);
+}
 
-  while (running) {
-    int handled, ignore;
-    buf_element_t *buf;
+static void video_decoder_drop_reset (video_decoder_state_t *vd) {
+  video_decoder_drop_set (vd, 0);
+  vd->drop_calm      = 0;
+  vd->drop_calm_need = 4;
+  vd->drop_age       = 0;
+  vd->drop_since_key = DROP_MAX_GOP;
+  vd->drop_need_key  = 0;
+  vd->drop_flags     = 0;
+  vd->drop_decoded   = 0;
+  vd->drop_skip      = -1;
+  video_decoder_drop_window (vd);
+}
 
-    lprintf ("getting buffer...\n");
+/* a frame has been decoded, or dropped. */
+static void video_decoder_drop_frame (video_decoder_state_t *vd) {
+  xine_stream_private_t *stream = vd->stream;
+  int64_t span, load;
+  int duration, depth, max_level, level;
 
-    buf = stream->s.video_fifo->tget (stream->s.video_fifo, running_ticket);
+  if (vd->drop_flags & BUF_FLAG_KEYFRAME) {
+    vd->drop_key++;
+    vd->drop_since_key = 0;
+    vd->drop_need_key = 0;
+  } else {
+    if (!(vd->drop_flags & BUF_FLAG_DISPOSABLE)) {
+      vd->drop_ref++;
+      if (vd->drop_skip > 0)
+        vd->drop_need_key = 1;
+    }
+    if (vd->drop_since_key < DROP_MAX_GOP)
+      vd->drop_since_key++;
+  }
+  vd->drop_used += vd->drop_decoded;
+  vd->drop_flags = 0;
+  vd->drop_decoded = 0;
+  vd->drop_skip = -1;
+  depth = stream->s.video_out->get_property (stream->s.video_out, VO_PROP_BUFS_IN_FIFO);
+  if ((depth >= 0) && (depth < vd->drop_depth))
+    vd->drop_depth = depth;
+  if ((++vd->drop_frames < DROP_WINDOW) || (vd->drop_used < 2))
+    return;
 
-    _x_extra_info_merge( stream->video_decoder_extra_info, buf->extra_info );
-    stream->video_decoder_extra_info->seek_count = stream->video_seek_count;
+  duration = _x_stream_info_get (&stream->s, XINE_STREAM_INFO_FRAME_DURATION);
+  if (duration <= 0) {
+    video_decoder_drop_window (vd);
+    return;
+  }
+  span = (int64_t)vd->drop_frames * duration * 100000 / 9;
+  load = vd->drop_busy * 100 / span;
+  max_level = (vd->drop_since_key < DROP_MAX_GOP) ? 2 : 1;
+  level = vd->drop_level;
+  vd->drop_age++;
+
+  if ((load >= DROP_HIGH) && (vd->drop_depth <= 2)) {
+    if (level < max_level) {
+      level++;
+      /* we just came from here. stay longer next time. */
+      if ((vd->drop_age <= 2) && (vd->drop_calm_need < 64))
+        vd->drop_calm_need <<= 1;
+    }
+    vd->drop_calm = 0;
+  } else if (level > 0) {
+    /* what the frames dropped now would cost. */
+    int n = (level == 1) ? vd->drop_frames : vd->drop_key + vd->drop_ref;
+    if (vd->drop_busy * n / vd->drop_used * 100 / span < DROP_LOW) {
+      if (++vd->drop_calm >= vd->drop_calm_need) {
+        level--;
+        vd->drop_calm = 0;
+        vd->drop_age = 0;
+      }
+    } else {
+      vd->drop_calm = 0;
+    }
+  }
+  if (level > max_level)
+    level = max_level;
+  video_decoder_drop_set (vd, level);
+  video_decoder_drop_window (vd);
+}
 
-    lprintf ("got buffer 0x%08x\n", buf->type);
+static void video_decoder_state_init (video_decoder_state_t *vd, xine_stream_private_t *stream) {
+  xine_private_t *xine = (xine_private_t *)stream->s.xine;
 
-    switch (BUFTYPE_BASE (buf->type)) {
+  vd->job.fifo          = stream->s.video_fifo;
+  vd->stream            = stream;
+  vd->running_ticket    = xine->port_ticket;
+  vd->restart           = 1;
+  vd->keyframes_seen    = 0;
+  vd->end_wait          = 0;
+  vd->disc_wait         = 0;
+  vd->buftype_unknown   = 0;
+  vd->video_br_lasttime = 0;
+  vd->video_br_lastsize = 0;
+  vd->video_br_time     = 1;
+  vd->video_br_bytes    = 0;
+  vd->video_br_num      = 20;
+  vd->video_br_value    = 0;
+  vd->drop_level        = 0;
+  video_decoder_drop_reset (vd);
+  vd->spu_track_map[0]  = SPU_TRACK_MAP_END;
+
+  vd->drop_enable = xine->x.config->register_bool (xine->x.config,
+    "engine.decoder.early_frame_drop", 1,
+    _("skip frames before decoding when the CPU is too slow"),
+    _("When video decoding cannot keep up, skip frames that nothing else depends on, "
+      "and if that is not enough, all but keyframes, before they are decoded. "
+      "Otherwise, frames are decoded first, and then thrown away because they are late."),
+    20, NULL, NULL);
+}
 
-      case BUFTYPE_BASE (BUF_VIDEO_BASE):
+/* handle 1 buf, and free it unless XINE_DECODER_STEP_WAIT. */
+static int video_decoder_step (xine_decoder_job_t *job, buf_element_t *buf) {
+  video_decoder_state_t *vd = (video_decoder_state_t *)job;
+  xine_stream_private_t *stream = vd->stream;
+  xine_ticket_t *running_ticket = vd->running_ticket;
+  int handled, ignore, keyframes_only, streamtype;
+  int ret = XINE_DECODER_STEP_OK;
+
+  if (vd->disc_wait) {
+    if (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 1)
+      return XINE_DECODER_STEP_WAIT;
+    vd->disc_wait = 0;
+    buf->free_buffer (buf);
+    return ret;
+  }
 
-        if ((buf->type & 0xffff0000) == BUF_VIDEO_UNKNOWN)
-          break;
-        xine_rwlock_rdlock (&stream->info_lock);
-        handled = stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED];
-        ignore  = stream->stream_info[XINE_STREAM_INFO_IGNORE_VIDEO];
-        xine_rwlock_unlock (&stream->info_lock);
-        (void)handled; /* dont optimize away the read. */
-        if (ignore)
-          break;
+  _x_extra_info_merge( stream->video_decoder_extra_info, buf->extra_info );
+  stream->video_decoder_extra_info->seek_count = stream->video_seek_count;
 
-        /* at first frame contents after start or seek, read first_frame_flag.
-         * this way, video_port.draw () need not grab lock for _every_ frame. */
-        if (restart) {
-          /* a 4 byte buf may be a generated sequence end code from mpeg-ts. */
-          if (!(buf->decoder_flags & (BUF_FLAG_PREVIEW | BUF_FLAG_HEADER)) && (buf->size != 4)) {
-            int first_frame_flag;
-            restart = 0;
-            pthread_mutex_lock (&stream->first_frame.lock);
-            first_frame_flag = stream->first_frame.flag;
-            pthread_mutex_unlock (&stream->first_frame.lock);
-            /* use first_frame_flag here, so gcc does not optimize it away. */
-            xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
-              "video_decoder: first_frame_flag = %d.\n", first_frame_flag);
-          }
-        }
+  lprintf ("got buffer 0x%08x\n", buf->type);
+
+  switch (BUFTYPE_BASE (buf->type)) {
 
-        xine_profiler_start_count (prof_video_decode);
+    case BUFTYPE_BASE (BUF_VIDEO_BASE):
 
-        /* running_ticket->acquire(running_ticket, 0); */
-        /* printf ("video_decoder: got package %d, decoder_info[0]:%d\n", buf, buf->decoder_info[0]); */
+      if ((buf->type & 0xffff0000) == BUF_VIDEO_UNKNOWN)
+        break;
+      xine_rwlock_rdlock (&stream->info_lock);
+      handled = stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED];
+      ignore  = stream->stream_info[XINE_STREAM_INFO_IGNORE_VIDEO];
+      keyframes_only = stream->stream_info[XINE_STREAM_INFO_KEYFRAMES_ONLY];
+      xine_rwlock_unlock (&stream->info_lock);
+      (void)handled; /* dont optimize away the read. */
+      if (ignore)
+        break;
+      if (buf->decoder_flags & BUF_FLAG_KEYFRAME) {
+        vd->keyframes_seen = 1;
+      } else if (keyframes_only && vd->keyframes_seen
+        && !(buf->decoder_flags & (BUF_FLAG_HEADER | BUF_FLAG_SPECIAL | BUF_FLAG_PREVIEW))) {
+        /* not a reference for anything we are going to decode. */
+        break;
+      }
+      if ((vd->drop_level || vd->drop_need_key)
+        && !(buf->decoder_flags & (BUF_FLAG_HEADER | BUF_FLAG_SPECIAL | BUF_FLAG_PREVIEW))) {
+        /* decide at the first buf of a frame, and stick to that until its end.
+         * after a level down, keep waiting for the keyframe level 2 was missing. */
+        if (vd->drop_skip < 0)
+          vd->drop_skip = (vd->drop_level && (buf->decoder_flags & BUF_FLAG_DISPOSABLE))
+            || (((vd->drop_level >= 2) || vd->drop_need_key) && !(buf->decoder_flags & BUF_FLAG_KEYFRAME)
+              && vd->keyframes_seen && (vd->drop_since_key < DROP_MAX_GOP));
+        if (vd->drop_skip) {
+          vd->drop_flags |= buf->decoder_flags;
+          if (buf->decoder_flags & BUF_FLAG_FRAME_END)
+            video_decoder_drop_frame (vd);
+          break;
+        }
+      }
+
+      /* try not to block a shared thread in video_port.get_frame ().
+       * if it still does, the pool starts a stand in meanwhile. */
+      if (vd->job.pool && stream->video_decoder_plugin) {
+        int free_frames = stream->s.video_out->get_property (stream->s.video_out, VO_PROP_BUFS_FREE);
+        if ((free_frames >= 0) && (free_frames < 2))
+          return XINE_DECODER_STEP_WAIT;
+      }
+
+      /* at first frame contents after start or seek, read first_frame_flag.
+       * this way, video_port.draw () need not grab lock for _every_ frame. */
+      if (vd->restart) {
+        /* a 4 byte buf may be a generated sequence end code from mpeg-ts. */
+        if (!(buf->decoder_flags & (BUF_FLAG_PREVIEW | BUF_FLAG_HEADER)) && (buf->size != 4)) {
+          int first_frame_flag;
+          vd->restart = 0;
+          pthread_mutex_lock (&stream->first_frame.lock);
+          first_frame_flag = stream->first_frame.flag;
+          pthread_mutex_unlock (&stream->first_frame.lock);
+          /* use first_frame_flag here, so gcc does not optimize it away. */
+          xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+            "video_decoder: first_frame_flag = %d.\n", first_frame_flag);
+        }
+      }
 
-        streamtype = (buf->type>>16) & 0xFF;
+      XINE_PROFILER_BEGIN ("video decode");
 
-        if( buf->type != buftype_unknown &&
-            (stream->video_decoder_streamtype != streamtype ||
-            !stream->video_decoder_plugin) ) {
+      /* running_ticket->acquire(running_ticket, 0); */
+      /* printf ("video_decoder: got package %d, decoder_info[0]:%d\n", buf, buf->decoder_info[0]); */
 
-          if (stream->video_decoder_plugin) {
-            _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
-          }
+      streamtype = (buf->type>>16) & 0xFF;
+
+      if( buf->type != vd->buftype_unknown &&
+          (stream->video_decoder_streamtype != streamtype ||
+          !stream->video_decoder_plugin) ) {
 
-          stream->video_decoder_streamtype = streamtype;
-          stream->video_decoder_plugin = _x_get_video_decoder (&stream->s, streamtype);
-
-          /* video_br_reset */
-          video_br_lasttime = 0;
-          video_br_lastsize = 0;
-          video_br_time     = 1; /* No / 0 please. */
-          video_br_bytes    = 0;
-          video_br_num      = 20;
-          video_br_value    = 0;
-  
-          handled = (stream->video_decoder_plugin != NULL);
-          xine_rwlock_wrlock (&stream->info_lock);
-          stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED] = handled;
-          xine_rwlock_unlock (&stream->info_lock);
+        if (stream->video_decoder_plugin) {
+          _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
         }
 
-        /* video_br_add. some decoders reset buf->pts, do this first. */
-        if (buf->pts) {
-          int64_t d = buf->pts - video_br_lasttime;
-          if (d > 0) {
-            if (d < 220000) {
-              video_br_time += d;
-              video_br_bytes += video_br_lastsize;
-              video_br_lastsize = 0;
-              if (--video_br_num < 0) {
-                int br, bdiff;
-                video_br_num = 20;
-                if ((video_br_bytes | video_br_time) & 0x80000000) {
-                  video_br_bytes >>= 1;
-                  video_br_time  >>= 1;
-                }
-                br = xine_uint_mul_div (video_br_bytes, 90000 * 8, video_br_time);
-                bdiff = br - video_br_value;
-                if (bdiff < 0)
-                  bdiff = -bdiff;
-                if (bdiff > (br >> 6)) {
-                  video_br_value = br;
-                  xine_rwlock_wrlock (&stream->info_lock);
-                  stream->stream_info[XINE_STREAM_INFO_VIDEO_BITRATE] = br;
-                  xine_rwlock_unlock (&stream->info_lock);
-                }
+        stream->video_decoder_streamtype = streamtype;
+        stream->video_decoder_plugin = _x_get_video_decoder (&stream->s, streamtype);
+
+        /* video_br_reset */
+        vd->video_br_lasttime = 0;
+        vd->video_br_lastsize = 0;
+        vd->video_br_time     = 1; /* No / 0 please. */
+        vd->video_br_bytes    = 0;
+        vd->video_br_num      = 20;
+        vd->video_br_value    = 0;
+
+        handled = (stream->video_decoder_plugin != NULL);
+        xine_rwlock_wrlock (&stream->info_lock);
+        stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED] = handled;
+        xine_rwlock_unlock (&stream->info_lock);
+      }
+
+      /* video_br_add. some decoders reset buf->pts, do this first. */
+      if (buf->pts) {
+        int64_t d = buf->pts - vd->video_br_lasttime;
+        if (d > 0) {
+          if (d < 220000) {
+            vd->video_br_time += d;
+            vd->video_br_bytes += vd->video_br_lastsize;
+            vd->video_br_lastsize = 0;
+            if (--vd->video_br_num < 0) {
+              int br, bdiff;
+              vd->video_br_num = 20;
+              if ((vd->video_br_bytes | vd->video_br_time) & 0x80000000) {
+                vd->video_br_bytes >>= 1;
+                vd->video_br_time  >>= 1;
+              }
+              br = xine_uint_mul_div (vd->video_br_bytes, 90000 * 8, vd->video_br_time);
+              bdiff = br - vd->video_br_value;
+              if (bdiff < 0)
+                bdiff = -bdiff;
+              if (bdiff > (br >> 6)) {
+                vd->video_br_value = br;
+                xine_rwlock_wrlock (&stream->info_lock);
+                stream->stream_info[XINE_STREAM_INFO_VIDEO_BITRATE] = br;
+                xine_rwlock_unlock (&stream->info_lock);
               }
             }
-            video_br_lasttime = buf->pts;
-          } else {
-            if (d <= -220000)
-              video_br_lasttime = buf->pts;
           }
+          vd->video_br_lasttime = buf->pts;
+        } else {
+          if (d <= -220000)
+            vd->video_br_lasttime = buf->pts;
         }
-        video_br_lastsize += buf->size;
+      }
+      vd->video_br_lastsize += buf->size;
 
+      if (!vd->drop_enable) {
         if (stream->video_decoder_plugin)
           stream->video_decoder_plugin->decode_data (stream->video_decoder_plugin, buf);
+      } else if (!(buf->decoder_flags & (BUF_FLAG_HEADER | BUF_FLAG_SPECIAL | BUF_FLAG_PREVIEW))) {
+        int64_t start = video_decoder_time ();
+        if (stream->video_decoder_plugin)
+          stream->video_decoder_plugin->decode_data (stream->video_decoder_plugin, buf);
+        vd->drop_busy += video_decoder_time () - start;
+        vd->drop_flags |= buf->decoder_flags;
+        vd->drop_decoded = 1;
+        if (buf->decoder_flags & BUF_FLAG_FRAME_END)
+          video_decoder_drop_frame (vd);
+      } else {
+        if (stream->video_decoder_plugin)
+          stream->video_decoder_plugin->decode_data (stream->video_decoder_plugin, buf);
+      }
 
-        /* no need to lock again. it may have been reset from this thread inside
-         * video_decoder_plugin->decode_data (), if at all.
-         * XXX: should we try a different decoder then? */
-        handled = stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED];
-        if (!handled && (buf->type != buftype_unknown)) {
-          const char *vname = _x_buf_video_name (buf->type);
+      /* no need to lock again. it may have been reset from this thread inside
+       * video_decoder_plugin->decode_data (), if at all.
+       * XXX: should we try a different decoder then? */
+      handled = stream->stream_info[XINE_STREAM_INFO_VIDEO_HANDLED];
+      if (!handled && (buf->type != vd->buftype_unknown)) {
+        const char *vname = _x_buf_video_name (buf->type);
 
-          xine_log (stream->s.xine, XINE_LOG_MSG,
-            _("video_decoder: no plugin available to handle '%s'\n"), vname);
+        xine_log (stream->s.xine, XINE_LOG_MSG,
+          _("video_decoder: no plugin available to handle '%s'\n"), vname);
 
-          if (!_x_meta_info_get (&stream->s, XINE_META_INFO_VIDEOCODEC))
+        if (!_x_meta_info_get (&stream->s, XINE_META_INFO_VIDEOCODEC))
 	    _x_meta_info_set_utf8 (&stream->s, XINE_META_INFO_VIDEOCODEC, vname);
 
-          buftype_unknown = buf->type;
+        vd->buftype_unknown = buf->type;
 
-          /* fatal error - dispose plugin */
-          if (stream->video_decoder_plugin) {
-            _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
-            stream->video_decoder_plugin = NULL;
-          }
+        /* fatal error - dispose plugin */
+        if (stream->video_decoder_plugin) {
+          _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
+          stream->video_decoder_plugin = NULL;
         }
+      }
 
-        /* if (running_ticket->ticket_revoked)
-         *   running_ticket->renew(running_ticket, 0);
-         * running_ticket->release(running_ticket, 0);
-         */
+      /* if (running_ticket->ticket_revoked)
+       *   running_ticket->renew(running_ticket, 0);
+       * running_ticket->release(running_ticket, 0);
+       */
 
-        xine_profiler_stop_count (prof_video_decode);
-        break;
+      XINE_PROFILER_END ();
+      break;
 
-      case BUFTYPE_BASE (BUF_SPU_BASE):
+    case BUFTYPE_BASE (BUF_SPU_BASE):
 
-        if (_x_stream_info_get (&stream->s, XINE_STREAM_INFO_IGNORE_SPU))
-          break;
-        xine_profiler_start_count (prof_spu_decode);
-        /* running_ticket->acquire(running_ticket, 0); */
-
-        update_spu_decoder (&stream->s, buf->type);
-
-        /* update track map */
-        {
-          uint32_t chan = buf->type & 0x0000ffff;
-          int i = 0;
-          while ((spu_track_map[i] & SPU_TRACK_MAP_MASK) < chan)
-            i++;
-          if ((spu_track_map[i] & SPU_TRACK_MAP_MASK) != chan) {
-            xine_event_t  ui_event;
-            int j = stream->spu_track_map_entries;
-            if (j >= 50) {
-              xine_profiler_stop_count (prof_spu_decode);
-              break;
-            }
-            while (j >= i) {
-              spu_track_map[j + 1] = spu_track_map[j];
-              j--;
-            }
-            spu_track_map[i] = buf->type;
-            stream->spu_track_map_entries++;
-            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-            ui_event.data_length = 0;
-            xine_event_send (&stream->s, &ui_event);
+      if (_x_stream_info_get (&stream->s, XINE_STREAM_INFO_IGNORE_SPU))
+        break;
+      XINE_PROFILER_BEGIN ("spu decode");
+      /* running_ticket->acquire(running_ticket, 0); */
+
+      update_spu_decoder (&stream->s, buf->type);
+
+      /* update track map */
+      {
+        uint32_t chan = buf->type & 0x0000ffff;
+        int i = 0;
+        while ((vd->spu_track_map[i] & SPU_TRACK_MAP_MASK) < chan)
+          i++;
+        if ((vd->spu_track_map[i] & SPU_TRACK_MAP_MASK) != chan) {
+          xine_event_t  ui_event;
+          int j = stream->spu_track_map_entries;
+          if (j >= 50) {
+            XINE_PROFILER_END ();
+            break;
+          }
+          while (j >= i) {
+            vd->spu_track_map[j + 1] = vd->spu_track_map[j];
+            j--;
           }
+          vd->spu_track_map[i] = buf->type;
+          stream->spu_track_map_entries++;
+          ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+          ui_event.data_length = 0;
+          xine_event_send (&stream->s, &ui_event);
         }
+      }
 
-        if (stream->s.spu_channel_user >= 0) {
-          if (stream->s.spu_channel_user < stream->spu_track_map_entries)
-            stream->s.spu_channel = (spu_track_map[stream->s.spu_channel_user] & 0xFF);
-          else
-            stream->s.spu_channel = stream->s.spu_channel_auto;
-        }
+      if (stream->s.spu_channel_user >= 0) {
+        if (stream->s.spu_channel_user < stream->spu_track_map_entries)
+          stream->s.spu_channel = (vd->spu_track_map[stream->s.spu_channel_user] & 0xFF);
+        else
+          stream->s.spu_channel = stream->s.spu_channel_auto;
+      }
 
-        if (stream->s.spu_decoder_plugin)
-          stream->s.spu_decoder_plugin->decode_data (stream->s.spu_decoder_plugin, buf);
+      if (stream->s.spu_decoder_plugin)
+        stream->s.spu_decoder_plugin->decode_data (stream->s.spu_decoder_plugin, buf);
 
-        /* if (running_ticket->ticket_revoked)
-         *   running_ticket->renew(running_ticket, 0);
-         * running_ticket->release(running_ticket, 0);
-         */
+      /* if (running_ticket->ticket_revoked)
+       *   running_ticket->renew(running_ticket, 0);
+       * running_ticket->release(running_ticket, 0);
+       */
 
-        xine_profiler_stop_count (prof_spu_decode);
-        break;
+      XINE_PROFILER_END ();
+      break;
 
-      case BUFTYPE_BASE (BUF_CONTROL_BASE):
+    case BUFTYPE_BASE (BUF_CONTROL_BASE):
 
-        switch (BUFTYPE_SUB (buf->type)) {
-          int t;
+      switch (BUFTYPE_SUB (buf->type)) {
+        int t;
 
-          case BUFTYPE_SUB (BUF_CONTROL_HEADERS_DONE):
+        case BUFTYPE_SUB (BUF_CONTROL_HEADERS_DONE):
 
-            pthread_mutex_lock (&stream->counter.lock);
-            stream->counter.headers_video++;
-            if (stream->audio_thread_created) {
-              /* avoid useless wakes on an incomplete pair */
-              if (stream->counter.headers_video <= stream->counter.headers_audio)
-                pthread_cond_broadcast (&stream->counter.changed);
-            } else {
+          pthread_mutex_lock (&stream->counter.lock);
+          stream->counter.headers_video++;
+          if (stream->audio_thread_created) {
+            /* avoid useless wakes on an incomplete pair */
+            if (stream->counter.headers_video <= stream->counter.headers_audio)
               pthread_cond_broadcast (&stream->counter.changed);
-            }
-            pthread_mutex_unlock (&stream->counter.lock);
-            restart = 1;
-            break;
+          } else {
+            pthread_cond_broadcast (&stream->counter.changed);
+          }
+          pthread_mutex_unlock (&stream->counter.lock);
+          vd->restart = 1;
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_START):
-            /* decoder dispose might call port functions */
-            /* running_ticket->acquire(running_ticket, 0); */
-            if (stream->video_decoder_plugin) {
-              _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
-              stream->video_decoder_plugin = NULL;
-            }
-            if (stream->s.spu_decoder_plugin) {
-              _x_free_spu_decoder (&stream->s, stream->s.spu_decoder_plugin);
-              stream->s.spu_decoder_plugin = NULL;
-            }
-            /* running_ticket->release(running_ticket, 0); */
-            spu_track_map[0] = SPU_TRACK_MAP_END;
-            stream->spu_track_map_entries = 0;
-            if (!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW)) {
-              running_ticket->release (running_ticket, 0);
-              stream->s.metronom->handle_video_discontinuity (stream->s.metronom, DISC_STREAMSTART, 0);
-              running_ticket->acquire (running_ticket, 0);
-            }
-            buftype_unknown = 0;
-            restart = 1;
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_START):
+          /* decoder dispose might call port functions */
+          /* running_ticket->acquire(running_ticket, 0); */
+          if (stream->video_decoder_plugin) {
+            _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
+            stream->video_decoder_plugin = NULL;
+          }
+          if (stream->s.spu_decoder_plugin) {
+            _x_free_spu_decoder (&stream->s, stream->s.spu_decoder_plugin);
+            stream->s.spu_decoder_plugin = NULL;
+          }
+          /* running_ticket->release(running_ticket, 0); */
+          vd->spu_track_map[0] = SPU_TRACK_MAP_END;
+          stream->spu_track_map_entries = 0;
+          if (!(buf->decoder_flags & BUF_FLAG_GAPLESS_SW)) {
+            running_ticket->release (running_ticket, 0);
+            stream->s.metronom->handle_video_discontinuity (stream->s.metronom, DISC_STREAMSTART, 0);
+            running_ticket->acquire (running_ticket, 0);
+            vd->disc_wait = vd->job.pool &&
+              (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 1);
+          }
+          vd->buftype_unknown = 0;
+          vd->restart = 1;
+          vd->keyframes_seen = 0;
+          video_decoder_drop_reset (vd);
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_SPU_CHANNEL):
-            {
-              xine_event_t  ui_event;
-              /* We use widescreen spu as the auto selection, because widescreen
-               * display is common. SPU decoders can choose differently if it suits them. */
-              stream->s.spu_channel_auto = buf->decoder_info[0];
-              stream->s.spu_channel_letterbox = buf->decoder_info[1];
-              stream->spu_channel_pan_scan = buf->decoder_info[2];
-              if (stream->s.spu_channel_user == -1)
-                stream->s.spu_channel = stream->s.spu_channel_auto;
-              /* Inform UI of SPU channel changes */
-              ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-              ui_event.data_length = 0;
-              xine_event_send (&stream->s, &ui_event);
-            }
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_SPU_CHANNEL):
+          {
+            xine_event_t  ui_event;
+            /* We use widescreen spu as the auto selection, because widescreen
+             * display is common. SPU decoders can choose differently if it suits them. */
+            stream->s.spu_channel_auto = buf->decoder_info[0];
+            stream->s.spu_channel_letterbox = buf->decoder_info[1];
+            stream->spu_channel_pan_scan = buf->decoder_info[2];
+            if (stream->s.spu_channel_user == -1)
+              stream->s.spu_channel = stream->s.spu_channel_auto;
+            /* Inform UI of SPU channel changes */
+            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+            ui_event.data_length = 0;
+            xine_event_send (&stream->s, &ui_event);
+          }
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_END):
-            /* flush decoder frames if stream finished naturally (non-user stop) */
-            if (buf->decoder_flags) {
-              /* running_ticket->acquire(running_ticket, 0); */
-              if (stream->video_decoder_plugin)
-                stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
-              /* running_ticket->release(running_ticket, 0); */
-            }
+        case BUFTYPE_SUB (BUF_CONTROL_END):
+          /* flush decoder frames if stream finished naturally (non-user stop) */
+          if ((vd->end_wait == 0) && buf->decoder_flags) {
+            /* running_ticket->acquire(running_ticket, 0); */
+            if (stream->video_decoder_plugin)
+              stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
+            /* running_ticket->release(running_ticket, 0); */
+          }
+          if (vd->end_wait < 2) {
             /* wait the output fifos to run dry before sending the notification event
              * to the frontend. exceptions:
              * 1) don't wait if there is more than one stream attached to the current
@@ -430,6 +650,11 @@ static void *video_decoder_loop (void *stream_gen) {
               /* running_ticket->release(running_ticket, 0); */
               if (num_bufs > 0 && num_streams == 1 && !stream->early_finish_event &&
                 stream->s.master == &stream->s) {
+                if (vd->job.pool) {
+                  /* this pool worker has better things to do meanwhile. */
+                  vd->end_wait = 1;
+                  return XINE_DECODER_STEP_WAIT;
+                }
                 running_ticket->release (running_ticket, 0);
                 xine_usec_sleep (10000);
                 running_ticket->acquire (running_ticket, 0);
@@ -437,159 +662,220 @@ static void *video_decoder_loop (void *stream_gen) {
                 break;
             }
             running_ticket->release (running_ticket, 0);
-            /* wait for audio to reach this marker, if necessary */
             pthread_mutex_lock (&stream->counter.lock);
             stream->counter.finisheds_video++;
             lprintf ("reached end marker # %d\n", stream->counter.finisheds_video);
-            if (stream->audio_thread_created) {
-              if (stream->counter.finisheds_video > stream->counter.finisheds_audio) {
-                do {
-                  struct timespec ts = {0, 0};
-                  xine_gettime (&ts);
-                  ts.tv_sec += 1;
-                  /* use timedwait to workaround buggy pthread broadcast implementations */
-                  pthread_cond_timedwait (&stream->counter.changed, &stream->counter.lock, &ts);
-                } while (stream->counter.finisheds_video > stream->counter.finisheds_audio);
-              } else if (stream->counter.finisheds_video == stream->counter.finisheds_audio) {
-                pthread_cond_broadcast (&stream->counter.changed);
+          } else {
+            running_ticket->release (running_ticket, 0);
+            pthread_mutex_lock (&stream->counter.lock);
+          }
+          /* wait for audio to reach this marker, if necessary */
+          if (stream->audio_thread_created) {
+            if (stream->counter.finisheds_video > stream->counter.finisheds_audio) {
+              if (vd->job.pool) {
+                /* the audio decoder may need this pool worker. come back later. */
+                pthread_mutex_unlock (&stream->counter.lock);
+                running_ticket->acquire (running_ticket, 0);
+                vd->end_wait = 2;
+                return XINE_DECODER_STEP_WAIT;
               }
-            } else {
+              do {
+                struct timespec ts = {0, 0};
+                xine_gettime (&ts);
+                ts.tv_sec += 1;
+                /* use timedwait to workaround buggy pthread broadcast implementations */
+                pthread_cond_timedwait (&stream->counter.changed, &stream->counter.lock, &ts);
+              } while (stream->counter.finisheds_video > stream->counter.finisheds_audio);
+            } else if (stream->counter.finisheds_video == stream->counter.finisheds_audio) {
               pthread_cond_broadcast (&stream->counter.changed);
             }
-            pthread_mutex_unlock (&stream->counter.lock);
-            /* Wake up xine_play if it's waiting for a frame */
-            pthread_mutex_lock (&stream->first_frame.lock);
-            if (stream->first_frame.flag) {
-              stream->first_frame.flag = 0;
-              pthread_cond_broadcast(&stream->first_frame.reached);
-            }
-            pthread_mutex_unlock (&stream->first_frame.lock);
-            running_ticket->acquire (running_ticket, 0);
-            break;
+          } else {
+            pthread_cond_broadcast (&stream->counter.changed);
+          }
+          vd->end_wait = 0;
+          pthread_mutex_unlock (&stream->counter.lock);
+          /* Wake up xine_play if it's waiting for a frame */
+          pthread_mutex_lock (&stream->first_frame.lock);
+          if (stream->first_frame.flag) {
+            stream->first_frame.flag = 0;
+            pthread_cond_broadcast(&stream->first_frame.reached);
+          }
+          pthread_mutex_unlock (&stream->first_frame.lock);
+          running_ticket->acquire (running_ticket, 0);
+          break;
+
+        case BUFTYPE_SUB (BUF_CONTROL_QUIT):
+          /* decoder dispose might call port functions */
+          /* running_ticket->acquire(running_ticket, 0); */
+          if (stream->video_decoder_plugin) {
+            _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
+            stream->video_decoder_plugin = NULL;
+          }
+          if (stream->s.spu_decoder_plugin) {
+            _x_free_spu_decoder (&stream->s, stream->s.spu_decoder_plugin);
+            stream->s.spu_decoder_plugin = NULL;
+          }
+          /* running_ticket->release(running_ticket, 0); */
+          vd->spu_track_map[0] = SPU_TRACK_MAP_END;
+          stream->spu_track_map_entries = 0;
+          ret = XINE_DECODER_STEP_QUIT;
+          break;
+
+        case BUFTYPE_SUB (BUF_CONTROL_RESET_DECODER):
+          _x_extra_info_reset (stream->video_decoder_extra_info);
+          /* bump seek count, and inform audio decoder about this. */
+          stream->video_seek_count += 1;
+          (void)stream->s.audio_fifo->size (stream->s.audio_fifo);
+          /* the burst after a seek says nothing about decoding speed. */
+          video_decoder_drop_window (vd);
+          vd->drop_flags = 0;
+          vd->drop_decoded = 0;
+          vd->drop_skip = -1;
+          /* running_ticket->acquire(running_ticket, 0); */
+          if (stream->video_decoder_plugin)
+            stream->video_decoder_plugin->reset (stream->video_decoder_plugin);
+          if (stream->s.spu_decoder_plugin)
+            stream->s.spu_decoder_plugin->reset (stream->s.spu_decoder_plugin);
+          /* running_ticket->release(running_ticket, 0); */
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_QUIT):
-            /* decoder dispose might call port functions */
+        case BUFTYPE_SUB (BUF_CONTROL_FLUSH_DECODER):
+          if (stream->video_decoder_plugin) {
             /* running_ticket->acquire(running_ticket, 0); */
-            if (stream->video_decoder_plugin) {
-              _x_free_video_decoder (&stream->s, stream->video_decoder_plugin);
-              stream->video_decoder_plugin = NULL;
-            }
-            if (stream->s.spu_decoder_plugin) {
-              _x_free_spu_decoder (&stream->s, stream->s.spu_decoder_plugin);
-              stream->s.spu_decoder_plugin = NULL;
-            }
+            stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
             /* running_ticket->release(running_ticket, 0); */
-            spu_track_map[0] = SPU_TRACK_MAP_END;
-            stream->spu_track_map_entries = 0;
-            running = 0;
-            break;
+          }
+          break;
+
+        case BUFTYPE_SUB (BUF_CONTROL_DISCONTINUITY):
+          lprintf ("discontinuity ahead\n");
+          t = DISC_RELATIVE;
+          goto handle_disc;
 
-          case BUFTYPE_SUB (BUF_CONTROL_RESET_DECODER):
-            _x_extra_info_reset (stream->video_decoder_extra_info);
-            /* bump seek count, and inform audio decoder about this. */
-            stream->video_seek_count += 1;
-            (void)stream->s.audio_fifo->size (stream->s.audio_fifo);
+        case BUFTYPE_SUB (BUF_CONTROL_NEWPTS):
+          lprintf ("new pts %"PRId64"\n", buf->disc_off);
+          t = (buf->decoder_flags & BUF_FLAG_SEEK) ? DISC_STREAMSEEK : DISC_ABSOLUTE;
+        handle_disc:
+          if (stream->video_decoder_plugin) {
             /* running_ticket->acquire(running_ticket, 0); */
-            if (stream->video_decoder_plugin)
-              stream->video_decoder_plugin->reset (stream->video_decoder_plugin);
-            if (stream->s.spu_decoder_plugin)
-              stream->s.spu_decoder_plugin->reset (stream->s.spu_decoder_plugin);
+            stream->video_decoder_plugin->discontinuity (stream->video_decoder_plugin);
+            /* it might be a long time before we get back from a handle_video_discontinuity,
+             * so we better flush the decoder before */
+            if (!stream->disable_decoder_flush_at_discontinuity)
+              stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
             /* running_ticket->release(running_ticket, 0); */
-            break;
+          }
+          running_ticket->release (running_ticket, 0);
+          stream->s.metronom->handle_video_discontinuity (stream->s.metronom, t, buf->disc_off);
+          running_ticket->acquire (running_ticket, 0);
+          vd->disc_wait = vd->job.pool &&
+            (stream->s.metronom->get_option (stream->s.metronom, METRONOM_WAITING) & 1);
+          /* video_br_discontinuity */
+          vd->video_br_lasttime = 0;
+          vd->video_br_lastsize = 0;
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_FLUSH_DECODER):
-            if (stream->video_decoder_plugin) {
-              /* running_ticket->acquire(running_ticket, 0); */
-              stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
-              /* running_ticket->release(running_ticket, 0); */
-            }
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_AUDIO_CHANNEL):
+          {
+            xine_event_t  ui_event;
+            /* Inform UI of AUDIO channel changes */
+            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+            ui_event.data_length = 0;
+            xine_event_send (&stream->s, &ui_event);
+          }
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_DISCONTINUITY):
-            lprintf ("discontinuity ahead\n");
-            t = DISC_RELATIVE;
-            goto handle_disc;
+        case BUFTYPE_SUB (BUF_CONTROL_NOP):
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_NEWPTS):
-            lprintf ("new pts %"PRId64"\n", buf->disc_off);
-            t = (buf->decoder_flags & BUF_FLAG_SEEK) ? DISC_STREAMSEEK : DISC_ABSOLUTE;
-          handle_disc:
-            if (stream->video_decoder_plugin) {
-              /* running_ticket->acquire(running_ticket, 0); */
-              stream->video_decoder_plugin->discontinuity (stream->video_decoder_plugin);
-              /* it might be a long time before we get back from a handle_video_discontinuity,
-               * so we better flush the decoder before */
-              if (!stream->disable_decoder_flush_at_discontinuity)
-                stream->video_decoder_plugin->flush (stream->video_decoder_plugin);
-              /* running_ticket->release(running_ticket, 0); */
-            }
-            running_ticket->release (running_ticket, 0);
-            stream->s.metronom->handle_video_discontinuity (stream->s.metronom, t, buf->disc_off);
-            running_ticket->acquire (running_ticket, 0);
-            /* video_br_discontinuity */
-            video_br_lasttime = 0;
-            video_br_lastsize = 0;
-            break;
+        case BUFTYPE_SUB (BUF_CONTROL_RESET_TRACK_MAP):
+          if (stream->spu_track_map_entries) {
+            xine_event_t ui_event;
+            vd->spu_track_map[0] = SPU_TRACK_MAP_END;
+            stream->spu_track_map_entries = 0;
+            ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
+            ui_event.data_length = 0;
+            xine_event_send (&stream->s, &ui_event);
+          }
+          break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_AUDIO_CHANNEL):
-            {
-              xine_event_t  ui_event;
-              /* Inform UI of AUDIO channel changes */
-              ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-              ui_event.data_length = 0;
-              xine_event_send (&stream->s, &ui_event);
-            }
-            break;
+        default:
+          if (buf->type != vd->buftype_unknown) {
+            xine_log (stream->s.xine, XINE_LOG_MSG,
+              _("video_decoder: error, unknown buffer type: %08x\n"), buf->type);
+            vd->buftype_unknown = buf->type;
+          }
 
-          case BUFTYPE_SUB (BUF_CONTROL_NOP):
-            break;
+      } /* switch (BUFTYPE_SUB (buf->type)) */
+      break;
 
-          case BUFTYPE_SUB (BUF_CONTROL_RESET_TRACK_MAP):
-            if (stream->spu_track_map_entries) {
-              xine_event_t ui_event;
-              spu_track_map[0] = SPU_TRACK_MAP_END;
-              stream->spu_track_map_entries = 0;
-              ui_event.type        = XINE_EVENT_UI_CHANNELS_CHANGED;
-              ui_event.data_length = 0;
-              xine_event_send (&stream->s, &ui_event);
-            }
-            break;
+    default:
+      if (buf->type != vd->buftype_unknown) {
+        xine_log (stream->s.xine, XINE_LOG_MSG,
+          _("video_decoder: error, unknown buffer type: %08x\n"), buf->type);
+        vd->buftype_unknown = buf->type;
+      }
 
-          default:
-            if (buf->type != buftype_unknown) {
-              xine_log (stream->s.xine, XINE_LOG_MSG,
-                _("video_decoder: error, unknown buffer type: %08x\n"), buf->type);
-              buftype_unknown = buf->type;
-            }
+  } /* switch (BUFTYPE_BASE (buf->type)) */
 
-        } /* switch (BUFTYPE_SUB (buf->type)) */
-        break;
+  /* keep buf until audio has been here as well. */
+  if (vd->disc_wait)
+    return XINE_DECODER_STEP_WAIT;
 
-      default:
-        if (buf->type != buftype_unknown) {
-          xine_log (stream->s.xine, XINE_LOG_MSG,
-            _("video_decoder: error, unknown buffer type: %08x\n"), buf->type);
-          buftype_unknown = buf->type;
-        }
+  buf->free_buffer (buf);
+  return ret;
+}
 
-    } /* switch (BUFTYPE_BASE (buf->type)) */
+static buf_element_t *video_decoder_get (xine_decoder_job_t *job) {
+  return job->fifo->try_get (job->fifo);
+}
 
-    buf->free_buffer (buf);
+static void *video_decoder_loop (void *stream_gen) {
+
+  xine_stream_private_t *stream = (xine_stream_private_t *)stream_gen;
+  video_decoder_state_t vd;
+
+#ifndef WIN32
+  errno = 0;
+  if (nice(-1) == -1 && errno)
+    xine_log (stream->s.xine, XINE_LOG_MSG, "video_decoder: can't raise nice priority by 1: %s\n", strerror(errno));
+#endif /* WIN32 */
+
+  XINE_PROFILER_THREAD ("video decoder");
+
+  video_decoder_state_init (&vd, stream);
+  vd.job.pool = NULL;
+
+  vd.running_ticket->acquire (vd.running_ticket, 0);
+
+  while (1) {
+    buf_element_t *buf;
+
+    lprintf ("getting buffer...\n");
+
+    XINE_PROFILER_BEGIN ("video fifo wait");
+    buf = stream->s.video_fifo->tget (stream->s.video_fifo, vd.running_ticket);
+    XINE_PROFILER_END ();
+
+    if (video_decoder_step (&vd.job, buf) == XINE_DECODER_STEP_QUIT)
+      break;
   }
 
-  running_ticket->release (running_ticket, 0);
+  vd.running_ticket->release (vd.running_ticket, 0);
 
   return NULL;
 }
 
 int _x_video_decoder_init (xine_stream_t *s) {
   xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  xine_private_t *xine;
 
   if (!stream)
     return 0;
   stream = stream->side_streams[0];
   if (stream->s.video_fifo)
     return 1;
+  xine = (xine_private_t *)stream->s.xine;
 
   stream->spu_track_map_entries = 0;
 
@@ -631,6 +917,25 @@ int _x_video_decoder_init (xine_stream_t *s) {
       return 0;
     }
 
+    /* engine.decoder.pool_threads: let the shared workers do it. */
+    if (xine->decoder_pool) {
+      video_decoder_state_t *vd = malloc (sizeof (*vd));
+      if (!vd) {
+        stream->s.video_fifo->dispose (stream->s.video_fifo);
+        stream->s.video_fifo = NULL;
+        return 0;
+      }
+      video_decoder_state_init (vd, stream);
+      vd->job.get  = video_decoder_get;
+      vd->job.step = video_decoder_step;
+      stream->video_decoder_job = &vd->job;
+      /* never block a shared thread in a/v discontinuity sync. */
+      stream->s.metronom->set_option (stream->s.metronom, METRONOM_DISC_NONBLOCK, 1);
+      stream->video_thread_created = 1;
+      _x_decoder_pool_join (xine->decoder_pool, &vd->job);
+      return 1;
+    }
+
     pthread_attr_init(&pth_attrs);
 #if defined(_POSIX_THREAD_PRIORITY_SCHEDULING) && (_POSIX_THREAD_PRIORITY_SCHEDULING > 0)
     pthread_attr_getschedparam(&pth_attrs, &pth_params);
@@ -680,7 +985,13 @@ void _x_video_decoder_shutdown (xine_stream_t *s) {
 
     lprintf ("shutdown...3\n");
 
-    pthread_join (stream->video_thread, &p);
+    if (stream->video_decoder_job) {
+      _x_decoder_pool_leave (stream->video_decoder_job);
+      free (stream->video_decoder_job);
+      stream->video_decoder_job = NULL;
+    } else {
+      pthread_join (stream->video_thread, &p);
+    }
     stream->video_thread_created = 0;
 
     lprintf ("shutdown...4\n");
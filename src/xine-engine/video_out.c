@@ -48,6 +48,7 @@
 #include <xine/video_out.h>
 #include <xine/metronom.h>
 #include <xine/xineutils.h>
+#include <xine/worker_pool.h>
 #include <yuv2rgb.h>
 
 #include "xine_private.h"
@@ -179,6 +180,18 @@ typedef struct {
     vo_frame_t             *last_frame;
   } grab;
 
+  /* grab only port: xine_get_video_frames () helpers. */
+  struct {
+    int                     ring_size;
+    int                     num_dropped;
+    /* serializes RGB conversion: the factory tables are shared by all
+     * running converters, and pool and factory are made on first use. */
+    pthread_mutex_t         lock;
+    xine_worker_pool_t     *pool;
+    yuv2rgb_factory_t      *yuv2rgb_factory;
+    int                     yuv2rgb_cm;      /* current factory color matrix, or -1 */
+  } batch;
+
   uint32_t                  video_loop_running:1;
   uint32_t                  video_opened:1;
 
@@ -743,7 +756,9 @@ static vo_frame_t *vo_free_queue_get (vos_t *this,
         struct timespec ts = {0, 0};
         xine_gettime (&ts);
         ts.tv_sec += 1;
+        _x_decoder_pool_wait_begin ();
         pthread_cond_timedwait (&this->free_queue.not_empty, &this->free_queue.mutex, &ts);
+        _x_decoder_pool_wait_end ();
       }
     }
   } while (!img);
@@ -1416,6 +1431,23 @@ static vo_frame_t * crop_frame( xine_video_port_t *this_gen, vo_frame_t *img ) {
   return dupl;
 }
 
+/* ring mode: let the oldest queued frames go instead of blocking the decoder. */
+static void vo_batch_ring_trim (vos_t *this) {
+  vo_frame_t *list = NULL, **add = &list;
+  int n = 0;
+
+  pthread_mutex_lock (&this->display_queue.mutex);
+  while (this->display_queue.first && (this->display_queue.num_buffers > this->batch.ring_size)) {
+    *add = vo_display_queue_pop_int (this);
+    add = &(*add)->next;
+    n++;
+  }
+  this->batch.num_dropped += n;
+  pthread_mutex_unlock (&this->display_queue.mutex);
+
+  vo_list_flush (this, list);
+}
+
 static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
 
   xine_stream_private_t *stream = (xine_stream_private_t *)s;
@@ -1650,6 +1682,9 @@ static int vo_frame_draw (vo_frame_t *img, xine_stream_t *s) {
       vo_frame_inc2_lock (img);
     vo_display_reref_append (this, img);
 
+    if (this->grab_only && (this->batch.ring_size > 0))
+      vo_batch_ring_trim (this);
+
     if (img->is_first && (this->display_queue.first == img)) {
       /* wake up render thread */
       pthread_mutex_lock (&this->trigger_drawing.mutex);
@@ -2374,6 +2409,8 @@ static void *video_out_loop (void *this_gen) {
 
   lprintf ("loop starting...\n");
 
+  XINE_PROFILER_THREAD ("video out");
+
   pthread_mutex_lock (&this->trigger_drawing.mutex);
   this->rp.speed = this->trigger_drawing.speed;
   pthread_mutex_unlock (&this->trigger_drawing.mutex);
@@ -2393,7 +2430,9 @@ static void *video_out_loop (void *this_gen) {
 
     {
       /* find frame to display */
-      vo_frame_t *img = next_frame (this, &next_frame_vpts);
+      vo_frame_t *img;
+      XINE_PROFILER_SCOPE ("video out display");
+      img = next_frame (this, &next_frame_vpts);
       /* if we have found a frame, display it */
       if (img) {
         lprintf ("displaying frame (id=%d)\n", img->id);
@@ -2473,6 +2512,7 @@ static void *video_out_loop (void *this_gen) {
       /* we don't know when the next frame is due, only wait a little */
       usec_to_sleep = this->rp.poll_time;
 
+    XINE_PROFILER_BEGIN ("video out sleep");
     while (this->video_loop_running) {
       int timedout, wait;
 
@@ -2514,6 +2554,7 @@ static void *video_out_loop (void *this_gen) {
       if (!timedout && this->grab.last_frame)
         break;
     }
+    XINE_PROFILER_END ();
   }
 
   /*
@@ -2626,6 +2667,197 @@ void xine_free_video_frame (xine_video_port_t *port,
   vo_frame_dec2_lock (this, img);
 }
 
+/*
+ * batch frame retrieval
+ */
+
+typedef struct {
+  vos_t                  *this;
+  xine_video_frame_ref_t *frames;
+  int                     rgb_width, rgb_height;
+} vo_batch_rgb_t;
+
+static void vo_batch_rgb_job (void *data, int job) {
+  vo_batch_rgb_t *b = (vo_batch_rgb_t *)data;
+  xine_video_frame_ref_t *f = b->frames + job;
+  vo_frame_t *img = (vo_frame_t *)f->xine_frame;
+  yuv2rgb_t *yuv2rgb;
+  int width, height;
+
+  f->rgb = NULL;
+  if ((img->format != XINE_IMGFMT_YV12) && (img->format != XINE_IMGFMT_YUY2))
+    return;
+
+  width  = b->rgb_width  > 0 ? b->rgb_width  : img->width;
+  height = b->rgb_height > 0 ? b->rgb_height : img->height;
+  f->rgb = malloc ((size_t)width * height * 3);
+  if (!f->rgb)
+    return;
+
+  yuv2rgb = b->this->batch.yuv2rgb_factory->create_converter (b->this->batch.yuv2rgb_factory);
+  if (!yuv2rgb) {
+    _x_freep (&f->rgb);
+    return;
+  }
+  yuv2rgb->configure (yuv2rgb, img->width, img->height, img->pitches[0], img->pitches[1],
+    width, height, width * 3);
+  if (img->format == XINE_IMGFMT_YV12)
+    yuv2rgb->yuv2rgb_fun (yuv2rgb, f->rgb, img->base[0], img->base[1], img->base[2]);
+  else
+    yuv2rgb->yuy22rgb_fun (yuv2rgb, f->rgb, img->base[0]);
+  yuv2rgb->dispose (yuv2rgb);
+
+  f->rgb_width  = width;
+  f->rgb_height = height;
+}
+
+/* color matrix: same guess as vo_grab_grab_video_frame (). */
+static int vo_batch_rgb_cm (vo_frame_t *img) {
+  int cm = VO_GET_FLAGS_CM (img->flags);
+  if ((cm >> 1) == 2)
+    cm = (cm & 1) | ((img->height >= 720) || (img->width >= 1280) ? 2 : 10);
+  else if ((cm >> 1) == 0)
+    cm = (cm & 1) | 10;
+  return cm;
+}
+
+static void vo_batch_rgb (vos_t *this, xine_video_frame_ref_t *frames, int num, int rgb_width, int rgb_height) {
+  vo_batch_rgb_t b;
+  int start, end;
+
+  if (!this->batch.yuv2rgb_factory) {
+    this->batch.yuv2rgb_factory = yuv2rgb_factory_init (MODE_24_RGB, 0, NULL);
+    if (!this->batch.yuv2rgb_factory)
+      return;
+    this->batch.yuv2rgb_cm = -1;
+  }
+  if (!this->batch.pool && (num > 1))
+    this->batch.pool = xine_worker_pool_new (0);
+
+  b.this       = this;
+  b.rgb_width  = rgb_width;
+  b.rgb_height = rgb_height;
+  /* converters share the factory tables. so convert runs of frames with the same
+   * color matrix, and switch tables only between them. */
+  for (start = 0; start < num; start = end) {
+    int cm = vo_batch_rgb_cm ((vo_frame_t *)frames[start].xine_frame);
+    for (end = start + 1; end < num; end++) {
+      if (vo_batch_rgb_cm ((vo_frame_t *)frames[end].xine_frame) != cm)
+        break;
+    }
+    if (cm != this->batch.yuv2rgb_cm) {
+      this->batch.yuv2rgb_factory->set_csc_levels (this->batch.yuv2rgb_factory, 0, 128, 128, cm);
+      this->batch.yuv2rgb_cm = cm;
+    }
+    b.frames = frames + start;
+    xine_worker_pool_run (this->batch.pool, vo_batch_rgb_job, &b, end - start);
+  }
+}
+
+int xine_get_video_frames (xine_video_port_t *this_gen, xine_video_frame_ref_t *frames, int num,
+  int flags, int rgb_width, int rgb_height) {
+  vos_t *this = (vos_t *)this_gen;
+  struct timespec now = {0, 990000000};
+  int n = 0, i;
+
+  /* the render thread owns the queue of a regular port. */
+  if (!this || !frames || (num <= 0) || !this->grab_only)
+    return 0;
+
+  pthread_mutex_lock (&this->display_queue.mutex);
+  while (1) {
+    while (this->display_queue.first && (n < num))
+      frames[n++].xine_frame = vo_display_queue_pop_int (this);
+    if ((n >= num) || (flags & XINE_VIDEO_FRAMES_NOWAIT))
+      break;
+    /* decoder is waiting for us. */
+    if (n && (this->free_queue.num_buffers <= this->free_queue.locked_for_read))
+      break;
+    {
+      xine_stream_private_t *stream = this->streams[0];
+      if (stream && (stream->s.video_fifo->fifo_size == 0)
+        && (stream->demux.plugin->get_status (stream->demux.plugin) != DEMUX_OK))
+        break;
+    }
+
+    now.tv_nsec += 20000000;
+    if (now.tv_nsec >= 1000000000) {
+      xine_gettime (&now);
+      now.tv_nsec += 20000000;
+      if (now.tv_nsec >= 1000000000) {
+        now.tv_sec++;
+        now.tv_nsec -= 1000000000;
+      }
+    }
+    {
+      struct timespec ts = now;
+      pthread_cond_timedwait (&this->display_queue.not_empty, &this->display_queue.mutex, &ts);
+    }
+  }
+  pthread_mutex_unlock (&this->display_queue.mutex);
+
+  for (i = 0; i < n; i++) {
+    xine_video_frame_ref_t *f = frames + i;
+    vo_frame_t *img = (vo_frame_t *)f->xine_frame;
+
+    f->vpts         = img->vpts;
+    f->duration     = img->duration;
+    f->width        = img->width;
+    f->height       = img->height;
+    f->pos_stream   = img->extra_info->input_normpos;
+    f->pos_time     = img->extra_info->input_time;
+    f->frame_number = img->extra_info->frame_number;
+    f->aspect_ratio = img->ratio;
+    f->colorspace   = img->format;
+    f->base[0]      = img->base[0];
+    f->base[1]      = img->base[1];
+    f->base[2]      = img->base[2];
+    f->pitches[0]   = img->pitches[0];
+    f->pitches[1]   = img->pitches[1];
+    f->pitches[2]   = img->pitches[2];
+    f->rgb          = NULL;
+    f->rgb_width    = 0;
+    f->rgb_height   = 0;
+  }
+
+  if (n && (flags & XINE_VIDEO_FRAMES_RGB)) {
+    pthread_mutex_lock (&this->batch.lock);
+    vo_batch_rgb (this, frames, n, rgb_width, rgb_height);
+    pthread_mutex_unlock (&this->batch.lock);
+  }
+
+  return n;
+}
+
+void xine_free_video_frames (xine_video_port_t *this_gen, xine_video_frame_ref_t *frames, int num) {
+  vos_t *this = (vos_t *)this_gen;
+  vo_frame_t *list = NULL, **add = &list;
+  int i;
+
+  if (!this || !frames)
+    return;
+
+  for (i = 0; i < num; i++) {
+    vo_frame_t *img = (vo_frame_t *)frames[i].xine_frame;
+    _x_freep (&frames[i].rgb);
+    if (!img)
+      continue;
+    frames[i].xine_frame = NULL;
+    *add = img;
+    add = &img->next;
+  }
+  *add = NULL;
+  vo_list_flush (this, list);
+}
+
+void xine_set_video_frames_ring (xine_video_port_t *this_gen, int max_queued) {
+  vos_t *this = (vos_t *)this_gen;
+
+  if (!this)
+    return;
+  this->batch.ring_size = max_queued > 0 ? max_queued : 0;
+}
+
 
 /********************************************************************
  * external API                                                     *
@@ -2792,9 +3024,10 @@ static int vo_set_property (xine_video_port_t *this_gen, int property, int value
       this->display_queue.discard_frames++;
       ret = this->display_queue.discard_frames;
       if (this->grab_only) {
-        /* discard buffers here because we have no output thread. */
-        vo_manual_flush (this);
+        /* discard buffers here because we have no output thread.
+         * vo_manual_flush () takes display_queue.mutex itself. */
         pthread_mutex_unlock (&this->display_queue.mutex);
+        vo_manual_flush (this);
       } else {
         pthread_mutex_unlock (&this->display_queue.mutex);
         if (ret == 1) {
@@ -2998,6 +3231,15 @@ static void vo_exit (xine_video_port_t *this_gen) {
     }
   }
   vo_dispose_list (vo_display_queue_get_all (this));
+  /* give back cached plane memory when the last port is gone. */
+  xine_frame_mem_unref ();
+
+  if (this->batch.num_dropped)
+    xprintf (&this->xine->x, XINE_VERBOSITY_DEBUG,
+      "video_out: ring mode dropped %d frames.\n", this->batch.num_dropped);
+  xine_worker_pool_delete (this->batch.pool);
+  if (this->batch.yuv2rgb_factory)
+    this->batch.yuv2rgb_factory->dispose (this->batch.yuv2rgb_factory);
 
   /* print frame usage stats */
   xprintf (&this->xine->x, XINE_VERBOSITY_LOG, _("video_out: max frames used: %d of %d\n"),
@@ -3026,6 +3268,7 @@ static void vo_exit (xine_video_port_t *this_gen) {
   pthread_mutex_destroy (&this->driver_lock);
 
   pthread_mutex_destroy(&this->grab.lock);
+  pthread_mutex_destroy (&this->batch.lock);
   pthread_cond_destroy(&this->grab.wake);
 
   lprintf ("vo_exit... done\n");
@@ -3129,6 +3372,11 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
   this->trigger_drawing.step  = 0;
   this->grab.last_frame       = NULL;
   this->grab.request          = NULL;
+  this->batch.ring_size       = 0;
+  this->batch.num_dropped     = 0;
+  this->batch.pool            = NULL;
+  this->batch.yuv2rgb_factory = NULL;
+  this->batch.yuv2rgb_cm      = 0;
   this->frames_extref         = 0;
   this->frames_peak_used      = 0;
   this->frame_drop_cpt        = 0;
@@ -3223,6 +3471,9 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
     this->extra_info_base = (extra_info_t *)m;
   }
 
+  /* vo_exit () drops this again. */
+  xine_frame_mem_ref ();
+
   this->overlay_source = _x_video_overlay_new_manager (xine);
   if (this->overlay_source) {
     this->overlay_source->init (this->overlay_source);
@@ -3236,6 +3487,7 @@ xine_video_port_t *_x_vo_new_port (xine_t *xine, vo_driver_t *driver, int grabon
   pthread_mutex_init (&this->driver_lock, NULL);
 
   pthread_mutex_init (&this->grab.lock, NULL);
+  pthread_mutex_init (&this->batch.lock, NULL);
   pthread_cond_init (&this->grab.wake, NULL);
 
   vo_streams_open (this);
@@ -38,9 +38,14 @@
 #define LOG_DEBUG
 */
 
+/* Events are kept in a pool that grows on demand, up to EVENTS_MAX.
+ * Free slots are on a stack, pending ones in a min-heap sorted by vpts.
+ * seq keeps events with the same vpts in order of arrival. */
+#define EVENTS_MAX (1 << 16)
+
 typedef struct video_overlay_events_s {
-  video_overlay_event_t  *event;
-  uint32_t	next_event;
+  video_overlay_event_t  event;
+  uint32_t               seq;
 } video_overlay_events_t;
 
 typedef struct video_overlay_showing_s {
@@ -54,7 +59,13 @@ typedef struct video_overlay_s {
   xine_t                   *xine;
 
   pthread_mutex_t           events_mutex;
-  video_overlay_events_t    events[MAX_EVENTS];
+  video_overlay_events_t   *events;
+  uint32_t                 *events_free;      /* free slots */
+  uint32_t                 *events_heap;      /* pending slots */
+  int                       events_size;
+  int                       events_num_free;
+  int                       events_num_pending;
+  uint32_t                  events_seq;
   pthread_mutex_t           objects_mutex;
   video_overlay_object_t    objects[MAX_OBJECTS];
   pthread_mutex_t           showing_mutex;
@@ -103,37 +114,116 @@ static void remove_showing_handle( video_overlay_t *this, int32_t handle )
   pthread_mutex_unlock( &this->showing_mutex );
 }
 
+static int event_before (video_overlay_t *this, uint32_t a, uint32_t b) {
+  const video_overlay_events_t *ea = &this->events[a], *eb = &this->events[b];
+
+  if (ea->event.vpts != eb->event.vpts)
+    return ea->event.vpts < eb->event.vpts;
+  return (int32_t)(ea->seq - eb->seq) < 0;
+}
+
+static void event_heap_up (video_overlay_t *this, int i) {
+  uint32_t *heap = this->events_heap;
+  uint32_t slot = heap[i];
+
+  while (i > 0) {
+    int parent = (i - 1) >> 1;
+    if (!event_before (this, slot, heap[parent]))
+      break;
+    heap[i] = heap[parent];
+    i = parent;
+  }
+  heap[i] = slot;
+}
+
+static void event_heap_down (video_overlay_t *this, int i) {
+  uint32_t *heap = this->events_heap;
+  uint32_t slot = heap[i];
+  int n = this->events_num_pending;
+
+  while (1) {
+    int child = 2 * i + 1;
+    if (child >= n)
+      break;
+    if ((child + 1 < n) && event_before (this, heap[child + 1], heap[child]))
+      child++;
+    if (!event_before (this, heap[child], slot))
+      break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = slot;
+}
+
+/* free the overlay of an event, and return its slot to the pool. */
+static void event_release (video_overlay_t *this, uint32_t slot) {
+  video_overlay_event_t *event = &this->events[slot].event;
+
+  if (event->object.overlay) {
+    set_argb_layer_ptr (&event->object.overlay->argb_layer, NULL);
+    _x_freep (&event->object.overlay->rle);
+    _x_freep (&event->object.overlay);
+  }
+  event->event_type = OVERLAY_EVENT_NULL;
+  this->events_free[this->events_num_free++] = slot;
+}
+
+/* make room for at least 1 more event. */
+static int events_grow (video_overlay_t *this) {
+  video_overlay_events_t *events;
+  uint32_t *free_slots, *heap;
+  int size = this->events_size, new_size, i;
+
+  if (this->events_num_free > 0)
+    return 1;
+  if (size >= EVENTS_MAX)
+    return 0;
+  new_size = size ? 2 * size : MAX_EVENTS;
+  if (new_size > EVENTS_MAX)
+    new_size = EVENTS_MAX;
+
+  events = realloc (this->events, new_size * sizeof (*events));
+  if (!events)
+    return 0;
+  this->events = events;
+  free_slots = realloc (this->events_free, new_size * sizeof (*free_slots));
+  if (!free_slots)
+    return 0;
+  this->events_free = free_slots;
+  heap = realloc (this->events_heap, new_size * sizeof (*heap));
+  if (!heap)
+    return 0;
+  this->events_heap = heap;
+
+  memset (events + size, 0, (new_size - size) * sizeof (*events));
+  /* hand out low slots first */
+  for (i = new_size - 1; i >= size; i--)
+    free_slots[this->events_num_free++] = i;
+  this->events_size = new_size;
+  return 1;
+}
+
 static void remove_events_handle( video_overlay_t *this, int32_t handle, int lock )
 {
-  uint32_t   last_event,this_event;
+  int i, removed = 0;
 
   if( lock )
     pthread_mutex_lock( &this->events_mutex );
 
-  this_event=0;
-  do {
-    last_event=this_event;
-    this_event=this->events[last_event].next_event;
-
-    while( this_event &&
-        this->events[this_event].event->object.handle == handle ) {
-      /* remove event from pts list */
-      this->events[last_event].next_event=
-        this->events[this_event].next_event;
-
-      /* free its overlay */
-      if( this->events[this_event].event->object.overlay ) {
-        _x_freep( &this->events[this_event].event->object.overlay->rle );
-        _x_freep( &this->events[this_event].event->object.overlay );
-      }
-
-      /* mark as free */
-      this->events[this_event].next_event = 0;
-      this->events[this_event].event->event_type = OVERLAY_EVENT_NULL;
-
-      this_event=this->events[last_event].next_event;
+  for (i = 0; i < this->events_num_pending; ) {
+    uint32_t slot = this->events_heap[i];
+    if (this->events[slot].event.object.handle == handle) {
+      event_release (this, slot);
+      this->events_heap[i] = this->events_heap[--this->events_num_pending];
+      removed = 1;
+    } else {
+      i++;
     }
-  } while ( this_event );
+  }
+  if (removed) {
+    for (i = (this->events_num_pending >> 1) - 1; i >= 0; i--)
+      event_heap_down (this, i);
+  }
 
   if( lock )
     pthread_mutex_unlock( &this->events_mutex );
@@ -198,19 +288,9 @@ static void video_overlay_reset (video_overlay_t *this) {
   int i;
 
   pthread_mutex_lock (&this->events_mutex);
-  for (i=0; i < MAX_EVENTS; i++) {
-    if (this->events[i].event == NULL) {
-      this->events[i].event = calloc(1, sizeof(video_overlay_event_t));
-#ifdef LOG_DEBUG
-      printf ("video_overlay: MALLOC2: this->events[%d].event %p, len=%d\n",
-	      i,
-	      this->events[i].event,
-	      sizeof(video_overlay_event_t));
-#endif
-    }
-    this->events[i].event->event_type = 0;  /* Empty slot */
-    this->events[i].next_event = 0;
-  }
+  while (this->events_num_pending > 0)
+    event_release (this, this->events_heap[--this->events_num_pending]);
+  events_grow (this);
   pthread_mutex_unlock (&this->events_mutex);
 
   pthread_mutex_lock( &this->showing_mutex );
@@ -252,38 +332,21 @@ static void video_overlay_init (video_overlay_manager_t *this_gen) {
 static int32_t video_overlay_add_event(video_overlay_manager_t *this_gen,  void *event_gen ) {
   video_overlay_event_t *event = (video_overlay_event_t *) event_gen;
   video_overlay_t *this = (video_overlay_t *) this_gen;
-  uint32_t   last_event,this_event,new_event;
+  video_overlay_event_t *new_event;
+  int32_t slot;
 
   pthread_mutex_lock (&this->events_mutex);
 
-  /* We skip the 0 entry because that is used as a pointer to the first event.*/
-  /* Find a free event slot */
-  for( new_event = 1; new_event<MAX_EVENTS &&
-       this->events[new_event].event->event_type > 0; new_event++ )
-    ;
+  if (events_grow (this)) {
+    slot = this->events_free[--this->events_num_free];
+    new_event = &this->events[slot].event;
 
-  if (new_event < MAX_EVENTS) {
-    /* Find position in event queue to be added. */
-    this_event=0;
-    /* Find where in the current queue to insert the event. I.E. Sort it. */
-    do {
-      last_event=this_event;
-      this_event=this->events[last_event].next_event;
-    } while ( this_event && this->events[this_event].event->vpts <= event->vpts );
-
-    this->events[last_event].next_event=new_event;
-    this->events[new_event].next_event=this_event;
-
-    /* memcpy everything except the actual image */
-    if ( this->events[new_event].event == NULL ) {
-      xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: event slot is NULL!\n");
-    }
-    this->events[new_event].event->event_type=event->event_type;
-    this->events[new_event].event->vpts=event->vpts;
-    this->events[new_event].event->object.handle=event->object.handle;
-    this->events[new_event].event->object.pts=event->object.pts;
+    new_event->event_type=event->event_type;
+    new_event->vpts=event->vpts;
+    new_event->object.handle=event->object.handle;
+    new_event->object.pts=event->object.pts;
 
-    if ( this->events[new_event].event->object.overlay ) {
+    if ( new_event->object.overlay ) {
       xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: add_event: event->object.overlay was not freed!\n");
     }
 
@@ -296,24 +359,29 @@ static int32_t video_overlay_add_event(video_overlay_manager_t *this_gen,  void
 	  event->object.overlay->hili_trans[i] = OVL_MAX_OPACITY;
       }
 
-      this->events[new_event].event->object.overlay = calloc(1, sizeof(vo_overlay_t));
-      xine_fast_memcpy(this->events[new_event].event->object.overlay,
+      new_event->object.overlay = calloc(1, sizeof(vo_overlay_t));
+      xine_fast_memcpy(new_event->object.overlay,
            event->object.overlay, sizeof(vo_overlay_t));
 
       /* We took the callers rle and data, therefore it will be our job to free it */
       /* clear callers overlay so it will not be freed twice */
       memset(event->object.overlay,0,sizeof(vo_overlay_t));
     } else {
-      this->events[new_event].event->object.overlay = NULL;
+      new_event->object.overlay = NULL;
     }
+
+    /* queue it */
+    this->events[slot].seq = this->events_seq++;
+    this->events_heap[this->events_num_pending] = slot;
+    event_heap_up (this, this->events_num_pending++);
   } else {
     xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:No spare subtitle event slots\n");
-    new_event = -1;
+    slot = -1;
   }
 
   pthread_mutex_unlock (&this->events_mutex);
 
-  return new_event;
+  return slot;
 }
 
 
@@ -349,25 +417,33 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
 
   pthread_mutex_lock (&this->events_mutex);
 
-  this_event=this->events[0].next_event;
-  while ( this_event && (vpts > this->events[this_event].event->vpts ||
-          vpts == 0) ) {
+  while ( (this->events_num_pending > 0) &&
+          (vpts > this->events[this->events_heap[0]].event.vpts || vpts == 0) ) {
+    /* take it off the queue. this keeps it safe from remove_events_handle () below. */
+    this_event = this->events_heap[0];
+    this->events_heap[0] = this->events_heap[--this->events_num_pending];
+    if (this->events_num_pending > 0)
+      event_heap_down (this, 0);
+
     processed++;
-    handle=this->events[this_event].event->object.handle;
+    handle=this->events[this_event].event.object.handle;
 #ifdef LOG_DEBUG
     printf ("video_overlay: video_overlay_event: handle = %d\n", handle);
 #endif
     _x_assert(handle >= 0);
-    if ( handle < 0 ) break;
+    if ( handle < 0 ) {
+      event_release (this, this_event);
+      break;
+    }
 
-    switch( this->events[this_event].event->event_type ) {
+    switch( this->events[this_event].event.event_type ) {
       case OVERLAY_EVENT_SHOW:
 #ifdef LOG_DEBUG
         printf ("video_overlay: SHOW SPU NOW\n");
 #endif
-        if (this->events[this_event].event->object.overlay != NULL) {
+        if (this->events[this_event].event.object.overlay != NULL) {
 #ifdef LOG_DEBUG
-          video_overlay_print_overlay( this->events[this_event].event->object.overlay ) ;
+          video_overlay_print_overlay( this->events[this_event].event.object.overlay ) ;
 #endif
           /* this->objects[handle].overlay is about to be
            * overwritten by this event data. make sure we free it if needed.
@@ -380,10 +456,10 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
             xprintf(this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: error: object->overlay was not freed!\n");
           }
           this->objects[handle].overlay =
-             this->events[this_event].event->object.overlay;
+             this->events[this_event].event.object.overlay;
           this->objects[handle].pts =
-             this->events[this_event].event->object.pts;
-          this->events[this_event].event->object.overlay = NULL;
+             this->events[this_event].event.object.pts;
+          this->events[this_event].event.object.overlay = NULL;
 
           add_showing_handle( this, handle );
         }
@@ -394,11 +470,11 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         printf ("video_overlay: HIDE SPU NOW\n");
 #endif
         /* free any overlay associated with this event */
-        if (this->events[this_event].event->object.overlay != NULL) {
-          set_argb_layer_ptr(&this->events[this_event].event->object.overlay->argb_layer, NULL);
+        if (this->events[this_event].event.object.overlay != NULL) {
+          set_argb_layer_ptr(&this->events[this_event].event.object.overlay->argb_layer, NULL);
 
-          _x_freep( &this->events[this_event].event->object.overlay->rle );
-          _x_freep( &this->events[this_event].event->object.overlay );
+          _x_freep( &this->events[this_event].event.object.overlay->rle );
+          _x_freep( &this->events[this_event].event.object.overlay );
         }
         remove_showing_handle( this, handle );
         break;
@@ -408,15 +484,12 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         printf ("video_overlay: FREE SPU NOW\n");
 #endif
         /* free any overlay associated with this event */
-        if( this->events[this_event].event->object.overlay != NULL) {
-          set_argb_layer_ptr(&this->events[this_event].event->object.overlay->argb_layer, NULL);
+        if( this->events[this_event].event.object.overlay != NULL) {
+          set_argb_layer_ptr(&this->events[this_event].event.object.overlay->argb_layer, NULL);
 
-          _x_freep( &this->events[this_event].event->object.overlay->rle );
-          _x_freep( &this->events[this_event].event->object.overlay );
+          _x_freep( &this->events[this_event].event.object.overlay->rle );
+          _x_freep( &this->events[this_event].event.object.overlay );
         }
-        /* this avoid removing this_event from the queue
-         * (it will be removed at the end of this loop) */
-        this->events[this_event].event->object.handle = -1;
         remove_showing_handle(this,handle);
         remove_events_handle(this,handle,0);
         internal_video_overlay_free_handle( this, handle );
@@ -432,19 +505,19 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         /* This code drops buttons, where the button PTS derived from the NAV
 	 * packet on DVDs does not match the SPU PTS. Practical experience shows,
 	 * that this is not necessary and causes problems with some DVDs */
-        if ( (this->events[this_event].event->object.pts !=
+        if ( (this->events[this_event].event.object.pts !=
                 this->objects[handle].pts) ) {
           xprintf (this->xine, XINE_VERBOSITY_DEBUG,
 		   "video_overlay:MENU BUTTON DROPPED menu pts=%lld spu pts=%lld\n",
-            this->events[this_event].event->object.pts,
+            this->events[this_event].event.object.pts,
             this->objects[handle].pts);
           break;
         }
 #endif
-        if ( (this->events[this_event].event->object.overlay != NULL) &&
+        if ( (this->events[this_event].event.object.overlay != NULL) &&
              (this->objects[handle].overlay) ) {
           vo_overlay_t *overlay = this->objects[handle].overlay;
-          vo_overlay_t *event_overlay = this->events[this_event].event->object.overlay;
+          vo_overlay_t *event_overlay = this->events[this_event].event.object.overlay;
 
 #ifdef LOG_DEBUG
           printf ("video_overlay:overlay present\n");
@@ -464,18 +537,18 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
           overlay->hili_trans[3] = event_overlay->hili_trans[3];
           overlay->hili_rgb_clut = event_overlay->hili_rgb_clut;
 #ifdef LOG_DEBUG
-          video_overlay_print_overlay( this->events[this_event].event->object.overlay ) ;
+          video_overlay_print_overlay( this->events[this_event].event.object.overlay ) ;
 #endif
           add_showing_handle( this, handle );
         } else {
           xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay:overlay not present\n");
         }
 
-        if( this->events[this_event].event->object.overlay->rle ) {
+        if( this->events[this_event].event.object.overlay->rle ) {
           xprintf (this->xine, XINE_VERBOSITY_DEBUG, "video_overlay: warning EVENT_MENU_BUTTON with rle data\n");
-          _x_freep( &this->events[this_event].event->object.overlay->rle );
+          _x_freep( &this->events[this_event].event.object.overlay->rle );
         }
-        _x_freep (&this->events[this_event].event->object.overlay);
+        _x_freep (&this->events[this_event].event.object.overlay);
         break;
 
       default:
@@ -483,11 +556,7 @@ static int video_overlay_event( video_overlay_t *this, int64_t vpts ) {
         break;
     }
 
-    this->events[0].next_event = this->events[this_event].next_event;
-    this->events[this_event].next_event = 0;
-    this->events[this_event].event->event_type = 0;
-
-    this_event=this->events[0].next_event;
+    event_release (this, this_event);
   }
 
   pthread_mutex_unlock (&this->events_mutex);
@@ -709,15 +778,11 @@ static void video_overlay_dispose(video_overlay_manager_t *this_gen) {
   video_overlay_t *this = (video_overlay_t *) this_gen;
   int i;
 
-  for (i=0; i < MAX_EVENTS; i++) {
-    if (this->events[i].event != NULL) {
-      if (this->events[i].event->object.overlay != NULL) {
-        _x_freep (&this->events[i].event->object.overlay->rle);
-        _x_freep (&this->events[i].event->object.overlay);
-      }
-      _x_freep (&this->events[i].event);
-    }
-  }
+  while (this->events_num_pending > 0)
+    event_release (this, this->events_heap[--this->events_num_pending]);
+  _x_freep (&this->events);
+  _x_freep (&this->events_free);
+  _x_freep (&this->events_heap);
 
   for (i=0; i < MAX_OBJECTS; i++)
     internal_video_overlay_free_handle(this, i);
@@ -738,10 +803,13 @@ video_overlay_manager_t *_x_video_overlay_new_manager (xine_t *xine) {
     return NULL;
 
 #ifndef HAVE_ZERO_SAFE_MEM
-  for (i = 0; i < MAX_EVENTS; i++) {
-    this->events[i].event = NULL;
-    this->events[i].next_event = 0;
-  }
+  this->events             = NULL;
+  this->events_free        = NULL;
+  this->events_heap        = NULL;
+  this->events_size        = 0;
+  this->events_num_free    = 0;
+  this->events_num_pending = 0;
+  this->events_seq         = 0;
 #endif
 
   for (i = 0; i < MAX_OBJECTS; i++) {
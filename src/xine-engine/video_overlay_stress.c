@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * overlay event queue stress test: queues lots of show and hide events
+ * in random vpts order, and checks that every frame shows what it should.
+ *
+ * usage: video_overlay_stress [events]
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <xine.h>
+#include <xine/xine_internal.h>
+#include <xine/video_out.h>
+#include <xine/video_overlay.h>
+
+#define HANDLES    20
+#define VPTS_RANGE 1000000
+#define FRAME_STEP 3600
+
+typedef struct {
+  int handle, show, vpts;
+} test_event_t;
+
+static int shown[HANDLES];
+
+static double _now (void) {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* x = event number, y = handle. */
+static void _blend (vo_driver_t *self, vo_frame_t *frame, vo_overlay_t *overlay) {
+  (void)self;
+  (void)frame;
+  if ((overlay->y >= 0) && (overlay->y < HANDLES))
+    shown[overlay->y] = overlay->x;
+}
+
+static int _cmp (const void *a, const void *b) {
+  const test_event_t *ea = *(const test_event_t * const *)a, *eb = *(const test_event_t * const *)b;
+  if (ea->vpts != eb->vpts)
+    return ea->vpts < eb->vpts ? -1 : 1;
+  return ea < eb ? -1 : ea > eb;
+}
+
+int main (int argc, char **argv) {
+  int num_events = argc > 1 ? atoi (argv[1]) : 20000;
+  test_event_t *events, **sorted;
+  video_overlay_manager_t *ovl;
+  vo_driver_t driver;
+  int handles[HANDLES], state[HANDLES];
+  unsigned int seed = 1;
+  int i, next, frames = 0, errors = 0, failed = 0, accepted;
+  double start, t_add, t_run;
+  xine_t *xine;
+
+  xine = xine_new ();
+  xine_init (xine);
+
+  ovl = _x_video_overlay_new_manager (xine);
+  ovl->init (ovl);
+  for (i = 0; i < HANDLES; i++) {
+    handles[i] = ovl->get_handle (ovl, 0);
+    state[i] = -1;
+  }
+
+  memset (&driver, 0, sizeof (driver));
+  driver.overlay_blend = _blend;
+
+  events = calloc (num_events, sizeof (*events));
+  sorted = calloc (num_events, sizeof (*sorted));
+  if (!events || !sorted)
+    return 1;
+
+  start = _now ();
+  for (i = 0; i < num_events; i++) {
+    video_overlay_event_t event;
+    vo_overlay_t overlay;
+
+    seed = seed * 1103515245 + 12345;
+    events[i].handle = (seed >> 8) % HANDLES;
+    events[i].show = (seed >> 20) & 1;
+    seed = seed * 1103515245 + 12345;
+    events[i].vpts = 1 + (seed >> 4) % VPTS_RANGE;
+    sorted[i] = &events[i];
+
+    memset (&event, 0, sizeof (event));
+    event.vpts = events[i].vpts;
+    event.object.handle = handles[events[i].handle];
+    if (events[i].show) {
+      memset (&overlay, 0, sizeof (overlay));
+      overlay.x = i;
+      overlay.y = events[i].handle;
+      event.event_type = OVERLAY_EVENT_SHOW;
+      event.object.overlay = &overlay;
+    } else {
+      event.event_type = OVERLAY_EVENT_HIDE;
+    }
+    if (ovl->add_event (ovl, &event) < 0)
+      failed++;
+  }
+  t_add = _now () - start;
+
+  /* what should be visible */
+  qsort (sorted, num_events, sizeof (*sorted), _cmp);
+
+  start = _now ();
+  next = 0;
+  /* vpts 0 would mean "everything now" */
+  for (i = 1; i <= VPTS_RANGE + FRAME_STEP; i += FRAME_STEP) {
+    int h;
+
+    while ((next < num_events) && (sorted[next]->vpts < i)) {
+      state[sorted[next]->handle] = sorted[next]->show ? (int)(sorted[next] - events) : -1;
+      next++;
+    }
+    for (h = 0; h < HANDLES; h++)
+      shown[h] = -1;
+    ovl->multiple_overlay_blend (ovl, i, &driver, NULL, 1);
+    for (h = 0; h < HANDLES; h++) {
+      if (shown[h] != state[h])
+        errors++;
+    }
+    frames++;
+  }
+  t_run = _now () - start;
+
+  printf ("%d events: add %.3f ms, %d frames %.3f ms each, %d failed, %d errors\n",
+          num_events, t_add * 1000.0, frames, t_run * 1000.0 / frames, failed, errors);
+
+  /* queue limit */
+  accepted = 0;
+  for (i = 0; i < 100000; i++) {
+    video_overlay_event_t event;
+    memset (&event, 0, sizeof (event));
+    event.event_type = OVERLAY_EVENT_HIDE;
+    event.vpts = 1 + i;
+    event.object.handle = handles[0];
+    if (ovl->add_event (ovl, &event) >= 0)
+      accepted++;
+  }
+  ovl->flush_events (ovl);
+  printf ("queue limit: %d of %d events accepted\n", accepted, i);
+
+  ovl->dispose (ovl);
+  free (events);
+  free (sorted);
+  xine_exit (xine);
+  return (failed || errors) ? 1 : 0;
+}
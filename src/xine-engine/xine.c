@@ -825,11 +825,17 @@ void xine_stop (xine_stream_t *s) {
 }
 
 
+static void keyframes_scan_stop (xine_stream_private_t *stream);
+
 static void close_internal (xine_stream_private_t *stream) {
   xine_stream_private_t *m = stream->side_streams[0];
   xine_private_t *xine = (xine_private_t *)m->s.xine;
   int flush = !m->gapless_switch && !m->finished_naturally;
 
+  /* the background index scan would refill the index we are about to drop. */
+  if (stream == m)
+    keyframes_scan_stop (m);
+
   if (m->s.slave) {
     xine_close (m->s.slave);
     if (m->slave_is_subtitle) {
@@ -887,6 +893,10 @@ static void close_internal (xine_stream_private_t *stream) {
       stream->s.input_plugin = NULL;
     }
   }
+  if (stream->input_stream) {
+    _x_input_stream_dispose (&stream->input_stream->s);
+    stream->input_stream = NULL;
+  }
 
   /*
    * reset / free meta info
@@ -1044,6 +1054,8 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
    */
   stream->s.spu_decoder_plugin     = NULL;
   stream->audio_decoder_plugin     = NULL;
+  stream->audio_decoder_job        = NULL;
+  stream->video_decoder_job        = NULL;
   stream->early_finish_event       = 0;
   stream->delay_finish_event       = 0;
   stream->gapless_switch           = 0;
@@ -1065,6 +1077,13 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
   stream->err                      = 0;
   stream->broadcaster              = NULL;
   stream->index.array              = NULL;
+  stream->index.scan               = NULL;
+  stream->input_stream             = NULL;
+  stream->actions_from_master      = 0;
+  stream->next.thread_created      = 0;
+  stream->next.mrl                 = NULL;
+  stream->next.input               = NULL;
+  stream->next.stream              = NULL;
   stream->s.slave                  = NULL;
   stream->slave_is_subtitle        = 0;
   stream->query_input_plugins[0]   = NULL;
@@ -1087,6 +1106,10 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
   stream->audio_decoder_extra_info = &stream->ei[0];
   stream->video_decoder_extra_info = &stream->ei[1];
 
+  stream->demux.wakeup_set   = 0;
+  stream->demux.wakeup_fd[0] = -1;
+  stream->demux.wakeup_fd[1] = -1;
+
   stream->side_streams[0]       = stream;
   stream->id_flag               = 1 << 0;
   stream->s.xine                = this;
@@ -1209,6 +1232,7 @@ xine_stream_t *xine_stream_new (xine_t *this, xine_audio_port_t *ao, xine_video_
   pthread_mutex_destroy (&stream->event.lock);
   pthread_cond_destroy  (&stream->demux.resume);
   pthread_mutex_destroy (&stream->demux.pair);
+  xine_action_wakeup_close (stream);
   pthread_mutex_destroy (&stream->demux.action_lock);
   pthread_mutex_destroy (&stream->demux.lock);
   xine_rwlock_destroy   (&stream->meta_lock);
@@ -1259,6 +1283,7 @@ static void xine_side_dispose_internal (xine_stream_private_t *stream) {
   xine_rwlock_destroy   (&stream->info_lock);
   */
   pthread_cond_destroy  (&stream->demux.resume);
+  xine_action_wakeup_close (stream);
   pthread_mutex_destroy (&stream->demux.action_lock);
   pthread_mutex_destroy (&stream->demux.lock);
 
@@ -1266,18 +1291,9 @@ static void xine_side_dispose_internal (xine_stream_private_t *stream) {
   free (stream);
 }
 
-xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
-  xine_stream_private_t *m = (xine_stream_private_t *)master, *s;
-
-  if (!m || (index < 0) || (index >= XINE_NUM_SIDE_STREAMS))
-    return NULL;
-  /* no sub-sides, please. */
-  m = m->side_streams[0];
-  xine_rwlock_rdlock (&m->info_lock);
-  s = m->side_streams[index];
-  xine_rwlock_unlock (&m->info_lock);
-  if (s)
-    return &s->s;
+/* index 0 makes a hidden side stream that is not listed in m->side_streams[]. */
+static xine_stream_private_t *xine_side_stream_new (xine_stream_private_t *m, int index) {
+  xine_stream_private_t *s;
 
   xprintf (m->s.xine, XINE_VERBOSITY_DEBUG, "xine_side_stream_new (%p, %d)\n", (void *)m, index);
 
@@ -1289,6 +1305,8 @@ xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
 #ifndef HAVE_ZERO_SAFE_MEM
   s->s.spu_decoder_plugin     = NULL;
   s->audio_decoder_plugin     = NULL;
+  s->audio_decoder_job        = NULL;
+  s->video_decoder_job        = NULL;
   s->audio_track_map_entries  = 0;
   s->audio_type               = 0;
   s->early_finish_event       = 0;
@@ -1309,6 +1327,9 @@ xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
   s->err                      = 0;
   s->broadcaster              = NULL;
   s->index.array              = NULL;
+  s->index.scan               = NULL;
+  s->input_stream             = NULL;
+  s->actions_from_master      = 0;
   s->s.slave                  = NULL;
   s->slave_is_subtitle        = 0;
   s->query_input_plugins[0]   = NULL;
@@ -1328,6 +1349,10 @@ xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
   _x_extra_info_reset (&stream->ei[1]);
   */
 
+  s->demux.wakeup_set   = 0;
+  s->demux.wakeup_fd[0] = -1;
+  s->demux.wakeup_fd[1] = -1;
+
   /* create a reference counter */
   xine_refs_init (&s->refs, (void (*)(void *))xine_side_dispose_internal, &s->s);
 
@@ -1335,7 +1360,7 @@ xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
   s->video_decoder_extra_info = m->video_decoder_extra_info;
 
   s->side_streams[0] = m;
-  s->id_flag         = 1 << index;
+  s->id_flag         = index ? 1 << index : 0;
   s->s.xine = m->s.xine;
   s->status = XINE_STATUS_IDLE;
 
@@ -1405,11 +1430,46 @@ xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
   s->s.osd_renderer = m->s.osd_renderer;
 
   /* register stream */
-  xine_refs_add (&m->refs, 1);
-  xine_rwlock_wrlock (&m->info_lock);
-  m->side_streams[index] = s;
+  if (index) {
+    xine_refs_add (&m->refs, 1);
+    xine_rwlock_wrlock (&m->info_lock);
+    m->side_streams[index] = s;
+    xine_rwlock_unlock (&m->info_lock);
+  }
+  return s;
+}
+
+xine_stream_t *xine_get_side_stream (xine_stream_t *master, int index) {
+  xine_stream_private_t *m = (xine_stream_private_t *)master, *s;
+
+  if (!m || (index < 0) || (index >= XINE_NUM_SIDE_STREAMS))
+    return NULL;
+  /* no sub-sides, please. */
+  m = m->side_streams[0];
+  xine_rwlock_rdlock (&m->info_lock);
+  s = m->side_streams[index];
   xine_rwlock_unlock (&m->info_lock);
-  return &s->s;
+  if (s)
+    return &s->s;
+
+  s = xine_side_stream_new (m, index);
+  return s ? &s->s : NULL;
+}
+
+xine_stream_t *_x_input_stream_new (xine_stream_t *master) {
+  xine_stream_private_t *m = (xine_stream_private_t *)master, *s;
+
+  if (!m)
+    return NULL;
+  s = xine_side_stream_new (m->side_streams[0], 0);
+  return s ? &s->s : NULL;
+}
+
+void _x_input_stream_dispose (xine_stream_t *s) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+
+  if (stream)
+    xine_refs_sub (&stream->refs, 1);
 }
 
 void _x_mrl_unescape (char *mrl) {
@@ -1526,6 +1586,213 @@ static inline int _x_path_looks_like_mrl (const char *path) {
   return (p[-1] == ':') && (p[0] == '/');
 }
 
+/* split mrl into input plugin name and args after the stream setup hash.
+ * name needs strlen (mrl) + 1 bytes, args point into it. */
+static uint8_t *_x_mrl_split (const char *mrl, uint8_t *name) {
+  uint8_t *args = NULL;
+  const uint8_t *p = (const uint8_t *)mrl;
+  uint8_t *prot = NULL, *q = name, z;
+  /* test protocol prefix */
+  if (tab_parse[*p] & 0x02) {
+    while (tab_parse[z = *p] & 0x04) p++, *q++ = z;
+    if ((q > name) && (z == ':') && (p[1] == '/')) prot = name;
+  }
+  if (prot) {
+    /* split off args at first hash */
+    while (!(tab_parse[z = *p] & 0x21)) p++, *q++ = z;
+    *q = 0;
+    if (z == '#') {
+      p++;
+      args = ++q;
+      while ((*q++ = *p++) != 0) ;
+    }
+  } else {
+    /* raw filename, may contain any number of hashes */
+    while (1) {
+      struct stat s;
+      while (!(tab_parse[z = *p] & 0x21)) p++, *q++ = z;
+      *q = 0;
+      /* no need to stat when no hashes found */
+      if (!args && !z) break;
+      if (!stat ((const char *)name, &s)) {
+        args = NULL;
+        /* no general break yet, beware "/foo/#bar.flv" */
+      }
+      if (!z) break;
+      p++, *q++ = z;
+      args = q;
+    }
+    if (args) args[-1] = 0;
+  }
+  return args;
+}
+
+/* does the stream setup after the hash have key? */
+static int _x_mrl_args_have (const uint8_t *args, const char *key) {
+  size_t l = strlen (key);
+
+  while (args) {
+    if (!strncasecmp ((const char *)args, key, l) && ((args[l] == ':') || (args[l] == ';') || !args[l]))
+      return 1;
+    args = (const uint8_t *)strchr ((const char *)args, ';');
+    if (args)
+      args++;
+  }
+  return 0;
+}
+
+/* xine_open_next (): find and open the input plugin in the background,
+ * while the current mrl still plays. the input is made for a hidden side
+ * stream. until open_next_take (), that stream keeps its own info, meta
+ * info and events, so the playing track is not touched. it also has its
+ * own demux actions, so seeking the playing track does not abort the
+ * pre-open. */
+static xine_stream_private_t *open_next_stream_new (xine_stream_private_t *m) {
+  xine_stream_private_t *s = (xine_stream_private_t *)_x_input_stream_new (&m->s);
+
+  if (!s)
+    return NULL;
+  s->event.queues = xine_list_new ();
+  if (!s->event.queues) {
+    _x_input_stream_dispose (&s->s);
+    return NULL;
+  }
+  pthread_mutex_init (&s->event.lock, NULL);
+  xine_rwlock_init_default (&s->info_lock);
+  xine_rwlock_init_default (&s->meta_lock);
+  s->side_streams[0] = s;
+  return s;
+}
+
+/* make s a plain side stream of m again. with take, m gets the info and
+ * meta info found so far, and s follows the demux actions of m from now on.
+ * the input of s must be idle. */
+static void open_next_stream_join (xine_stream_private_t *s, xine_stream_private_t *m, int take) {
+  int i;
+
+  if (take) {
+    xine_rwlock_wrlock (&m->info_lock);
+    for (i = 0; i < XINE_STREAM_INFO_MAX; i++)
+      m->stream_info[i] = s->stream_info[i];
+    xine_rwlock_unlock (&m->info_lock);
+  }
+  xine_rwlock_wrlock (&m->meta_lock);
+  for (i = 0; i < XINE_STREAM_INFO_MAX; i++) {
+    if (s->meta_info_public[i] != s->meta_info[i])
+      free (s->meta_info_public[i]);
+    s->meta_info_public[i] = NULL;
+    if (take && s->meta_info[i]) {
+      if (m->meta_info_public[i] != m->meta_info[i])
+        free (m->meta_info_public[i]);
+      m->meta_info_public[i] = NULL;
+      free (m->meta_info[i]);
+      m->meta_info[i] = s->meta_info[i];
+    } else {
+      free (s->meta_info[i]);
+    }
+    s->meta_info[i] = NULL;
+  }
+  xine_rwlock_unlock (&m->meta_lock);
+
+  xine_rwlock_destroy (&s->meta_lock);
+  xine_rwlock_destroy (&s->info_lock);
+  pthread_mutex_destroy (&s->event.lock);
+  xine_list_delete (s->event.queues);
+  s->event.queues = m->event.queues;
+  s->side_streams[0] = m;
+  s->actions_from_master = take;
+}
+
+static void *open_next_loop (void *data) {
+  xine_stream_private_t *stream = data, *side = stream->next.stream;
+  input_plugin_t *input;
+  uint8_t *name;
+
+  name = malloc (strlen (stream->next.mrl) + 2);
+  if (!name)
+    return NULL;
+  _x_mrl_split (stream->next.mrl, name);
+  input = _x_find_input_plugin (&side->s, (const char *)name);
+  free (name);
+  if (input && (input->open (input) != 1)) {
+    _x_free_input_plugin (&side->s, input);
+    input = NULL;
+  }
+  /* read after pthread_join () only. */
+  stream->next.input = input;
+  xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG,
+    "xine_open_next: %s \"%s\".\n", input ? "pre-opened" : "cannot pre-open", stream->next.mrl);
+  return NULL;
+}
+
+/* get the pre-opened input if it is for mrl, or drop it. */
+static input_plugin_t *open_next_take (xine_stream_private_t *stream, const char *mrl) {
+  input_plugin_t *input;
+
+  if (!stream->next.mrl)
+    return NULL;
+  if (stream->next.thread_created) {
+    pthread_join (stream->next.thread, NULL);
+    stream->next.thread_created = 0;
+  }
+  input = stream->next.input;
+  stream->next.input = NULL;
+  if (input && (!mrl || strcmp (mrl, stream->next.mrl))) {
+    _x_free_input_plugin (&stream->next.stream->s, input);
+    input = NULL;
+  }
+  open_next_stream_join (stream->next.stream, stream, !!input);
+  if (input) {
+    /* close_internal () drops it along with the input. */
+    stream->input_stream = stream->next.stream;
+  } else {
+    _x_input_stream_dispose (&stream->next.stream->s);
+  }
+  stream->next.stream = NULL;
+  _x_freep (&stream->next.mrl);
+  return input;
+}
+
+int xine_open_next (xine_stream_t *s, const char *mrl) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  int err;
+
+  if (!stream || (&stream->s == XINE_ANON_STREAM))
+    return 0;
+  stream = stream->side_streams[0];
+
+  pthread_mutex_lock (&stream->frontend_lock);
+  if (stream->next.mrl && mrl && !strcmp (mrl, stream->next.mrl)) {
+    pthread_mutex_unlock (&stream->frontend_lock);
+    return 1;
+  }
+  open_next_take (stream, NULL);
+  if (!mrl || !mrl[0] || !(stream->next.mrl = strdup (mrl))) {
+    pthread_mutex_unlock (&stream->frontend_lock);
+    return 0;
+  }
+  stream->next.stream = open_next_stream_new (stream);
+  if (!stream->next.stream) {
+    _x_freep (&stream->next.mrl);
+    pthread_mutex_unlock (&stream->frontend_lock);
+    return 0;
+  }
+  err = pthread_create (&stream->next.thread, NULL, open_next_loop, stream);
+  if (err) {
+    xprintf (stream->s.xine, XINE_VERBOSITY_LOG,
+      "xine_open_next: can't create thread (%s).\n", strerror (err));
+    open_next_stream_join (stream->next.stream, stream, 0);
+    _x_input_stream_dispose (&stream->next.stream->s);
+    stream->next.stream = NULL;
+    _x_freep (&stream->next.mrl);
+    pthread_mutex_unlock (&stream->frontend_lock);
+    return 0;
+  }
+  stream->next.thread_created = 1;
+  pthread_mutex_unlock (&stream->frontend_lock);
+  return 1;
+}
+
 static int open_internal (xine_stream_private_t *stream, const char *mrl) {
 
   static const uint8_t tab_tolower[256] = {
@@ -1575,52 +1842,34 @@ static int open_internal (xine_stream_private_t *stream, const char *mrl) {
   if (!buf)
     return 0;
   name = buf + 32;
-  args = NULL;
-  {
-    const uint8_t *p = (const uint8_t *)mrl;
-    uint8_t *prot = NULL, *q = name, z;
-    /* test protocol prefix */
-    if (tab_parse[*p] & 0x02) {
-      while (tab_parse[z = *p] & 0x04) p++, *q++ = z;
-      if ((q > name) && (z == ':') && (p[1] == '/')) prot = name;
-    }
-    if (prot) {
-      /* split off args at first hash */
-      while (!(tab_parse[z = *p] & 0x21)) p++, *q++ = z;
-      *q = 0;
-      if (z == '#') {
-        p++;
-        args = ++q;
-        while ((*q++ = *p++) != 0) ;
-      }
-    } else {
-      /* raw filename, may contain any number of hashes */
-      while (1) {
-        struct stat s;
-        while (!(tab_parse[z = *p] & 0x21)) p++, *q++ = z;
-        *q = 0;
-        /* no need to stat when no hashes found */
-        if (!args && !z) break;
-        if (!stat ((const char *)name, &s)) {
-          args = NULL;
-          /* no general break yet, beware "/foo/#bar.flv" */
-        }
-        if (!z) break;
-        p++, *q++ = z;
-        args = q;
-      }
-      if (args) args[-1] = 0;
-    }
-  }
-    
+  args = _x_mrl_split (mrl, name);
+
   {
     /*
      * find an input plugin
      */
-    stream->s.input_plugin = _x_find_input_plugin (&stream->s, (const char *)name);
+    int res = 0;
+
+    /* #timeshift records from a hidden side stream, so that seeking
+     * in the recording never interrupts the live input. */
+    if ((stream == stream->side_streams[0]) && _x_mrl_args_have (args, "timeshift")) {
+      open_next_take (stream, NULL);
+      stream->input_stream = (xine_stream_private_t *)_x_input_stream_new (&stream->s);
+      if (stream->input_stream)
+        stream->s.input_plugin = _x_find_input_plugin (&stream->input_stream->s, (const char *)name);
+    }
+    /* xine_open_next () may have done this already. */
+    if (!stream->s.input_plugin && (stream == stream->side_streams[0])) {
+      stream->s.input_plugin = open_next_take (stream, mrl);
+      if (stream->s.input_plugin) {
+        xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG, "xine_open: using pre-opened input.\n");
+        res = 1;
+      }
+    }
+    if (!stream->s.input_plugin)
+      stream->s.input_plugin = _x_find_input_plugin (&stream->s, (const char *)name);
 
     if (stream->s.input_plugin) {
-      int res;
       input_class_t *input_class = stream->s.input_plugin->input_class;
 
       xine_log (stream->s.xine, XINE_LOG_MSG, _("xine: found input plugin  : %s\n"),
@@ -1631,7 +1880,8 @@ static int open_internal (xine_stream_private_t *stream, const char *mrl) {
       _x_meta_info_set_utf8 (&stream->s, XINE_META_INFO_INPUT_PLUGIN,
         stream->s.input_plugin->input_class->identifier);
 
-      res = (stream->s.input_plugin->open) (stream->s.input_plugin);
+      if (!res)
+        res = (stream->s.input_plugin->open) (stream->s.input_plugin);
       switch(res) {
       case 1: /* Open successfull */
 	break;
@@ -1727,6 +1977,28 @@ static int open_internal (xine_stream_private_t *stream, const char *mrl) {
 	continue;
       }
 
+      if (!memcmp (key, "timeshift", 10)) {
+        /* ring size in MiB, optional */
+        input_plugin_t *input_timeshift;
+        int size_mb = value ? atoi ((char *)value) : 0;
+
+        xine_log (stream->s.xine, XINE_LOG_MSG, _("xine: join timeshift input plugin\n"));
+        input_timeshift = _x_timeshift_plugin_get_instance (&stream->s,
+          stream->input_stream ? &stream->input_stream->s : &stream->s, size_mb);
+
+        if (input_timeshift) {
+          stream->s.input_plugin = input_timeshift;
+        } else {
+          xprintf (stream->s.xine, XINE_VERBOSITY_LOG, _("xine: error opening timeshift input plugin instance\n"));
+          stream->err = XINE_ERROR_INPUT_FAILED;
+          stream->status = XINE_STATUS_IDLE;
+          free (buf);
+          return 0;
+        }
+        entry = NULL;
+        continue;
+      }
+
       if (!memcmp (key, "lastdemuxprobe", 15)) {
         if (value) {
           /* all demuxers will be probed before the specified one */
@@ -2105,6 +2377,7 @@ static int play_internal (xine_stream_private_t *stream, int start_pos, int star
   do {
     pthread_mutex_lock (&sp->s->demux.action_lock);
     sp->s->demux.action_pending += 0x10001;
+    xine_action_wakeup_update (sp->s);
     if (!(sp->s->demux.input_caps & (INPUT_CAP_SEEKABLE | INPUT_CAP_SLOW_SEEKABLE)))
       input_is_seekable = 0;
     pthread_mutex_unlock (&sp->s->demux.action_lock);
@@ -2147,6 +2420,7 @@ static int play_internal (xine_stream_private_t *stream, int start_pos, int star
     /* demux.lock taken. now demuxer is suspended. unblock io for seeking. */
     pthread_mutex_lock (&sp->s->demux.action_lock);
     sp->s->demux.action_pending -= 0x00001;
+    xine_action_wakeup_update (sp->s);
     pthread_mutex_unlock (&sp->s->demux.action_lock);
     sp++;
   } while (sp->s);
@@ -2375,6 +2649,7 @@ static void xine_dispose_internal (xine_stream_private_t *stream) {
   pthread_mutex_destroy (&stream->event.lock);
   pthread_cond_destroy  (&stream->demux.resume);
   pthread_mutex_destroy (&stream->demux.pair);
+  xine_action_wakeup_close (stream);
   pthread_mutex_destroy (&stream->demux.action_lock);
   pthread_mutex_destroy (&stream->demux.lock);
   xine_rwlock_destroy   (&stream->meta_lock);
@@ -2405,6 +2680,10 @@ void xine_dispose (xine_stream_t *s) {
 
   xine_close (&stream->s);
 
+  pthread_mutex_lock (&stream->frontend_lock);
+  open_next_take (stream, NULL);
+  pthread_mutex_unlock (&stream->frontend_lock);
+
   if (stream->s.master != &stream->s) {
     stream->s.master->slave = NULL;
   }
@@ -2491,6 +2770,18 @@ void xine_exit (xine_t *this_gen) {
     pthread_mutex_destroy (&this->x.streams_lock);
   }
 
+  _x_decoder_pool_delete (&this->decoder_pool);
+
+  if (xine_profiler_enabled) {
+    const char *name = getenv ("XINE_PROFILE");
+    if (name && name[0]) {
+      if (xine_profiler_write (name, 0))
+        xprintf (&this->x, XINE_VERBOSITY_LOG, "xine_exit: wrote profile %s.\n", name);
+      else
+        xprintf (&this->x, XINE_VERBOSITY_LOG, "xine_exit: cannot write profile %s.\n", name);
+    }
+  }
+
   if (this->x.config)
     this->x.config->unregister_callbacks (this->x.config, NULL, NULL, this, sizeof (*this));
 
@@ -2542,6 +2833,7 @@ xine_t *xine_new (void) {
   this->x.streams        = NULL;
   this->x.clock          = NULL;
   this->port_ticket      = NULL;
+  this->decoder_pool     = NULL;
   this->speed_change_flags = 0;
 #endif
 
@@ -2705,6 +2997,14 @@ void xine_init (xine_t *this_gen) {
     }
   }
 
+  /* XINE_PROFILE=file.json|file.folded|file.txt records engine thread activity,
+   * and writes it at xine_exit (). */
+  {
+    const char *s = getenv ("XINE_PROFILE");
+    if (s && s[0])
+      xine_profiler_init ();
+  }
+
   /*
    * locks
    */
@@ -2832,6 +3132,23 @@ void xine_init (xine_t *this_gen) {
    * tickets
    */
   this->port_ticket = ticket_init();
+
+  /*
+   * shared decoder threads
+   */
+  {
+    int threads = this->x.config->register_num (this->x.config,
+      "engine.decoder.pool_threads", 0,
+      _("number of shared decoder threads"),
+      _("By default, each stream runs its own audio and video decoder thread. "
+        "When playing many streams at once, a few shared threads doing the "
+        "decoding for all of them can save a lot of context switches.\n"
+        "0 means no sharing. Otherwise, use at least as many threads as there are "
+        "CPU cores, and restart the application to apply changes."),
+      30, NULL, NULL);
+    if (threads > 0)
+      this->decoder_pool = _x_decoder_pool_new (&this->x, threads > 256 ? 256 : threads);
+  }
 }
 
 void _x_select_spu_channel (xine_stream_t *s, int channel) {
@@ -3291,6 +3608,51 @@ xine_grab_video_frame_t* xine_new_grab_video_frame (xine_stream_t *stream) {
   return frame;
 }
 
+int xine_get_thumbnails (xine_stream_t *s, xine_video_frame_ref_t *frames, int num,
+  int rgb_width, int rgb_height) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  int keyframes_only, ignore_audio, ignore_spu;
+  int i, n = 0;
+
+  if (!stream || !frames || (num <= 0))
+    return 0;
+  stream = stream->side_streams[0];
+
+  keyframes_only = _x_stream_info_get (&stream->s, XINE_STREAM_INFO_KEYFRAMES_ONLY);
+  ignore_audio   = _x_stream_info_get (&stream->s, XINE_STREAM_INFO_IGNORE_AUDIO);
+  ignore_spu     = _x_stream_info_get (&stream->s, XINE_STREAM_INFO_IGNORE_SPU);
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_KEYFRAMES_ONLY, 1);
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_IGNORE_AUDIO, 1);
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_IGNORE_SPU, 1);
+
+  for (i = 0; i < num; i++) {
+    xine_video_frame_ref_t *f = frames + n;
+    uint8_t *rgb;
+
+    /* the middle of each of num equal parts. */
+    if (!xine_play (&stream->s, (2 * i + 1) * 65535 / (2 * num), 0))
+      break;
+    if (xine_get_video_frames (stream->s.video_out, f, 1, XINE_VIDEO_FRAMES_RGB, rgb_width, rgb_height) != 1)
+      continue;
+    /* give the engine frame back now, so the port never runs dry. */
+    rgb = f->rgb;
+    f->rgb = NULL;
+    xine_free_video_frames (stream->s.video_out, f, 1);
+    f->rgb = rgb;
+    f->base[0] = f->base[1] = f->base[2] = NULL;
+    if (rgb)
+      n++;
+  }
+  xine_stop (&stream->s);
+
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_KEYFRAMES_ONLY, keyframes_only);
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_IGNORE_AUDIO, ignore_audio);
+  _x_stream_info_set (&stream->s, XINE_STREAM_INFO_IGNORE_SPU, ignore_spu);
+
+  xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG, "xine: got %d of %d thumbnails.\n", n, num);
+  return n;
+}
+
 static int _get_spu_lang (xine_stream_private_t *stream, int channel, char *lang) {
   if (!lang)
     return 0;
@@ -3846,3 +4208,291 @@ int _x_keyframes_set (xine_stream_t *s, xine_keyframes_entry_t *list, int size)
     "keyframes: got %d of them.\n", stream->index.used);
   return 0;
 }
+
+/* background keyframe index scan.
+ * a hidden stream without audio and video ports gets dummy fifos and no decoder
+ * threads, so its demuxer runs at full input speed. we watch the video buffers
+ * going into the dummy fifo, and add the keyframes to the master index. */
+
+typedef struct xine_keyframes_scan_s {
+  xine_stream_private_t *master;
+  char                  *mrl;
+  pthread_t              thread;
+  pthread_mutex_t        lock;
+  pthread_cond_t         wake;
+  int                    stop, done;
+  /* below is owned by the scan demux thread. */
+  uint32_t               video_type;
+  int                    flagged; /* demuxer marks keyframes itself */
+  int                    normpos;
+  int                    found;
+  int64_t                first_pts;
+  int                    tail_len;
+  uint8_t                tail[8];
+} xine_keyframes_scan_t;
+
+/* q points behind a 00 00 01 start code, q[0..3] are valid. */
+static int keyframes_scan_check (uint32_t codec, const uint8_t *q) {
+  switch (codec) {
+    case BUF_VIDEO_MPEG:
+      /* picture header, picture_coding_type I. */
+      return (q[0] == 0x00) && (((q[2] >> 3) & 7) == 1);
+    case BUF_VIDEO_MPEG4:
+    case BUF_VIDEO_XVID:
+    case BUF_VIDEO_DIVX5:
+    case BUF_VIDEO_3IVX:
+      /* VOP, vop_coding_type I. */
+      return (q[0] == 0xb6) && !(q[1] & 0xc0);
+    case BUF_VIDEO_H264:
+      /* first slice of an IDR picture, or of an I picture (open GOP broadcast). */
+      if (!(q[1] & 0x80))
+        return 0;
+      if ((q[0] & 0x1f) == 5)
+        return 1;
+      if ((q[0] & 0x1f) == 1) {
+        /* slice_type ue (v): 2 or 7. */
+        uint32_t v = (((uint32_t)q[1] << 24) | ((uint32_t)q[2] << 16) | ((uint32_t)q[3] << 8)) << 1;
+        return (v >> 29) == 3 || (v >> 25) == 8;
+      }
+      return 0;
+    case BUF_VIDEO_HEVC:
+      /* first slice segment of an IRAP picture. */
+      return ((q[0] >> 1) >= 16) && ((q[0] >> 1) <= 21) && (q[2] & 0x80);
+    default:
+      return 0;
+  }
+}
+
+static int keyframes_scan_codes (uint32_t codec, const uint8_t *p, const uint8_t *e) {
+  e -= 7;
+  while (p <= e) {
+    if (p[2] > 1) {
+      p += 3;
+    } else if ((p[2] == 1) && !p[1] && !p[0]) {
+      if (keyframes_scan_check (codec, p + 3))
+        return 1;
+      p += 3;
+    } else {
+      p++;
+    }
+  }
+  return 0;
+}
+
+static void keyframes_scan_put (fifo_buffer_t *fifo, buf_element_t *buf, void *data) {
+  xine_keyframes_scan_t *scan = data;
+  uint32_t codec;
+  int key;
+
+  (void)fifo;
+  /* demux loop end. BUF_CONTROL_END also comes with open and stop. */
+  if ((buf->type == BUF_CONTROL_NOP) && (buf->decoder_flags & BUF_FLAG_END_STREAM)) {
+    pthread_mutex_lock (&scan->lock);
+    scan->done = 1;
+    pthread_cond_signal (&scan->wake);
+    pthread_mutex_unlock (&scan->lock);
+    return;
+  }
+  if ((buf->type & 0xff000000) != BUF_VIDEO_BASE)
+    return;
+  if (buf->decoder_flags & (BUF_FLAG_HEADER | BUF_FLAG_SPECIAL | BUF_FLAG_PREVIEW))
+    return;
+  /* stick to the first video track. */
+  if (!scan->video_type)
+    scan->video_type = buf->type;
+  else if (buf->type != scan->video_type)
+    return;
+  if (buf->pts > 0 && !scan->first_pts)
+    scan->first_pts = buf->pts;
+  scan->normpos = buf->extra_info->input_normpos;
+
+  codec = buf->type & 0xffff0000;
+  key = 0;
+  if (buf->decoder_flags & BUF_FLAG_KEYFRAME) {
+    scan->flagged = key = 1;
+  } else if (!scan->flagged && (buf->size > 0)) {
+    /* a start code may cross buffer boundaries. */
+    uint8_t t[16];
+    int n = buf->size < 8 ? buf->size : 8;
+    memcpy (t, scan->tail, scan->tail_len);
+    memcpy (t + scan->tail_len, buf->content, n);
+    key = keyframes_scan_codes (codec, t, t + scan->tail_len + n)
+       || keyframes_scan_codes (codec, buf->content, buf->content + buf->size);
+    n = buf->size < 8 ? buf->size : 8;
+    memcpy (scan->tail, buf->content + buf->size - n, n);
+    scan->tail_len = n;
+  }
+
+  if (key) {
+    xine_keyframes_entry_t entry;
+    entry.msecs = buf->extra_info->input_time;
+    if (!entry.msecs && (buf->pts > 0))
+      entry.msecs = (buf->pts - scan->first_pts) / 90;
+    entry.normpos = buf->extra_info->input_normpos;
+    if (_x_keyframes_add (&scan->master->s, &entry) >= 0)
+      scan->found++;
+  }
+}
+
+static void keyframes_scan_progress (xine_keyframes_scan_t *scan, int percent) {
+  xine_event_t event;
+  xine_progress_data_t prg;
+
+  prg.description = _("Building keyframe index...");
+  prg.percent = percent;
+  event.type = XINE_EVENT_PROGRESS;
+  event.data = &prg;
+  event.data_length = sizeof (prg);
+  xine_event_send (&scan->master->s, &event);
+}
+
+static void *keyframes_scan_loop (void *data) {
+  xine_keyframes_scan_t *scan = data;
+  xine_t *xine = scan->master->s.xine;
+  xine_stream_t *s;
+  struct timespec ts = {0, 0};
+  int percent = 0, stop = 1;
+
+  xine_gettime (&ts);
+  s = xine_stream_new (xine, NULL, NULL);
+  if (s) {
+    s->video_fifo->register_put_cb (s->video_fifo, keyframes_scan_put, scan);
+    if (xine_open (s, scan->mrl) && xine_play (s, 0, 0)) {
+      keyframes_scan_progress (scan, 0);
+      pthread_mutex_lock (&scan->lock);
+      while (!scan->done && !scan->stop) {
+        struct timespec tw = {0, 0};
+        int p;
+        xine_gettime (&tw);
+        tw.tv_nsec += 500000000;
+        if (tw.tv_nsec >= 1000000000) {
+          tw.tv_nsec -= 1000000000;
+          tw.tv_sec  += 1;
+        }
+        pthread_cond_timedwait (&scan->wake, &scan->lock, &tw);
+        p = scan->normpos * 100 / 65536;
+        if (!scan->done && !scan->stop && (p != percent)) {
+          percent = p;
+          pthread_mutex_unlock (&scan->lock);
+          keyframes_scan_progress (scan, percent);
+          pthread_mutex_lock (&scan->lock);
+        }
+      }
+      stop = scan->stop;
+      pthread_mutex_unlock (&scan->lock);
+    }
+    xine_close (s);
+    s->video_fifo->unregister_put_cb (s->video_fifo, keyframes_scan_put);
+    xine_dispose (s);
+  }
+
+  if (!stop) {
+    struct timespec te = {0, 0};
+    xine_gettime (&te);
+    keyframes_scan_progress (scan, 100);
+    xprintf (xine, XINE_VERBOSITY_DEBUG, "keyframes: scan found %d keyframes in %d ms.\n",
+      scan->found, (int)(te.tv_sec - ts.tv_sec) * 1000 + (int)(te.tv_nsec - ts.tv_nsec) / 1000000);
+  } else {
+    xprintf (xine, XINE_VERBOSITY_DEBUG, "keyframes: scan stopped after %d keyframes.\n", scan->found);
+  }
+  return NULL;
+}
+
+static void keyframes_scan_stop (xine_stream_private_t *stream) {
+  xine_keyframes_scan_t *scan;
+
+  pthread_mutex_lock (&stream->index.lock);
+  scan = stream->index.scan;
+  stream->index.scan = NULL;
+  pthread_mutex_unlock (&stream->index.lock);
+  if (!scan)
+    return;
+
+  pthread_mutex_lock (&scan->lock);
+  scan->stop = 1;
+  pthread_cond_signal (&scan->wake);
+  pthread_mutex_unlock (&scan->lock);
+  pthread_join (scan->thread, NULL);
+
+  pthread_cond_destroy (&scan->wake);
+  pthread_mutex_destroy (&scan->lock);
+  free (scan->mrl);
+  free (scan);
+}
+
+int xine_keyframes_scan (xine_stream_t *s) {
+  xine_stream_private_t *stream = (xine_stream_private_t *)s;
+  xine_keyframes_scan_t *scan;
+  const char *mrl;
+  int err;
+
+  if (!stream || (&stream->s == XINE_ANON_STREAM))
+    return 0;
+  stream = stream->side_streams[0];
+  if (!stream->s.input_plugin || !stream->demux.plugin)
+    return 0;
+  /* a second pass over live or unseekable input would read another stream,
+   * or never end. */
+  {
+    uint32_t caps = stream->s.input_plugin->get_capabilities (stream->s.input_plugin);
+    if (!(caps & INPUT_CAP_SEEKABLE) || (caps & INPUT_CAP_LIVE)
+      || (stream->s.input_plugin->get_length (stream->s.input_plugin) <= 0))
+      return 0;
+  }
+  mrl = stream->s.input_plugin->get_mrl (stream->s.input_plugin);
+  if (!mrl || !mrl[0])
+    return 0;
+
+  pthread_mutex_lock (&stream->index.lock);
+  /* already scanning, or the demuxer got a complete index from the container. */
+  if (stream->index.scan || (stream->index.array && (stream->index.used > 1))) {
+    pthread_mutex_unlock (&stream->index.lock);
+    return 1;
+  }
+  pthread_mutex_unlock (&stream->index.lock);
+
+  scan = calloc (1, sizeof (*scan));
+  if (!scan)
+    return 0;
+#ifndef HAVE_ZERO_SAFE_MEM
+  scan->stop       = 0;
+  scan->done       = 0;
+  scan->video_type = 0;
+  scan->flagged    = 0;
+  scan->normpos    = 0;
+  scan->found      = 0;
+  scan->first_pts  = 0;
+  scan->tail_len   = 0;
+#endif
+  scan->master = stream;
+  scan->mrl = strdup (mrl);
+  if (!scan->mrl) {
+    free (scan);
+    return 0;
+  }
+  pthread_mutex_init (&scan->lock, NULL);
+  pthread_cond_init (&scan->wake, NULL);
+
+  pthread_mutex_lock (&stream->index.lock);
+  if (stream->index.scan) {
+    pthread_mutex_unlock (&stream->index.lock);
+    err = -1;
+  } else {
+    err = pthread_create (&scan->thread, NULL, keyframes_scan_loop, scan);
+    if (!err)
+      stream->index.scan = scan;
+    pthread_mutex_unlock (&stream->index.lock);
+  }
+  if (err) {
+    if (err > 0)
+      xprintf (stream->s.xine, XINE_VERBOSITY_LOG,
+        "keyframes: can't create scan thread (%s).\n", strerror (err));
+    pthread_cond_destroy (&scan->wake);
+    pthread_mutex_destroy (&scan->lock);
+    free (scan->mrl);
+    free (scan);
+    return err < 0;
+  }
+  xprintf (stream->s.xine, XINE_VERBOSITY_DEBUG, "keyframes: scanning \"%s\".\n", scan->mrl);
+  return 1;
+}
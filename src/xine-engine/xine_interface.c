@@ -541,6 +541,10 @@ void xine_set_param (xine_stream_t *s, int param, int value) {
     _x_stream_info_set (&stream->s, XINE_STREAM_INFO_IGNORE_SPU, value);
     break;
 
+  case XINE_PARAM_KEYFRAMES_ONLY:
+    _x_stream_info_set (&stream->s, XINE_STREAM_INFO_KEYFRAMES_ONLY, !!value);
+    break;
+
   case XINE_PARAM_METRONOM_PREBUFFER:
     stream->s.metronom->set_option (stream->s.metronom, METRONOM_PREBUFFER, value);
     break;
@@ -718,6 +722,10 @@ int xine_get_param (xine_stream_t *s, int param) {
     ret = _x_stream_info_get_public (&stream->s, XINE_STREAM_INFO_IGNORE_SPU);
     break;
 
+  case XINE_PARAM_KEYFRAMES_ONLY:
+    ret = _x_stream_info_get_public (&stream->s, XINE_STREAM_INFO_KEYFRAMES_ONLY);
+    break;
+
   case XINE_PARAM_METRONOM_PREBUFFER:
     ret = stream->s.metronom->get_option (stream->s.metronom, METRONOM_PREBUFFER);
     break;
@@ -801,6 +809,8 @@ uint32_t xine_get_stream_info (xine_stream_t *s, int info) {
   case XINE_STREAM_INFO_DVD_CHAPTER_COUNT:
   case XINE_STREAM_INFO_DVD_ANGLE_NUMBER:
   case XINE_STREAM_INFO_DVD_ANGLE_COUNT:
+  case XINE_STREAM_INFO_LIVE_LATENCY:
+  case XINE_STREAM_INFO_VIDEO_DROP_LEVEL:
     return _x_stream_info_get_public (&stream->s, info);
 
   case XINE_STREAM_INFO_MAX_AUDIO_CHANNEL:
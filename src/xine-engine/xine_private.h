@@ -199,6 +199,12 @@ void _x_free_audio_driver (xine_t *xine, ao_driver_t **driver) INTERNAL;
 demux_plugin_t *_x_find_demux_plugin_last_probe(xine_stream_t *stream, const char *last_demux_name, input_plugin_t *input) INTERNAL;
 input_plugin_t *_x_rip_plugin_get_instance (xine_stream_t *stream, const char *filename) INTERNAL;
 input_plugin_t *_x_cache_plugin_get_instance (xine_stream_t *stream) INTERNAL;
+input_plugin_t *_x_timeshift_plugin_get_instance (xine_stream_t *stream, xine_stream_t *main_stream, int size_mb) INTERNAL;
+/* a hidden side stream for an input plugin. it has its own demux action state,
+ * so the master's seeks do not interrupt its io. meta info and events still go
+ * to the master. */
+xine_stream_t *_x_input_stream_new (xine_stream_t *master) INTERNAL;
+void _x_input_stream_dispose (xine_stream_t *stream) INTERNAL;
 ///@}
 
 ///@{
@@ -214,6 +220,51 @@ int _x_audio_decoder_init           (xine_stream_t *stream) INTERNAL;
 void _x_audio_decoder_shutdown      (xine_stream_t *stream) INTERNAL;
 ///@}
 
+/**
+ * @defgroup
+ * @brief  shared decoder worker threads (engine.decoder.pool_threads)
+ *
+ * Instead of running its own thread, a decoder may join a pool as a job.
+ * Its fifo wakes the pool on put, and a worker calls job->step () for a
+ * few bufs taken with job->get () before moving on to the next job.
+ * step () must not block on other decoders. It may return
+ * XINE_DECODER_STEP_WAIT instead, and will see the same buf again later.
+ * Output ports wrap their waits for free frames/bufs in
+ * _x_decoder_pool_wait_begin ()/_end (), so a blocked worker gets a
+ * stand in. These do nothing outside pool worker threads.
+*/
+///@{
+typedef struct xine_decoder_pool_s xine_decoder_pool_t;
+typedef struct xine_decoder_job_s xine_decoder_job_t;
+
+#define XINE_DECODER_STEP_QUIT 0
+#define XINE_DECODER_STEP_OK   1
+#define XINE_DECODER_STEP_WAIT 2
+
+struct xine_decoder_job_s {
+  fifo_buffer_t        *fifo;
+  /* non blocking, NULL if there is nothing to do. */
+  buf_element_t      *(*get) (xine_decoder_job_t *job);
+  /* called with port ticket held. */
+  int                 (*step) (xine_decoder_job_t *job, buf_element_t *buf);
+  /* private to the pool. */
+  xine_decoder_pool_t  *pool;
+  xine_decoder_job_t   *next;
+  buf_element_t        *retry;
+  struct timespec       due;
+  int                   state;
+  int                   pending;
+};
+
+xine_decoder_pool_t *_x_decoder_pool_new (xine_t *xine, int threads) INTERNAL;
+void _x_decoder_pool_delete (xine_decoder_pool_t **pool) INTERNAL;
+void _x_decoder_pool_join (xine_decoder_pool_t *pool, xine_decoder_job_t *job) INTERNAL;
+/** wait until job->step () returned XINE_DECODER_STEP_QUIT. */
+void _x_decoder_pool_leave (xine_decoder_job_t *job) INTERNAL;
+void _x_decoder_pool_wait_begin (void) INTERNAL;
+void _x_decoder_pool_wait_end (void) INTERNAL;
+///@}
+
 /**
  * @brief Benchmark available memcpy methods
  */
@@ -455,6 +506,9 @@ typedef struct {
   xine_ticket_t             *port_ticket;
   pthread_mutex_t            log_lock;
 
+  /* engine.decoder.pool_threads > 0 */
+  xine_decoder_pool_t       *decoder_pool;
+
   xine_log_cb_t              log_cb;
   void                      *log_cb_user_data;
 
@@ -507,6 +561,7 @@ typedef struct xine_stream_private_st {
 
 /*  vo_driver_t               *video_driver;*/
   pthread_t                  video_thread;
+  xine_decoder_job_t        *video_decoder_job;
   video_decoder_t           *video_decoder_plugin;
   extra_info_t              *video_decoder_extra_info;
   int                        video_decoder_streamtype;
@@ -516,6 +571,7 @@ typedef struct xine_stream_private_st {
 
   int                        audio_decoder_streamtype;
   pthread_t                  audio_thread;
+  xine_decoder_job_t        *audio_decoder_job;
   audio_decoder_t           *audio_decoder_plugin;
   extra_info_t              *audio_decoder_extra_info;
 
@@ -604,6 +660,9 @@ typedef struct xine_stream_private_st {
     uint32_t                 input_caps;
     uint32_t                 thread_created:1;
     uint32_t                 thread_running:1;
+    /* readable while action_pending, opened by xine_action_wakeup_fd (). protected by action_lock. */
+    uint32_t                 wakeup_set:1;
+    int                      wakeup_fd[2];
     /* filter out duplicate seek discontinuities from side streams */
     uint32_t                 max_seek_bufs;
     /* set of id_flag values */
@@ -632,8 +691,25 @@ typedef struct xine_stream_private_st {
     pthread_mutex_t          lock;
     xine_keyframes_entry_t  *array;
     int                      size, used, lastadd;
+    /* xine_keyframes_scan () state, or NULL. */
+    struct xine_keyframes_scan_s *scan;
   } index;
 
+  /* the hidden side stream that the current input plugin was made for, or NULL. */
+  struct xine_stream_private_st *input_stream;
+  /* hidden side stream only: use the demux actions of side_streams[0]. */
+  int                        actions_from_master;
+
+  /* xine_open_next () */
+  struct {
+    pthread_t                thread;
+    int                      thread_created;
+    char                    *mrl;
+    input_plugin_t          *input;
+    /* what input was made for, see open_next_stream_new (). */
+    struct xine_stream_private_st *stream;
+  } next;
+
   uint32_t                   disable_decoder_flush_at_discontinuity;
 
   /* _x_find_input_plugin () recursion protection */
@@ -644,6 +720,13 @@ typedef struct xine_stream_private_st {
 
 void xine_current_extra_info_set (xine_stream_private_t *stream, const extra_info_t *info) INTERNAL;
 
+/* A file descriptor that gets readable when an action is pending on the stream,
+ * for waiting in poll (). -1 if not available. Opened on first use. */
+int xine_action_wakeup_fd (xine_stream_private_t *stream) INTERNAL;
+/* with demux.action_lock held, after changing demux.action_pending. */
+void xine_action_wakeup_update (xine_stream_private_t *stream) INTERNAL;
+void xine_action_wakeup_close (xine_stream_private_t *stream) INTERNAL;
+
 /* Nasty net_buf_ctrl helper: inform about something outside its regular callbacks. */
 #define XINE_NBC_EVENT_AUDIO_DRY 1
 void xine_nbc_event (xine_stream_private_t *stream, uint32_t type) INTERNAL;
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ *
+ * Video frame plane memory.
+ *
+ * Large planes are mapped directly and marked for transparent huge pages,
+ * saving page faults and TLB misses with 4k and 8k video. Freed blocks are
+ * kept in a small cache, and handed out again for requests of about the
+ * same size. Most of them come from the decoder thread (vo_get_frame () ->
+ * driver update_frame_format ()), so a new block gets first touched - and
+ * thus placed - on that thread's NUMA node, and the cache prefers blocks
+ * from the caller's node.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#endif
+#ifdef __linux__
+#  include <sys/syscall.h>
+#endif
+
+#include <xine/attributes.h>
+#include <xine/xineutils.h>
+
+#if defined(HAVE_SYS_MMAN_H) && defined(MAP_ANONYMOUS)
+#  define FRAME_MEM_MMAP
+#endif
+
+#define FRAME_MEM_HUGE_SIZE  (2 << 20)     /* x86 and arm64 huge page size */
+#define FRAME_MEM_MAP_MIN    FRAME_MEM_HUGE_SIZE
+#define FRAME_MEM_CACHE_MAX  32            /* cached blocks */
+#define FRAME_MEM_CACHE_SIZE (256 << 20)   /* cached bytes */
+
+/* sits right before the user data. */
+typedef union {
+  struct {
+    void   *base;      /* what to free () or munmap () */
+    size_t  map_size;  /* 0 when from malloc () */
+    size_t  size;      /* usable bytes */
+    int     node;      /* NUMA node at allocation time, or -1 */
+  } h;
+  uint8_t align[XINE_FRAME_MEM_ALIGN];
+} frame_mem_head_t;
+
+static struct {
+  pthread_mutex_t   mutex;
+  int               users;
+  size_t            cached_size;
+  int               used;
+  frame_mem_head_t *blocks[FRAME_MEM_CACHE_MAX]; /* oldest first */
+} frame_mem_cache = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER
+};
+
+static int _frame_mem_node (void) {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned int cpu, node;
+  if (syscall (SYS_getcpu, &cpu, &node, NULL) == 0)
+    return node;
+#endif
+  return -1;
+}
+
+static void _frame_mem_release (frame_mem_head_t *head) {
+#ifdef FRAME_MEM_MMAP
+  if (head->h.map_size) {
+    munmap (head->h.base, head->h.map_size);
+    return;
+  }
+#endif
+  free (head->h.base);
+}
+
+#ifdef FRAME_MEM_MMAP
+static frame_mem_head_t *_frame_mem_map (size_t size) {
+  size_t page = sysconf (_SC_PAGESIZE);
+  size_t map_size = (size + sizeof (frame_mem_head_t) + page - 1) & ~(page - 1);
+  uint8_t *base, *start;
+  frame_mem_head_t *head;
+
+  /* huge pages need a huge page aligned start. */
+  base = mmap (NULL, map_size + FRAME_MEM_HUGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+  start = (uint8_t *)(((uintptr_t)base + FRAME_MEM_HUGE_SIZE - 1) & ~((uintptr_t)FRAME_MEM_HUGE_SIZE - 1));
+  if (start > base)
+    munmap (base, start - base);
+  munmap (start + map_size, base + FRAME_MEM_HUGE_SIZE - start);
+#  ifdef MADV_HUGEPAGE
+  madvise (start, map_size, MADV_HUGEPAGE);
+#  endif
+
+  head = (frame_mem_head_t *)start;
+  head->h.base     = start;
+  head->h.map_size = map_size;
+  head->h.size     = map_size - sizeof (frame_mem_head_t);
+  return head;
+}
+#endif
+
+static frame_mem_head_t *_frame_mem_malloc (size_t size) {
+  uint8_t *base;
+  frame_mem_head_t *head;
+
+  size = (size + XINE_FRAME_MEM_ALIGN - 1) & ~((size_t)XINE_FRAME_MEM_ALIGN - 1);
+  base = malloc (size + 2 * sizeof (frame_mem_head_t));
+  if (!base)
+    return NULL;
+  head = (frame_mem_head_t *)(((uintptr_t)base + XINE_FRAME_MEM_ALIGN - 1) & ~((uintptr_t)XINE_FRAME_MEM_ALIGN - 1));
+  head->h.base     = base;
+  head->h.map_size = 0;
+  head->h.size     = size;
+  return head;
+}
+
+void *xine_frame_mem_alloc (size_t size) {
+  frame_mem_head_t *head = NULL;
+  int node = _frame_mem_node ();
+
+  if (!size)
+    size = 1;
+
+  /* recycle. accept up to 1/4 waste, prefer our own node, then the best fit. */
+  pthread_mutex_lock (&frame_mem_cache.mutex);
+  {
+    int i, best = -1;
+    for (i = 0; i < frame_mem_cache.used; i++) {
+      frame_mem_head_t *b = frame_mem_cache.blocks[i];
+      if ((b->h.size < size) || (b->h.size - size > (size >> 2)))
+        continue;
+      if ((best < 0)
+        || ((b->h.node == node) && (frame_mem_cache.blocks[best]->h.node != node))
+        || (((b->h.node == node) == (frame_mem_cache.blocks[best]->h.node == node))
+          && (b->h.size < frame_mem_cache.blocks[best]->h.size)))
+        best = i;
+    }
+    if (best >= 0) {
+      head = frame_mem_cache.blocks[best];
+      frame_mem_cache.cached_size -= head->h.size;
+      frame_mem_cache.used--;
+      for (i = best; i < frame_mem_cache.used; i++)
+        frame_mem_cache.blocks[i] = frame_mem_cache.blocks[i + 1];
+    }
+  }
+  pthread_mutex_unlock (&frame_mem_cache.mutex);
+  if (head)
+    return head + 1;
+
+#ifdef FRAME_MEM_MMAP
+  if (size >= FRAME_MEM_MAP_MIN)
+    head = _frame_mem_map (size);
+#endif
+  if (!head)
+    head = _frame_mem_malloc (size);
+  if (!head)
+    return NULL;
+  /* this touches the first page from the calling thread. */
+  head->h.node = node;
+  return head + 1;
+}
+
+void *xine_frame_mem_allocz (size_t size) {
+  void *ptr = xine_frame_mem_alloc (size);
+
+  if (ptr)
+    memset (ptr, 0, size);
+  return ptr;
+}
+
+void xine_frame_mem_free (void *ptr) {
+  frame_mem_head_t *head, *drop[FRAME_MEM_CACHE_MAX];
+  int n = 0;
+
+  if (!ptr)
+    return;
+  head = (frame_mem_head_t *)ptr - 1;
+
+  if (head->h.size > FRAME_MEM_CACHE_SIZE) {
+    _frame_mem_release (head);
+    return;
+  }
+
+  pthread_mutex_lock (&frame_mem_cache.mutex);
+  /* make room, oldest first. */
+  while ((frame_mem_cache.used > 0)
+    && ((frame_mem_cache.used >= FRAME_MEM_CACHE_MAX)
+      || (frame_mem_cache.cached_size + head->h.size > FRAME_MEM_CACHE_SIZE))) {
+    int i;
+    drop[n] = frame_mem_cache.blocks[0];
+    frame_mem_cache.cached_size -= drop[n]->h.size;
+    n++;
+    frame_mem_cache.used--;
+    for (i = 0; i < frame_mem_cache.used; i++)
+      frame_mem_cache.blocks[i] = frame_mem_cache.blocks[i + 1];
+  }
+  frame_mem_cache.blocks[frame_mem_cache.used++] = head;
+  frame_mem_cache.cached_size += head->h.size;
+  pthread_mutex_unlock (&frame_mem_cache.mutex);
+
+  while (n > 0)
+    _frame_mem_release (drop[--n]);
+}
+
+static void _frame_mem_flush (int unref) {
+  frame_mem_head_t *drop[FRAME_MEM_CACHE_MAX];
+  int n;
+
+  pthread_mutex_lock (&frame_mem_cache.mutex);
+  if (unref && (--frame_mem_cache.users > 0)) {
+    pthread_mutex_unlock (&frame_mem_cache.mutex);
+    return;
+  }
+  for (n = 0; n < frame_mem_cache.used; n++)
+    drop[n] = frame_mem_cache.blocks[n];
+  frame_mem_cache.used = 0;
+  frame_mem_cache.cached_size = 0;
+  pthread_mutex_unlock (&frame_mem_cache.mutex);
+
+  while (n > 0)
+    _frame_mem_release (drop[--n]);
+}
+
+void xine_frame_mem_flush (void) {
+  _frame_mem_flush (0);
+}
+
+void xine_frame_mem_ref (void) {
+  pthread_mutex_lock (&frame_mem_cache.mutex);
+  frame_mem_cache.users++;
+  pthread_mutex_unlock (&frame_mem_cache.mutex);
+}
+
+void xine_frame_mem_unref (void) {
+  _frame_mem_flush (1);
+}
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2000-2019 the xine project
+ * Copyright (C) 2000-2020 the xine project
  *
  * This file is part of xine, a free video player.
  *
@@ -18,6 +18,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
  *
  * debug print and profiling functions - implementation
+ *
+ * every thread records its own finished zones {name, start, stop} into
+ * a private chunked buffer. the writer is the only one to touch it, the
+ * number of valid events is published with a release store, so readers
+ * (the export functions) never need to stop anybody. the thread list is
+ * only locked when a new thread shows up.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -25,29 +31,160 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <time.h>
 #include <sys/time.h>
 
 #include <xine/xineutils.h>
 
-#define MAX_ID 10
+#define MAX_ID 32
+
+/* zones per chunk, and max chunks per thread (16 MiB). */
+#define PROF_CHUNK_BITS 13
+#define PROF_CHUNK_SIZE (1 << PROF_CHUNK_BITS)
+#define PROF_CHUNKS     64
+#define PROF_MAX_DEPTH  32
 
-#ifndef NDEBUG
+#if (HAVE_ATOMIC_VARS > 0) && (HAVE_ATOMIC_VARS < 3)
+#  define PROF_PUBLISH(v,n) __atomic_store_n (&(v), (n), __ATOMIC_RELEASE)
+#  define PROF_GET(v) __atomic_load_n (&(v), __ATOMIC_ACQUIRE)
+#else
+#  define PROF_PUBLISH(v,n) do { __sync_synchronize (); (v) = (n); } while (0)
+#  define PROF_GET(v) __sync_fetch_and_add (&(v), 0)
+#endif
 
 typedef struct {
-    uint64_t    p_times;
-    uint64_t    p_start;
-    long        p_calls;
-    const char *p_label;
-} xine_profiler_t;
+  const char *name;
+  uint64_t    start, stop;
+} xine_prof_zone_t;
+
+typedef struct xine_prof_thread_s xine_prof_thread_t;
+
+struct xine_prof_thread_s {
+  xine_prof_thread_t *next;
+  const char         *name;
+  int                 index;
+  /* written by owner thread only. */
+  uint32_t            depth;
+  uint32_t            dropped;
+  uint32_t            used;
+  xine_prof_zone_t    stack[PROF_MAX_DEPTH];
+  uint64_t            slot_start[MAX_ID];
+  xine_prof_zone_t   *chunks[PROF_CHUNKS];
+};
+
+int xine_profiler_enabled = 0;
+
+static pthread_mutex_t     profiler_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t      profiler_once = PTHREAD_ONCE_INIT;
+static pthread_key_t       profiler_key;
+static xine_prof_thread_t *profiler_threads = NULL;
+static int                 profiler_num_threads = 0;
+static const char         *profiler_labels[MAX_ID];
+/* ignore zones that ended before this (xine_profiler_init () again). */
+static uint64_t            profiler_base = 0;
+
+static uint64_t _prof_now (void) {
+#if _POSIX_TIMERS > 0 && defined(_POSIX_MONOTONIC_CLOCK) && defined(HAVE_POSIX_TIMERS)
+  struct timespec ts;
+  if (!clock_gettime (CLOCK_MONOTONIC, &ts))
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+  {
+    struct timeval tv;
+    gettimeofday (&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000000u + (uint64_t)tv.tv_usec * 1000u;
+  }
+}
 
-static xine_profiler_t profiler[MAX_ID];
-static pthread_mutex_t profiler_lock = PTHREAD_MUTEX_INITIALIZER;
+static void _prof_key_init (void) {
+  pthread_key_create (&profiler_key, NULL);
+}
 
-void xine_profiler_init () {
-  pthread_mutex_lock(&profiler_lock);
-  memset(profiler, 0, sizeof(profiler));
-  pthread_mutex_unlock(&profiler_lock);
+static xine_prof_thread_t *_prof_thread (void) {
+  xine_prof_thread_t *t;
+
+  pthread_once (&profiler_once, _prof_key_init);
+  t = pthread_getspecific (profiler_key);
+  if (t)
+    return t;
+  /* thread exit leaves the buffer in the list, for later export. */
+  t = calloc (1, sizeof (*t));
+  if (!t)
+    return NULL;
+  pthread_setspecific (profiler_key, t);
+  pthread_mutex_lock (&profiler_lock);
+  t->index = ++profiler_num_threads;
+  t->next = profiler_threads;
+  profiler_threads = t;
+  pthread_mutex_unlock (&profiler_lock);
+  return t;
+}
+
+static void _prof_add (xine_prof_thread_t *t, const char *name, uint64_t start, uint64_t stop) {
+  uint32_t n = t->used, c = n >> PROF_CHUNK_BITS;
+  xine_prof_zone_t *z;
+
+  if (c >= PROF_CHUNKS) {
+    t->dropped++;
+    return;
+  }
+  if (!t->chunks[c]) {
+    t->chunks[c] = malloc (PROF_CHUNK_SIZE * sizeof (xine_prof_zone_t));
+    if (!t->chunks[c]) {
+      t->dropped++;
+      return;
+    }
+  }
+  z = t->chunks[c] + (n & (PROF_CHUNK_SIZE - 1));
+  z->name = name;
+  z->start = start;
+  z->stop = stop;
+  PROF_PUBLISH (t->used, n + 1);
+}
+
+void xine_profiler_init (void) {
+  pthread_mutex_lock (&profiler_lock);
+  profiler_base = _prof_now ();
+  xine_profiler_enabled = 1;
+  pthread_mutex_unlock (&profiler_lock);
+}
+
+void xine_profiler_thread_name (const char *name) {
+  xine_prof_thread_t *t;
+
+  if (!xine_profiler_enabled)
+    return;
+  t = _prof_thread ();
+  if (t)
+    t->name = name;
+}
+
+void xine_profiler_zone_begin (const char *name) {
+  xine_prof_thread_t *t = _prof_thread ();
+
+  if (!t)
+    return;
+  if (t->depth < PROF_MAX_DEPTH) {
+    t->stack[t->depth].name = name;
+    t->stack[t->depth].start = _prof_now ();
+  }
+  t->depth++;
+}
+
+void xine_profiler_zone_end (void) {
+  xine_prof_thread_t *t = _prof_thread ();
+
+  if (!t || !t->depth)
+    return;
+  t->depth--;
+  if (t->depth < PROF_MAX_DEPTH)
+    _prof_add (t, t->stack[t->depth].name, t->stack[t->depth].start, _prof_now ());
+  else
+    t->dropped++;
 }
 
 int xine_profiler_allocate_slot (const char *label) {
@@ -55,7 +192,7 @@ int xine_profiler_allocate_slot (const char *label) {
 
   pthread_mutex_lock(&profiler_lock);
 
-  for (id = 0; id < MAX_ID && profiler[id].p_label != NULL; id++)
+  for (id = 0; id < MAX_ID && profiler_labels[id] != NULL; id++)
     ;
 
   if (id >= MAX_ID) {
@@ -63,113 +200,310 @@ int xine_profiler_allocate_slot (const char *label) {
     return -1;
   }
 
-  profiler[id].p_label = label;
+  profiler_labels[id] = label;
 
   pthread_mutex_unlock(&profiler_lock);
 
   return id;
 }
 
+/* slots do not need to nest, they are timed on their own. */
+void xine_profiler_start_count (int id) {
+  xine_prof_thread_t *t;
 
-#if defined(ARCH_X86_32)
-static __inline__ uint64_t rdtsc(void)
-{
-  unsigned long long int x;
-  __asm__ volatile ("rdtsc\n\t" : "=A" (x));
-  return x;
-}
-#elif defined(ARCH_X86_X32) || defined(ARCH_X86_64)
-static __inline__ uint64_t rdtsc(void)
-{
-  unsigned long long int a, d;
-  __asm__ volatile ("rdtsc\n\t" : "=a" (a), "=d" (d));
-  return (d << 32) | (a & 0xffffffff);
+  if ( id >= MAX_ID || id < 0 || !xine_profiler_enabled) return;
+
+  t = _prof_thread ();
+  if (t)
+    t->slot_start[id] = _prof_now ();
 }
-#endif
 
-void xine_profiler_start_count (int id) {
-  if ( id >= MAX_ID || id < 0 ) return;
+void xine_profiler_stop_count (int id) {
+  xine_prof_thread_t *t;
 
-#if defined(ARCH_X86)
-  profiler[id].p_start = rdtsc();
-#endif
+  if ( id >= MAX_ID || id < 0 || !xine_profiler_enabled) return;
+
+  t = _prof_thread ();
+  if (t && t->slot_start[id]) {
+    _prof_add (t, profiler_labels[id], t->slot_start[id], _prof_now ());
+    t->slot_start[id] = 0;
+  }
 }
 
-void xine_profiler_stop_count (int id) {
-  if ( id >= MAX_ID || id < 0 ) return;
+/*
+ * export.
+ */
 
-#if defined(ARCH_X86)
-  profiler[id].p_times += rdtsc() - profiler[id].p_start;
-#endif
-  profiler[id].p_calls++;
+typedef struct {
+  xine_prof_thread_t *thread;
+  xine_prof_zone_t   *zones;
+  uint32_t            num;
+} xine_prof_snap_t;
+
+static int _prof_cmp (const void *a, const void *b) {
+  const xine_prof_zone_t *d = (const xine_prof_zone_t *)a, *e = (const xine_prof_zone_t *)b;
+  /* outer zones first. */
+  if (d->start != e->start)
+    return d->start < e->start ? -1 : 1;
+  if (d->stop != e->stop)
+    return d->stop > e->stop ? -1 : 1;
+  return 0;
 }
 
-void xine_profiler_print_results (void) {
+/* copy out all threads' zones recorded since xine_profiler_init (), sorted by start time. */
+static xine_prof_snap_t *_prof_snapshot (int *num_threads, uint64_t *base) {
+  xine_prof_snap_t *snap;
+  xine_prof_thread_t *t;
+  int n = 0, i;
+
+  pthread_mutex_lock (&profiler_lock);
+  *base = profiler_base;
+  snap = calloc (profiler_num_threads + 1, sizeof (*snap));
+  if (!snap) {
+    pthread_mutex_unlock (&profiler_lock);
+    return NULL;
+  }
+  for (t = profiler_threads; t; t = t->next)
+    snap[n++].thread = t;
+  pthread_mutex_unlock (&profiler_lock);
+
+  for (i = 0; i < n; i++) {
+    xine_prof_snap_t *s = snap + i;
+    uint32_t used = PROF_GET (s->thread->used), u;
+
+    s->zones = malloc ((used + 1) * sizeof (*s->zones));
+    if (!s->zones)
+      continue;
+    for (u = 0; u < used; u++) {
+      const xine_prof_zone_t *z = s->thread->chunks[u >> PROF_CHUNK_BITS] + (u & (PROF_CHUNK_SIZE - 1));
+      if (z->stop >= *base)
+        s->zones[s->num++] = *z;
+    }
+    qsort (s->zones, s->num, sizeof (*s->zones), _prof_cmp);
+  }
+  *num_threads = n;
+  return snap;
+}
+
+static void _prof_snapshot_free (xine_prof_snap_t *snap, int n) {
   int i;
 
-#if defined(ARCH_X86)
-  static uint64_t cpu_speed;	/* cpu cyles/usec */
+  for (i = 0; i < n; i++)
+    free (snap[i].zones);
+  free (snap);
+}
 
-  if (!cpu_speed) {
-    uint64_t tsc_start, tsc_end;
-    struct timeval tv_start, tv_end;
+static void _prof_json_string (FILE *f, const char *s) {
+  fputc ('"', f);
+  for (; s && *s; s++) {
+    if ((*s == '"') || (*s == '\\'))
+      fputc ('\\', f);
+    if ((uint8_t)*s >= 0x20)
+      fputc (*s, f);
+  }
+  fputc ('"', f);
+}
 
-    tsc_start = rdtsc();
-    gettimeofday(&tv_start, NULL);
+/* chrome://tracing, perfetto ui, speedscope. */
+static void _prof_write_chrome (FILE *f, xine_prof_snap_t *snap, int n, uint64_t base) {
+  int pid = getpid (), i, first = 1;
+
+  fputs ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", f);
+  for (i = 0; i < n; i++) {
+    xine_prof_snap_t *s = snap + i;
+    uint32_t u;
+
+    fprintf (f, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+      first ? "" : ",\n", pid, s->thread->index);
+    first = 0;
+    if (s->thread->name) {
+      _prof_json_string (f, s->thread->name);
+    } else {
+      fprintf (f, "\"thread %d\"", s->thread->index);
+    }
+    fputs ("}}", f);
+    for (u = 0; u < s->num; u++) {
+      const xine_prof_zone_t *z = s->zones + u;
+      uint64_t start = z->start > base ? z->start - base : 0;
+
+      fputs (",\n{\"ph\":\"X\",\"name\":", f);
+      _prof_json_string (f, z->name);
+      fprintf (f, ",\"pid\":%d,\"tid\":%d,\"ts\":%" PRIu64 ".%03u,\"dur\":%" PRIu64 ".%03u}",
+        pid, s->thread->index, start / 1000, (unsigned int)(start % 1000),
+        (z->stop - z->start) / 1000, (unsigned int)((z->stop - z->start) % 1000));
+    }
+  }
+  fputs ("\n]}\n", f);
+}
 
-    xine_usec_sleep(100000);
+/* call tree of one thread. */
+typedef struct {
+  const char *name;
+  int         parent, child, next;
+  uint64_t    self;
+} xine_prof_node_t;
+
+static void _prof_write_path (FILE *f, const xine_prof_node_t *nodes, int i) {
+  if (nodes[i].parent >= 0) {
+    _prof_write_path (f, nodes, nodes[i].parent);
+    fputc (';', f);
+  }
+  fputs (nodes[i].name ? nodes[i].name : "?", f);
+}
 
-    tsc_end = rdtsc();
-    gettimeofday(&tv_end, NULL);
+/* folded stacks "thread;zone;inner zone usec", the format that perf script
+ * output has after stackcollapse-perf.pl. feed to flamegraph.pl. */
+static void _prof_write_folded (FILE *f, xine_prof_snap_t *snap, int n) {
+  int i;
 
-    cpu_speed = (tsc_end - tsc_start) /
-	((tv_end.tv_sec - tv_start.tv_sec) * 1e6 +
-	 tv_end.tv_usec - tv_start.tv_usec);
+  for (i = 0; i < n; i++) {
+    xine_prof_snap_t *s = snap + i;
+    xine_prof_node_t *nodes;
+    int stack[PROF_MAX_DEPTH + 1], depth = 0, used = 1, k;
+    uint64_t stops[PROF_MAX_DEPTH + 1];
+    char tname[32];
+    uint32_t u;
+
+    if (!s->num)
+      continue;
+    nodes = calloc (s->num + 1, sizeof (*nodes));
+    if (!nodes)
+      continue;
+    /* node 0 is the thread. */
+    if (!s->thread->name)
+      snprintf (tname, sizeof (tname), "thread %d", s->thread->index);
+    nodes[0].name = s->thread->name ? s->thread->name : tname;
+    nodes[0].parent = -1;
+    stack[0] = 0;
+    stops[0] = ~(uint64_t)0;
+    for (u = 0; u < s->num; u++) {
+      const xine_prof_zone_t *z = s->zones + u;
+      uint64_t d = z->stop - z->start;
+      int p;
+
+      while ((depth > 0) && (stops[depth] <= z->start))
+        depth--;
+      if (depth >= PROF_MAX_DEPTH)
+        continue;
+      /* find or add child of current node. */
+      p = stack[depth];
+      for (k = nodes[p].child; k; k = nodes[k].next)
+        if ((nodes[k].name == z->name) || (nodes[k].name && z->name && !strcmp (nodes[k].name, z->name)))
+          break;
+      if (!k) {
+        k = used++;
+        nodes[k].name = z->name;
+        nodes[k].parent = p;
+        nodes[k].next = nodes[p].child;
+        nodes[p].child = k;
+      }
+      nodes[k].self += d;
+      if (p > 0)
+        nodes[p].self -= d < nodes[p].self ? d : nodes[p].self;
+      stack[++depth] = k;
+      stops[depth] = z->stop;
+    }
+    for (k = 1; k < used; k++) {
+      if (nodes[k].self < 1000)
+        continue;
+      _prof_write_path (f, nodes, k);
+      fprintf (f, " %" PRIu64 "\n", nodes[k].self / 1000);
+    }
+    free (nodes);
   }
-#endif
+}
 
-  printf ("\n\nPerformance analysis:\n\n"
-	  "%-3s %-24.24s %12s %9s %12s %9s\n"
-	  "----------------------------------------------------------------------------\n",
-	  "ID", "name", "cpu cycles", "calls", "cycles/call", "usec/call");
-  for (i=0; i<MAX_ID; i++) {
-    if (profiler[i].p_label) {
-      printf ("%2d: %-24.24s %12" PRIu64 " %9ld",
-	      i, profiler[i].p_label, profiler[i].p_times, profiler[i].p_calls);
-      if (profiler[i].p_calls) {
-          printf(" %12" PRIu64, profiler[i].p_times / (uint64_t)profiler[i].p_calls);
-#if defined(ARCH_X86)
-	  printf(" %9" PRIu64, profiler[i].p_times / ((uint64_t)cpu_speed * profiler[i].p_calls));
-#endif
-      }
-      printf ("\n");
+/* total per zone name, over all threads. */
+static void _prof_write_summary (FILE *f, xine_prof_snap_t *snap, int n) {
+  struct {
+    const char *name;
+    uint64_t    calls, total, max;
+  } *sum;
+  uint32_t all = 0, used = 0, u, dropped = 0;
+  int i;
+
+  for (i = 0; i < n; i++)
+    all += snap[i].num;
+  sum = calloc (all + 1, sizeof (*sum));
+  if (!sum)
+    return;
+  for (i = 0; i < n; i++) {
+    dropped += snap[i].thread->dropped;
+    for (u = 0; u < snap[i].num; u++) {
+      const xine_prof_zone_t *z = snap[i].zones + u;
+      uint64_t d = z->stop - z->start;
+      uint32_t k;
+
+      for (k = 0; k < used; k++)
+        if ((sum[k].name == z->name) || (sum[k].name && z->name && !strcmp (sum[k].name, z->name)))
+          break;
+      if (k == used)
+        sum[used++].name = z->name;
+      sum[k].calls++;
+      sum[k].total += d;
+      if (sum[k].max < d)
+        sum[k].max = d;
     }
   }
+
+  fprintf (f, "\n\nPerformance analysis:\n\n"
+    "%-32.32s %9s %12s %10s %10s\n"
+    "----------------------------------------------------------------------------\n",
+    "name", "calls", "total usec", "usec/call", "max usec");
+  for (u = 0; u < used; u++)
+    fprintf (f, "%-32.32s %9" PRIu64 " %12" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+      sum[u].name ? sum[u].name : "?", sum[u].calls, sum[u].total / 1000,
+      sum[u].total / 1000 / sum[u].calls, sum[u].max / 1000);
+  if (dropped)
+    fprintf (f, "(%u zones dropped)\n", (unsigned int)dropped);
+  free (sum);
 }
 
+int xine_profiler_write (const char *filename, int format) {
+  xine_prof_snap_t *snap;
+  FILE *f = stdout;
+  uint64_t base;
+  int n;
+
+  if (filename && !format) {
+    const char *ext = strrchr (filename, '.');
+    format = XINE_PROFILER_SUMMARY;
+    if (ext && !strcasecmp (ext, ".json"))
+      format = XINE_PROFILER_CHROME_TRACE;
+    else if (ext && !strcasecmp (ext, ".folded"))
+      format = XINE_PROFILER_FOLDED;
+  }
 
-#else /* DEBUG */
+  snap = _prof_snapshot (&n, &base);
+  if (!snap)
+    return 0;
+  if (filename) {
+    f = fopen (filename, "w");
+    if (!f) {
+      _prof_snapshot_free (snap, n);
+      return 0;
+    }
+  }
 
-#define NO_PROFILER_MSG  {printf("xine's profiler is unavailable.\n");}
+  switch (format) {
+    case XINE_PROFILER_CHROME_TRACE:
+      _prof_write_chrome (f, snap, n, base);
+      break;
+    case XINE_PROFILER_FOLDED:
+      _prof_write_folded (f, snap, n);
+      break;
+    default:
+      _prof_write_summary (f, snap, n);
+  }
 
-/* Dummies */
-void xine_profiler_init (void) {
-  NO_PROFILER_MSG
-}
-int xine_profiler_allocate_slot (const char *label) {
-  (void)label;
-  return -1;
-}
-void xine_profiler_start_count (int id) {
-  (void)id;
-}
-void xine_profiler_stop_count (int id) {
-  (void)id;
+  if (filename)
+    fclose (f);
+  else
+    fflush (f);
+  _prof_snapshot_free (snap, n);
+  return 1;
 }
+
 void xine_profiler_print_results (void) {
-  NO_PROFILER_MSG
+  xine_profiler_write (NULL, XINE_PROFILER_SUMMARY);
 }
-
-#endif
-
-
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2000-2020 the xine project
+ *
+ * This file is part of xine, a free video player.
+ *
+ * xine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * xine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110, USA
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#include <xine/attributes.h>
+#include <xine/worker_pool.h>
+#include <xine/xineutils.h>
+
+#define MAX_THREADS 64
+
+struct xine_worker_pool_s {
+  pthread_mutex_t     run_lock;   /* serializes job sets of different callers */
+
+  pthread_mutex_t     lock;
+  pthread_cond_t      wake;       /* workers wait here for a new job set */
+  pthread_cond_t      done;       /* caller waits here for job set completion */
+
+  /* current job set */
+  xine_worker_func_t  func;
+  void               *data;
+  int                 num_jobs;
+  int                 next_job;
+  int                 jobs_done;
+  unsigned int        generation;
+
+  int                 quit;
+  int                 num_threads;
+  pthread_t           threads[1];
+};
+
+/* Grab and run jobs of the current set until there are none left.
+ * Called with lock held, returns with lock held. */
+static void _xine_worker_pool_work (xine_worker_pool_t *pool) {
+  while (pool->next_job < pool->num_jobs) {
+    int job = pool->next_job++;
+    pthread_mutex_unlock (&pool->lock);
+    pool->func (pool->data, job);
+    pthread_mutex_lock (&pool->lock);
+    if (++pool->jobs_done == pool->num_jobs)
+      pthread_cond_signal (&pool->done);
+  }
+}
+
+static void *_xine_worker_pool_loop (void *data) {
+  xine_worker_pool_t *pool = (xine_worker_pool_t *)data;
+  unsigned int generation;
+
+  pthread_mutex_lock (&pool->lock);
+  generation = pool->generation;
+  while (1) {
+    while (!pool->quit && (pool->generation == generation))
+      pthread_cond_wait (&pool->wake, &pool->lock);
+    if (pool->quit)
+      break;
+    generation = pool->generation;
+    _xine_worker_pool_work (pool);
+  }
+  pthread_mutex_unlock (&pool->lock);
+
+  return NULL;
+}
+
+xine_worker_pool_t *xine_worker_pool_new (int num_threads) {
+  xine_worker_pool_t *pool;
+  int i;
+
+  if (num_threads <= 0)
+    num_threads = xine_cpu_count ();
+  if (num_threads > MAX_THREADS)
+    num_threads = MAX_THREADS;
+  if (num_threads < 1)
+    num_threads = 1;
+
+  pool = calloc (1, sizeof (*pool) + (num_threads - 1) * sizeof (pthread_t));
+  if (!pool)
+    return NULL;
+
+  pthread_mutex_init (&pool->run_lock, NULL);
+  pthread_mutex_init (&pool->lock, NULL);
+  pthread_cond_init (&pool->wake, NULL);
+  pthread_cond_init (&pool->done, NULL);
+
+  /* the caller is thread #0 */
+  pool->num_threads = 1;
+  for (i = 1; i < num_threads; i++) {
+    if (pthread_create (&pool->threads[pool->num_threads - 1], NULL, _xine_worker_pool_loop, pool))
+      break;
+    pool->num_threads++;
+  }
+
+  return pool;
+}
+
+void xine_worker_pool_delete (xine_worker_pool_t *pool) {
+  int i;
+
+  if (!pool)
+    return;
+
+  pthread_mutex_lock (&pool->lock);
+  pool->quit = 1;
+  pthread_cond_broadcast (&pool->wake);
+  pthread_mutex_unlock (&pool->lock);
+
+  for (i = 0; i < pool->num_threads - 1; i++)
+    pthread_join (pool->threads[i], NULL);
+
+  pthread_cond_destroy (&pool->done);
+  pthread_cond_destroy (&pool->wake);
+  pthread_mutex_destroy (&pool->lock);
+  pthread_mutex_destroy (&pool->run_lock);
+  free (pool);
+}
+
+int xine_worker_pool_size (xine_worker_pool_t *pool) {
+  return pool ? pool->num_threads : 1;
+}
+
+void xine_worker_pool_run (xine_worker_pool_t *pool, xine_worker_func_t func, void *data, int num_jobs) {
+  int i;
+
+  if (num_jobs <= 0)
+    return;
+
+  if (!pool || (pool->num_threads < 2) || (num_jobs == 1)) {
+    for (i = 0; i < num_jobs; i++)
+      func (data, i);
+    return;
+  }
+
+  pthread_mutex_lock (&pool->run_lock);
+  pthread_mutex_lock (&pool->lock);
+
+  pool->func      = func;
+  pool->data      = data;
+  pool->num_jobs  = num_jobs;
+  pool->next_job  = 0;
+  pool->jobs_done = 0;
+  pool->generation++;
+  pthread_cond_broadcast (&pool->wake);
+
+  _xine_worker_pool_work (pool);
+  while (pool->jobs_done < pool->num_jobs)
+    pthread_cond_wait (&pool->done, &pool->lock);
+
+  pool->func = NULL;
+  pool->data = NULL;
+  pool->num_jobs = 0;
+  pool->next_job = 0;
+
+  pthread_mutex_unlock (&pool->lock);
+  pthread_mutex_unlock (&pool->run_lock);
+}